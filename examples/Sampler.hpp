@@ -26,21 +26,6 @@
 namespace gauss
 {
 
-/** @brief Saves output vectors to file as ("prefix" + index + ".txt")
-    @param upscale upscale object to perform permutations
-    @param vect local vector to save
-    @param prefix filename prefix
-    @param index filename suffix
-*/
-template <typename T>
-void SaveOutput(const Graph& graph, const T& vect, const std::string& prefix, int index)
-{
-    std::stringstream ss;
-    ss << prefix << std::setw(5) << std::setfill('0') << index << ".txt";
-
-    WriteVertexVector(graph, vect, ss.str());
-}
-
 /** @brief Scalar normal distribution */
 class NormalDistribution
 {
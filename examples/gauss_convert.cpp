@@ -0,0 +1,86 @@
+/*BHEADER**********************************************************************
+ *
+ * Copyright (c) 2018, Lawrence Livermore National Security, LLC.
+ * Produced at the Lawrence Livermore National Laboratory.
+ * LLNL-CODE-759464. All Rights reserved. See file COPYRIGHT for details.
+ *
+ * This file is part of GAUSS. For more information and source code
+ * availability, see https://www.github.com/gelever/GAUSS.
+ *
+ * GAUSS is free software; you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License (as published by the Free
+ * Software Foundation) version 2.1 dated February 1999.
+ *
+ ***********************************************************************EHEADER*/
+
+/** @file gauss_convert.cpp
+    @brief Converts text graph data to binary graph files.
+
+    Translates the text formats in graphdata, a CSR vertex_edge
+    relationship, a partition, edge weights or a vertex vector,
+    to the binary format described in GraphFile.hpp.
+
+    Example:
+        gauss-convert --in vertex_edge.txt --out vertex_edge.bin --type csr
+        gauss-convert --in partition.txt --out partition.bin --type int
+        gauss-convert --in weight.txt --out weight.bin --type double
+*/
+
+#include <mpi.h>
+
+#include "GAUSS.hpp"
+
+using namespace gauss;
+
+int main(int argc, char* argv[])
+{
+    // Initialize MPI
+    MpiSession mpi_info(argc, argv);
+    int myid = mpi_info.myid_;
+
+    // program options from command line
+    std::string in_filename = "";
+    std::string out_filename = "";
+    std::string type = "csr";
+
+    linalgcpp::ArgParser arg_parser(argc, argv);
+
+    arg_parser.Parse(in_filename, "--in", "Text file to convert.");
+    arg_parser.Parse(out_filename, "--out", "Binary file to write.");
+    arg_parser.Parse(type, "--type", "Type of data: csr, int or double.");
+
+    if (!arg_parser.IsGood() || in_filename.empty() || out_filename.empty() ||
+            (type != "csr" && type != "int" && type != "double"))
+    {
+        ParPrint(myid, arg_parser.ShowHelp());
+        ParPrint(myid, arg_parser.ShowErrors());
+
+        return EXIT_FAILURE;
+    }
+
+    ParPrint(myid, arg_parser.ShowOptions());
+
+    if (myid == 0)
+    {
+        Timer timer(Timer::Start::True);
+
+        if (type == "csr")
+        {
+            WriteGraphFile(out_filename, linalgcpp::ReadCSR(in_filename));
+        }
+        else if (type == "int")
+        {
+            WriteGraphFile(out_filename, linalgcpp::ReadText<int>(in_filename));
+        }
+        else
+        {
+            WriteGraphFile(out_filename, linalgcpp::ReadText<double>(in_filename));
+        }
+
+        timer.Click();
+
+        std::cout << "Converted " << in_filename << " in " << timer.TotalTime() << "s.\n";
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -65,6 +65,8 @@ int main(int argc, char* argv[])
     bool generate_fiedler = false;
     bool save_fiedler = false;
 
+    bool distributed_read = false;
+
     bool generate_graph = false;
     int gen_vertices = 1000;
     int mean_degree = 40;
@@ -87,6 +89,7 @@ int main(int argc, char* argv[])
     arg_parser.Parse(num_levels, "--nl", "Number of levels.");
     arg_parser.Parse(generate_fiedler, "--gf", "Generate Fiedler vector.");
     arg_parser.Parse(save_fiedler, "--sf", "Save a generated Fiedler vector.");
+    arg_parser.Parse(distributed_read, "--dr", "Each processor reads only its part of the graph files.");
     arg_parser.Parse(generate_graph, "--gg", "Generate a graph.");
     arg_parser.Parse(gen_vertices, "--nv", "Number of vertices of generated graph.");
     arg_parser.Parse(mean_degree, "--md", "Average vertex degree of generated graph.");
@@ -103,54 +106,66 @@ int main(int argc, char* argv[])
 
     ParPrint(myid, arg_parser.ShowOptions());
 
-    /// [Load graph from file or generate one]
-    SparseMatrix vertex_edge_global;
+    Graph graph;
 
-    if (generate_graph)
-    {
-        vertex_edge_global = GenerateGraph(comm, gen_vertices, mean_degree, beta, seed);
-    }
-    else
+    if (distributed_read)
     {
-        vertex_edge_global = ReadCSR(graph_filename);
-    }
-
-    const int nvertices_global = vertex_edge_global.Rows();
-    const int nedges_global = vertex_edge_global.Cols();
-    /// [Load graph from file or generate one]
+        assert(!generate_graph && !metis_agglomeration && w_block_filename.empty());
 
-    /// [Partitioning]
-    std::vector<int> global_partitioning;
-    if (metis_agglomeration || generate_graph)
-    {
-        assert(num_partitions >= num_procs);
-        global_partitioning = MetisPart(vertex_edge_global, num_partitions);
+        graph = Graph(comm, graph_filename, partition_filename, weight_filename);
     }
     else
     {
-        global_partitioning = ReadText<int>(partition_filename);
-    }
-    /// [Partitioning]
-
-    /// [Load the edge weights]
-    std::vector<double> weight;
-    if (!weight_filename.empty())
-    {
-        weight = linalgcpp::ReadText(weight_filename);
-    }
-    /// [Load the edge weights]
-
-    /// [Load W block]
-    SparseMatrix W_block;
-    if (!w_block_filename.empty())
-    {
-        W_block = linalgcpp::ReadCSR(w_block_filename);
+        /// [Load graph from file or generate one]
+        SparseMatrix vertex_edge_global;
+
+        if (generate_graph)
+        {
+            vertex_edge_global = GenerateGraph(comm, gen_vertices, mean_degree, beta, seed);
+        }
+        else
+        {
+            vertex_edge_global = ReadGraphCSR(graph_filename);
+        }
+
+        const int nvertices_global = vertex_edge_global.Rows();
+        const int nedges_global = vertex_edge_global.Cols();
+        /// [Load graph from file or generate one]
+
+        /// [Partitioning]
+        std::vector<int> global_partitioning;
+        if (metis_agglomeration || generate_graph)
+        {
+            assert(num_partitions >= num_procs);
+            global_partitioning = MetisPart(vertex_edge_global, num_partitions);
+        }
+        else
+        {
+            global_partitioning = ReadGraphArray<int>(partition_filename);
+        }
+        /// [Partitioning]
+
+        /// [Load the edge weights]
+        std::vector<double> weight;
+        if (!weight_filename.empty())
+        {
+            weight = ReadGraphArray(weight_filename);
+        }
+        /// [Load the edge weights]
+
+        /// [Load W block]
+        SparseMatrix W_block;
+        if (!w_block_filename.empty())
+        {
+            W_block = linalgcpp::ReadCSR(w_block_filename);
+        }
+        /// [Load W block]
+
+        graph = Graph(comm, vertex_edge_global, global_partitioning, weight, W_block);
     }
-    /// [Load W block]
 
     // Set up GraphUpscale
     /// [Upscale]
-    Graph graph(comm, vertex_edge_global, global_partitioning, weight, W_block);
     GraphUpscale upscale(graph, {spect_tol, max_evects, hybridization, num_levels});
 
     upscale.PrintInfo();
@@ -68,6 +68,8 @@ int main(int argc, char* argv[])
     double kappa = 0.001;
     double cell_volume = 200.0;
     bool coarse_sample = false;
+    int prec_reuse = 0;
+    double prec_growth = 0.0;
 
     linalgcpp::ArgParser arg_parser(argc, argv);
 
@@ -88,6 +90,10 @@ int main(int argc, char* argv[])
     arg_parser.Parse(kappa, "--kappa", "Correlation length for Gaussian samples.");
     arg_parser.Parse(cell_volume, "--cell-volume", "Graph Cell volume");
     arg_parser.Parse(coarse_sample, "--coarse-sample", "Sample on the coarse level.");
+    arg_parser.Parse(prec_reuse, "--prec-reuse",
+                     "Samples to keep a preconditioner for, negative to always keep.");
+    arg_parser.Parse(prec_growth, "--prec-growth",
+                     "Rebuild a kept preconditioner when iterations grow by this factor.");
 
     if (!arg_parser.IsGood())
     {
@@ -145,6 +151,12 @@ int main(int argc, char* argv[])
                        dimension, kappa, cell_volume, sampler_seed);
     GraphUpscale upscale(graph, {spect_tol, max_evects, hybridization});
 
+    PrecReusePolicy reuse_policy;
+    reuse_policy.max_reuse = prec_reuse;
+    reuse_policy.max_iter_growth = prec_growth;
+
+    upscale.SetPrecReuse(reuse_policy);
+
     /// [Upscale]
 
     /// [Right Hand Side]
@@ -159,6 +171,16 @@ int main(int argc, char* argv[])
     BlockVector fine_sol = upscale.GetBlockVector(0);
     BlockVector upscaled_sol = upscale.GetBlockVector(0);
 
+    std::unique_ptr<SampleWriter> sample_writer;
+
+    if (save_output)
+    {
+        std::vector<std::string> fields {"coarse_sol", "fine_sol", "coarse_coeff", "fine_coeff"};
+
+        sample_writer = make_unique<SampleWriter>(comm, "samples.bin", graph.global_vertices_,
+                                                  graph.vertex_map_, fields, true);
+    }
+
     for (int i = 1; i <= num_samples; ++i)
     {
         ParPrint(myid, std::cout << "\n---------------------\n\n");
@@ -181,10 +203,10 @@ int main(int argc, char* argv[])
 
         if (save_output)
         {
-            SaveOutput(graph, upscaled_sol.GetBlock(1), "coarse_sol_", i);
-            SaveOutput(graph, fine_sol.GetBlock(1), "fine_sol_", i);
-            SaveOutput(graph, upscaled_coeff, "coarse_coeff_", i);
-            SaveOutput(graph, fine_coeff, "fine_coeff_", i);
+            sample_writer->Write(i - 1, "coarse_sol", upscaled_sol.GetBlock(1));
+            sample_writer->Write(i - 1, "fine_sol", fine_sol.GetBlock(1));
+            sample_writer->Write(i - 1, "coarse_coeff", upscaled_coeff);
+            sample_writer->Write(i - 1, "fine_coeff", fine_coeff);
         }
 
         upscale.ShowCoarseSolveInfo();
@@ -197,6 +219,8 @@ int main(int argc, char* argv[])
     }
 
     ParPrint(myid, std::cout << "\n---------------------\n\n");
+    ParPrint(myid, std::cout << "Preconditioner builds: fine " << upscale.NumPrecBuilds(0)
+             << ", coarse " << upscale.NumPrecBuilds(1) << "\n");
 
     /// [Solve]
 
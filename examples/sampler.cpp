@@ -170,6 +170,16 @@ int main(int argc, char* argv[])
 
     double max_error = 0.0;
 
+    std::unique_ptr<SampleWriter> sample_writer;
+
+    if (save_output)
+    {
+        std::vector<std::string> fields {"coarse_sol", "fine_sol"};
+
+        sample_writer = make_unique<SampleWriter>(comm, "samples.bin", graph.global_vertices_,
+                                                  graph.vertex_map_, fields, true);
+    }
+
     for (int sample = 1; sample <= num_samples; ++sample)
     {
         ParPrint(myid, std::cout << "\n---------------------\n\n");
@@ -211,8 +221,8 @@ int main(int argc, char* argv[])
 
         if (save_output)
         {
-            SaveOutput(graph, upscaled_sol, "coarse_sol_", sample);
-            SaveOutput(graph, fine_sol, "fine_sol_", sample);
+            sample_writer->Write(sample - 1, "coarse_sol", upscaled_sol);
+            sample_writer->Write(sample - 1, "fine_sol", fine_sol);
         }
     }
 
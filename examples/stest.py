@@ -128,6 +128,18 @@ def make_tests():
           "finest-u-error": 0.22621045683612057,
           "operator-complexity": 1.0372402200489}]
 
+    tests["eigenvector-distread"] = \
+        [["./generalgraph",
+          "--g", graph_data + "/fe_vertex_edge.txt",
+          "--w", graph_data + "/fe_weight_0.txt",
+          "--p", graph_data + "/fe_part.txt",
+          "--f", graph_data + "/fe_rhs.txt",
+          "--t", "1.0", "--m", "1", "--dr"],
+         {"finest-div-error": 2.0312444586906591e-08,
+          "finest-p-error": 0.14743131732550618,
+          "finest-u-error": 0.22621045683612057,
+          "operator-complexity": 1.0372402200489}]
+
     tests["eigenvector4"] = \
         [["./generalgraph",
           "--g", graph_data + "/fe_vertex_edge.txt",
@@ -330,6 +342,18 @@ def make_tests():
           "finest-u-error": 0.22621045683612057,
           "operator-complexity": 1.0372402200488997}]
 
+    tests["pareigenvector-distread"] = \
+        [["mpirun", "-n", num_procs, "./generalgraph",
+          "--g", graph_data + "/fe_vertex_edge.txt",
+          "--w", graph_data + "/fe_weight_0.txt",
+          "--p", graph_data + "/fe_part.txt",
+          "--f", graph_data + "/fe_rhs.txt",
+          "--t", "1.0", "--m", "1", "--dr"],
+         {"finest-div-error": 2.0312444586906591e-08,
+          "finest-p-error": 0.14743131732550618,
+          "finest-u-error": 0.22621045683612057,
+          "operator-complexity": 1.0372402200488997}]
+
     tests["pareigenvector4"] = \
         [["mpirun", "-n", num_procs, "./generalgraph",
           "--g", graph_data + "/fe_vertex_edge.txt",
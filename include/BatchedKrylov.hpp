@@ -0,0 +1,178 @@
+/*BHEADER**********************************************************************
+ *
+ * Copyright (c) 2018, Lawrence Livermore National Security, LLC.
+ * Produced at the Lawrence Livermore National Laboratory.
+ * LLNL-CODE-759464. All Rights reserved. See file COPYRIGHT for details.
+ *
+ * This file is part of GAUSS. For more information and source code
+ * availability, see https://www.github.com/gelever/GAUSS.
+ *
+ * GAUSS is free software; you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License (as published by the Free
+ * Software Foundation) version 2.1 dated February 1999.
+ *
+ ***********************************************************************EHEADER*/
+
+/** @file BatchedKrylov.hpp
+
+    @brief Krylov solvers for several right hand sides at once.
+
+    Each right hand side runs its own recurrence, but the inner products
+    of all right hand sides are combined into a single reduction per step.
+    Right hand sides that have converged are frozen while the others continue.
+    On a single processor the reductions are skipped, see ParSum.
+
+   The relative tolerance is measured against the preconditioned norm of the
+   right hand side, so a good initial guess takes fewer iterations. With a
+   zero initial guess this is the usual initial residual criterion.
+*/
+
+#ifndef __BATCHEDKRYLOV_HPP__
+#define __BATCHEDKRYLOV_HPP__
+
+#include <mutex>
+
+#include "Utilities.hpp"
+
+namespace gauss
+{
+
+/**
+   @brief Applies an operator while holding a lock
+
+   For operators that keep work vectors internally, such as hypre's
+   BoomerAMG, and so cannot be applied from several threads at once.
+*/
+class LockedOperator : public linalgcpp::Operator
+{
+public:
+    /** @brief Constructor
+        @param op operator to apply
+        @param mutex lock shared by all users of op
+    */
+    LockedOperator(const linalgcpp::Operator& op, std::mutex& mutex)
+        : linalgcpp::Operator(op.Rows(), op.Cols()), op_(op), mutex_(mutex) { }
+
+    void Mult(const VectorView& input, VectorView output) const override
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+
+        op_.Mult(input, output);
+    }
+
+    using linalgcpp::Operator::Mult;
+
+private:
+    const linalgcpp::Operator& op_;
+    std::mutex& mutex_;
+};
+
+/**
+   @brief Preconditioned conjugate gradient on several right hand sides
+
+   @param comm communicator the vectors are distributed over
+   @param A symmetric positive definite operator
+   @param M preconditioner, or nullptr for none
+   @param b right hand sides, in true dofs
+   @param x on input the initial guesses, on output the solutions
+   @param max_iter maximum number of iterations
+   @param rel_tol relative tolerance on the preconditioned residual
+   @param abs_tol absolute tolerance on the preconditioned residual
+   @returns largest number of iterations over all right hand sides
+*/
+int BatchedPCG(MPI_Comm comm, const linalgcpp::Operator& A,
+               const linalgcpp::Operator* M,
+               const std::vector<Vector>& b, std::vector<Vector>& x,
+               int max_iter, double rel_tol, double abs_tol);
+
+/**
+   @brief Pipelined preconditioned conjugate gradient on several right hand sides
+
+   The variant of Ghysels and Vanroose, with a single non-blocking reduction
+   per iteration that is overlapped with the preconditioner and operator
+   application. The recurrences for the residual and its images drift from
+   the true residual in finite precision, so they are recomputed every
+   replace_freq iterations, or when the recurrence loses positivity.
+
+   Takes an extra preconditioner and operator application at startup and
+   each replacement, and more work vectors than BatchedPCG, so it only pays
+   off when the reduction latency dominates.
+
+   @param comm communicator the vectors are distributed over
+   @param A symmetric positive definite operator
+   @param M preconditioner, or nullptr for none
+   @param b right hand sides, in true dofs
+   @param x on input the initial guesses, on output the solutions
+   @param max_iter maximum number of iterations
+   @param rel_tol relative tolerance on the preconditioned residual
+   @param abs_tol absolute tolerance on the preconditioned residual
+   @param replace_freq iterations between residual replacements, 0 to only
+          replace on loss of positivity
+   @returns largest number of iterations over all right hand sides
+*/
+int BatchedPipelinedPCG(MPI_Comm comm, const linalgcpp::Operator& A,
+                        const linalgcpp::Operator* M,
+                        const std::vector<Vector>& b, std::vector<Vector>& x,
+                        int max_iter, double rel_tol, double abs_tol,
+                        int replace_freq = 50);
+
+/**
+   @brief Preconditioned MINRES on several right hand sides
+
+   @param comm communicator the vectors are distributed over
+   @param A symmetric operator
+   @param M symmetric positive definite preconditioner, or nullptr for none
+   @param b right hand sides, in true dofs
+   @param x on input the initial guesses, on output the solutions
+   @param max_iter maximum number of iterations
+   @param rel_tol relative tolerance on the preconditioned residual
+   @param abs_tol absolute tolerance on the preconditioned residual
+   @returns largest number of iterations over all right hand sides
+*/
+int BatchedPMINRES(MPI_Comm comm, const linalgcpp::Operator& A,
+                   const linalgcpp::Operator* M,
+                   const std::vector<Vector>& b, std::vector<Vector>& x,
+                   int max_iter, double rel_tol, double abs_tol);
+
+/**
+   @brief Right preconditioned flexible GMRES on several right hand sides
+
+   The preconditioned directions are kept, so the preconditioner may change
+   from one application to the next, as for a multigrid cycle with an inner
+   iterative solve. The Arnoldi vectors are orthogonalized by classical
+   Gram-Schmidt applied twice, each pass a single reduction for all right
+   hand sides.
+
+   @param comm communicator the vectors are distributed over
+   @param A operator
+   @param M preconditioner, or nullptr for none
+   @param b right hand sides, in true dofs
+   @param x on input the initial guesses, on output the solutions
+   @param max_iter maximum number of iterations
+   @param rel_tol relative tolerance on the residual
+   @param abs_tol absolute tolerance on the residual
+   @param restart iterations between restarts
+   @returns largest number of iterations over all right hand sides
+*/
+int BatchedFGMRES(MPI_Comm comm, const linalgcpp::Operator& A,
+                  const linalgcpp::Operator* M,
+                  const std::vector<Vector>& b, std::vector<Vector>& x,
+                  int max_iter, double rel_tol, double abs_tol,
+                  int restart = 50);
+
+/**
+   @brief Inner products of several pairs of vectors with a single reduction
+
+   @param comm communicator the vectors are distributed over
+   @param lhs left vectors
+   @param rhs right vectors
+   @param active only pairs marked true are computed, others are zero
+   @param dots global inner products, one per pair
+*/
+void BatchedDot(MPI_Comm comm, const std::vector<Vector>& lhs,
+                const std::vector<Vector>& rhs, const std::vector<bool>& active,
+                std::vector<double>& dots);
+
+} // namespace gauss
+
+#endif /* __BATCHEDKRYLOV_HPP__ */
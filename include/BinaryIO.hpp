@@ -0,0 +1,157 @@
+/*BHEADER**********************************************************************
+ *
+ * Copyright (c) 2018, Lawrence Livermore National Security, LLC.
+ * Produced at the Lawrence Livermore National Laboratory.
+ * LLNL-CODE-759464. All Rights reserved. See file COPYRIGHT for details.
+ *
+ * This file is part of GAUSS. For more information and source code
+ * availability, see https://www.github.com/gelever/GAUSS.
+ *
+ * GAUSS is free software; you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License (as published by the Free
+ * Software Foundation) version 2.1 dated February 1999.
+ *
+ ***********************************************************************EHEADER*/
+
+/** @file BinaryIO.hpp
+
+    @brief Raw binary serialization of linalgcpp and GAUSS data structures.
+
+    Data is written in native byte order and is intended to be read back
+    on the same platform, e.g. for checkpoint and restart.
+*/
+
+#ifndef __BINARYIO_HPP__
+#define __BINARYIO_HPP__
+
+#include <iostream>
+#include <type_traits>
+
+#include "Utilities.hpp"
+#include "GraphTopology.hpp"
+#include "GraphSpace.hpp"
+#include "MixedMatrix.hpp"
+#include "Level.hpp"
+
+namespace gauss
+{
+
+/** @brief Write an arithmetic value */
+template <typename T>
+typename std::enable_if<std::is_arithmetic<T>::value>::type
+WriteBinary(std::ostream& out, const T& val)
+{
+    out.write(reinterpret_cast<const char*>(&val), sizeof(T));
+}
+
+/** @brief Read an arithmetic value */
+template <typename T>
+typename std::enable_if<std::is_arithmetic<T>::value>::type
+ReadBinary(std::istream& in, T& val)
+{
+    in.read(reinterpret_cast<char*>(&val), sizeof(T));
+}
+
+/** @brief Write a vector of arithmetic values, prefixed by its size */
+template <typename T>
+typename std::enable_if<std::is_arithmetic<T>::value>::type
+WriteBinary(std::ostream& out, const std::vector<T>& vect)
+{
+    long long size = vect.size();
+
+    WriteBinary(out, size);
+    out.write(reinterpret_cast<const char*>(vect.data()), size * sizeof(T));
+}
+
+/** @brief Read a vector of arithmetic values, prefixed by its size */
+template <typename T>
+typename std::enable_if<std::is_arithmetic<T>::value>::type
+ReadBinary(std::istream& in, std::vector<T>& vect)
+{
+    long long size;
+
+    ReadBinary(in, size);
+    vect.resize(size);
+    in.read(reinterpret_cast<char*>(vect.data()), size * sizeof(T));
+}
+
+void WriteBinary(std::ostream& out, const Vector& vect);
+void ReadBinary(std::istream& in, Vector& vect);
+
+void WriteBinary(std::ostream& out, const SparseMatrix& mat);
+void ReadBinary(std::istream& in, SparseMatrix& mat);
+
+void WriteBinary(std::ostream& out, const DenseMatrix& mat);
+void ReadBinary(std::istream& in, DenseMatrix& mat);
+
+/** @brief Write the local part of a distributed matrix */
+void WriteBinary(std::ostream& out, const ParMatrix& mat);
+
+/** @brief Read the local part of a distributed matrix
+    @param comm communicator the matrix was distributed over
+*/
+void ReadBinary(std::istream& in, MPI_Comm comm, ParMatrix& mat);
+
+void WriteBinary(std::ostream& out, const GraphTopology& gt);
+void ReadBinary(std::istream& in, MPI_Comm comm, GraphTopology& gt);
+
+void WriteBinary(std::ostream& out, const GraphSpace& graph_space);
+void ReadBinary(std::istream& in, MPI_Comm comm, GraphSpace& graph_space);
+
+/** @brief Write the element matrices and local blocks of a mixed matrix */
+void WriteBinary(std::ostream& out, const MixedMatrix& mm);
+
+/** @brief Read a mixed matrix, global blocks are rebuilt from the local ones */
+void ReadBinary(std::istream& in, MPI_Comm comm, MixedMatrix& mm);
+
+/** @brief Write everything in a level except the solver and work vectors */
+void WriteBinary(std::ostream& out, const Level& level);
+
+/** @brief Read a level, the solver is not created */
+void ReadBinary(std::istream& in, MPI_Comm comm, Level& level);
+
+/** @brief Write a vector of objects, prefixed by its size */
+template <typename T>
+typename std::enable_if < !std::is_arithmetic<T>::value >::type
+WriteBinary(std::ostream& out, const std::vector<T>& vect)
+{
+    long long size = vect.size();
+
+    WriteBinary(out, size);
+
+    for (const auto& val : vect)
+    {
+        WriteBinary(out, val);
+    }
+}
+
+/** @brief Read a vector of objects, prefixed by its size */
+template <typename T>
+typename std::enable_if < !std::is_arithmetic<T>::value >::type
+ReadBinary(std::istream& in, std::vector<T>& vect)
+{
+    long long size;
+
+    ReadBinary(in, size);
+    vect.resize(size);
+
+    for (auto& val : vect)
+    {
+        ReadBinary(in, val);
+    }
+}
+
+/** @brief Write a checkpoint header with magic string and format version */
+void WriteBinaryHeader(std::ostream& out, MPI_Comm comm, int version);
+
+/** @brief Read and check a checkpoint header
+    @returns format version of the file
+*/
+int ReadBinaryHeader(std::istream& in, MPI_Comm comm);
+
+/** @brief Name of the per processor file for a checkpoint prefix */
+std::string ProcFilename(MPI_Comm comm, const std::string& prefix);
+
+} // namespace gauss
+
+#endif /* __BINARYIO_HPP__ */
@@ -21,3 +21,5 @@
 #include "GraphUpscale.hpp"
 #include "UpscaleOperators.hpp"
 #include "GraphGenerator.hpp"
+#include "GraphFile.hpp"
+#include "SampleStore.hpp"
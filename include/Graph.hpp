@@ -54,6 +54,28 @@ struct Graph
           const std::vector<double>& weight_global = {},
           const SparseMatrix& W_block_global = {});
 
+    /**
+       @brief Read a graph from file in parallel.
+
+       Each processor reads only its block of rows of the graph and
+       partition files, and its block of the edge weights. Files may be
+       text or binary graph files, see GraphFile.hpp; binary files are
+       memory mapped so a block is read without scanning the file. Vertices are
+       then sent to the processor that owns their partition, so no
+       processor ever holds the global graph.
+
+       Partitions are assigned to processors in contiguous blocks of
+       partition numbers.
+
+       @param comm the communicator over which to distribute the graph
+       @param graph_filename vertex edge relationship in CSR format
+       @param partition_filename partition of the global vertices
+       @param weight_filename edge weights, unit weights if empty
+    */
+    Graph(MPI_Comm comm, const std::string& graph_filename,
+          const std::string& partition_filename,
+          const std::string& weight_filename = "");
+
     /**
        @brief Accepts an already distributed graph.
               Computes vertex and edge maps from local info,
@@ -107,6 +129,8 @@ private:
                          = {});
 
     void MakeLocalW(const SparseMatrix& W_global);
+
+    void ScaleSharedWeight();
 };
 
 template <typename T>
@@ -22,6 +22,7 @@
 #define __GRAPHCOARSEN_HPP__
 
 #include "Utilities.hpp"
+#include "BinaryIO.hpp"
 #include "LocalEigenSolver.hpp"
 #include "Level.hpp"
 #include "MixedMatrix.hpp"
@@ -56,9 +57,10 @@ public:
         @param max_evects maximum number of eigenvectors per aggregate
         @param spect_tol spectral tolerance used to determine how many eigenvectors
                          to keep per aggregate
+        @param warm_start keep the local eigenvectors to warm start Update
     */
     GraphCoarsen(const Graph& graph, const MixedMatrix& mgl,
-                 SpectralPair spect_pair);
+                 SpectralPair spect_pair, bool warm_start = false);
 
     /** @brief Construtor from graph topology
 
@@ -67,10 +69,11 @@ public:
         @param max_evects maximum number of eigenvectors per aggregate
         @param spect_tol spectral tolerance used to determine how many eigenvectors
                          to keep per aggregate
+        @param warm_start keep the local eigenvectors to warm start Update
     */
     GraphCoarsen(GraphTopology gt, const GraphSpace& graph_space,
                  const MixedMatrix& mgl, const VectorView& constant_rep,
-                 SpectralPair spect_pair);
+                 SpectralPair spect_pair, bool warm_start = false);
 
     /** @brief Construtor from Level structure
 
@@ -79,9 +82,10 @@ public:
         @param max_evects maximum number of eigenvectors per aggregate
         @param spect_tol spectral tolerance used to determine how many eigenvectors
                          to keep per aggregate
+        @param warm_start keep the local eigenvectors to warm start Update
     */
     GraphCoarsen(GraphTopology gt, const Level& prev_level,
-                 SpectralPair spect_pair);
+                 SpectralPair spect_pair, bool warm_start = false);
 
 
     /** @brief Default Destructor */
@@ -99,6 +103,34 @@ public:
     /** @brief Swap to coarseners */
     friend void swap(GraphCoarsen& lhs, GraphCoarsen& rhs) noexcept;
 
+    /** @brief Write coarsener to binary stream */
+    friend void WriteBinary(std::ostream& out, const GraphCoarsen& coarsener);
+
+    /** @brief Read coarsener from binary stream */
+    friend void ReadBinary(std::istream& in, MPI_Comm comm, GraphCoarsen& coarsener);
+
+    /** @brief Recompute the coarse space after the fine matrices change
+
+        Intended for edge weight updates on a fixed graph. The topology,
+        extension permutations, and dof extraction plans are kept. If the
+        coarsener was built with warm_start, the previous local eigenvectors
+        warm start the iterative eigensolver.
+        If the dof layout of the level changed, the extraction plans are
+        rebuilt but the topology is still reused.
+
+        @param level Fine level with updated matrices
+    */
+    void Update(const Level& level);
+
+    /** @brief Recompute the coarse space after the fine matrices change
+
+        @param graph_space Fine level graph space
+        @param mgl Fine level mixed matrix with updated weights
+        @param constant_rep Fine level constant representation
+    */
+    void Update(const GraphSpace& graph_space, const MixedMatrix& mgl,
+                const VectorView& constant_rep);
+
     /** @brief Create the coarse mixed matrix
         @param mgl Fine level mixed matrix
     */
@@ -157,6 +189,22 @@ public:
     */
     void Restrict(const BlockVector& fine_vect, BlockVector& coarse_vect) const;
 
+    /** @brief Interpolate several coarse mixed form vectors up to the fine level,
+               with a single pass over the interpolation matrices
+        @param coarse_vects coarse vectors to interpolate
+        @param fine_vects holds the interpolated vectors
+    */
+    void Interpolate(const std::vector<BlockVector>& coarse_vects,
+                     std::vector<BlockVector>& fine_vects) const;
+
+    /** @brief Restrict several fine level mixed form vectors to the coarse level,
+               with a single pass over the interpolation matrices
+        @param fine_vects fine vectors to restrict
+        @param coarse_vects holds the restricted vectors
+    */
+    void Restrict(const std::vector<BlockVector>& fine_vects,
+                  std::vector<BlockVector>& coarse_vects) const;
+
     /** @brief Project a fine level mixed form vector to the coarse level
         @param fine_vect fine level mixed form vector
         @returns coarse_vect projected mixed form vector
@@ -177,22 +225,45 @@ public:
     const SparseMatrix& Pvertex() const { return P_vertex_; }
     const GraphTopology& Topology() const { return gt_; }
 
+    /// Number of aggregates over all processors whose local eigenvectors
+    /// did not converge in the last construction or Update
+    int NumNotConverged() const { return num_not_converged_; }
+
+    /// Number of aggregates over all processors whose local eigenvectors
+    /// were warm started in the last construction or Update
+    int NumWarmStarted() const { return num_warm_started_; }
+
     GraphSpace BuildGraphSpace() const;
 
 private:
     template <class T>
     using Vect2D = std::vector<std::vector<T>>;
 
+    void BuildExtension(const GraphSpace& graph_space, const MixedMatrix& mgl);
+    void ComputeTargets(const MixedMatrix& mgl, const VectorView& constant_rep);
+    std::vector<int> DofLayout(const GraphSpace& graph_space) const;
+
     void ComputeVertexTargets(const ParMatrix& M_ext, const ParMatrix& D_ext);
     void ComputeEdgeTargets(const MixedMatrix& mgl, const VectorView& constant_vect,
                             const ParMatrix& face_edge_perm);
     void ScaleEdgeTargets(const MixedMatrix& mgl, const VectorView& constant_vect);
 
 
-    Vect2D<DenseMatrix> CollectSigma(const SparseMatrix& face_edge);
-    Vect2D<Vector> CollectConstant(const VectorView& constant_vect);
-    Vect2D<SparseMatrix> CollectD(const MixedMatrix& mgl);
-    Vect2D<SparseMatrix> CollectM(const SparseMatrix& M_local);
+    // Start collecting face data, shared faces are complete after CollectEnd()
+    Vect2D<DenseMatrix>& CollectSigma(const SparseMatrix& face_edge,
+                                      SharedEntityComm<DenseMatrix>& sec_sigma);
+    Vect2D<Vector>& CollectConstant(const VectorView& constant_vect,
+                                    SharedEntityComm<Vector>& sec_constant);
+    Vect2D<SparseMatrix>& CollectD(const MixedMatrix& mgl,
+                                   SharedEntityComm<SparseMatrix>& sec_D);
+    Vect2D<SparseMatrix>& CollectM(const SparseMatrix& M_local,
+                                   SharedEntityComm<SparseMatrix>& sec_M);
+
+    void ComputeFaceTargets(const SparseMatrix& face_edge, bool shared_faces,
+                            Vect2D<DenseMatrix>& shared_sigma,
+                            Vect2D<Vector>& shared_constant,
+                            Vect2D<SparseMatrix>& shared_M,
+                            Vect2D<SparseMatrix>& shared_D);
 
     SparseMatrix CombineM(const std::vector<SparseMatrix>& face_M, int num_face_edges) const;
     SparseMatrix CombineD(const std::vector<SparseMatrix>& face_D, int num_face_edges) const;
@@ -243,6 +314,7 @@ private:
 
     int max_evects_;
     double spect_tol_;
+    bool warm_start_ = false;
 
     SparseMatrix Q_edge_;
     SparseMatrix P_edge_;
@@ -265,9 +337,21 @@ private:
     // End ML Stuff
     //////////////////
 
+    // Kept for Update
+    ParMatrix permute_v_;
+    ParMatrix permute_e_;
+    ParMatrix face_perm_edge_;
+    std::vector<int> dof_layout_;
+
+    // Extended eigenvectors, warm start for Update, empty unless warm_start_
+    std::vector<DenseMatrix> agg_ext_evects_;
+
     mutable std::vector<int> col_marker_;
 
     std::vector<std::vector<double>> D_trace_sum_;
+
+    int num_not_converged_ = 0;
+    int num_warm_started_ = 0;
 };
 
 } // namespace gauss
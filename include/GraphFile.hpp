@@ -0,0 +1,154 @@
+/*BHEADER**********************************************************************
+ *
+ * Copyright (c) 2018, Lawrence Livermore National Security, LLC.
+ * Produced at the Lawrence Livermore National Laboratory.
+ * LLNL-CODE-759464. All Rights reserved. See file COPYRIGHT for details.
+ *
+ * This file is part of GAUSS. For more information and source code
+ * availability, see https://www.github.com/gelever/GAUSS.
+ *
+ * GAUSS is free software; you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License (as published by the Free
+ * Software Foundation) version 2.1 dated February 1999.
+ *
+ ***********************************************************************EHEADER*/
+
+/** @file GraphFile.hpp
+
+    @brief Binary file format for graph input data.
+
+    Holds either a CSR matrix, such as vertex_edge, or an array, such as
+    a partition, edge weights or a vertex vector. Unlike the text formats,
+    any block of rows or entries can be read without parsing the rest of
+    the file, and files are memory mapped so only the pages read are loaded.
+
+    All values are little endian. The file starts with a 40 byte header:
+
+        char[8]  magic "GAUSSGRF"
+        int32    format version
+        int32    kind, see GraphFileKind
+        int64    rows, or number of entries of an array
+        int64    cols, zero for arrays
+        int64    nnz, zero for arrays
+
+    followed by, for a CSR matrix
+
+        int64    indptr[rows + 1]
+        int32    indices[nnz], padded to a multiple of 8 bytes
+        float64  data[nnz]
+
+    or for an array
+
+        int32 or float64 values[rows]
+*/
+
+#ifndef __GRAPHFILE_HPP__
+#define __GRAPHFILE_HPP__
+
+#include "Utilities.hpp"
+
+namespace gauss
+{
+
+/** @brief Contents of a graph file */
+enum class GraphFileKind { CSR = 1, IntArray = 2, DoubleArray = 3 };
+
+/**
+   @brief Memory mapped reader of a binary graph file
+*/
+class GraphFileReader
+{
+public:
+    /** @brief Constructor, maps the file and checks its header
+        @param filename file to read
+    */
+    explicit GraphFileReader(const std::string& filename);
+
+    /** @brief Destructor, unmaps the file */
+    ~GraphFileReader() noexcept;
+
+    GraphFileReader(const GraphFileReader& other) = delete;
+    GraphFileReader& operator=(const GraphFileReader& other) = delete;
+
+    /** @brief Contents of the file */
+    GraphFileKind Kind() const { return kind_; }
+
+    /** @brief Number of rows of a matrix, or entries of an array */
+    long long Rows() const { return rows_; }
+
+    /** @brief Number of columns of a matrix */
+    long long Cols() const { return cols_; }
+
+    /** @brief Number of nonzeros of a matrix */
+    long long NNZ() const { return nnz_; }
+
+    /** @brief Read the whole CSR matrix */
+    SparseMatrix ReadCSR() const;
+
+    /** @brief Read a block of rows of the CSR matrix
+        @param row_begin first row to read
+        @param row_end one past the last row to read
+        @returns rows [row_begin, row_end) with all columns
+    */
+    SparseMatrix ReadCSRRows(long long row_begin, long long row_end) const;
+
+    /** @brief Read a block of entries of an array
+        @param begin first entry to read
+        @param end one past the last entry to read
+    */
+    template <typename T>
+    std::vector<T> ReadArray(long long begin, long long end) const;
+
+    /** @brief Read the whole array */
+    template <typename T>
+    std::vector<T> ReadArray() const { return ReadArray<T>(0, rows_); }
+
+    /** @brief Read selected entries of an array of doubles
+        @param local_to_global entries to read
+    */
+    Vector ReadVector(const std::vector<int>& local_to_global) const;
+
+private:
+    const char* Section(long long offset) const;
+
+    std::string filename_;
+
+    char* data_;
+    size_t size_;
+
+    GraphFileKind kind_;
+    long long rows_;
+    long long cols_;
+    long long nnz_;
+};
+
+/** @brief Check if a file is a binary graph file */
+bool IsGraphFile(const std::string& filename);
+
+/** @brief Write a CSR matrix to a binary graph file */
+void WriteGraphFile(const std::string& filename, const SparseMatrix& mat);
+
+/** @brief Write an array of ints to a binary graph file */
+void WriteGraphFile(const std::string& filename, const std::vector<int>& vect);
+
+/** @brief Write an array of doubles to a binary graph file */
+void WriteGraphFile(const std::string& filename, const std::vector<double>& vect);
+
+/** @brief Read a CSR matrix from a binary graph file or a text file */
+SparseMatrix ReadGraphCSR(const std::string& filename);
+
+/** @brief Read an array from a binary graph file or a text file */
+template <typename T = double>
+std::vector<T> ReadGraphArray(const std::string& filename)
+{
+    if (IsGraphFile(filename))
+    {
+        return GraphFileReader(filename).ReadArray<T>();
+    }
+
+    return linalgcpp::ReadText<T>(filename);
+}
+
+} // namespace gauss
+
+#endif /* __GRAPHFILE_HPP__ */
@@ -23,6 +23,7 @@
 
 #include "Utilities.hpp"
 #include "MixedMatrix.hpp"
+#include "SharedEntityComm.hpp"
 
 namespace gauss
 {
@@ -92,6 +93,11 @@ public:
     int GlobalNumEdges() const { return face_edge_.GlobalCols(); }
     int GlobalNumFaces() const { return face_edge_.GlobalRows(); }
 
+    /** @brief Communication plan for faces shared across processors,
+               built on first use and shared by copies of this topology
+    */
+    SharedEntityPlan& FacePlan() const;
+
     // Local topology
     SparseMatrix agg_vertex_local_; // Aggregate to vertex, not exteneded
     SparseMatrix agg_edge_local_;   // Aggregate to edge, not extended
@@ -123,6 +129,8 @@ private:
     SparseMatrix ExtendFaceAgg(const ParMatrix& agg_agg,
                                const SparseMatrix& face_int_agg);
 
+    mutable std::shared_ptr<SharedEntityPlan> face_plan_;
+
 };
 
 } // namespace gauss
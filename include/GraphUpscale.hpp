@@ -29,6 +29,7 @@
 
 
 #include "Utilities.hpp"
+#include "BinaryIO.hpp"
 #include "MixedMatrix.hpp"
 #include "GraphCoarsen.hpp"
 #include "MGLSolver.hpp"
@@ -38,6 +39,7 @@
 #include "MinresBlockSolver.hpp"
 #include "HybridSolver.hpp"
 #include "SPDSolver.hpp"
+#include "MultigridSolver.hpp"
 
 namespace gauss
 {
@@ -78,8 +80,76 @@ struct UpscaleParams
 
     std::vector<SpectralPair> spectral_pair;
     std::vector<int> elim_edge_dofs;
+
+    /// Levels that solve with pipelined CG, see BatchedPipelinedPCG,
+    /// levels past the end use standard CG
+    std::vector<bool> pipelined_cg;
+
+    /// Store the element matrices of the hybridization solver in single
+    /// precision, with iterative refinement to double precision accuracy
+    bool hybrid_single_precision = false;
+
+    /// Solve the fine level with FGMRES preconditioned by a V-cycle
+    /// through the hierarchy, see MultigridSolver, instead of CG
+    bool multigrid = false;
+    MultigridParams multigrid_params;
+
+    /// Keep the local eigenvectors of each coarsener to warm start
+    /// UpdateWeights, at the cost of storing and checkpointing them
+    bool warm_start = false;
+
+    /// Report setup warnings on processor 0, such as local eigenvectors
+    /// that did not converge
+    bool verbose = true;
+};
+
+/**
+   @brief Work vectors for solves and transfers through a hierarchy
+
+   The const solve and transfer methods of GraphUpscale that take a workspace
+   only write into it, so several threads can share one hierarchy if each
+   has its own workspace. Workspaces must be made again after the solvers
+   of the hierarchy are recreated.
+
+   Concurrent solves need MPI initialized with MPI_THREAD_MULTIPLE, see
+   MpiSession. Since the distributed matrices communicate on the communicator
+   of the hierarchy, they are only supported on a single processor, where
+   the solvers skip their global reductions, see ParSum.
+*/
+struct UpscaleWorkspace
+{
+    /// Mixed form vectors per level
+    std::vector<BlockVector> rhs;
+    std::vector<BlockVector> sol;
+
+    /// Solver work vectors per level, created on first use
+    std::vector<std::unique_ptr<SolverWorkspace>> solver;
+
+    /// Mixed form vectors per level and right hand side of multiple
+    /// right hand side solves, created on first use
+    std::vector<std::vector<BlockVector>> multi_rhs;
+    std::vector<std::vector<BlockVector>> multi_sol;
 };
 
+/**
+   @brief When RescaleSolver keeps the preconditioner of a level
+
+   Rebuilding the preconditioner, BoomerAMG in all solvers, usually
+   dominates the cost of RescaleSolver. For coefficients that do not change
+   too much, e.g. samples of a random field, the preconditioner built for
+   one coefficient can be kept for the next few at the cost of some
+   iterations. The default rebuilds every time.
+*/
+struct PrecReusePolicy
+{
+    /// Rebuild after keeping the preconditioner this many times,
+    /// 0 always rebuilds and a negative value never rebuilds
+    int max_reuse = 0;
+
+    /// Also rebuild once the last solve took more than this factor times the
+    /// iterations of the first solve with the preconditioner, 0 to disable
+    double max_iter_growth = 0.0;
+};
 
 /**
    @brief Use upscaling as operator
@@ -98,9 +168,29 @@ public:
     */
     GraphUpscale(const Graph& graph, const UpscaleParams& params = {});
 
+    /**
+       @brief Checkpoint Constructor
+
+       Loads a hierarchy written by Save, only the solvers are rebuilt.
+       Must be called with the same number of processors used to save.
+
+       @param comm the communicator the hierarchy was saved from
+       @param prefix checkpoint file prefix
+    */
+    GraphUpscale(MPI_Comm comm, const std::string& prefix);
+
     /// Default Destructor
     ~GraphUpscale() = default;
 
+    /**
+       @brief Write the hierarchy to a versioned binary checkpoint
+
+       Each processor writes its own file, prefix.<rank>.
+
+       @param prefix checkpoint file prefix
+    */
+    void Save(const std::string& prefix) const;
+
     /// Get global number of rows (vertex dofs)
     int GlobalRows() const;
 
@@ -111,11 +201,25 @@ public:
     void MakeSolver(int level);
     void MakeSolver(int level, MixedMatrix& mm);
 
-    /// Rescale solver w/ weights per aggregate
+    /// Rescale solver w/ weights per aggregate,
+    /// the preconditioner is kept according to the reuse policy
     void RescaleSolver(int level, const std::vector<double>& agg_weights);
     void RescaleSolver(int level, const std::vector<double>& agg_weights,
                        MixedMatrix& mm);
 
+    /**
+       @brief Recompute the hierarchy for new edge weights on the same graph
+
+       Reuses the graph topology and extraction plans of each coarsener.
+       With UpscaleParams::warm_start, the local eigensolvers are also
+       warm started from the previous hierarchy.
+       The graph must have the same vertex edge relation and distribution
+       as the one used to construct this object.
+
+       @param graph input graph with updated weights
+    */
+    void UpdateWeights(const Graph& graph);
+
     /// Wrapper for applying the upscaling, in linalgcpp terminology
     void Mult(const VectorView& x, VectorView y) const override;
     using linalgcpp::Operator::Mult;
@@ -124,8 +228,17 @@ public:
     std::vector<BlockVector> MultMultiLevel(const BlockVector& x) const;
 
     void MultMultiGrid(const BlockVector& x, BlockVector& y) const;
+    void MultMultiGrid(const BlockVector& x, BlockVector& y, UpscaleWorkspace& work) const;
     BlockVector MultMultiGrid(const BlockVector& x) const;
 
+    /**
+       @brief Create work vectors for the methods below that take a workspace
+
+       Methods without a workspace argument create temporary work vectors
+       on each call, so are also safe to call from several threads at once.
+    */
+    UpscaleWorkspace MakeWorkspace() const;
+
     /// Wrapper for applying the upscaling
     void Solve(const VectorView& x, VectorView y) const;
     Vector Solve(const VectorView& x) const;
@@ -136,34 +249,62 @@ public:
 
     /// Upscaled Solution from Level
     void Solve(int level, const VectorView& x, VectorView y) const;
+    void Solve(int level, const VectorView& x, VectorView y, UpscaleWorkspace& work) const;
     Vector Solve(int level, const VectorView& x) const;
 
     /// Upscaled Solution from Level, in mixed form
     void Solve(int level, const BlockVector& x, BlockVector& y) const;
+    void Solve(int level, const BlockVector& x, BlockVector& y, UpscaleWorkspace& work) const;
     BlockVector Solve(int level, const BlockVector& x) const;
 
+    /// Solve on a given level in mixed form, starting from an initial guess
+    /// on the fine level that is projected to the solve level
+    void Solve(int level, const BlockVector& x, BlockVector& y,
+               const BlockVector& initial_guess) const;
+    void Solve(int level, const BlockVector& x, BlockVector& y,
+               const BlockVector& initial_guess, UpscaleWorkspace& work) const;
+
+    /// Solve several right hand sides at once on a given level, in mixed form
+    void Solve(int level, const std::vector<BlockVector>& x,
+               std::vector<BlockVector>& y) const;
+    void Solve(int level, const std::vector<BlockVector>& x,
+               std::vector<BlockVector>& y, UpscaleWorkspace& work) const;
+
     /// Solve Level only, no restriction/interpolate
     void SolveLevel(int level, const VectorView& x, VectorView y) const;
+    void SolveLevel(int level, const VectorView& x, VectorView y, UpscaleWorkspace& work) const;
     Vector SolveLevel(int level, const VectorView& x) const;
 
     /// Solve Level only, in mixed form
     void SolveLevel(int level, const BlockVector& x, BlockVector& y) const;
+    void SolveLevel(int level, const BlockVector& x, BlockVector& y,
+                    UpscaleWorkspace& work) const;
     BlockVector SolveLevel(int level, const BlockVector& x) const;
 
+    /// Solve Level only, in mixed form, starting from an initial guess on that level
+    void SolveLevel(int level, const BlockVector& x, BlockVector& y,
+                    const BlockVector& initial_guess) const;
+    void SolveLevel(int level, const BlockVector& x, BlockVector& y,
+                    const BlockVector& initial_guess, UpscaleWorkspace& work) const;
+
     /// Interpolate a coarse vector to the fine level
     void Interpolate(const VectorView& x, VectorView y) const;
+    void Interpolate(const VectorView& x, VectorView y, UpscaleWorkspace& work) const;
     Vector Interpolate(const VectorView& x, int level = 0) const;
 
     /// Interpolate a coarse vector to the fine level, in mixed form
     void Interpolate(const BlockVector& x, BlockVector& y) const;
+    void Interpolate(const BlockVector& x, BlockVector& y, UpscaleWorkspace& work) const;
     BlockVector Interpolate(const BlockVector& x, int level = 0) const;
 
     /// Restrict a fine vector to the coarse level
     void Restrict(const VectorView& x, VectorView y) const;
+    void Restrict(const VectorView& x, VectorView y, UpscaleWorkspace& work) const;
     Vector Restrict(const VectorView& x, int level = 1) const;
 
     /// Restrict a fine vector to the coarse level, in mixed form
     void Restrict(const BlockVector& x, BlockVector& y) const;
+    void Restrict(const BlockVector& x, BlockVector& y, UpscaleWorkspace& work) const;
     BlockVector Restrict(const BlockVector& x, int level = 1) const;
 
     /// Project a fine vector to the coarse level, in mixed form
@@ -209,6 +350,15 @@ public:
     void SetRelTol(double rtol);
     void SetAbsTol(double atol);
 
+    /// Solve the level with pipelined CG, kept when the solver is remade
+    void SetPipelinedCG(int level, bool pipelined_cg);
+
+    /// Set when RescaleSolver keeps the preconditioner
+    void SetPrecReuse(const PrecReusePolicy& policy) { prec_reuse_policy_ = policy; }
+
+    /// Number of preconditioners built on the level by MakeSolver and RescaleSolver
+    int NumPrecBuilds(int level) const;
+
     /// Show Total Solve time on the coarse level on processor 0
     void ShowCoarseSolveInfo(std::ostream& out = std::cout) const;
 
@@ -265,6 +415,26 @@ public:
     bool Orthogonalization() const { return do_ortho_; }
 
 private:
+    void InitWorkspace(UpscaleWorkspace& work) const;
+    SolverWorkspace& GetSolverWorkspace(int level, UpscaleWorkspace& work) const;
+    std::vector<BlockVector>& GetMultiVectors(int level, int num_rhs,
+                                              std::vector<std::vector<BlockVector>>& vects) const;
+
+    // Decide if RescaleSolver rebuilds the preconditioner and update the counts
+    bool RebuildPrec(int level);
+
+    // Times the preconditioner of a level was kept since it was built, the
+    // iterations of the first solve with it, or -1 if unknown, and total builds
+    struct PrecReuseState
+    {
+        int num_reuse = 0;
+        int base_iters = -1;
+        int num_builds = 0;
+    };
+
+    PrecReusePolicy prec_reuse_policy_;
+    std::vector<PrecReuseState> prec_reuse_;
+
     std::vector<Level> levels_;
     std::vector<GraphCoarsen> coarsener_;
 
@@ -276,7 +446,14 @@ private:
     std::unordered_map<int, int> size_to_level_;
 
     bool hybridization_;
+    bool hybrid_single_precision_ = false;
+    bool multigrid_ = false;
+    MultigridParams multigrid_params_;
     bool do_ortho_;
+
+    std::vector<bool> pipelined_cg_;
+
+    bool verbose_ = true;
 };
 
 } // namespace gauss
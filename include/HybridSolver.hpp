@@ -73,6 +73,12 @@ namespace gauss
 
    Each constraint in turn creates a dual variable (Lagrange multiplier).
    The construction is done locally in each element.
+
+   The element matrices can be stored in single precision, which halves
+   their memory and the memory traffic of the transform and recovery. The
+   solution is then corrected by iterative refinement on the original
+   system, with residuals computed from the lower triangles of the element
+   matrices of M, which are kept in double precision for this purpose.
 */
 class HybridSolver : public MGLSolver
 {
@@ -81,16 +87,49 @@ public:
        @brief Constructor for hybridiziation solver.
 
        @param mgL Mixed matrices for the graph Laplacian
+       @param graph_space Graph space of the mixed matrices
+       @param single_precision store the element matrices in single precision
     */
-    HybridSolver(const MixedMatrix& mgL, const GraphSpace& graph_space);
+    HybridSolver(const MixedMatrix& mgL, const GraphSpace& graph_space,
+                 bool single_precision = false);
 
     virtual ~HybridSolver() = default;
 
+    /// Create work vectors for solves with this solver
+    std::unique_ptr<SolverWorkspace> MakeWorkspace() const override;
+
     /// Wrapper for solving the saddle point system through hybridization
-    void Solve(const BlockVector& Rhs, BlockVector& Sol) const override;
+    void Solve(const BlockVector& Rhs, BlockVector& Sol,
+               SolverWorkspace& work) const override;
+
+    /**
+       @brief Solve through hybridization from an initial iterate
+
+       The initial multiplier is the least squares fit of the element
+       recovery to the initial guess, averaged over shared multipliers.
+       It is exact when the initial guess is a recovered solution.
+    */
+    void Solve(const BlockVector& Rhs, BlockVector& Sol,
+               const BlockVector& initial_guess, SolverWorkspace& work) const override;
+
+    /// Batched CG on the hybridized system for several right hand sides
+    void Solve(const std::vector<BlockVector>& Rhs,
+               std::vector<BlockVector>& Sol) const override;
 
-    /// Transform original RHS to the RHS of the hybridized system
-    void RHSTransform(const BlockVector& OriginalRHS, VectorView HybridRHS) const;
+    using MGLSolver::Solve;
+
+    /**
+       @brief Transform original RHS to the RHS of the hybridized system
+
+       Saves the element solutions needed by RecoverOriginalSolution
+       in the workspace, which must then be given to the recovery.
+
+       @param OriginalRHS right hand side of the original system
+       @param HybridRHS right hand side of the hybridized system
+       @param work Work vectors from MakeWorkspace
+    */
+    void RHSTransform(const BlockVector& OriginalRHS, VectorView HybridRHS,
+                      SolverWorkspace& work) const;
 
     /**
        @brief Recover the solution of the original system from multiplier \f$ \mu \f$.
@@ -107,40 +146,112 @@ public:
        This procedure is done locally in each element
 
        This function assumes the offsets of RecoveredSol have been defined
+
+       @param HybridSol multiplier \f$ \mu \f$
+       @param RecoveredSol solution of the original system
+       @param work Workspace given to the RHSTransform of the same right hand side
     */
-    void RecoverOriginalSolution(const VectorView& HybridSol,
-                                 BlockVector& RecoveredSol) const;
+    void RecoverOriginalSolution(const VectorView& HybridSol, BlockVector& RecoveredSol,
+                                 SolverWorkspace& work) const;
 
     /**
        @brief Update weights of local M matrices on aggregates
        @param agg_weights weights per aggregate
+       @param rebuild_prec rebuild the preconditioner, or keep the one
+              built for earlier weights
 
        @todo when W is non-zero, Aloc and Hybrid_el need to be recomputed
     */
-    void UpdateAggScaling(const std::vector<double>& agg_weight);
+    void UpdateAggScaling(const std::vector<double>& agg_weight, bool rebuild_prec = true);
+
+    /// Number of local Lagrange multipliers, the size of the hybridized system
+    int NumMultiplierDofs() const { return num_multiplier_dofs_; }
+
+    /// Check if the element matrices are stored in single precision
+    bool SinglePrecision() const { return single_precision_; }
 
-    ///@name Set solver parameters
-    ///@{
-    virtual void SetPrintLevel(int print_level) override;
-    virtual void SetMaxIter(int max_num_iter) override;
-    virtual void SetRelTol(double rtol) override;
-    virtual void SetAbsTol(double atol) override;
-    ///@}
+    /// Local memory used by the element matrices, in bytes
+    long long ElemBytes() const;
 
 private:
+    struct Workspace;
 
     SparseMatrix AssembleHybridSystem(const MixedMatrix& mgl,
                                       const std::vector<int>& j_multiplier_edgedof);
 
+    SparseMatrix AssembleElements(const std::vector<double>& agg_weight) const;
+
     SparseMatrix MakeEdgeDofMultiplier() const;
 
     SparseMatrix MakeLocalC(int agg, const ParMatrix& edge_true_edge,
                             const std::vector<int>& j_multiplier_edgedof,
-                            std::vector<int>& edge_map,
-                            std::vector<bool>& edge_marker) const;
+                            const std::vector<int>& edgedof_first_agg,
+                            std::vector<int>& edge_map) const;
 
     void CountEdgeDofs();
-    void InitSolver(SparseMatrix local_hybrid);
+    void PackOffsets();
+    void PackM(const MixedMatrix& mgl);
+    void ColorAggregates();
+    void ResizeWork(std::vector<double>& work) const;
+
+    // Element solutions [M B^T;B 0]^-1[f;g] saved by the transform for recovery,
+    // packed by aggregate using the offsets of agg_vertexdof_ and agg_edgedof_
+    struct ElemSolution
+    {
+        std::vector<double> Ainv_f;
+        std::vector<double> Minv_g;
+        std::vector<double> AinvDMinv_g;
+    };
+
+    ElemSolution MakeElemSolution() const;
+
+    void RHSTransform(const BlockVector& OriginalRHS, VectorView HybridRHS,
+                      ElemSolution& elem_sol, std::vector<double>& work) const;
+    void RecoverOriginalSolution(const VectorView& HybridSol, BlockVector& RecoveredSol,
+                                 const ElemSolution& elem_sol,
+                                 std::vector<double>& work) const;
+
+    // Multiply by the diagonal scaling of the hybridized system, if any
+    void Rescale(VectorView vect) const;
+
+    // Transform the right hand side to true multiplier dofs in the workspace
+    void TrueRHS(const BlockVector& Rhs, Workspace& work) const;
+
+    // Solve for the multiplier from the initial one in the workspace and recover
+    void SolveMultiplier(BlockVector& Sol, Workspace& work) const;
+
+    // Batched solve on the hybridized system, without refinement
+    void SolveBatched(const std::vector<BlockVector>& Rhs,
+                      std::vector<BlockVector>& Sol) const;
+
+    // Iterative refinement of a solution from single precision elements
+    void Refine(const BlockVector& Rhs, BlockVector& Sol, Workspace& work) const;
+
+    // Residual of the original system in double precision, in the same form
+    // as the right hand side, returns its global norm
+    double Residual(const BlockVector& Rhs, const BlockVector& Sol,
+                    BlockVector& resid, std::vector<double>& work) const;
+
+    // Initial true multiplier from an initial guess of the original system
+    void InitialMultiplier(const BlockVector& initial_guess, Workspace& work) const;
+    template <typename T>
+    void InitialMultiplier(int agg, const T* elem, const BlockVector& initial_guess,
+                           const ElemSolution& elem_sol,
+                           VectorView mu, VectorView null_mu,
+                           DenseMatrix& normal, DenseMatrix& normal_inv,
+                           double* work) const;
+
+    // Element level transform and recovery of a single aggregate,
+    // from its packed element matrices in double or single precision
+    template <typename T>
+    void RHSTransform(int agg, const T* elem, const BlockVector& OriginalRHS,
+                      VectorView HybridRHS, ElemSolution& elem_sol, double* work) const;
+    template <typename T>
+    void RecoverOriginalSolution(int agg, const T* elem, const VectorView& HybridSol,
+                                 BlockVector& RecoveredSol,
+                                 const ElemSolution& elem_sol, double* work) const;
+
+    void InitSolver(SparseMatrix local_hybrid, bool rebuild_prec = true);
 
     ParMatrix ComputeScaledSystem(const ParMatrix& hybrid_d);
 
@@ -148,6 +259,9 @@ private:
     SparseMatrix agg_edgedof_;
     SparseMatrix agg_multiplier_;
 
+    // Sparsity pattern of the local hybridized system, fixed by the graph
+    SparseMatrix hybrid_pattern_;
+
     int num_aggs_;
     int num_edge_dofs_;
     int num_multiplier_dofs_;
@@ -156,27 +270,46 @@ private:
 
     ParMatrix pHybridSystem_;
 
-    linalgcpp::PCGSolver cg_;
     linalgcpp::BoomerAMG prec_;
+    bool use_prec_;
 
-    std::vector<DenseMatrix> Minv_;
-    std::vector<DenseMatrix> MinvDT_;
-    std::vector<DenseMatrix> MinvCT_;
-    std::vector<DenseMatrix> AinvDMinvCT_;
-    std::vector<DenseMatrix> Ainv_;
-    std::vector<DenseMatrix> hybrid_elem_;
+    bool single_precision_;
 
-    mutable std::vector<Vector> Ainv_f_;
-    mutable std::vector<Vector> Minv_g_;
-    mutable std::vector<Vector> AinvDMinv_g_;
+    // Hybridized element matrices, or packed column major
+    // into a single arena when stored in single precision
+    std::vector<DenseMatrix> hybrid_elem_;
+    std::vector<int> hybrid_offsets_;
+    std::vector<float> hybrid_data_single_;
+
+    // Element matrices Minv, MinvDT, MinvCT, AinvDMinvCT and Ainv
+    // of each aggregate, packed column major into a single arena
+    // of the precision they are stored in
+    std::vector<int> elem_offsets_;
+    std::vector<double> elem_data_;
+    std::vector<float> elem_data_single_;
+
+    // Original system for the residuals of iterative refinement, lower
+    // triangles of the element matrices of M, or only their diagonals
+    bool diagonal_M_;
+    std::vector<int> M_offsets_;
+    std::vector<double> M_data_;
+    SparseMatrix D_local_;
+    SparseMatrix W_local_;
+
+    int max_vertexdof_;
+    int max_edgedof_;
+    int max_multiplier_;
+
+    // Aggregates grouped by color, no two aggregates
+    // of the same color share an edge dof
+    SparseMatrix color_agg_;
+
+    // Local work space per thread, sized for the largest aggregate
+    int work_stride_;
 
     std::vector<int> edgedof_count_;
     std::vector<double> agg_weights_;
 
-    mutable Vector trueHrhs_;
-    mutable Vector trueMu_;
-    mutable Vector Hrhs_;
-    mutable Vector Mu_;
     mutable std::vector<double> diag_scaling_;
 
     int rescale_iter_;
@@ -48,8 +48,6 @@ struct Level
     Vector constant_rep;
 
     std::unique_ptr<MGLSolver> solver;
-    mutable BlockVector rhs;
-    mutable BlockVector sol;
 
     std::vector<int> edge_elim_dofs;
 };
@@ -68,7 +66,6 @@ Level::Level(MixedMatrix mm, GraphSpace gs, Vector const_vect,
              bool assemble_M, std::vector<int> elim_dofs_in)
     : mixed_matrix(std::move(mm)), graph_space(std::move(gs)),
       constant_rep(std::move(const_vect)),
-      rhs(mixed_matrix.Offsets()), sol(mixed_matrix.Offsets()),
       edge_elim_dofs(std::move(elim_dofs_in))
 {
     if (assemble_M)
@@ -16,7 +16,8 @@
 /** @file LocalEigenSolver.hpp
 
     @brief Wrapper for LAPACK and ARPACK (via arpackpp), solving (generalized)
-    eigenproblem of symmetric matrices.
+    eigenproblem of symmetric matrices. Without ARPACK, large block problems
+    are solved by a built-in matrix-free LOBPCG.
 
    ARPACK implementation is based on
    https://perso.univ-rennes1.fr/yvon.lafranche/mintera/index.html
@@ -44,9 +45,12 @@ public:
        @param rel_tol (in) relative tolerance for eigenvalues, only eigenvectors
               corresponding to eigenvalues < rel_tol * eig_max will be computed,
               up to max_num_evects total.
-       @param size_offset size offset for decision on dense or sparse solver
+       @param size_offset size offset for decision on dense or ARPACK solver
+       @param iterative_size size above which BlockCompute uses the
+              matrix-free iterative solver when ARPACK is not available
     */
-    LocalEigenSolver(int max_num_evects, double rel_tol, int size_offset = 20);
+    LocalEigenSolver(int max_num_evects, double rel_tol, int size_offset = 20,
+                     int iterative_size = 1000);
 
     /**
        Given a symmetric matrix \f$ A \f$, find the eigenpairs
@@ -85,7 +89,57 @@ public:
     */
     double Compute(SparseMatrix& A, DenseMatrix& evects);
 
-    double BlockCompute(SparseMatrix M, SparseMatrix D, DenseMatrix& evects);
+    /**
+       Given \f$ M, D \f$, find the eigenvectors of \f$ D M^{-1} D^T \f$
+       corresponding to the smallest few eigenvalues.
+
+       Given initial_evects, a matrix-free LOBPCG solver that never forms
+       \f$ D M^{-1} D^T \f$ starts from them, unless D has fewer than three
+       rows per eigenvector, when the LAPACK-based solver is used instead.
+
+       Without initial_evects, if GAUSS_USE_ARPACK is on, the ARPACK-based
+       solver is used when the size of D > size_offset_. Otherwise LOBPCG
+       is used when the size of D > iterative_size_, which by default only
+       the few largest aggregates reach. Smaller problems use the
+       LAPACK-based solver.
+       On every path, each eigenvector is signed so its largest entry is
+       positive.
+
+       @param M (in) edge mass matrix
+       @param D (in) vertex edge matrix
+       @param evects (out) eigenvectors
+       @param initial_evects (in) optional initial guess for the iterative
+              solver, e.g. eigenvectors of a previous, similar problem
+       @return smallest eigenvalue
+    */
+    double BlockCompute(SparseMatrix M, SparseMatrix D, DenseMatrix& evects,
+                        const DenseMatrix& initial_evects = DenseMatrix());
+
+    /**
+       Batched version of BlockCompute for many small problems.
+
+       Dense problems are bucketed by size and groups of batch_width_
+       problems of the same size are solved together by a cyclic Jacobi
+       kernel that is interleaved across the group, so the inner loops
+       vectorize over the problems. The number of eigenvectors kept for
+       each problem is chosen as in the single problem case.
+
+       Jacobi computes the full spectrum, so it only pays off for small
+       matrices and breaks even with LAPACK around 14 rows, see
+       eigen_benchmark. Problems larger than batch_max_size_, 14 rows, are
+       solved one at a time as in BlockCompute, as are problems larger than
+       size_offset_ with GAUSS_USE_ARPACK on.
+
+       @param M (in) edge mass matrix of each problem
+       @param D (in) vertex edge matrix of each problem
+       @param evects (out) eigenvectors of each problem
+       @param initial_evects (in) optional initial guesses of each problem,
+              problems with one are solved one at a time from it
+    */
+    void BlockCompute(const std::vector<SparseMatrix>& M,
+                      const std::vector<SparseMatrix>& D,
+                      std::vector<DenseMatrix>& evects,
+                      const std::vector<DenseMatrix>& initial_evects = {});
 
     /**
        Given symmetric matrices \f$ A, B \f$, find the eigenvectors
@@ -102,6 +156,14 @@ public:
     */
     double Compute(SparseMatrix& A, SparseMatrix& B, DenseMatrix& evects);
 
+    /// Number of problems solved by an iterative solver, including batched
+    /// Jacobi, whose eigenvectors did not converge, over all calls. Nothing is printed, so solvers
+    /// can run inside threaded loops and the caller reports the total.
+    int NumNotConverged() const { return num_not_converged_; }
+
+    /// Number of problems solved by LOBPCG from an initial guess, over all calls
+    int NumWarmStarted() const { return num_warm_started_; }
+
     ~LocalEigenSolver() = default;
 private:
     // Allocate workspace for LAPACK
@@ -127,9 +189,27 @@ private:
     void DenseBlockCompute(const SparseMatrix& M, const SparseMatrix& D, std::vector<double>& evals,
                            DenseMatrix& evects);
 
+    // Matrix-free LOBPCG on D M^{-1} D^T, used for large problems without ARPACK
+    void IterativeBlockCompute(const SparseMatrix& M, const SparseMatrix& D,
+                               std::vector<double>& evals, DenseMatrix& evects,
+                               const DenseMatrix& initial_evects);
+
+    // Forms D M^{-1} D^T in DMinvDT_
+    void FormDMinvDT(const SparseMatrix& M, const SparseMatrix& D);
+
+    // Solves the problems in ids, all of size n, as one interleaved batch
+    void BatchedDenseCompute(int n, const std::vector<int>& ids,
+                             const std::vector<SparseMatrix>& M,
+                             const std::vector<SparseMatrix>& D,
+                             std::vector<DenseMatrix>& evects);
+
     int max_num_evects_;
     double rel_tol_;
     int size_offset_;
+    int iterative_size_;
+
+    int num_not_converged_;
+    int num_warm_started_;
 
     std::vector<double> evals_;
     DenseMatrix dense_A_;
@@ -172,6 +252,19 @@ private:
     std::vector<int> ifail_;
     ///@}
 
+    ///@name Batched Jacobi parameters and workspace
+    ///@{
+    const int batch_width_;
+    const int batch_max_size_;
+    const int max_sweeps_;
+
+    std::vector<double> A_batch_;
+    std::vector<double> V_batch_;
+    std::vector<double> rot_c_;
+    std::vector<double> rot_s_;
+    std::vector<int> order_;
+    ///@}
+
     ///@name ARPACK parameters
     ///@{
     const int num_arnoldi_vectors_;
@@ -22,12 +22,42 @@
 #ifndef __MGLSOLVER_HPP__
 #define __MGLSOLVER_HPP__
 
+#include <atomic>
+#include <memory>
+#include <mutex>
+
 #include "Utilities.hpp"
 #include "MixedMatrix.hpp"
+#include "BatchedKrylov.hpp"
 
 namespace gauss
 {
 
+/**
+   @brief Work vectors and results of a single solve
+
+   A solve only writes into the workspace it is given, so several threads
+   can solve with the same solver at once, each with its own workspace.
+   Solvers derive from this to add their own work vectors, so a workspace
+   must come from MakeWorkspace of the solver it is used with.
+*/
+struct SolverWorkspace
+{
+    SolverWorkspace() = default;
+    SolverWorkspace(const std::vector<int>& offsets)
+        : rhs(offsets), sol(offsets) { }
+
+    virtual ~SolverWorkspace() = default;
+
+    /// Mixed form vectors used by the primal solve
+    BlockVector rhs;
+    BlockVector sol;
+
+    /// Results of the last solve with this workspace
+    int num_iterations = 0;
+    double timing = 0.0;
+};
+
 /**
    @brief Abstract base class for solvers of graph Laplacian problems
 */
@@ -51,6 +81,9 @@ public:
     /** @brief Default Destructor */
     virtual ~MGLSolver() = default;
 
+    /** @brief Create work vectors for solves with this solver */
+    virtual std::unique_ptr<SolverWorkspace> MakeWorkspace() const;
+
     /**
        @brief Solve the graph Laplacian problem in mixed form
 
@@ -58,13 +91,54 @@ public:
        That is, dofs on processor boundaries are *repeated* in the vectors that
        come into and go out of this method.
 
+       Safe to call from several threads at once, if each has its own workspace.
+
+       @param rhs Right hand side
+       @param sol Solution
+       @param work Work vectors from MakeWorkspace
+    */
+    virtual void Solve(const BlockVector& rhs, BlockVector& sol,
+                       SolverWorkspace& work) const = 0;
+
+    /** @brief Solve in mixed form with temporary work vectors */
+    void Solve(const BlockVector& rhs, BlockVector& sol) const;
+
+    /**
+       @brief Solve the graph Laplacian problem in mixed form,
+              starting from a given initial iterate
+
+       Without W the solution is only unique up to a constant, which the
+       solvers fix by pinning their first dof. The initial guess is shifted
+       by the constant representation to match before the solve.
+
        @param rhs Right hand side
        @param sol Solution
+       @param initial_guess Initial iterate, in the same form as sol
+       @param work Work vectors from MakeWorkspace
     */
-    virtual void Solve(const BlockVector& rhs, BlockVector& sol) const = 0;
+    virtual void Solve(const BlockVector& rhs, BlockVector& sol,
+                       const BlockVector& initial_guess, SolverWorkspace& work) const;
+
+    /** @brief Solve in mixed form from an initial iterate with temporary work vectors */
+    void Solve(const BlockVector& rhs, BlockVector& sol,
+               const BlockVector& initial_guess) const;
     virtual void Mult(const BlockVector& rhs, BlockVector& sol) const;
     virtual BlockVector Mult(const BlockVector& rhs) const;
 
+    /**
+       @brief Solve the graph Laplacian problem in mixed form
+              for several right hand sides at once
+
+       The default solves one right hand side at a time. Solvers that
+       override this run a batched Krylov method, sharing the global
+       reductions of every iteration across right hand sides.
+
+       @param rhs Right hand sides
+       @param sol Solutions, also used as initial guesses
+    */
+    virtual void Solve(const std::vector<BlockVector>& rhs,
+                       std::vector<BlockVector>& sol) const;
+
     /**
        @brief Solve the graph Laplacian problem as primal.
               Only vertex data is used, edge vectors are not considered.
@@ -73,20 +147,33 @@ public:
        @param sol Solution
     */
     virtual void Solve(const VectorView& rhs, VectorView sol) const;
+    virtual void Solve(const VectorView& rhs, VectorView sol, SolverWorkspace& work) const;
     virtual void Mult(const VectorView& rhs, VectorView sol) const;
     virtual Vector Mult(const VectorView& rhs) const;
 
     using linalgcpp::Operator::Mult;
 
+    /**
+       @brief Set the representation of the constant vector on this level,
+              the null space of the vertex block when there is no W
+
+       Only used to match initial guesses to the pinned solution,
+       defaults to all ones as on the fine level.
+    */
+    void SetConstantRep(const VectorView& constant_rep);
+
     ///@name Set solver parameters
     ///@{
     virtual void SetPrintLevel(int print_level) { print_level_ = print_level; }
     virtual void SetMaxIter(int max_num_iter) { max_num_iter_ = max_num_iter; }
     virtual void SetRelTol(double rtol) { rtol_ = rtol; }
     virtual void SetAbsTol(double atol) { atol_ = atol; }
+
+    /// Use pipelined CG, see BatchedPipelinedPCG, in solvers that run CG
+    virtual void SetPipelinedCG(bool pipelined_cg) { pipelined_cg_ = pipelined_cg; }
     ///@}
 
-    ///@name Get results of iterative solve
+    ///@name Get results of the last iterative solve, from any thread
     ///@{
     virtual int GetNumIterations() const { return num_iterations_; }
     virtual int GetNNZ() const { return nnz_; }
@@ -94,22 +181,37 @@ public:
     ///@}
 
 protected:
+    // Shift the vertex part of an initial guess by a multiple of the
+    // constant representation, so its first dof is zero as in the solution
+    void PinInitialGuess(VectorView vertex_guess) const;
+
+    // Run standard or pipelined CG with the solver options,
+    // returns the number of iterations
+    int PCG(const linalgcpp::Operator& A, const linalgcpp::Operator* M,
+            const std::vector<Vector>& b, std::vector<Vector>& x) const;
+
     MPI_Comm comm_;
     int myid_;
     bool use_w_;
 
-    mutable BlockVector rhs_;
-    mutable BlockVector sol_;
+    std::vector<int> offsets_;
+
+    // Constant representation of the vertex space, empty for all ones
+    Vector constant_rep_;
 
     // default linear solver options
     int print_level_ = 0;
     int max_num_iter_ = 5000;
     double rtol_ = 1e-9;
     double atol_ = 1e-12;
+    bool pipelined_cg_ = false;
 
     int nnz_ = 0;
-    mutable int num_iterations_ = 0;
-    mutable double timing_ = 0;
+    mutable std::atomic<int> num_iterations_{0};
+    mutable std::atomic<double> timing_{0.0};
+
+    // Guards operators that cannot be applied by several threads at once
+    mutable std::mutex prec_mutex_;
 };
 
 } // namespace gauss
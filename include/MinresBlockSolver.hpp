@@ -87,19 +87,33 @@ public:
     /** @brief Default Destructor */
     ~MinresBlockSolver() noexcept = default;
 
+    /** @brief Create work vectors for solves with this solver */
+    std::unique_ptr<SolverWorkspace> MakeWorkspace() const override;
+
     /** @brief Use block-preconditioned MINRES to solve the problem.
         @param rhs Right hand side
-        @param sol Solution
+        @param sol Solution, also used as initial guess
+        @param work Work vectors from MakeWorkspace
+    */
+    void Solve(const BlockVector& rhs, BlockVector& sol,
+               SolverWorkspace& work) const override;
+
+    /** @brief Use batched block-preconditioned MINRES to solve
+               for several right hand sides.
+        @param rhs Right hand sides
+        @param sol Solutions, also used as initial guesses
     */
-    void Solve(const BlockVector& rhs, BlockVector& sol) const override;
+    void Solve(const std::vector<BlockVector>& rhs,
+               std::vector<BlockVector>& sol) const override;
 
-    ///@name Set solver parameters
-    ///@{
-    virtual void SetPrintLevel(int print_level) override;
-    virtual void SetMaxIter(int max_num_iter) override;
-    virtual void SetRelTol(double rtol) override;
-    virtual void SetAbsTol(double atol) override;
-    ///@}
+    using MGLSolver::Solve;
+
+    /** @brief Reassemble the operator for new coefficients on the same graph
+        @param mgl mixed matrix with the new coefficients
+        @param rebuild_prec rebuild the Schur complement preconditioner,
+               or keep the one built for earlier coefficients
+    */
+    void UpdateOperator(const MixedMatrix& mgl, bool rebuild_prec = true);
 
 protected:
 
@@ -117,10 +131,18 @@ private:
     linalgcpp::ParDiagScale M_prec_;
     linalgcpp::BoomerAMG schur_prec_;
 
-    linalgcpp::PMINRESSolver pminres_;
+    std::vector<int> true_offsets_;
+    std::vector<int> elim_dofs_;
+
+    struct Workspace;
+
+    // Assemble the blocks and diagonal preconditioner, returns the Schur complement
+    ParMatrix AssembleOperator(const MixedMatrix& mgl);
 
-    mutable BlockVector true_rhs_;
-    mutable BlockVector true_sol_;
+    // Copy to and from true dofs, the true vectors are ordered as true_offsets_
+    void ToTrue(const BlockVector& rhs, const BlockVector& sol,
+                Vector& true_rhs, Vector& true_sol) const;
+    void FromTrue(Vector& true_sol, BlockVector& sol) const;
 };
 
 
@@ -46,6 +46,9 @@ public:
         @param graph Global graph information
         @param global_weight Global edge weights
         @param W_global optional global W block
+
+        The element matrices of a graph are diagonal,
+        so only their diagonal is stored.
     */
     MixedMatrix(const Graph& graph);
 
@@ -60,6 +63,17 @@ public:
                 SparseMatrix D_local, SparseMatrix W_local,
                 ParMatrix edge_true_edge);
 
+    /** @brief Constructor with given local matrices and diagonal element matrices
+        @param M_elem_diag Diagonal entry of the element matrices on each edge
+        @param elem_dof element to dof relationship
+        @param D_local Local D
+        @param W_local Local W
+        @param edge_true_edge Edge to true edge relationship
+    */
+    MixedMatrix(std::vector<double> M_elem_diag, SparseMatrix elem_dof,
+                SparseMatrix D_local, SparseMatrix W_local,
+                ParMatrix edge_true_edge);
+
     /** @brief Default Destructor */
     virtual ~MixedMatrix() noexcept = default;
 
@@ -80,12 +94,33 @@ public:
 
     /** @brief Assemble scaled M from element matrices
         @param agg_weight weights per aggregate
+
+        The sparsity pattern of M is built on the first call,
+        later calls only rewrite its values.
     */
     void AssembleM(const std::vector<double>& agg_weight);
 
-    /** @brief Access element matrices */
+    /** @brief Access element matrices, empty if M is diagonal */
     const std::vector<DenseMatrix>& GetElemM() const { return M_elem_; }
 
+    /** @brief Access diagonal element matrices, empty if M is not diagonal */
+    const std::vector<double>& GetElemMDiag() const { return M_elem_diag_; }
+
+    /** @brief Get a single element matrix, for either storage
+        @param elem element number
+        @param M_elem element matrix
+    */
+    void GetElemM(int elem, DenseMatrix& M_elem) const;
+
+    /** @brief Check if the element matrices are stored by their diagonal */
+    bool IsDiagonalM() const { return !M_elem_diag_.empty(); }
+
+    /** @brief Local memory used by the element matrices, in bytes */
+    long long ElemMBytes() const;
+
+    /** @brief Local memory the element matrices would use as dense matrices, in bytes */
+    long long DenseElemMBytes() const;
+
     /** @brief Access element to dof relationship */
     const SparseMatrix& GetElemDof() const { return elem_dof_; }
 
@@ -152,6 +187,10 @@ public:
 protected:
     void Init();
 
+    void AssembleDiagonalM(const std::vector<double>& agg_weight);
+    void AssembleDenseM(const std::vector<double>& agg_weight);
+    void AssembleMPattern();
+
     ParMatrix edge_true_edge_;
 
     // Local blocks
@@ -170,6 +209,13 @@ protected:
     // Element information
     std::vector<DenseMatrix> M_elem_;
     SparseMatrix elem_dof_;
+
+    // Diagonal entry of the element matrices on each edge,
+    // used instead of M_elem_ on graph levels
+    std::vector<double> M_elem_diag_;
+
+    // Position of each element matrix entry in the data of M_local_
+    std::vector<int> M_elem_pos_;
 };
 
 } // namespace gauss
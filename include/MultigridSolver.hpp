@@ -0,0 +1,242 @@
+/*BHEADER**********************************************************************
+ *
+ * Copyright (c) 2018, Lawrence Livermore National Security, LLC.
+ * Produced at the Lawrence Livermore National Laboratory.
+ * LLNL-CODE-759464. All Rights reserved. See file COPYRIGHT for details.
+ *
+ * This file is part of GAUSS. For more information and source code
+ * availability, see https://www.github.com/gelever/GAUSS.
+ *
+ * GAUSS is free software; you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License (as published by the Free
+ * Software Foundation) version 2.1 dated February 1999.
+ *
+ ***********************************************************************EHEADER*/
+
+/**
+   @file MultigridSolver.hpp
+
+   @brief Given a hierarchy of graphs in mixed form, solve the fine level
+   system with FGMRES preconditioned by a multilevel V-cycle
+*/
+
+#ifndef MULTIGRIDSOLVER_HPP
+#define MULTIGRIDSOLVER_HPP
+
+#include <memory>
+#include <assert.h>
+
+#include "Utilities.hpp"
+#include "MixedMatrix.hpp"
+#include "MGLSolver.hpp"
+#include "GraphCoarsen.hpp"
+#include "HybridSolver.hpp"
+
+namespace gauss
+{
+
+/**
+   @brief Smoothers of the multilevel V-cycle
+
+   All smoothers are inexact Braess-Sarazin steps, with the l1 row sums of
+   M in place of M. They differ in the approximate inverse of the Schur
+   complement \f$ S = D \, \mathrm{diag}(M)_{l1}^{-1} D^T - W \f$:
+
+   - Jacobi: the l1 row sums of S
+   - Chebyshev: a Chebyshev polynomial in the l1 scaled S
+   - Schwarz: the blocks of S on the vertex dofs of each aggregate,
+     with the l1 row sums of the entries outside the block on the diagonal
+
+   Each is bounded by the inverse of S, so the steps do not need damping.
+*/
+enum class SmootherType { Jacobi, Chebyshev, Schwarz };
+
+/**
+   @brief Collection of parameters for MultigridSolver
+*/
+struct MultigridParams
+{
+    /// Smoother on all but the coarsest level
+    SmootherType smoother = SmootherType::Jacobi;
+
+    /// Number of smoothing steps before and after the coarse correction
+    int smooth_steps = 1;
+
+    /// Degree of the Chebyshev polynomial
+    int chebyshev_degree = 3;
+
+    /// Ratio of the largest to the smallest eigenvalue targeted by Chebyshev
+    double chebyshev_ratio = 30.0;
+
+    /// Relative tolerance of the coarsest level solve
+    double coarse_rel_tol = 1e-8;
+
+    /// Iterations between restarts of FGMRES
+    int restart = 50;
+};
+
+/**
+   @brief FGMRES solver for the fine level saddle point problem,
+   preconditioned by a V-cycle through the spectral hierarchy.
+
+   Given matrix M and D on each level, solve the fine level problem
+   \f[
+     \left( \begin{array}{cc}
+       M&  D^T \\
+       D&  -W
+     \end{array} \right)
+     \left( \begin{array}{c}
+       u \\ p
+     \end{array} \right)
+     =
+     \left( \begin{array}{c}
+       f \\ g
+     \end{array} \right)
+   \f]
+
+   The V-cycle smooths on each level, see SmootherType, and moves between
+   levels with the edge and vertex interpolations of the coarseners. The
+   coarsest level is solved by the hybridization solver. Since the coarse
+   spaces contain the local spectral modes of the weighted graph, the
+   number of iterations is meant to depend little on the contrast of the
+   edge weights.
+
+   The coarsest solve is iterative, so the V-cycle is not a fixed linear
+   operator and the outer iteration is flexible GMRES.
+*/
+class MultigridSolver : public MGLSolver
+{
+public:
+    /** @brief Constructor from a hierarchy
+        @param mgl fine level mixed matrix, used in place of that of levels[0]
+        @param levels hierarchy of at least two levels
+        @param coarseners coarseners between consecutive levels
+        @param params multigrid parameters
+    */
+    MultigridSolver(const MixedMatrix& mgl, const std::vector<Level>& levels,
+                    const std::vector<GraphCoarsen>& coarseners,
+                    const MultigridParams& params = {});
+
+    MultigridSolver(const MultigridSolver& other) = delete;
+    MultigridSolver& operator=(const MultigridSolver& other) = delete;
+
+    /** @brief Default Destructor */
+    ~MultigridSolver() noexcept = default;
+
+    /** @brief Create work vectors for solves with this solver */
+    std::unique_ptr<SolverWorkspace> MakeWorkspace() const override;
+
+    /** @brief Use V-cycle preconditioned FGMRES to solve the problem.
+        @param rhs Right hand side
+        @param sol Solution, also used as initial guess
+        @param work Work vectors from MakeWorkspace
+    */
+    void Solve(const BlockVector& rhs, BlockVector& sol,
+               SolverWorkspace& work) const override;
+
+    /** @brief Use batched FGMRES to solve for several right hand sides.
+        @param rhs Right hand sides
+        @param sol Solutions, also used as initial guesses
+    */
+    void Solve(const std::vector<BlockVector>& rhs,
+               std::vector<BlockVector>& sol) const override;
+
+    using MGLSolver::Solve;
+
+    /** @brief Reassemble the fine level for new coefficients on the same graph,
+               the coarse levels are kept
+        @param mgl mixed matrix with the new coefficients
+        @param rebuild_prec rebuild the fine level smoother, otherwise keep
+                            the smoother of the previous coefficients
+    */
+    void UpdateOperator(const MixedMatrix& mgl, bool rebuild_prec = true);
+
+    /// Number of levels of the V-cycle, including the coarsest
+    int NumLevels() const { return levels_.size() + 1; }
+
+private:
+    // Operators and smoother of a level, in true dofs
+    struct SmoothLevel
+    {
+        std::vector<int> true_offsets;
+        bool use_w;
+
+        ParMatrix M;
+        ParMatrix D;
+        ParMatrix DT;
+        ParMatrix W;
+        ParMatrix schur;
+
+        // Inverse l1 row sums of M and the Schur complement
+        std::vector<double> M_scale;
+        std::vector<double> schur_scale;
+
+        // Vertex dofs and inverse Schur complement blocks of the aggregates
+        SparseMatrix agg_vertexdof;
+        std::vector<DenseMatrix> schur_blocks;
+
+        // Interpolation from the next coarser level
+        ParMatrix P_edge;
+        SparseMatrix P_vertex;
+    };
+
+    struct Workspace;
+    class LevelOperator;
+    class VCycle;
+
+    // Operators and, if requested, smoother from a mixed matrix
+    void BuildLevel(const MixedMatrix& mgl, const std::vector<int>& elim_dofs,
+                    SmoothLevel& level, bool build_smoother = true) const;
+
+    // Smoother data that depends on the coefficients
+    void BuildSmoother(SmoothLevel& level) const;
+
+    // Interpolation of true dofs from the next coarser level
+    void BuildInterpolation(const MixedMatrix& mgl, const MixedMatrix& coarse_mgl,
+                            const GraphCoarsen& coarsener, SmoothLevel& level) const;
+
+    // y = A x on a level
+    void Mult(int level_i, const BlockVector& x, BlockVector& y, Workspace& work) const;
+
+    // Correction from an inexact Braess-Sarazin step on the level residual
+    void Smooth(int level_i, Workspace& work) const;
+
+    // Add the correction to the level solution, and optionally update the residual
+    void Correct(int level_i, Workspace& work, bool update_resid) const;
+
+    // Approximate inverse of the Schur complement on the level Schur residual
+    void SchurSolve(int level_i, Workspace& work) const;
+
+    // Solve the coarsest level, its rhs and sol are in true dofs
+    void CoarseSolve(Workspace& work) const;
+
+    // V-cycle from the given level down, its rhs and sol are in true dofs
+    void Cycle(int level_i, Workspace& work) const;
+
+    // Copy to and from true dofs, the true vectors are ordered as true_offsets
+    void ToTrue(const BlockVector& rhs, const BlockVector& sol,
+                Vector& true_rhs, Vector& true_sol) const;
+    void FromTrue(Vector& true_sol, BlockVector& sol) const;
+
+    MultigridParams params_;
+
+    // All levels but the coarsest
+    std::vector<SmoothLevel> levels_;
+
+    // Edge counts are the number of processors sharing each true edge
+    ParMatrix edge_true_edge_;
+    std::vector<double> edge_count_;
+
+    // Coarsest level, solved in local dofs
+    std::unique_ptr<HybridSolver> coarse_solver_;
+    ParMatrix coarse_edge_true_edge_;
+    std::vector<double> coarse_edge_count_;
+    std::vector<int> coarse_offsets_;
+    std::vector<int> coarse_true_offsets_;
+
+    std::vector<int> elim_dofs_;
+};
+
+} // namespace gauss
+
+#endif // MULTIGRIDSOLVER_HPP
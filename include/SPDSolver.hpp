@@ -84,19 +84,32 @@ public:
     /** @brief Default Destructor */
     ~SPDSolver() noexcept = default;
 
-    /** @brief Use block-preconditioned MINRES to solve the problem.
+    /** @brief Create work vectors for solves with this solver */
+    std::unique_ptr<SolverWorkspace> MakeWorkspace() const override;
+
+    /** @brief Use preconditioned CG to solve the problem.
         @param rhs Right hand side
         @param sol Solution
+        @param work Work vectors from MakeWorkspace
+    */
+    void Solve(const BlockVector& rhs, BlockVector& sol,
+               SolverWorkspace& work) const override;
+
+    /** @brief Use batched CG to solve for several right hand sides.
+        @param rhs Right hand sides
+        @param sol Solutions
     */
-    void Solve(const BlockVector& rhs, BlockVector& sol) const override;
+    void Solve(const std::vector<BlockVector>& rhs,
+               std::vector<BlockVector>& sol) const override;
 
-    ///@name Set solver parameters
-    ///@{
-    virtual void SetPrintLevel(int print_level) override;
-    virtual void SetMaxIter(int max_num_iter) override;
-    virtual void SetRelTol(double rtol) override;
-    virtual void SetAbsTol(double atol) override;
-    ///@}
+    using MGLSolver::Solve;
+
+    /** @brief Reassemble the operator for new coefficients on the same graph
+        @param mgl mixed matrix with the new coefficients
+        @param rebuild_prec rebuild the preconditioner, or keep the one
+               built for earlier coefficients
+    */
+    void UpdateOperator(const MixedMatrix& mgl, bool rebuild_prec = true);
 
     const ParMatrix& A() const { return A_; }
     const ParMatrix& Minv() const { return Minv_; }
@@ -108,8 +121,24 @@ protected:
     ParMatrix MinvDT_;
 
 private:
+    struct Workspace;
+
+    // Symbolic part, depends only on the graph
+    void AssemblePattern(const MixedMatrix& mgl);
+
+    // Numeric part, rescales the cached patterns by the current M
+    void AssembleOperator(const MixedMatrix& mgl);
+
+    void PrimalRHS(const BlockVector& rhs, VectorView primal_rhs, VectorView vertex_work) const;
+    void RecoverEdges(const BlockVector& rhs, BlockVector& sol, VectorView edge_work) const;
+
+    ParMatrix D_elim_;
+    ParMatrix edge_edge_;
+    ParMatrix edge_DT_;
+
+    std::vector<int> elim_dofs_;
+
     linalgcpp::BoomerAMG prec_;
-    linalgcpp::PCGSolver pcg_;
 };
 
 
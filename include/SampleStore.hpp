@@ -0,0 +1,187 @@
+/*BHEADER**********************************************************************
+ *
+ * Copyright (c) 2018, Lawrence Livermore National Security, LLC.
+ * Produced at the Lawrence Livermore National Laboratory.
+ * LLNL-CODE-759464. All Rights reserved. See file COPYRIGHT for details.
+ *
+ * This file is part of GAUSS. For more information and source code
+ * availability, see https://www.github.com/gelever/GAUSS.
+ *
+ * GAUSS is free software; you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License (as published by the Free
+ * Software Foundation) version 2.1 dated February 1999.
+ *
+ ***********************************************************************EHEADER*/
+
+/** @file SampleStore.hpp
+
+    @brief Binary store for the output vectors of a sampling run.
+
+    All samples of a run go into a single file. Each sample holds one
+    record per field, such as "fine_sol" or "coarse_coeff", and every record
+    is a global vector of the same size, so any record is found directly
+    from its sample id and field.
+
+    Values are stored in host byte order. The file starts with a header:
+
+        char[8]  magic "GAUSSSMP"
+        int32    format version
+        int32    number of fields
+        int64    global size of each record
+        char[32] name of each field, zero padded
+
+    followed by the records, in order of sample and then field:
+
+        float64  values[global size]
+*/
+
+#ifndef __SAMPLESTORE_HPP__
+#define __SAMPLESTORE_HPP__
+
+#include <algorithm>
+#include <fstream>
+
+#include "Utilities.hpp"
+
+namespace gauss
+{
+
+/**
+   @brief Writes samples of distributed vectors to a sample store
+
+   Write is collective, each processor gives its local part of the vector.
+   Opening an existing store appends to it, provided its fields and
+   global size match, unless it is truncated to start a new run.
+*/
+class SampleWriter
+{
+public:
+    /** @brief Constructor, creates or opens the store
+        @param comm MPI Communicator
+        @param filename name of store file
+        @param global_size global size of each vector
+        @param local_to_global map of local indices to global indices
+        @param fields names of the vectors saved for each sample
+        @param truncate discard any existing samples instead of appending
+    */
+    SampleWriter(MPI_Comm comm, const std::string& filename, int global_size,
+                 std::vector<int> local_to_global, std::vector<std::string> fields,
+                 bool truncate = false);
+
+    /** @brief Destructor, closes the store */
+    ~SampleWriter() noexcept;
+
+    SampleWriter(const SampleWriter& other) = delete;
+    SampleWriter& operator=(const SampleWriter& other) = delete;
+
+    /** @brief Write a field of a sample
+        @param sample sample id, starting from 0
+        @param field name of the field
+        @param vect local vector to write
+    */
+    template <typename T = VectorView>
+    void Write(int sample, const std::string& field, const T& vect);
+
+    /** @brief Names of the fields */
+    const std::vector<std::string>& Fields() const { return fields_; }
+
+    /** @brief Global size of each vector */
+    int GlobalSize() const { return global_size_; }
+
+private:
+    void WriteRecord(int sample, int field, const std::vector<double>& vect);
+
+    MPI_Comm comm_;
+    MPI_File file_;
+
+    std::string filename_;
+    int global_size_;
+    std::vector<std::string> fields_;
+
+    // Local entries, sorted by owner of their block of the vector
+    std::vector<int> send_order_;
+    std::vector<int> send_counts_;
+    std::vector<int> send_offsets_;
+
+    // Entries received from each processor, relative to the owned block
+    std::vector<int> recv_indices_;
+    std::vector<int> recv_counts_;
+    std::vector<int> recv_offsets_;
+
+    int block_begin_;
+    int block_size_;
+};
+
+/**
+   @brief Reads samples from a sample store, without MPI
+*/
+class SampleReader
+{
+public:
+    /** @brief Constructor, opens the store and reads its header
+        @param filename name of store file
+    */
+    explicit SampleReader(const std::string& filename);
+
+    /** @brief Number of samples with all fields written,
+        checked each call so a store still being written can be followed
+    */
+    int NumSamples();
+
+    /** @brief Names of the fields */
+    const std::vector<std::string>& Fields() const { return fields_; }
+
+    /** @brief Global size of each vector */
+    int GlobalSize() const { return global_size_; }
+
+    /** @brief Read a field of a sample
+        @param sample sample id
+        @param field name of the field
+        @returns global vector
+    */
+    Vector Read(int sample, const std::string& field);
+
+    /** @brief Read the local part of a field of a sample
+        @param sample sample id
+        @param field name of the field
+        @param local_to_global map of local indices to global indices
+        @returns local vector
+    */
+    Vector Read(int sample, const std::string& field,
+                const std::vector<int>& local_to_global);
+
+private:
+    std::vector<double> ReadValues(int sample, const std::string& field, int begin, int end);
+
+    std::string filename_;
+    std::ifstream in_;
+
+    int global_size_;
+    std::vector<std::string> fields_;
+};
+
+template <typename T>
+void SampleWriter::Write(int sample, const std::string& field, const T& vect)
+{
+    auto iter = std::find(std::begin(fields_), std::end(fields_), field);
+
+    if (iter == std::end(fields_))
+    {
+        throw std::runtime_error("Unknown field " + field + " in: " + filename_);
+    }
+
+    int local_size = send_order_.size();
+
+    std::vector<double> local_vect(local_size);
+
+    for (int i = 0; i < local_size; ++i)
+    {
+        local_vect[i] = vect[send_order_[i]];
+    }
+
+    WriteRecord(sample, iter - std::begin(fields_), local_vect);
+}
+
+} // namespace gauss
+
+#endif /* __SAMPLESTORE_HPP__ */
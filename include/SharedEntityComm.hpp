@@ -27,10 +27,17 @@
     operation onto the master, where the user is responsible to do what is
     necessary.
 
+    All entities going to the same neighbor are packed into one buffer of
+    ints and one of doubles, so each pair of neighbors exchanges a fixed
+    number of messages per collective regardless of how many entities they share.
+
+    Which processors share each entity is worked out once in a
+    SharedEntityPlan, which can be reused by any number of collectives on
+    the same entity_true_entity relationship.
+
     This is "fairly" generic but not completely, if you want to use for a
-    datatype other than mfem::DenseMatrix or mfem::Vector you need to implement:
-    SetSizeSpecifer(), PackSizes(), SendData(), ReceiveData(), and CopyData()
-    routines yourself.
+    datatype other than DenseMatrix, SparseMatrix or Vector you need to
+    implement the PackData() and UnpackData() routines yourself.
 
     Significant improvements to handling the "tags" argument to honor the
     MPI_TAG_UB constraint are due to Alex Druinsky from Lawrence Berkeley
@@ -40,6 +47,7 @@
 #ifndef __SHAREDENTITYCOMM_HPP__
 #define __SHAREDENTITYCOMM_HPP__
 
+#include <algorithm>
 #include <unordered_map>
 
 #include "linalgcpp.hpp"
@@ -51,13 +59,30 @@ namespace gauss
 {
 
 /**
-   @brief Handles sharing information across processors, where that information
-   belongs to entities that are also shared across processors.
+   @brief Communication plan for entities shared across processors
+
+   Holds which processors share each entity and which of them is the
+   master, along with a small pool of persistent requests for exchanging
+   buffer sizes with each neighbor. Built once per entity_true_entity
+   relationship and reused by every SharedEntityComm on it.
 */
-template <typename T>
-class SharedEntityComm
+class SharedEntityPlan
 {
 public:
+    /** @brief Direction of an exchange */
+    enum class Direction { Reduce, Broadcast };
+
+    /** @brief Slot and requests of an exchange in flight,
+               see ExchangeBegin() and ExchangeEnd() */
+    struct PendingExchange
+    {
+        Direction direction;
+        int slot;
+
+        // Buffer receives, posted as their sizes arrive, then buffer sends
+        std::vector<MPI_Request> requests;
+    };
+
     /** @brief Constructor given the entity true entity relationship
 
         @param entity_true_entity global entity true entity relationship
@@ -66,19 +91,16 @@ public:
         you how many processors share the entity, and the partitions they
         are in tell you which processors it is on.
     */
-    SharedEntityComm(const ParMatrix& entity_true_entity);
-
-    /** @brief Sends mat from entity to whichever processor
-        owns the corresponding true entity.
+    SharedEntityPlan(const ParMatrix& entity_true_entity);
 
-        Should be called even if you are the owner.
-        Does not do anything (from user perspective) until Collect() is called
+    /** @brief Destructor, frees the persistent requests */
+    ~SharedEntityPlan() noexcept;
 
-        @param entity entity which is sending this information
-        @param mat matrix to send
-    */
-    void ReduceSend(int entity, T mat);
+    SharedEntityPlan(const SharedEntityPlan& other) = delete;
+    SharedEntityPlan& operator=(const SharedEntityPlan& other) = delete;
 
+    /** @brief Number of local entities */
+    int NumEntities() const { return num_entities_; }
 
     /** @brief Determines if this entity is local
         @param entity entity to check
@@ -86,486 +108,426 @@ public:
     */
     bool IsOwnedByMe(int entity) const;
 
+    /** @brief Processor that is master of an entity */
+    int Master(int entity) const { return entity_master_[entity]; }
+
+    /** @brief Processors that share an entity, including myself */
+    std::vector<int> EntityProcs(int entity) const { return entity_proc_.GetIndices(entity); }
+
     /** @brief Given entity in local numbering, return the global entity number
         @param entity local entity
         @returns global entity
     */
-    int GetTrueEntity(int entity) const;
+    int GetTrueEntity(int entity) const { return true_entity_[entity]; }
 
-    /** @brief Collects all data sent by ReduceSend
-        @returns collection collected data arrays
-        T[number of local entities][number of processors who share entity, including yourself]
+    /** @brief Given a global entity shared with me, return the local entity
+        @param true_entity global entity
+        @returns local entity
     */
-    std::vector<std::vector<T>> Collect();
+    int GetEntity(int true_entity) const;
 
-    /** @brief Broadcasts matrix from master to slave.
+    /** @brief Neighbors sent to in this direction, in increasing order */
+    const std::vector<int>& SendProcs(Direction direction) const;
 
-        @param mats should be size num_entities. The array entries where this
-        processor is master should be filled with the appropriate matrix,
-        all others will be overwritten.
-    */
-    void Broadcast(std::vector<T>& mats);
+    /** @brief Neighbors received from in this direction, in increasing order */
+    const std::vector<int>& RecvProcs(Direction direction) const;
 
-private:
-    void MakeEntityProc();
+    /** @brief Position of proc in SendProcs(direction) */
+    int SendIndex(Direction direction, int proc) const;
 
-    void SetSizeSpecifier();
-    std::vector<int> PackSendSize(const T& mat) const;
+    /** @brief Number of entities received by masters in a reduction */
+    int NumMasterComms() const { return num_master_comms_; }
 
-    void SendData(const T& mat, int recipient, int tag, MPI_Request& request) const;
-    T ReceiveData(const std::vector<int>& sizes, int sender, int tag, MPI_Request& request) const;
+    /** @brief Number of entities sent by slaves in a reduction */
+    int NumSlaveComms() const { return num_slave_comms_; }
 
-    void ReducePrepare();
+    /** @brief Exchange packed buffers with each neighbor
 
-    void BroadcastSizes(std::vector<T>& mats);
-    void BroadcastData(std::vector<T>& mats);
+        @param direction Reduce sends from slaves to masters,
+                         Broadcast from masters to slaves
+        @param send_ints ints to send to each of SendProcs(direction)
+        @param send_doubles doubles to send to each of SendProcs(direction)
+        @param recv_ints ints received from each of RecvProcs(direction)
+        @param recv_doubles doubles received from each of RecvProcs(direction)
+    */
+    void Exchange(Direction direction,
+                  const std::vector<std::vector<int>>& send_ints,
+                  const std::vector<std::vector<double>>& send_doubles,
+                  std::vector<std::vector<int>>& recv_ints,
+                  std::vector<std::vector<double>>& recv_doubles);
+
+    /** @brief Start exchanging packed buffers with each neighbor, without waiting
+
+        The buffer sizes are sent along with the buffers, by the persistent
+        requests of the next exchange slot, so nothing blocks here. The send
+        buffers must be left untouched until ExchangeEnd(). Up to eight
+        exchanges may be in flight at once and end in any order, provided
+        every processor starts them in the same order.
+
+        @param pending on return, the exchange to pass to ExchangeEnd()
+        See Exchange() for the other parameters.
+    */
+    void ExchangeBegin(Direction direction,
+                       const std::vector<std::vector<int>>& send_ints,
+                       const std::vector<std::vector<double>>& send_doubles,
+                       PendingExchange& pending);
 
-    const ParMatrix& entity_true_entity_;
-    SparseMatrix entity_diag_T_;
-    SparseMatrix entity_offd_T_;
+    /** @brief Wait for an exchange started by ExchangeBegin()
 
-    linalgcpp::ParCommPkg comm_pkg_;
+        Each receive is posted as soon as the size from that neighbor arrives.
+
+        @param pending exchange returned by ExchangeBegin()
+        See Exchange() for the other parameters.
+    */
+    void ExchangeEnd(PendingExchange& pending,
+                     std::vector<std::vector<int>>& recv_ints,
+                     std::vector<std::vector<double>>& recv_doubles);
+
+private:
+    void MakeEntityProc(const ParMatrix& entity_true_entity);
+    void InitSizeRequests(int slot, Direction direction);
 
     MPI_Comm comm_;
     int myid_;
 
     int num_entities_;
-    int size_specifier_;
-    int send_counter_;
+    int true_entity_begin_;
 
     std::vector<int> entity_master_;
-    std::vector<int> entity_slave_id_;
+    std::vector<int> true_entity_;
+
+    // Local entity of owned true entities, and of shared true entities
+    std::vector<int> owned_entity_;
+    std::unordered_map<int, int> shared_entity_;
 
     int num_master_comms_;
     int num_slave_comms_;
 
+    // Processors that are master of some of my entities
+    std::vector<int> master_procs_;
+    // Processors that share some of the entities I am master of
+    std::vector<int> slave_procs_;
+
     linalgcpp::SparseMatrix<int> entity_proc_;
 
-    std::vector<T> send_buffer_;
-    std::vector<std::vector<T>> recv_buffer_;
+    // Persistent size exchange of an exchange slot, indexed by direction.
+    // Each slot has its own tags, so that exchanges between the same
+    // neighbors can end in any order.
+    struct SizeSlot
+    {
+        bool in_flight = false;
 
-    std::vector<std::vector<int>> send_headers_;
-    std::vector<std::vector<int>> recv_headers_;
+        std::vector<int> send_sizes[2];
+        std::vector<int> recv_sizes[2];
 
-    std::vector<MPI_Request> header_requests_;
-    std::vector<MPI_Request> data_requests_;
+        // Receives from each of RecvProcs, then sends to each of SendProcs
+        std::vector<MPI_Request> requests[2];
+    };
 
-    bool preparing_to_reduce_;
+    static constexpr int num_slots_ = 8;
+
+    std::vector<SizeSlot> size_slots_;
+
+    // Exchanges started so far, the slot of the next one is this modulo num_slots_
+    int num_exchanges_ = 0;
 
-    enum { ENTITY_HEADER_TAG, ENTITY_MESSAGE_TAG, };
+    enum { ENTITY_HEADER_TAG, ENTITY_INT_TAG, ENTITY_DOUBLE_TAG, NUM_ENTITY_TAGS };
 };
 
+/**
+   @brief Handles sharing information across processors, where that information
+   belongs to entities that are also shared across processors.
+*/
 template <typename T>
-SharedEntityComm<T>::SharedEntityComm(const ParMatrix& entity_true_entity)
-    : entity_true_entity_(entity_true_entity),
-      entity_diag_T_(entity_true_entity_.GetDiag().Transpose()),
-      entity_offd_T_(entity_true_entity_.GetOffd().Transpose()),
-      comm_pkg_(entity_true_entity_.MakeCommPkg()),
-      comm_(entity_true_entity_.GetComm()),
-      myid_(entity_true_entity_.GetMyId()),
-      num_entities_(entity_true_entity_.Rows()),
-      size_specifier_(0),
-      send_counter_(0),
-      entity_master_(num_entities_),
-      entity_slave_id_(num_entities_),
-      num_master_comms_(0),
-      num_slave_comms_(0),
-      recv_buffer_(num_entities_),
-      preparing_to_reduce_(false)
+class SharedEntityComm
 {
-    MakeEntityProc();
+public:
+    /** @brief Constructor given the entity true entity relationship,
+               builds a plan used only by this object
 
-    for (int i = 0; i < num_entities_; ++i)
-    {
-        if (entity_master_[i] == myid_)
-        {
-            num_master_comms_ += entity_proc_.RowSize(i) - 1; // -1 for myself
-            entity_slave_id_[i] = -1;
-        }
-        else
-        {
-            entity_slave_id_[i] = num_slave_comms_++;
-        }
-    }
+        @param entity_true_entity global entity true entity relationship
+    */
+    SharedEntityComm(const ParMatrix& entity_true_entity);
 
-    send_buffer_.resize(num_slave_comms_);
+    /** @brief Constructor given an existing plan
 
-    SetSizeSpecifier();
-}
+        @param plan communication plan, must outlive this object
+    */
+    SharedEntityComm(SharedEntityPlan& plan);
 
-template <typename T>
-void SharedEntityComm<T>::MakeEntityProc()
-{
-    auto& send_starts = comm_pkg_.send_map_starts_;
-    auto& recv_starts = comm_pkg_.recv_vec_starts_;
+    /** @brief Sends mat from entity to whichever processor
+        owns the corresponding true entity.
 
-    std::vector<std::pair<int, int> > true_entity_proc;
+        Should be called even if you are the owner.
+        Does not do anything (from user perspective) until Collect() is called
 
-    int num_sends = comm_pkg_.num_sends_;
+        @param entity entity which is sending this information
+        @param mat matrix to send
+    */
+    void ReduceSend(int entity, T mat);
 
-    for (int send = 0; send < num_sends; ++send)
-    {
-        int proc = comm_pkg_.send_procs_[send];
 
-        for (int j = send_starts[send]; j < send_starts[send + 1]; ++j)
-        {
-            int true_entity = comm_pkg_.send_map_elmts_[j];
+    /** @brief Determines if this entity is local
+        @param entity entity to check
+        @returns true if entity is local
+    */
+    bool IsOwnedByMe(int entity) const { return plan_.IsOwnedByMe(entity); }
 
-            true_entity_proc.push_back(std::make_pair(true_entity, proc));
-        }
-    }
+    /** @brief Given entity in local numbering, return the global entity number
+        @param entity local entity
+        @returns global entity
+    */
+    int GetTrueEntity(int entity) const { return plan_.GetTrueEntity(entity); }
 
-    const auto& ete_diag = entity_true_entity_.GetDiag();
-    const auto& ete_diag_indptr = ete_diag.GetIndptr();
-    const auto& ete_diag_indices = ete_diag.GetIndices();
+    /** @brief Collects all data sent by ReduceSend
+        @returns collection collected data arrays
+        T[number of local entities][number of processors who share entity, including yourself]
+    */
+    std::vector<std::vector<T>> Collect();
 
-    const auto& ete_offd = entity_true_entity_.GetOffd();
-    const auto& ete_offd_indptr = ete_offd.GetIndptr();
-    const auto& ete_offd_indices = ete_offd.GetIndices();
+    /** @brief Starts collecting the data sent by ReduceSend, without waiting for it
 
-    linalgcpp::CooMatrix<int> entity_proc;
+        @returns collection as in Collect(). Entries of entities that are not
+        shared with other processors are complete, the others are filled in
+        by CollectEnd(). Owned by this object.
+    */
+    std::vector<std::vector<T>>& CollectBegin();
 
-    for (int entity = 0; entity < num_entities_; ++entity)
-    {
-        int offd_size = ete_offd.RowSize(entity);
+    /** @brief Waits for the data started by CollectBegin() */
+    void CollectEnd();
 
-        entity_master_[entity] = myid_;
-        entity_proc.Add(entity, myid_, 1);
+    /** @brief Broadcasts matrix from master to slave.
 
-        if (offd_size == 0)
-        {
-            assert(ete_diag.RowSize(entity) == 1);
+        @param mats should be size num_entities. The array entries where this
+        processor is master should be filled with the appropriate matrix,
+        all others will be overwritten.
+    */
+    void Broadcast(std::vector<T>& mats);
 
-            int true_entity = ete_diag_indices[ete_diag_indptr[entity]];
+private:
+    void PackData(const T& mat, std::vector<int>& ints, std::vector<double>& doubles) const;
+    T UnpackData(const int*& ints, const double*& doubles) const;
 
-            for (auto& true_entity_proc_i : true_entity_proc)
-            {
-                if (true_entity_proc_i.first == true_entity)
-                {
-                    entity_proc.Add(entity, true_entity_proc_i.second, 1);
-                }
-            }
-        }
-        else
-        {
-            assert(ete_diag.RowSize(entity) == 0 && offd_size == 1);
+    void ReducePrepare();
 
-            int shared_entity = ete_offd_indices[ete_offd_indptr[entity]];
+    std::unique_ptr<SharedEntityPlan> owned_plan_;
+    SharedEntityPlan& plan_;
 
-            for (int recv = 0; recv < comm_pkg_.num_recvs_; ++recv)
-            {
-                int proc = comm_pkg_.recv_procs_[recv];
-
-                for (int k = recv_starts[recv]; k < recv_starts[recv + 1]; ++k)
-                {
-                    if (k == shared_entity)
-                    {
-                        entity_proc.Add(entity, proc, 1);
-
-                        if (proc < entity_master_[entity])
-                        {
-                            entity_master_[entity] = proc;
-                        }
-                    }
-                }
-            }
-        }
-    }
+    int num_entities_;
+    int send_counter_;
 
-    entity_proc_ = entity_proc.ToSparse();
-}
+    std::vector<std::vector<T>> recv_buffer_;
+
+    // Packed entities, one buffer per neighbor
+    std::vector<std::vector<int>> send_ints_;
+    std::vector<std::vector<double>> send_doubles_;
+    std::vector<std::vector<int>> recv_ints_;
+    std::vector<std::vector<double>> recv_doubles_;
+
+    SharedEntityPlan::PendingExchange collect_exchange_;
+
+    bool preparing_to_reduce_;
+    bool collecting_;
+};
 
 template <typename T>
-void SharedEntityComm<T>::ReducePrepare()
+SharedEntityComm<T>::SharedEntityComm(const ParMatrix& entity_true_entity)
+    : owned_plan_(make_unique<SharedEntityPlan>(entity_true_entity)),
+      plan_(*owned_plan_),
+      num_entities_(plan_.NumEntities()),
+      send_counter_(0),
+      preparing_to_reduce_(false),
+      collecting_(false)
 {
-    const int header_length = size_specifier_ + 1;
-
-    send_headers_.resize(num_slave_comms_);
-    recv_headers_.resize(num_master_comms_, std::vector<int>(header_length));
+}
 
-    header_requests_.resize(num_master_comms_ + num_slave_comms_);
-    data_requests_.resize(num_master_comms_ + num_slave_comms_);
+template <typename T>
+SharedEntityComm<T>::SharedEntityComm(SharedEntityPlan& plan)
+    : plan_(plan),
+      num_entities_(plan_.NumEntities()),
+      send_counter_(0),
+      preparing_to_reduce_(false),
+      collecting_(false)
+{
+}
 
-    int header_recv_counter = 0;
+template <typename T>
+void SharedEntityComm<T>::ReducePrepare()
+{
+    recv_buffer_.resize(num_entities_);
 
     for (int i = 0; i < num_entities_; ++i)
     {
-        if (entity_master_[i] == myid_)
+        if (plan_.IsOwnedByMe(i))
         {
-            int neighbor_row_size = entity_proc_.RowSize(i);
-            recv_buffer_[i].resize(neighbor_row_size);
-
-            std::vector<int> neighbor_row = entity_proc_.GetIndices(i);
-
-            for (auto neighbor : neighbor_row)
-            {
-                if (neighbor != myid_)
-                {
-                    MPI_Irecv(
-                        recv_headers_[header_recv_counter].data(),
-                        header_length, MPI_INT, neighbor,
-                        ENTITY_HEADER_TAG, comm_,
-                        &header_requests_[header_recv_counter]);
-                    header_recv_counter++;
-                }
-            }
+            recv_buffer_[i].resize(plan_.EntityProcs(i).size());
         }
     }
 
-    assert(header_recv_counter == num_master_comms_);
+    const int num_sends = plan_.SendProcs(SharedEntityPlan::Direction::Reduce).size();
+
+    send_ints_.assign(num_sends, std::vector<int>());
+    send_doubles_.assign(num_sends, std::vector<double>());
 
     preparing_to_reduce_ = true;
 }
 
-template <class T>
-int SharedEntityComm<T>::GetTrueEntity(int entity) const
+template <typename T>
+void SharedEntityComm<T>::ReduceSend(int entity, T mat)
 {
-    if (entity_master_[entity] == myid_)
+    assert(!collecting_);
+
+    if (!preparing_to_reduce_)
     {
-        const auto& ete_diag = entity_true_entity_.GetDiag();
-        const auto& ete_diag_indptr = ete_diag.GetIndptr();
-        const auto& ete_diag_indices = ete_diag.GetIndices();
-        const auto& ete_col_starts = entity_true_entity_.GetColStarts();
+        ReducePrepare();
+    }
 
-        return ete_col_starts[0] + ete_diag_indices[ete_diag_indptr[entity]];
+    if (plan_.IsOwnedByMe(entity))
+    {
+        swap(recv_buffer_[entity][0], mat);
     }
     else
     {
-        const auto& ete_offd = entity_true_entity_.GetOffd();
-        const auto& ete_offd_indptr = ete_offd.GetIndptr();
-        const auto& ete_offd_indices = ete_offd.GetIndices();
-        const auto& ete_colmap = entity_true_entity_.GetColMap();
+        int neighbor = plan_.SendIndex(SharedEntityPlan::Direction::Reduce,
+                                       plan_.Master(entity));
+
+        send_ints_[neighbor].push_back(plan_.GetTrueEntity(entity));
+        PackData(mat, send_ints_[neighbor], send_doubles_[neighbor]);
 
-        return ete_colmap[ete_offd_indices[ete_offd_indptr[entity]]];
+        send_counter_++;
     }
 }
 
-template <class T>
-bool SharedEntityComm<T>::IsOwnedByMe(int entity) const
+template <typename T>
+std::vector<std::vector<T>> SharedEntityComm<T>::Collect()
 {
-    assert(entity >= 0);
-    assert(entity < static_cast<int>(entity_master_.size()));
+    CollectBegin();
+    CollectEnd();
 
-    return (entity_master_[entity] == myid_);
+    return std::move(recv_buffer_);
 }
 
 template <typename T>
-void SharedEntityComm<T>::ReduceSend(int entity, T mat)
+std::vector<std::vector<T>>& SharedEntityComm<T>::CollectBegin()
 {
+    assert(!collecting_);
+
     if (!preparing_to_reduce_)
     {
         ReducePrepare();
     }
 
-    int owner = entity_master_[entity];
-
-    if (owner == myid_)
-    {
-        swap(recv_buffer_[entity][0], mat);
-    }
-    else
-    {
-        int true_entity = GetTrueEntity(entity);
-        int send_id = entity_slave_id_[entity];
-
-        assert(send_id >= 0);
+    assert(send_counter_ == plan_.NumSlaveComms());
 
-        send_headers_[send_id] = PackSendSize(mat);
-        send_headers_[send_id].push_back(true_entity);
+    plan_.ExchangeBegin(SharedEntityPlan::Direction::Reduce, send_ints_, send_doubles_,
+                        collect_exchange_);
 
-        const int header_length = send_headers_[send_id].size();
+    collecting_ = true;
 
-        MPI_Isend(send_headers_[send_id].data(), header_length,
-                  MPI_INT, owner, ENTITY_HEADER_TAG, comm_,
-                  &header_requests_[num_master_comms_ + send_id]);
-
-        swap(send_buffer_[send_id], mat);
-        SendData(send_buffer_[send_id], owner, ENTITY_MESSAGE_TAG,
-                 data_requests_[send_id]);
-        send_counter_++;
-    }
+    return recv_buffer_;
 }
 
 template <typename T>
-std::vector<std::vector<T>> SharedEntityComm<T>::Collect()
+void SharedEntityComm<T>::CollectEnd()
 {
-    assert(send_counter_ == num_slave_comms_);
+    assert(collecting_);
 
-    std::vector<MPI_Status> header_statuses(num_slave_comms_ + num_master_comms_);
-    MPI_Waitall(num_slave_comms_ + num_master_comms_, header_requests_.data(), header_statuses.data());
-
-    header_requests_.clear();
-
-    const auto& diag_T_indices = entity_diag_T_.GetIndices();
-    const auto& ete_col_starts = entity_true_entity_.GetColStarts();
+    plan_.ExchangeEnd(collect_exchange_, recv_ints_, recv_doubles_);
 
     std::vector<int> received_entities(num_entities_, 0);
     int data_receive_counter = 0;
 
-    for (int i = 0; i < num_entities_; ++i)
-    {
-        int owner = entity_master_[i];
-
-        if (owner != myid_)
-        {
-            continue;
-        }
+    // Neighbors are in increasing order, so each entity's collection
+    // is ordered by processor
+    const int num_recvs = recv_ints_.size();
 
-        std::vector<int> neighbors = entity_proc_.GetIndices(i);
+    for (int i = 0; i < num_recvs; ++i)
+    {
+        const int* ints = recv_ints_[i].data();
+        const int* ints_end = ints + recv_ints_[i].size();
+        const double* doubles = recv_doubles_[i].data();
 
-        for (auto neighbor : neighbors)
+        while (ints != ints_end)
         {
-            if (neighbor == myid_)
-            {
-                continue;
-            }
-
-            auto& header = recv_headers_[data_receive_counter];
-
-            int true_entity = header.back();
-            int entity = diag_T_indices[true_entity - ete_col_starts[0]];
-
-            int row = entity;
+            int entity = plan_.GetEntity(*ints++);
             int column = 1 + received_entities[entity];
 
-            recv_buffer_[row][column] = ReceiveData(header, neighbor, ENTITY_MESSAGE_TAG,
-                                                    data_requests_[num_slave_comms_ + data_receive_counter]);
+            recv_buffer_[entity][column] = UnpackData(ints, doubles);
 
             received_entities[entity]++;
             data_receive_counter++;
         }
     }
 
-    std::vector<MPI_Status> data_statuses(num_slave_comms_ + num_master_comms_);
-    MPI_Waitall(num_slave_comms_ + num_master_comms_,
-                data_requests_.data(), data_statuses.data());
+    assert(data_receive_counter == plan_.NumMasterComms());
 
-    preparing_to_reduce_ = false;
+    send_ints_.clear();
+    send_doubles_.clear();
+    recv_ints_.clear();
+    recv_doubles_.clear();
 
-    return std::move(recv_buffer_);
+    send_counter_ = 0;
+    preparing_to_reduce_ = false;
+    collecting_ = false;
 }
 
 template <class T>
 void SharedEntityComm<T>::Broadcast(std::vector<T>& mats)
 {
-    assert(!preparing_to_reduce_);
+    assert(!preparing_to_reduce_ && !collecting_);
 
-    BroadcastSizes(mats);
-    BroadcastData(mats);
-}
-
-template <class T>
-void SharedEntityComm<T>::BroadcastSizes(std::vector<T>& mats)
-{
-    int header_len = size_specifier_ + 1;
+    const auto direction = SharedEntityPlan::Direction::Broadcast;
+    const int num_sends = plan_.SendProcs(direction).size();
 
-    send_headers_.resize(num_master_comms_);
-    recv_headers_.resize(num_slave_comms_, std::vector<int>(header_len));
+    send_ints_.assign(num_sends, std::vector<int>());
+    send_doubles_.assign(num_sends, std::vector<double>());
 
-    header_requests_.resize(num_master_comms_ + num_slave_comms_);
-
-    const auto& offd_T_indices = entity_offd_T_.GetIndices();
-    const auto& entity_offd = entity_true_entity_.GetOffd();
-    int num_recv = entity_offd.Cols();
-    assert(num_recv == num_slave_comms_);
-
-    for (int i = 0; i < num_recv; ++i)
-    {
-        int entity = offd_T_indices[i];
-        int owner = entity_master_[entity];
-
-        MPI_Irecv(recv_headers_[i].data(), header_len, MPI_INT,
-                  owner, ENTITY_HEADER_TAG, comm_,
-                  &header_requests_[i]);
-    }
-
-    const auto& diag_T_indices = entity_diag_T_.GetIndices();
-    int num_send = entity_true_entity_.Cols();
-    int send_counter = 0;
-
-    for (int i = 0; i < num_send; ++i)
+    for (int entity = 0; entity < num_entities_; ++entity)
     {
-        int entity = diag_T_indices[i];
-        std::vector<int> neighbor_row = entity_proc_.GetIndices(entity);
+        if (!plan_.IsOwnedByMe(entity))
+        {
+            continue;
+        }
 
-        for (auto neighbor : neighbor_row)
+        for (auto proc : plan_.EntityProcs(entity))
         {
-            if (neighbor != myid_)
+            if (proc != plan_.Master(entity))
             {
-                send_headers_[send_counter] = PackSendSize(mats[entity]);
-                send_headers_[send_counter].push_back(GetTrueEntity(entity));
+                int neighbor = plan_.SendIndex(direction, proc);
 
-                MPI_Isend(send_headers_[send_counter].data(), header_len,
-                          MPI_INT, neighbor, ENTITY_HEADER_TAG, comm_,
-                          &header_requests_[num_slave_comms_ + send_counter]);
-                send_counter++;
+                send_ints_[neighbor].push_back(plan_.GetTrueEntity(entity));
+                PackData(mats[entity], send_ints_[neighbor], send_doubles_[neighbor]);
             }
         }
     }
 
-    assert(send_counter == num_master_comms_);
-
-    std::vector<MPI_Status> header_statuses(num_slave_comms_ + num_master_comms_);
-    MPI_Waitall(num_slave_comms_ + num_master_comms_,
-                header_requests_.data(), header_statuses.data());
-}
-
-template <class T>
-void SharedEntityComm<T>::BroadcastData(std::vector<T>& mats)
-{
-    data_requests_.resize(num_master_comms_ + num_slave_comms_);
-
-    const auto& offd_T_indices = entity_offd_T_.GetIndices();
-    const auto& entity_offd = entity_true_entity_.GetOffd();
-    int num_recv = entity_offd.Cols();
-    assert(num_recv == num_slave_comms_);
+    plan_.Exchange(direction, send_ints_, send_doubles_, recv_ints_, recv_doubles_);
 
-    std::unordered_map<int, int> true_entity_to_entity;
-    true_entity_to_entity.reserve(num_recv);
-
-    for (int i = 0; i < num_recv; ++i)
-    {
-        int entity = offd_T_indices[i];
-        true_entity_to_entity[GetTrueEntity(entity)] = entity;
-    }
+    const int num_recvs = recv_ints_.size();
+    int data_receive_counter = 0;
 
-    for (int i = 0; i < num_recv; ++i)
+    for (int i = 0; i < num_recvs; ++i)
     {
-        int owner = entity_master_[offd_T_indices[i]];
-
-        int true_entity = recv_headers_[i].back();
-        int entity = true_entity_to_entity.at(true_entity);
-
-        mats[entity] = ReceiveData(recv_headers_[i], owner,
-                                   ENTITY_MESSAGE_TAG,
-                                   data_requests_[i]);
-    }
+        const int* ints = recv_ints_[i].data();
+        const int* ints_end = ints + recv_ints_[i].size();
+        const double* doubles = recv_doubles_[i].data();
 
-    const auto& diag_T_indices = entity_diag_T_.GetIndices();
-    int num_send = entity_true_entity_.Cols();
-    int send_counter = 0;
+        while (ints != ints_end)
+        {
+            int entity = plan_.GetEntity(*ints++);
 
-    for (int i = 0; i < num_send; ++i)
-    {
-        int entity = diag_T_indices[i];
-        std::vector<int> neighbor_row = entity_proc_.GetIndices(entity);
+            mats[entity] = UnpackData(ints, doubles);
 
-        for (auto neighbor : neighbor_row)
-        {
-            if (neighbor != myid_)
-            {
-                SendData(mats[entity], neighbor, ENTITY_MESSAGE_TAG,
-                         data_requests_[num_slave_comms_ + send_counter]);
-                send_counter++;
-            }
+            data_receive_counter++;
         }
     }
 
-    assert(send_counter == num_master_comms_);
+    assert(data_receive_counter == plan_.NumSlaveComms());
 
-    std::vector<MPI_Status> data_statuses(num_slave_comms_ + num_master_comms_);
-    MPI_Waitall(num_slave_comms_ + num_master_comms_,
-                data_requests_.data(), data_statuses.data());
+    send_ints_.clear();
+    send_doubles_.clear();
+    recv_ints_.clear();
+    recv_doubles_.clear();
 }
 
 
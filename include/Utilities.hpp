@@ -24,8 +24,12 @@
 #define __UTILITIES_HPP__
 
 #include <map>
+#include <numeric>
+#include <stdexcept>
 #include <unordered_map>
 
+#include "GAUSS_config.h"
+
 #include "linalgcpp.hpp"
 #include "parlinalgcpp.hpp"
 #include "partition.hpp"
@@ -68,6 +72,40 @@ using SpectralPair = std::pair<double, int>;
 */
 int MyId(MPI_Comm comm = MPI_COMM_WORLD);
 
+/** @brief Find number of processors on given communicator
+    @param comm MPI Communicator
+    @returns number of processors
+*/
+int NumProcs(MPI_Comm comm = MPI_COMM_WORLD);
+
+/** @brief Sum values over all processors, in place
+
+    Makes no collective call on a single processor, so concurrent
+    solves there do not share reductions on the same communicator.
+
+    @param comm MPI Communicator
+    @param vals local values on input, global sums on output
+    @param count number of values
+*/
+void ParSum(MPI_Comm comm, double* vals, int count);
+
+/** @brief Global l2 norm of a distributed vector, see ParSum
+    @param comm MPI Communicator
+    @param vect local part of the vector
+    @returns global norm
+*/
+double ParNorm(MPI_Comm comm, const VectorView& vect);
+
+/** @brief Maximum number of threads available to a parallel region
+    @returns number of threads, 1 if threading is disabled
+*/
+int NumThreads();
+
+/** @brief Id of the calling thread inside a parallel region
+    @returns thread id, 0 if threading is disabled
+*/
+int ThreadId();
+
 /** @brief Create an edge to true edge relationship
     @param comm MPI Communicator
     @param proc_edge processor edge relationship
@@ -77,6 +115,15 @@ int MyId(MPI_Comm comm = MPI_COMM_WORLD);
 ParMatrix MakeEdgeTrueEdge(MPI_Comm comm, const SparseMatrix& proc_edge,
                            const std::vector<int>& edge_map);
 
+/** @brief Create an edge to true edge relationship from known true edges
+    @param comm MPI Communicator
+    @param edge_tedge global true edge of each local edge
+    @param num_tedges_local number of true edges owned by this processor
+    @returns global edge to true edge
+*/
+ParMatrix MakeEdgeTrueEdge(MPI_Comm comm, const std::vector<HYPRE_Int>& edge_tedge,
+                           int num_tedges_local);
+
 /** @brief Restricts aggregate relationship to interior only
     @param mat extended aggregate relationship
     @param mat interior aggregate relationship
@@ -252,6 +299,82 @@ double PowerIterate(MPI_Comm comm, const linalgcpp::Operator& A, VectorView resu
 */
 void BroadCast(MPI_Comm comm, SparseMatrix& mat);
 
+/** @brief First index of a processor's block when size items are split evenly
+
+    @param size number of items
+    @param num_procs number of processors
+    @param proc processor
+    @returns first index of proc's block, size if proc == num_procs
+*/
+int BlockStart(int size, int num_procs, int proc);
+
+/** @brief Processor whose block contains index, see BlockStart
+
+    @param size number of items
+    @param num_procs number of processors
+    @param index index of item
+    @returns processor that owns index
+*/
+int BlockOwner(int size, int num_procs, int index);
+
+/** @brief Send send[proc] to each processor
+
+    @param comm MPI Communicator
+    @param send data to send to each processor
+    @param type MPI type of T
+    @returns data received from each processor
+*/
+template <typename T>
+std::vector<std::vector<T>> Exchange(MPI_Comm comm, const std::vector<std::vector<T>>& send,
+                                     MPI_Datatype type)
+{
+    int num_procs;
+    MPI_Comm_size(comm, &num_procs);
+
+    assert(static_cast<int>(send.size()) == num_procs);
+
+    std::vector<int> send_counts(num_procs);
+    std::vector<int> recv_counts(num_procs);
+
+    for (int proc = 0; proc < num_procs; ++proc)
+    {
+        send_counts[proc] = send[proc].size();
+    }
+
+    MPI_Alltoall(send_counts.data(), 1, MPI_INT, recv_counts.data(), 1, MPI_INT, comm);
+
+    std::vector<int> send_offsets(num_procs + 1, 0);
+    std::vector<int> recv_offsets(num_procs + 1, 0);
+
+    std::partial_sum(std::begin(send_counts), std::end(send_counts),
+                     std::begin(send_offsets) + 1);
+    std::partial_sum(std::begin(recv_counts), std::end(recv_counts),
+                     std::begin(recv_offsets) + 1);
+
+    std::vector<T> send_buffer;
+    send_buffer.reserve(send_offsets.back());
+
+    for (const auto& data : send)
+    {
+        send_buffer.insert(std::end(send_buffer), std::begin(data), std::end(data));
+    }
+
+    std::vector<T> recv_buffer(recv_offsets.back());
+
+    MPI_Alltoallv(send_buffer.data(), send_counts.data(), send_offsets.data(), type,
+                  recv_buffer.data(), recv_counts.data(), recv_offsets.data(), type, comm);
+
+    std::vector<std::vector<T>> recv(num_procs);
+
+    for (int proc = 0; proc < num_procs; ++proc)
+    {
+        recv[proc].assign(std::begin(recv_buffer) + recv_offsets[proc],
+                          std::begin(recv_buffer) + recv_offsets[proc + 1]);
+    }
+
+    return recv;
+}
+
 /** @brief Adds two sparse matrices C = alpha * A + beta * B
 
     @param alpha scale for A
@@ -270,11 +393,39 @@ struct MpiSession
         @param argc argc from command line
         @param argv argv from command line
         @param comm MPI Communicator to use
+        @param thread_multiple allow MPI calls from several threads,
+               needed for concurrent solves
     */
-    MpiSession(int argc, char** argv, MPI_Comm comm = MPI_COMM_WORLD)
+    MpiSession(int argc, char** argv, MPI_Comm comm = MPI_COMM_WORLD,
+               bool thread_multiple = false)
         : comm_(comm)
     {
-        MPI_Init(&argc, &argv);
+        if (thread_multiple)
+        {
+            int provided;
+            MPI_Init_thread(&argc, &argv, MPI_THREAD_MULTIPLE, &provided);
+
+            if (provided < MPI_THREAD_MULTIPLE)
+            {
+                throw std::runtime_error("MPI does not support MPI_THREAD_MULTIPLE!");
+            }
+        }
+        else
+        {
+#if GAUSS_USE_OPENMP
+            // Only the main thread makes MPI calls
+            int provided;
+            MPI_Init_thread(&argc, &argv, MPI_THREAD_FUNNELED, &provided);
+
+            if (provided < MPI_THREAD_FUNNELED)
+            {
+                throw std::runtime_error("MPI does not support MPI_THREAD_FUNNELED!");
+            }
+#else
+            MPI_Init(&argc, &argv);
+#endif
+        }
+
         MPI_Comm_size(comm_, &num_procs_);
         MPI_Comm_rank(comm_, &myid_);
     }
@@ -309,6 +460,9 @@ std::vector<int> PartitionPostIsolate(const SparseMatrix& A, std::vector<int> pa
 
 /** @brief Read serial vector from file and extract local portion
 
+    Binary graph files are memory mapped and only the local entries are read,
+    text files are read in full.
+
     @param filename name of vector file
     @param local_to_global set of local indices to extract
     @returns local vector
@@ -316,6 +470,23 @@ std::vector<int> PartitionPostIsolate(const SparseMatrix& A, std::vector<int> pa
 Vector ReadVector(const std::string& filename,
                   const std::vector<int>& local_to_global);
 
+/** @brief Write a serial vector to file, combining local vectors from all processors
+
+    Each processor sends its entries to the processor owning that block
+    of the global vector, see BlockStart. The blocks are then written
+    collectively at their offsets in the file, one value per line.
+    Entries given by several processors are summed.
+
+    @param comm MPI Communicator
+    @param vect local values to write
+    @param filename name of vector file
+    @param global_size global size of vector
+    @param local_to_global map of local indices to global indices
+*/
+void WriteDistributedVector(MPI_Comm comm, const std::vector<double>& vect,
+                            const std::string& filename, int global_size,
+                            const std::vector<int>& local_to_global);
+
 /** @brief Write a serial vector to file, combining local vectors from all processors
 
     @param vect vector to write
@@ -330,28 +501,16 @@ void WriteVector(MPI_Comm comm, const T& vect, const std::string& filename, int
     assert(global_size > 0);
     assert(vect.size() <= global_size);
 
-    int myid;
-    int num_procs;
-    MPI_Comm_size(comm, &num_procs);
-    MPI_Comm_rank(comm, &myid);
-
-    std::vector<double> global_global(global_size, 0.0);
-    std::vector<double> global_local(global_size, 0.0);
-
     int local_size = local_to_global.size();
 
+    std::vector<double> local_vect(local_size);
+
     for (int i = 0; i < local_size; ++i)
     {
-        global_local[local_to_global[i]] = vect[i];
+        local_vect[i] = vect[i];
     }
 
-    MPI_Scan(global_local.data(), global_global.data(), global_size,
-             MPI_DOUBLE, MPI_SUM, comm);
-
-    if (myid == num_procs - 1)
-    {
-        linalgcpp::WriteText(global_global, filename);
-    }
+    WriteDistributedVector(comm, local_vect, filename, global_size, local_to_global);
 }
 
 /**
@@ -422,6 +581,30 @@ SparseMatrix RescaleLog(SparseMatrix A);
 /// Shifts partition such that indices are in [0, num_parts]
 void ShiftPartition(std::vector<int>& partition);
 
+/**
+   @brief Multiply several vectors by a sparse matrix in a single pass over the matrix
+
+   @param A sparse matrix
+   @param x input vectors
+   @param y output vectors, y[k] = A x[k]
+*/
+void MultiMult(const SparseMatrix& A, const std::vector<const double*>& x,
+               const std::vector<double*>& y);
+
+/**
+   @brief Multiply several vectors by a transposed sparse matrix in a single pass over the matrix
+
+   @param A sparse matrix
+   @param x input vectors
+   @param y output vectors, y[k] = A^T x[k]
+*/
+void MultiMultAT(const SparseMatrix& A, const std::vector<const double*>& x,
+                 const std::vector<double*>& y);
+
+/// Pointers to the data of the same block of several block vectors
+std::vector<const double*> BlockData(const std::vector<BlockVector>& vects, int block);
+std::vector<double*> BlockData(std::vector<BlockVector>& vects, int block);
+
 } //namespace gauss
 
 #endif // __UTILITIES_HPP__
@@ -378,9 +378,19 @@ void EliminateEssentialBC(gauss::GraphUpscale& upscale,
     gauss::SparseMatrix D_elim = DT_elim.Transpose();
 
     std::vector<gauss::MixedMatrix> mm_hats;
-    mm_hats.emplace_back(mm_0.GetElemM(), mm_0.GetElemDof(),
-                         std::move(D_elim), std::move(W_elim),
-                         mm_0.EdgeTrueEdge());
+
+    if (mm_0.IsDiagonalM())
+    {
+        mm_hats.emplace_back(mm_0.GetElemMDiag(), mm_0.GetElemDof(),
+                             std::move(D_elim), std::move(W_elim),
+                             mm_0.EdgeTrueEdge());
+    }
+    else
+    {
+        mm_hats.emplace_back(mm_0.GetElemM(), mm_0.GetElemDof(),
+                             std::move(D_elim), std::move(W_elim),
+                             mm_0.EdgeTrueEdge());
+    }
 
 
     // Coarsen eliminated hierarchy
@@ -0,0 +1,821 @@
+/*BHEADER**********************************************************************
+ *
+ * Copyright (c) 2018, Lawrence Livermore National Security, LLC.
+ * Produced at the Lawrence Livermore National Laboratory.
+ * LLNL-CODE-759464. All Rights reserved. See file COPYRIGHT for details.
+ *
+ * This file is part of GAUSS. For more information and source code
+ * availability, see https://www.github.com/gelever/GAUSS.
+ *
+ * GAUSS is free software; you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License (as published by the Free
+ * Software Foundation) version 2.1 dated February 1999.
+ *
+ ***********************************************************************EHEADER*/
+
+/** @file
+
+    @brief Implements Krylov solvers for several right hand sides at once
+*/
+
+#include <algorithm>
+#include <cmath>
+
+#include "BatchedKrylov.hpp"
+
+namespace gauss
+{
+
+namespace
+{
+// y += alpha * x
+void Axpy(double alpha, const Vector& x, Vector& y)
+{
+    const int size = x.size();
+
+    for (int i = 0; i < size; ++i)
+    {
+        y[i] += alpha * x[i];
+    }
+}
+
+// y = alpha * x + beta * y
+void Axpby(double alpha, const Vector& x, double beta, Vector& y)
+{
+    const int size = x.size();
+
+    for (int i = 0; i < size; ++i)
+    {
+        y[i] = alpha * x[i] + beta * y[i];
+    }
+}
+
+void ApplyPrec(const linalgcpp::Operator* M, const Vector& r, Vector& z)
+{
+    if (M)
+    {
+        M->Mult(r, z);
+    }
+    else
+    {
+        z = r;
+    }
+}
+
+// Recompute the residual r = b - A x, u = M^{-1} r and w = A u from the iterate
+void ReplaceResidual(const linalgcpp::Operator& A, const linalgcpp::Operator* M,
+                     const Vector& b, const Vector& x, Vector& r, Vector& u, Vector& w,
+                     Vector& work)
+{
+    A.Mult(x, work);
+
+    r = b;
+    r -= work;
+
+    ApplyPrec(M, r, u);
+    A.Mult(u, w);
+}
+
+bool AnyActive(const std::vector<bool>& active)
+{
+    return std::find(std::begin(active), std::end(active), true) != std::end(active);
+}
+
+// Preconditioned norms squared of the right hand sides, <b, M b>,
+// only computed for nonzero initial guesses, otherwise they equal
+// the initial residual norms and -1 is returned
+std::vector<double> RHSNorms(MPI_Comm comm, const linalgcpp::Operator* M,
+                             const std::vector<Vector>& b, const std::vector<Vector>& x,
+                             std::vector<Vector>& z)
+{
+    const int num_rhs = b.size();
+
+    std::vector<bool> all(num_rhs, true);
+    std::vector<double> x_norms;
+
+    BatchedDot(comm, x, x, all, x_norms);
+
+    std::vector<bool> warm(num_rhs);
+
+    for (int k = 0; k < num_rhs; ++k)
+    {
+        warm[k] = x_norms[k] > 0.0;
+
+        if (warm[k])
+        {
+            ApplyPrec(M, b[k], z[k]);
+        }
+    }
+
+    std::vector<double> b_norms(num_rhs, -1.0);
+
+    if (AnyActive(warm))
+    {
+        BatchedDot(comm, b, z, warm, b_norms);
+
+        for (int k = 0; k < num_rhs; ++k)
+        {
+            if (!warm[k])
+            {
+                b_norms[k] = -1.0;
+            }
+        }
+    }
+
+    return b_norms;
+}
+
+// Inner products of w with the first num_basis vectors of the basis V,
+// dots[k * num_basis + i] = <V[i][k], w[k]>, with a single reduction
+void BasisDots(MPI_Comm comm, const std::vector<std::vector<Vector>>& V, int num_basis,
+               const std::vector<Vector>& w, const std::vector<bool>& active,
+               std::vector<double>& dots)
+{
+    const int num_rhs = w.size();
+
+    std::vector<double> local_dots(num_rhs * num_basis, 0.0);
+
+    for (int k = 0; k < num_rhs; ++k)
+    {
+        if (!active[k])
+        {
+            continue;
+        }
+
+        const int size = w[k].size();
+
+        for (int i = 0; i < num_basis; ++i)
+        {
+            double& dot = local_dots[k * num_basis + i];
+
+            for (int j = 0; j < size; ++j)
+            {
+                dot += V[i][k][j] * w[k][j];
+            }
+        }
+    }
+
+    ParSum(comm, local_dots.data(), num_rhs * num_basis);
+
+    dots = std::move(local_dots);
+}
+} // namespace
+
+void BatchedDot(MPI_Comm comm, const std::vector<Vector>& lhs,
+                const std::vector<Vector>& rhs, const std::vector<bool>& active,
+                std::vector<double>& dots)
+{
+    const int num_vects = lhs.size();
+
+    assert(static_cast<int>(rhs.size()) == num_vects);
+    assert(static_cast<int>(active.size()) == num_vects);
+
+    std::vector<double> local_dots(num_vects, 0.0);
+
+    for (int k = 0; k < num_vects; ++k)
+    {
+        if (active[k])
+        {
+            const int size = lhs[k].size();
+
+            for (int i = 0; i < size; ++i)
+            {
+                local_dots[k] += lhs[k][i] * rhs[k][i];
+            }
+        }
+    }
+
+    ParSum(comm, local_dots.data(), num_vects);
+
+    dots = std::move(local_dots);
+}
+
+int BatchedPCG(MPI_Comm comm, const linalgcpp::Operator& A,
+               const linalgcpp::Operator* M,
+               const std::vector<Vector>& b, std::vector<Vector>& x,
+               int max_iter, double rel_tol, double abs_tol)
+{
+    const int num_rhs = b.size();
+
+    assert(static_cast<int>(x.size()) == num_rhs);
+
+    if (num_rhs == 0)
+    {
+        return 0;
+    }
+
+    const int size = A.Rows();
+
+    std::vector<Vector> r(num_rhs, Vector(size));
+    std::vector<Vector> z(num_rhs, Vector(size));
+    std::vector<Vector> p(num_rhs, Vector(size));
+    std::vector<Vector> Ap(num_rhs, Vector(size));
+
+    std::vector<bool> active(num_rhs, true);
+
+    std::vector<double> rz;
+    std::vector<double> rz_old;
+    std::vector<double> pAp;
+    std::vector<double> tol(num_rhs);
+
+    std::vector<double> b_norms = RHSNorms(comm, M, b, x, z);
+
+    for (int k = 0; k < num_rhs; ++k)
+    {
+        A.Mult(x[k], Ap[k]);
+
+        r[k] = b[k];
+        r[k] -= Ap[k];
+
+        ApplyPrec(M, r[k], z[k]);
+        p[k] = z[k];
+    }
+
+    BatchedDot(comm, r, z, active, rz);
+
+    for (int k = 0; k < num_rhs; ++k)
+    {
+        const double ref = b_norms[k] < 0.0 ? rz[k] : b_norms[k];
+
+        tol[k] = std::max(rel_tol * rel_tol * ref, abs_tol * abs_tol);
+        active[k] = rz[k] > tol[k];
+    }
+
+    int num_iter = 0;
+
+    for (; num_iter < max_iter && AnyActive(active); ++num_iter)
+    {
+        for (int k = 0; k < num_rhs; ++k)
+        {
+            if (active[k])
+            {
+                A.Mult(p[k], Ap[k]);
+            }
+        }
+
+        BatchedDot(comm, p, Ap, active, pAp);
+
+        for (int k = 0; k < num_rhs; ++k)
+        {
+            if (!active[k])
+            {
+                continue;
+            }
+
+            if (pAp[k] <= 0.0)
+            {
+                active[k] = false;
+                continue;
+            }
+
+            const double alpha = rz[k] / pAp[k];
+
+            Axpy(alpha, p[k], x[k]);
+            Axpy(-alpha, Ap[k], r[k]);
+
+            ApplyPrec(M, r[k], z[k]);
+        }
+
+        rz_old = rz;
+
+        BatchedDot(comm, r, z, active, rz);
+
+        for (int k = 0; k < num_rhs; ++k)
+        {
+            if (!active[k])
+            {
+                continue;
+            }
+
+            if (rz[k] <= tol[k])
+            {
+                active[k] = false;
+                continue;
+            }
+
+            Axpby(1.0, z[k], rz[k] / rz_old[k], p[k]);
+        }
+    }
+
+    return num_iter;
+}
+
+int BatchedPipelinedPCG(MPI_Comm comm, const linalgcpp::Operator& A,
+                        const linalgcpp::Operator* M,
+                        const std::vector<Vector>& b, std::vector<Vector>& x,
+                        int max_iter, double rel_tol, double abs_tol,
+                        int replace_freq)
+{
+    // Pipelined PCG as in Ghysels and Vanroose, with the residual r,
+    // u = M^{-1} r, w = A u, and the search direction p along with its
+    // images s = A p, q = M^{-1} s and z = A q.
+    const int num_rhs = b.size();
+
+    assert(static_cast<int>(x.size()) == num_rhs);
+
+    if (num_rhs == 0)
+    {
+        return 0;
+    }
+
+    const int size = A.Rows();
+
+    std::vector<Vector> r(num_rhs, Vector(size));
+    std::vector<Vector> u(num_rhs, Vector(size));
+    std::vector<Vector> w(num_rhs, Vector(size));
+    std::vector<Vector> m(num_rhs, Vector(size));
+    std::vector<Vector> n(num_rhs, Vector(size));
+    std::vector<Vector> p(num_rhs, Vector(size));
+    std::vector<Vector> s(num_rhs, Vector(size));
+    std::vector<Vector> q(num_rhs, Vector(size));
+    std::vector<Vector> z(num_rhs, Vector(size));
+
+    std::vector<bool> active(num_rhs, true);
+
+    // Restarted right hand sides take a steepest descent step next
+    std::vector<bool> restart(num_rhs, true);
+
+    std::vector<int> num_iter(num_rhs, 0);
+    std::vector<double> gamma_old(num_rhs);
+    std::vector<double> alpha_old(num_rhs);
+    std::vector<double> tol(num_rhs, -1.0);
+
+    std::vector<double> local_dots(2 * num_rhs);
+    std::vector<double> dots(2 * num_rhs);
+
+    const bool parallel = NumProcs(comm) > 1;
+
+    std::vector<double> b_norms = RHSNorms(comm, M, b, x, u);
+
+    for (int k = 0; k < num_rhs; ++k)
+    {
+        ReplaceResidual(A, M, b[k], x[k], r[k], u[k], w[k], m[k]);
+    }
+
+    while (AnyActive(active))
+    {
+        for (int k = 0; k < num_rhs; ++k)
+        {
+            local_dots[2 * k] = 0.0;
+            local_dots[2 * k + 1] = 0.0;
+
+            if (active[k])
+            {
+                for (int i = 0; i < size; ++i)
+                {
+                    local_dots[2 * k] += r[k][i] * u[k][i];
+                    local_dots[2 * k + 1] += w[k][i] * u[k][i];
+                }
+            }
+        }
+
+        // No reduction on a single processor, see ParSum
+        MPI_Request request = MPI_REQUEST_NULL;
+
+        if (parallel)
+        {
+            MPI_Iallreduce(local_dots.data(), dots.data(), 2 * num_rhs, MPI_DOUBLE,
+                           MPI_SUM, comm, &request);
+        }
+        else
+        {
+            dots = local_dots;
+        }
+
+        // Overlap the reduction with the next preconditioner and operator
+        for (int k = 0; k < num_rhs; ++k)
+        {
+            if (active[k])
+            {
+                ApplyPrec(M, w[k], m[k]);
+                A.Mult(m[k], n[k]);
+            }
+        }
+
+        if (parallel)
+        {
+            MPI_Wait(&request, MPI_STATUS_IGNORE);
+        }
+
+        for (int k = 0; k < num_rhs; ++k)
+        {
+            if (!active[k])
+            {
+                continue;
+            }
+
+            const double gamma = dots[2 * k];
+            const double delta = dots[2 * k + 1];
+
+            if (tol[k] < 0.0)
+            {
+                const double ref = b_norms[k] < 0.0 ? gamma : b_norms[k];
+
+                tol[k] = std::max(rel_tol * rel_tol * ref, abs_tol * abs_tol);
+            }
+
+            if (gamma <= tol[k] && gamma >= 0.0)
+            {
+                active[k] = false;
+                continue;
+            }
+
+            if (num_iter[k] >= max_iter)
+            {
+                active[k] = false;
+                continue;
+            }
+
+            const double beta = restart[k] ? 0.0 : gamma / gamma_old[k];
+            const double eta = restart[k] ? delta : delta - beta * gamma / alpha_old[k];
+
+            // Lost positivity, restart from the true residual,
+            // unless it was just computed and the problem is not SPD
+            if (gamma < 0.0 || eta <= 0.0)
+            {
+                if (restart[k])
+                {
+                    active[k] = false;
+                }
+                else
+                {
+                    ReplaceResidual(A, M, b[k], x[k], r[k], u[k], w[k], m[k]);
+                    restart[k] = true;
+                }
+
+                continue;
+            }
+
+            const double alpha = gamma / eta;
+
+            Axpby(1.0, n[k], beta, z[k]);
+            Axpby(1.0, m[k], beta, q[k]);
+            Axpby(1.0, w[k], beta, s[k]);
+            Axpby(1.0, u[k], beta, p[k]);
+
+            Axpy(alpha, p[k], x[k]);
+            Axpy(-alpha, s[k], r[k]);
+            Axpy(-alpha, q[k], u[k]);
+            Axpy(-alpha, z[k], w[k]);
+
+            gamma_old[k] = gamma;
+            alpha_old[k] = alpha;
+            restart[k] = false;
+
+            num_iter[k]++;
+
+            // Residual replacement, keeps the search direction
+            if (replace_freq > 0 && num_iter[k] % replace_freq == 0)
+            {
+                ReplaceResidual(A, M, b[k], x[k], r[k], u[k], w[k], m[k]);
+
+                A.Mult(p[k], s[k]);
+                ApplyPrec(M, s[k], q[k]);
+                A.Mult(q[k], z[k]);
+            }
+        }
+    }
+
+    return *std::max_element(std::begin(num_iter), std::end(num_iter));
+}
+
+int BatchedPMINRES(MPI_Comm comm, const linalgcpp::Operator& A,
+                   const linalgcpp::Operator* M,
+                   const std::vector<Vector>& b, std::vector<Vector>& x,
+                   int max_iter, double rel_tol, double abs_tol)
+{
+    // Preconditioned MINRES as in Elman, Silvester and Wathen,
+    // with the Lanczos vectors v, the preconditioned z = M^{-1} v,
+    // and the search directions w.
+    const int num_rhs = b.size();
+
+    assert(static_cast<int>(x.size()) == num_rhs);
+
+    if (num_rhs == 0)
+    {
+        return 0;
+    }
+
+    const int size = A.Rows();
+
+    std::vector<Vector> v(num_rhs, Vector(size));
+    std::vector<Vector> v_prev(num_rhs, Vector(size));
+    std::vector<Vector> z(num_rhs, Vector(size));
+    std::vector<Vector> z_next(num_rhs, Vector(size));
+    std::vector<Vector> Az(num_rhs, Vector(size));
+    std::vector<Vector> w(num_rhs, Vector(size));
+    std::vector<Vector> w_prev(num_rhs, Vector(size));
+
+    std::vector<bool> active(num_rhs, true);
+
+    std::vector<double> gamma;
+    std::vector<double> gamma_next;
+    std::vector<double> delta;
+    std::vector<double> gamma_prev(num_rhs, 1.0);
+    std::vector<double> c(num_rhs, 1.0);
+    std::vector<double> c_prev(num_rhs, 1.0);
+    std::vector<double> s(num_rhs, 0.0);
+    std::vector<double> s_prev(num_rhs, 0.0);
+    std::vector<double> eta(num_rhs);
+    std::vector<double> tol(num_rhs);
+
+    std::vector<double> b_norms = RHSNorms(comm, M, b, x, z);
+
+    for (int k = 0; k < num_rhs; ++k)
+    {
+        A.Mult(x[k], Az[k]);
+
+        v[k] = b[k];
+        v[k] -= Az[k];
+
+        v_prev[k] = 0.0;
+        w[k] = 0.0;
+        w_prev[k] = 0.0;
+
+        ApplyPrec(M, v[k], z[k]);
+    }
+
+    BatchedDot(comm, z, v, active, gamma);
+
+    for (int k = 0; k < num_rhs; ++k)
+    {
+        gamma[k] = std::sqrt(std::max(gamma[k], 0.0));
+        eta[k] = gamma[k];
+
+        const double ref = b_norms[k] < 0.0 ? gamma[k] : std::sqrt(std::max(b_norms[k], 0.0));
+
+        tol[k] = std::max(rel_tol * ref, abs_tol);
+        active[k] = gamma[k] > tol[k];
+    }
+
+    int num_iter = 0;
+
+    for (; num_iter < max_iter && AnyActive(active); ++num_iter)
+    {
+        for (int k = 0; k < num_rhs; ++k)
+        {
+            if (active[k])
+            {
+                z[k] /= gamma[k];
+                A.Mult(z[k], Az[k]);
+            }
+        }
+
+        BatchedDot(comm, Az, z, active, delta);
+
+        for (int k = 0; k < num_rhs; ++k)
+        {
+            if (active[k])
+            {
+                // v_next = Az - (delta / gamma) v - (gamma / gamma_prev) v_prev
+                Axpby(1.0, Az[k], -gamma[k] / gamma_prev[k], v_prev[k]);
+                Axpy(-delta[k] / gamma[k], v[k], v_prev[k]);
+                std::swap(v[k], v_prev[k]);
+
+                ApplyPrec(M, v[k], z_next[k]);
+            }
+        }
+
+        BatchedDot(comm, z_next, v, active, gamma_next);
+
+        for (int k = 0; k < num_rhs; ++k)
+        {
+            if (!active[k])
+            {
+                continue;
+            }
+
+            gamma_next[k] = std::sqrt(std::max(gamma_next[k], 0.0));
+
+            // Givens rotation
+            const double alpha_0 = c[k] * delta[k] - c_prev[k] * s[k] * gamma[k];
+            const double alpha_1 = std::sqrt(alpha_0 * alpha_0 + gamma_next[k] * gamma_next[k]);
+            const double alpha_2 = s[k] * delta[k] + c_prev[k] * c[k] * gamma[k];
+            const double alpha_3 = s_prev[k] * gamma[k];
+
+            const double c_next = alpha_0 / alpha_1;
+            const double s_next = gamma_next[k] / alpha_1;
+
+            // w_next = (z - alpha_3 w_prev - alpha_2 w) / alpha_1
+            Axpby(1.0 / alpha_1, z[k], -alpha_3 / alpha_1, w_prev[k]);
+            Axpy(-alpha_2 / alpha_1, w[k], w_prev[k]);
+            std::swap(w[k], w_prev[k]);
+
+            Axpy(c_next * eta[k], w[k], x[k]);
+            eta[k] *= -s_next;
+
+            gamma_prev[k] = gamma[k];
+            gamma[k] = gamma_next[k];
+            c_prev[k] = c[k];
+            c[k] = c_next;
+            s_prev[k] = s[k];
+            s[k] = s_next;
+
+            std::swap(z[k], z_next[k]);
+
+            active[k] = std::fabs(eta[k]) > tol[k];
+        }
+    }
+
+    return num_iter;
+}
+
+int BatchedFGMRES(MPI_Comm comm, const linalgcpp::Operator& A,
+                  const linalgcpp::Operator* M,
+                  const std::vector<Vector>& b, std::vector<Vector>& x,
+                  int max_iter, double rel_tol, double abs_tol,
+                  int restart)
+{
+    // Flexible GMRES as in Saad, with the Arnoldi vectors V, the
+    // preconditioned directions Z, and the Hessenberg matrix H reduced
+    // to upper triangular by Givens rotations as it is built.
+    const int num_rhs = b.size();
+
+    assert(static_cast<int>(x.size()) == num_rhs);
+    assert(restart > 0);
+
+    if (num_rhs == 0)
+    {
+        return 0;
+    }
+
+    const int size = A.Rows();
+    const int H_rows = restart + 1;
+
+    std::vector<std::vector<Vector>> V(restart + 1, std::vector<Vector>(num_rhs, Vector(size)));
+    std::vector<std::vector<Vector>> Z(restart, std::vector<Vector>(num_rhs, Vector(size)));
+    std::vector<Vector> Ax(num_rhs, Vector(size));
+
+    // Column major Hessenberg matrices, rotations and rotated residuals
+    std::vector<std::vector<double>> H(num_rhs, std::vector<double>(H_rows * restart));
+    std::vector<std::vector<double>> cs(num_rhs, std::vector<double>(restart));
+    std::vector<std::vector<double>> sn(num_rhs, std::vector<double>(restart));
+    std::vector<std::vector<double>> g(num_rhs, std::vector<double>(H_rows));
+
+    std::vector<bool> active(num_rhs, true);
+    std::vector<int> num_steps(num_rhs);
+
+    std::vector<double> beta;
+    std::vector<double> dots;
+    std::vector<double> norms;
+    std::vector<double> tol(num_rhs);
+
+    BatchedDot(comm, b, b, active, beta);
+
+    for (int k = 0; k < num_rhs; ++k)
+    {
+        tol[k] = std::max(rel_tol * std::sqrt(beta[k]), abs_tol);
+    }
+
+    int num_iter = 0;
+
+    while (num_iter < max_iter && AnyActive(active))
+    {
+        // Restart from the true residual
+        for (int k = 0; k < num_rhs; ++k)
+        {
+            if (active[k])
+            {
+                A.Mult(x[k], Ax[k]);
+
+                V[0][k] = b[k];
+                V[0][k] -= Ax[k];
+            }
+        }
+
+        BatchedDot(comm, V[0], V[0], active, beta);
+
+        for (int k = 0; k < num_rhs; ++k)
+        {
+            if (!active[k])
+            {
+                continue;
+            }
+
+            beta[k] = std::sqrt(std::max(beta[k], 0.0));
+            active[k] = beta[k] > tol[k];
+
+            if (active[k])
+            {
+                V[0][k] /= beta[k];
+
+                std::fill(std::begin(g[k]), std::end(g[k]), 0.0);
+                g[k][0] = beta[k];
+            }
+
+            num_steps[k] = 0;
+        }
+
+        std::vector<bool> cycle = active;
+
+        for (int j = 0; j < restart && num_iter < max_iter && AnyActive(cycle); ++j, ++num_iter)
+        {
+            for (int k = 0; k < num_rhs; ++k)
+            {
+                if (cycle[k])
+                {
+                    ApplyPrec(M, V[j][k], Z[j][k]);
+                    A.Mult(Z[j][k], V[j + 1][k]);
+
+                    std::fill_n(std::begin(H[k]) + j * H_rows, H_rows, 0.0);
+                }
+            }
+
+            // Classical Gram-Schmidt, twice for stability
+            for (int pass = 0; pass < 2; ++pass)
+            {
+                BasisDots(comm, V, j + 1, V[j + 1], cycle, dots);
+
+                for (int k = 0; k < num_rhs; ++k)
+                {
+                    if (!cycle[k])
+                    {
+                        continue;
+                    }
+
+                    for (int i = 0; i <= j; ++i)
+                    {
+                        const double h = dots[k * (j + 1) + i];
+
+                        H[k][j * H_rows + i] += h;
+                        Axpy(-h, V[i][k], V[j + 1][k]);
+                    }
+                }
+            }
+
+            BatchedDot(comm, V[j + 1], V[j + 1], cycle, norms);
+
+            for (int k = 0; k < num_rhs; ++k)
+            {
+                if (!cycle[k])
+                {
+                    continue;
+                }
+
+                double* h = &H[k][j * H_rows];
+
+                h[j + 1] = std::sqrt(std::max(norms[k], 0.0));
+
+                if (h[j + 1] > 0.0)
+                {
+                    V[j + 1][k] /= h[j + 1];
+                }
+
+                // Apply the previous rotations, then eliminate the subdiagonal
+                for (int i = 0; i < j; ++i)
+                {
+                    const double h_i = cs[k][i] * h[i] + sn[k][i] * h[i + 1];
+
+                    h[i + 1] = -sn[k][i] * h[i] + cs[k][i] * h[i + 1];
+                    h[i] = h_i;
+                }
+
+                const double denom = std::sqrt(h[j] * h[j] + h[j + 1] * h[j + 1]);
+
+                cs[k][j] = denom > 0.0 ? h[j] / denom : 1.0;
+                sn[k][j] = denom > 0.0 ? h[j + 1] / denom : 0.0;
+
+                h[j] = denom;
+                h[j + 1] = 0.0;
+
+                g[k][j + 1] = -sn[k][j] * g[k][j];
+                g[k][j] *= cs[k][j];
+
+                num_steps[k] = j + 1;
+
+                // Converged, or broke down with the solution in the Krylov space
+                if (std::fabs(g[k][j + 1]) <= tol[k] || denom == 0.0 || norms[k] <= 0.0)
+                {
+                    cycle[k] = false;
+                }
+            }
+        }
+
+        // x += Z y, with y from the triangular system H y = g
+        for (int k = 0; k < num_rhs; ++k)
+        {
+            const int steps = num_steps[k];
+
+            for (int i = steps - 1; i >= 0; --i)
+            {
+                for (int l = i + 1; l < steps; ++l)
+                {
+                    g[k][i] -= H[k][l * H_rows + i] * g[k][l];
+                }
+
+                g[k][i] = H[k][i * H_rows + i] != 0.0 ? g[k][i] / H[k][i * H_rows + i] : 0.0;
+            }
+
+            for (int i = 0; i < steps; ++i)
+            {
+                Axpy(g[k][i], Z[i][k], x[k]);
+            }
+
+            num_steps[k] = 0;
+        }
+    }
+
+    return num_iter;
+}
+
+} // namespace gauss
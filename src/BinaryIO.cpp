@@ -0,0 +1,321 @@
+/*BHEADER**********************************************************************
+ *
+ * Copyright (c) 2018, Lawrence Livermore National Security, LLC.
+ * Produced at the Lawrence Livermore National Laboratory.
+ * LLNL-CODE-759464. All Rights reserved. See file COPYRIGHT for details.
+ *
+ * This file is part of GAUSS. For more information and source code
+ * availability, see https://www.github.com/gelever/GAUSS.
+ *
+ * GAUSS is free software; you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License (as published by the Free
+ * Software Foundation) version 2.1 dated February 1999.
+ *
+ ***********************************************************************EHEADER*/
+
+/** @file
+
+    @brief Implements binary serialization routines
+*/
+
+#include <cstring>
+#include <stdexcept>
+
+#include "BinaryIO.hpp"
+
+namespace gauss
+{
+
+namespace
+{
+const char magic[8] = {'G', 'A', 'U', 'S', 'S', 'B', 'I', 'N'};
+}
+
+void WriteBinary(std::ostream& out, const Vector& vect)
+{
+    WriteBinary(out, std::vector<double>(std::begin(vect), std::end(vect)));
+}
+
+void ReadBinary(std::istream& in, Vector& vect)
+{
+    std::vector<double> data;
+    ReadBinary(in, data);
+
+    vect = Vector(std::move(data));
+}
+
+void WriteBinary(std::ostream& out, const SparseMatrix& mat)
+{
+    WriteBinary(out, mat.Rows());
+    WriteBinary(out, mat.Cols());
+    WriteBinary(out, mat.GetIndptr());
+    WriteBinary(out, mat.GetIndices());
+    WriteBinary(out, mat.GetData());
+}
+
+void ReadBinary(std::istream& in, SparseMatrix& mat)
+{
+    int rows;
+    int cols;
+    std::vector<int> indptr;
+    std::vector<int> indices;
+    std::vector<double> data;
+
+    ReadBinary(in, rows);
+    ReadBinary(in, cols);
+    ReadBinary(in, indptr);
+    ReadBinary(in, indices);
+    ReadBinary(in, data);
+
+    if (indptr.empty())
+    {
+        indptr.resize(rows + 1, 0);
+    }
+
+    mat = SparseMatrix(std::move(indptr), std::move(indices), std::move(data),
+                       rows, cols);
+}
+
+void WriteBinary(std::ostream& out, const DenseMatrix& mat)
+{
+    int rows = mat.Rows();
+    int cols = mat.Cols();
+
+    std::vector<double> data(rows * cols);
+
+    for (int j = 0; j < cols; ++j)
+    {
+        for (int i = 0; i < rows; ++i)
+        {
+            data[j * rows + i] = mat(i, j);
+        }
+    }
+
+    WriteBinary(out, rows);
+    WriteBinary(out, cols);
+    WriteBinary(out, data);
+}
+
+void ReadBinary(std::istream& in, DenseMatrix& mat)
+{
+    int rows;
+    int cols;
+    std::vector<double> data;
+
+    ReadBinary(in, rows);
+    ReadBinary(in, cols);
+    ReadBinary(in, data);
+
+    mat = DenseMatrix(rows, cols, std::move(data));
+}
+
+void WriteBinary(std::ostream& out, const ParMatrix& mat)
+{
+    bool is_empty = mat.GetRowStarts().empty();
+
+    WriteBinary(out, is_empty);
+
+    if (is_empty)
+    {
+        return;
+    }
+
+    WriteBinary(out, mat.GetRowStarts());
+    WriteBinary(out, mat.GetColStarts());
+    WriteBinary(out, mat.GetDiag());
+    WriteBinary(out, mat.GetOffd());
+    WriteBinary(out, mat.GetColMap());
+}
+
+void ReadBinary(std::istream& in, MPI_Comm comm, ParMatrix& mat)
+{
+    bool is_empty;
+    ReadBinary(in, is_empty);
+
+    if (is_empty)
+    {
+        mat = ParMatrix();
+        return;
+    }
+
+    std::vector<HYPRE_Int> row_starts;
+    std::vector<HYPRE_Int> col_starts;
+    SparseMatrix diag;
+    SparseMatrix offd;
+    std::vector<int> col_map;
+
+    ReadBinary(in, row_starts);
+    ReadBinary(in, col_starts);
+    ReadBinary(in, diag);
+    ReadBinary(in, offd);
+    ReadBinary(in, col_map);
+
+    mat = ParMatrix(comm, std::move(row_starts), std::move(col_starts),
+                    std::move(diag), std::move(offd), std::move(col_map));
+}
+
+void WriteBinary(std::ostream& out, const GraphTopology& gt)
+{
+    WriteBinary(out, gt.agg_vertex_local_);
+    WriteBinary(out, gt.agg_edge_local_);
+    WriteBinary(out, gt.face_edge_local_);
+    WriteBinary(out, gt.face_agg_local_);
+    WriteBinary(out, gt.agg_face_local_);
+
+    WriteBinary(out, gt.face_face_);
+    WriteBinary(out, gt.face_true_face_);
+    WriteBinary(out, gt.face_edge_);
+    WriteBinary(out, gt.agg_ext_vertex_);
+    WriteBinary(out, gt.agg_ext_edge_);
+    WriteBinary(out, gt.edge_true_edge_);
+}
+
+void ReadBinary(std::istream& in, MPI_Comm comm, GraphTopology& gt)
+{
+    ReadBinary(in, gt.agg_vertex_local_);
+    ReadBinary(in, gt.agg_edge_local_);
+    ReadBinary(in, gt.face_edge_local_);
+    ReadBinary(in, gt.face_agg_local_);
+    ReadBinary(in, gt.agg_face_local_);
+
+    ReadBinary(in, comm, gt.face_face_);
+    ReadBinary(in, comm, gt.face_true_face_);
+    ReadBinary(in, comm, gt.face_edge_);
+    ReadBinary(in, comm, gt.agg_ext_vertex_);
+    ReadBinary(in, comm, gt.agg_ext_edge_);
+    ReadBinary(in, comm, gt.edge_true_edge_);
+}
+
+void WriteBinary(std::ostream& out, const GraphSpace& graph_space)
+{
+    WriteBinary(out, graph_space.vertex_vdof);
+    WriteBinary(out, graph_space.vertex_edof);
+    WriteBinary(out, graph_space.vertex_bdof);
+    WriteBinary(out, graph_space.edge_edof);
+    WriteBinary(out, graph_space.agg_vertexdof);
+    WriteBinary(out, graph_space.face_facedof);
+}
+
+void ReadBinary(std::istream& in, MPI_Comm comm, GraphSpace& graph_space)
+{
+    ReadBinary(in, comm, graph_space.vertex_vdof);
+    ReadBinary(in, comm, graph_space.vertex_edof);
+    ReadBinary(in, comm, graph_space.vertex_bdof);
+    ReadBinary(in, comm, graph_space.edge_edof);
+    ReadBinary(in, comm, graph_space.agg_vertexdof);
+    ReadBinary(in, comm, graph_space.face_facedof);
+}
+
+void WriteBinary(std::ostream& out, const MixedMatrix& mm)
+{
+    WriteBinary(out, mm.IsDiagonalM());
+    WriteBinary(out, mm.GetElemMDiag());
+    WriteBinary(out, mm.GetElemM());
+    WriteBinary(out, mm.GetElemDof());
+    WriteBinary(out, mm.LocalD());
+    WriteBinary(out, mm.LocalW());
+    WriteBinary(out, mm.EdgeTrueEdge());
+}
+
+void ReadBinary(std::istream& in, MPI_Comm comm, MixedMatrix& mm)
+{
+    bool is_diagonal;
+    std::vector<double> M_elem_diag;
+    std::vector<DenseMatrix> M_elem;
+    SparseMatrix elem_dof;
+    SparseMatrix D_local;
+    SparseMatrix W_local;
+    ParMatrix edge_true_edge;
+
+    ReadBinary(in, is_diagonal);
+    ReadBinary(in, M_elem_diag);
+    ReadBinary(in, M_elem);
+    ReadBinary(in, elem_dof);
+    ReadBinary(in, D_local);
+    ReadBinary(in, W_local);
+    ReadBinary(in, comm, edge_true_edge);
+
+    if (is_diagonal)
+    {
+        mm = MixedMatrix(std::move(M_elem_diag), std::move(elem_dof), std::move(D_local),
+                         std::move(W_local), std::move(edge_true_edge));
+    }
+    else
+    {
+        mm = MixedMatrix(std::move(M_elem), std::move(elem_dof), std::move(D_local),
+                         std::move(W_local), std::move(edge_true_edge));
+    }
+}
+
+void WriteBinary(std::ostream& out, const Level& level)
+{
+    WriteBinary(out, level.mixed_matrix);
+    WriteBinary(out, level.graph_space);
+    WriteBinary(out, level.constant_rep);
+    WriteBinary(out, level.edge_elim_dofs);
+}
+
+void ReadBinary(std::istream& in, MPI_Comm comm, Level& level)
+{
+    MixedMatrix mm;
+    GraphSpace graph_space;
+    Vector constant_rep;
+    std::vector<int> edge_elim_dofs;
+
+    ReadBinary(in, comm, mm);
+    ReadBinary(in, comm, graph_space);
+    ReadBinary(in, constant_rep);
+    ReadBinary(in, edge_elim_dofs);
+
+    level = Level(std::move(mm), std::move(graph_space), std::move(constant_rep),
+                  true, std::move(edge_elim_dofs));
+}
+
+void WriteBinaryHeader(std::ostream& out, MPI_Comm comm, int version)
+{
+    int num_procs;
+    MPI_Comm_size(comm, &num_procs);
+
+    out.write(magic, sizeof(magic));
+
+    WriteBinary(out, version);
+    WriteBinary(out, num_procs);
+}
+
+int ReadBinaryHeader(std::istream& in, MPI_Comm comm)
+{
+    int num_procs;
+    MPI_Comm_size(comm, &num_procs);
+
+    char file_magic[sizeof(magic)];
+    in.read(file_magic, sizeof(magic));
+
+    if (!in || std::memcmp(file_magic, magic, sizeof(magic)) != 0)
+    {
+        throw std::runtime_error("Not a GAUSS binary file!");
+    }
+
+    int version;
+    int file_num_procs;
+
+    ReadBinary(in, version);
+    ReadBinary(in, file_num_procs);
+
+    if (file_num_procs != num_procs)
+    {
+        throw std::runtime_error("Binary file was written with " + std::to_string(file_num_procs)
+                                 + " processors, but " + std::to_string(num_procs) + " are in use!");
+    }
+
+    return version;
+}
+
+std::string ProcFilename(MPI_Comm comm, const std::string& prefix)
+{
+    int myid;
+    MPI_Comm_rank(comm, &myid);
+
+    return prefix + "." + std::to_string(myid);
+}
+
+} // namespace gauss
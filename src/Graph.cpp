@@ -18,11 +18,136 @@
     @brief Contains Graph class
 */
 
+#include <fstream>
+#include <stdexcept>
+
 #include "Graph.hpp"
+#include "GraphFile.hpp"
 
 namespace gauss
 {
 
+namespace
+{
+void OpenText(const std::string& filename, std::ifstream& in)
+{
+    in.open(filename);
+
+    if (!in)
+    {
+        throw std::runtime_error("Unable to open file: " + filename);
+    }
+}
+
+void CheckText(const std::string& filename, const std::istream& in)
+{
+    if (!in)
+    {
+        throw std::runtime_error("Error reading file: " + filename);
+    }
+}
+
+// Skip count whitespace separated values
+template <typename T>
+void SkipText(std::istream& in, long long count)
+{
+    T val;
+
+    for (long long i = 0; i < count; ++i)
+    {
+        in >> val;
+    }
+}
+
+// Read entries [begin, end) of a binary graph file,
+// or of a text file with one value per line
+template <typename T>
+std::vector<T> ReadBlock(const std::string& filename, int begin, int end)
+{
+    if (IsGraphFile(filename))
+    {
+        GraphFileReader reader(filename);
+
+        return reader.ReadArray<T>(begin, end);
+    }
+
+    std::ifstream in;
+    OpenText(filename, in);
+
+    SkipText<T>(in, begin);
+
+    std::vector<T> block(end - begin);
+
+    for (auto& val : block)
+    {
+        in >> val;
+    }
+
+    CheckText(filename, in);
+
+    return block;
+}
+
+// Read this processor's block of rows of a CSR matrix from a binary
+// graph file or a text file. The values of a text file are not read.
+SparseMatrix ReadRowBlock(const std::string& filename, int num_procs, int myid,
+                          int& num_rows, int& row_begin)
+{
+    if (IsGraphFile(filename))
+    {
+        GraphFileReader reader(filename);
+
+        num_rows = reader.Rows();
+        row_begin = BlockStart(num_rows, num_procs, myid);
+
+        return reader.ReadCSRRows(row_begin, BlockStart(num_rows, num_procs, myid + 1));
+    }
+
+    std::ifstream in;
+    OpenText(filename, in);
+
+    int num_cols;
+    in >> num_rows >> num_cols;
+
+    row_begin = BlockStart(num_rows, num_procs, myid);
+    int row_end = BlockStart(num_rows, num_procs, myid + 1);
+
+    SkipText<int>(in, row_begin);
+
+    std::vector<int> indptr(row_end - row_begin + 1);
+
+    for (auto& val : indptr)
+    {
+        in >> val;
+    }
+
+    SkipText<int>(in, num_rows - row_end);
+
+    const int offset = indptr[0];
+
+    for (auto& val : indptr)
+    {
+        val -= offset;
+    }
+
+    SkipText<int>(in, offset);
+
+    std::vector<int> indices(indptr.back());
+
+    for (auto& val : indices)
+    {
+        in >> val;
+    }
+
+    CheckText(filename, in);
+
+    std::vector<double> data(indices.size(), 1.0);
+
+    return SparseMatrix(std::move(indptr), std::move(indices), std::move(data),
+                        row_end - row_begin, num_cols);
+}
+} // namespace
+
 Graph::Graph(MPI_Comm comm, const SparseMatrix& vertex_edge_global,
              const std::vector<int>& part_global,
              const std::vector<double>& weight_global,
@@ -68,6 +193,268 @@ Graph::Graph(MPI_Comm comm, const SparseMatrix& vertex_edge_global,
     MakeLocalW(W_block_global);
 }
 
+Graph::Graph(MPI_Comm comm, const std::string& graph_filename,
+             const std::string& partition_filename,
+             const std::string& weight_filename)
+{
+    int myid;
+    int num_procs;
+
+    MPI_Comm_rank(comm, &myid);
+    MPI_Comm_size(comm, &num_procs);
+
+    // Read this processor's block of vertices and
+    // send each vertex to the owner of its partition
+    std::vector<std::vector<int>> send_vertices(num_procs);
+
+    {
+        int vertex_begin;
+        SparseMatrix vertex_edge = ReadRowBlock(graph_filename, num_procs, myid,
+                                                global_vertices_, vertex_begin);
+
+        global_edges_ = vertex_edge.Cols();
+
+        int vertex_end = vertex_begin + vertex_edge.Rows();
+
+        const auto& indptr = vertex_edge.GetIndptr();
+        const auto& indices = vertex_edge.GetIndices();
+
+        std::vector<int> part = ReadBlock<int>(partition_filename, vertex_begin, vertex_end);
+
+        int local_parts = part.empty() ? 0 : *std::max_element(std::begin(part), std::end(part)) + 1;
+        int num_parts;
+
+        MPI_Allreduce(&local_parts, &num_parts, 1, MPI_INT, MPI_MAX, comm);
+
+        if (num_parts < num_procs)
+        {
+            throw std::runtime_error("Partition " + partition_filename + " has " +
+                                     std::to_string(num_parts) + " parts, fewer than the " +
+                                     std::to_string(num_procs) + " processors");
+        }
+
+        for (int i = 0; i < vertex_end - vertex_begin; ++i)
+        {
+            auto& send = send_vertices[BlockOwner(num_parts, num_procs, part[i])];
+
+            send.push_back(vertex_begin + i);
+            send.push_back(part[i]);
+            send.push_back(indptr[i + 1] - indptr[i]);
+            send.insert(std::end(send), std::begin(indices) + indptr[i],
+                        std::begin(indices) + indptr[i + 1]);
+        }
+    }
+
+    auto recv_vertices = Exchange(comm, send_vertices, MPI_INT);
+    send_vertices.clear();
+
+    // Local vertices are ordered by global number, each received as
+    // its global number, partition, number of edges and the edges
+    std::vector<std::pair<int, const int*>> vertices;
+
+    for (const auto& recv : recv_vertices)
+    {
+        for (auto it = std::begin(recv); it != std::end(recv); it += 3 + it[2])
+        {
+            vertices.emplace_back(*it, &*it);
+        }
+    }
+
+    std::sort(std::begin(vertices), std::end(vertices));
+
+    int num_vertices = vertices.size();
+
+    vertex_map_.resize(num_vertices);
+    part_local_.resize(num_vertices);
+
+    std::vector<int> edge_map;
+
+    for (int i = 0; i < num_vertices; ++i)
+    {
+        const int* vertex = vertices[i].second;
+
+        vertex_map_[i] = vertex[0];
+        part_local_[i] = vertex[1];
+        edge_map.insert(std::end(edge_map), vertex + 3, vertex + 3 + vertex[2]);
+    }
+
+    ShiftPartition(part_local_);
+
+    std::sort(std::begin(edge_map), std::end(edge_map));
+    edge_map.erase(std::unique(std::begin(edge_map), std::end(edge_map)), std::end(edge_map));
+
+    int num_edges = edge_map.size();
+
+    std::vector<int> indptr(num_vertices + 1, 0);
+    std::vector<int> indices;
+
+    for (int i = 0; i < num_vertices; ++i)
+    {
+        const int* vertex = vertices[i].second;
+
+        for (int j = 0; j < vertex[2]; ++j)
+        {
+            auto edge = std::lower_bound(std::begin(edge_map), std::end(edge_map), vertex[3 + j]);
+            indices.push_back(edge - std::begin(edge_map));
+        }
+
+        std::sort(std::begin(indices) + indptr[i], std::end(indices));
+        indptr[i + 1] = indices.size();
+    }
+
+    std::vector<double> data(indices.size(), 1.0);
+
+    vertex_edge_local_ = SparseMatrix(std::move(indptr), std::move(indices), std::move(data),
+                                      num_vertices, num_edges);
+
+    vertices.clear();
+    recv_vertices.clear();
+
+    // Each edge is looked up on the processor whose block of edges contains it.
+    // The lowest processor that has the edge owns it, and the other processor
+    // that has it, if any, is told who shares it. Since edge_map is sorted,
+    // the replies come back in the order of the local edges.
+    std::vector<std::vector<int>> send_edges(num_procs);
+
+    for (auto edge : edge_map)
+    {
+        send_edges[BlockOwner(global_edges_, num_procs, edge)].push_back(edge);
+    }
+
+    auto recv_edges = Exchange(comm, send_edges, MPI_INT);
+
+    int edge_begin = BlockStart(global_edges_, num_procs, myid);
+    int edge_end = BlockStart(global_edges_, num_procs, myid + 1);
+
+    std::vector<int> first_proc(edge_end - edge_begin, -1);
+    std::vector<int> second_proc(edge_end - edge_begin, -1);
+
+    for (int proc = 0; proc < num_procs; ++proc)
+    {
+        for (auto edge : recv_edges[proc])
+        {
+            const int index = edge - edge_begin;
+
+            if (first_proc[index] == -1)
+            {
+                first_proc[index] = proc;
+            }
+            else
+            {
+                assert(second_proc[index] == -1);
+                second_proc[index] = proc;
+            }
+        }
+    }
+
+    std::vector<double> weight_block;
+
+    if (!weight_filename.empty())
+    {
+        weight_block = ReadBlock<double>(weight_filename, edge_begin, edge_end);
+    }
+
+    std::vector<std::vector<int>> send_owner(num_procs);
+    std::vector<std::vector<double>> send_weight(num_procs);
+
+    for (int proc = 0; proc < num_procs; ++proc)
+    {
+        for (auto edge : recv_edges[proc])
+        {
+            int first = first_proc[edge - edge_begin];
+            int second = second_proc[edge - edge_begin];
+
+            send_owner[proc].push_back(first);
+            send_owner[proc].push_back(proc == first ? second : first);
+
+            if (!weight_block.empty())
+            {
+                send_weight[proc].push_back(weight_block[edge - edge_begin]);
+            }
+        }
+    }
+
+    auto recv_owner = Exchange(comm, send_owner, MPI_INT);
+    auto recv_weight = Exchange(comm, send_weight, MPI_DOUBLE);
+
+    std::vector<int> edge_owner;
+    std::vector<int> edge_shared;
+
+    edge_owner.reserve(num_edges);
+    edge_shared.reserve(num_edges);
+    weight_local_.reserve(num_edges);
+
+    for (int proc = 0; proc < num_procs; ++proc)
+    {
+        for (auto it = std::begin(recv_owner[proc]); it != std::end(recv_owner[proc]); it += 2)
+        {
+            edge_owner.push_back(it[0]);
+            edge_shared.push_back(it[1]);
+        }
+
+        for (auto weight : recv_weight[proc])
+        {
+            assert(std::fabs(weight) > 1e-14);
+            weight_local_.push_back(std::fabs(weight));
+        }
+    }
+
+    assert(static_cast<int>(edge_owner.size()) == num_edges);
+
+    // Owners number their true edges in order of global edge number,
+    // and send the true edge number to the processor that shares it
+    int num_tedges_local = std::count(std::begin(edge_owner), std::end(edge_owner), myid);
+    auto tedge_starts = linalgcpp::GenerateOffsets(comm, num_tedges_local);
+
+    std::vector<HYPRE_Int> edge_tedge(num_edges, -1);
+    std::vector<std::vector<HYPRE_Int>> send_tedge(num_procs);
+
+    HYPRE_Int tedge = tedge_starts[0];
+
+    for (int i = 0; i < num_edges; ++i)
+    {
+        if (edge_owner[i] == myid)
+        {
+            edge_tedge[i] = tedge++;
+
+            if (edge_shared[i] >= 0)
+            {
+                send_tedge[edge_shared[i]].push_back(edge_map[i]);
+                send_tedge[edge_shared[i]].push_back(edge_tedge[i]);
+            }
+        }
+    }
+
+    auto recv_tedge = Exchange(comm, send_tedge, HYPRE_MPI_INT);
+
+    for (const auto& recv : recv_tedge)
+    {
+        for (auto it = std::begin(recv); it != std::end(recv); it += 2)
+        {
+            auto edge = std::lower_bound(std::begin(edge_map), std::end(edge_map), it[0]);
+            assert(edge != std::end(edge_map) && *edge == it[0]);
+
+            edge_tedge[edge - std::begin(edge_map)] = it[1];
+        }
+    }
+
+    assert(std::find(std::begin(edge_tedge), std::end(edge_tedge), -1) == std::end(edge_tedge));
+
+    edge_true_edge_ = MakeEdgeTrueEdge(comm, edge_tedge, num_tedges_local);
+
+    ParMatrix edge_true_edge_T = edge_true_edge_.Transpose();
+    edge_edge_ = edge_true_edge_.Mult(edge_true_edge_T);
+
+    if (weight_filename.empty())
+    {
+        weight_local_.assign(num_edges, 1.0);
+    }
+
+    assert(static_cast<int>(weight_local_.size()) == num_edges);
+
+    ScaleSharedWeight();
+}
+
 void Graph::MakeLocalWeight(const std::vector<int>& edge_map,
                             const std::vector<double>& global_weight)
 {
@@ -90,6 +477,13 @@ void Graph::MakeLocalWeight(const std::vector<int>& edge_map,
         std::fill(std::begin(weight_local_), std::end(weight_local_), 1.0);
     }
 
+    ScaleSharedWeight();
+}
+
+void Graph::ScaleSharedWeight()
+{
+    int num_edges = vertex_edge_local_.Cols();
+
     const SparseMatrix& edge_offd = edge_edge_.GetOffd();
 
     assert(edge_offd.Rows() == num_edges);
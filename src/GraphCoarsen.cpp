@@ -25,31 +25,55 @@ namespace gauss
 {
 
 GraphCoarsen::GraphCoarsen(const Graph& graph, const MixedMatrix& mgl,
-                           SpectralPair spect_pair)
+                           SpectralPair spect_pair, bool warm_start)
     : GraphCoarsen(GraphTopology(graph), FineGraphSpace(graph), mgl,
                    Vector(graph.vertex_edge_local_.Rows(), 1.0 / std::sqrt(graph.global_vertices_)),
-                   spect_pair)
+                   spect_pair, warm_start)
 {
 
 }
 
 GraphCoarsen::GraphCoarsen(GraphTopology gt, const Level& level,
-                           SpectralPair spect_pair)
+                           SpectralPair spect_pair, bool warm_start)
     : GraphCoarsen(std::move(gt), level.graph_space, level.mixed_matrix, level.constant_rep,
-                   spect_pair)
+                   spect_pair, warm_start)
 {
 
 }
 
 GraphCoarsen::GraphCoarsen(GraphTopology gt, const GraphSpace& graph_space,
                            const MixedMatrix& mgl, const VectorView& constant_rep,
-                           SpectralPair spect_pair)
+                           SpectralPair spect_pair, bool warm_start)
     : gt_(std::move(gt)),
       max_evects_(spect_pair.second), spect_tol_(spect_pair.first),
+      warm_start_(warm_start),
       vertex_targets_(gt_.NumAggs()),
       edge_targets_(gt_.NumFaces()),
       agg_ext_sigma_(gt_.NumAggs()),
       D_trace_sum_(gt_.NumAggs())
+{
+    BuildExtension(graph_space, mgl);
+    ComputeTargets(mgl, constant_rep);
+}
+
+void GraphCoarsen::Update(const Level& level)
+{
+    Update(level.graph_space, level.mixed_matrix, level.constant_rep);
+}
+
+void GraphCoarsen::Update(const GraphSpace& graph_space, const MixedMatrix& mgl,
+                          const VectorView& constant_rep)
+{
+    // Extraction plans are only valid if the dof layout is unchanged
+    if (DofLayout(graph_space) != dof_layout_)
+    {
+        BuildExtension(graph_space, mgl);
+    }
+
+    ComputeTargets(mgl, constant_rep);
+}
+
+void GraphCoarsen::BuildExtension(const GraphSpace& graph_space, const MixedMatrix& mgl)
 {
     const ParMatrix& v_vdof = graph_space.vertex_vdof;
     const ParMatrix& v_bdof = graph_space.vertex_bdof;
@@ -62,17 +86,15 @@ GraphCoarsen::GraphCoarsen(GraphTopology gt, const GraphSpace& graph_space,
     agg_ext_edof_ = linalgcpp::ParAdd(no_bub, with_bub);
     agg_ext_vdof_ = gt_.agg_ext_vertex_.Mult(v_vdof);
 
-    ParMatrix permute_v = MakeExtPermutation(gt_.agg_ext_vertex_.Mult(v_vdof));
-    ParMatrix permute_e = MakeExtPermutation(agg_ext_edof_);
-    ParMatrix permute_e_T = permute_e.Transpose();
+    permute_v_ = MakeExtPermutation(agg_ext_vdof_);
+    permute_e_ = MakeExtPermutation(agg_ext_edof_);
 
-    ParMatrix M_ext_global = permute_e.Mult(mgl.GlobalM().Mult(permute_e_T));
-    ParMatrix D_ext_global = permute_v.Mult(mgl.GlobalD().Mult(permute_e_T));
+    ParMatrix permute_e_T = permute_e_.Transpose();
 
-    ParMatrix face_perm_edge = gt_.face_edge_.Mult(e_edof).Mult(mgl.EdgeTrueEdge()).Mult(permute_e_T);
+    face_perm_edge_ = gt_.face_edge_.Mult(e_edof).Mult(mgl.EdgeTrueEdge()).Mult(permute_e_T);
 
-    int marker_size = std::max(permute_v.Rows(), permute_e.Rows());
-    col_marker_.resize(marker_size, -1);
+    int marker_size = std::max(permute_v_.Rows(), permute_e_.Rows());
+    col_marker_.assign(marker_size, -1);
 
     SparseMatrix agg_edgedof = gt_.agg_edge_local_.Mult(e_edof.GetDiag());
     SparseMatrix agg_bubbledof = gt_.agg_vertex_local_.Mult(v_bdof.GetDiag());
@@ -81,8 +103,32 @@ GraphCoarsen::GraphCoarsen(GraphTopology gt, const GraphSpace& graph_space,
     agg_vertexdof_ = gt_.agg_vertex_local_.Mult(v_vdof.GetDiag());
     face_edgedof_ = gt_.face_edge_local_.Mult(e_edof.GetDiag());
 
+    dof_layout_ = DofLayout(graph_space);
+
+    // Previous eigenvectors do not match a new layout
+    agg_ext_evects_.clear();
+
+    if (warm_start_)
+    {
+        agg_ext_evects_.resize(gt_.NumAggs());
+    }
+}
+
+void GraphCoarsen::ComputeTargets(const MixedMatrix& mgl, const VectorView& constant_rep)
+{
+    ParMatrix permute_e_T = permute_e_.Transpose();
+
+    ParMatrix M_ext_global = permute_e_.Mult(mgl.GlobalM().Mult(permute_e_T));
+    ParMatrix D_ext_global = permute_v_.Mult(mgl.GlobalD().Mult(permute_e_T));
+
+    agg_ext_sigma_.clear();
+    agg_ext_sigma_.resize(gt_.NumAggs());
+
+    D_trace_sum_.clear();
+    D_trace_sum_.resize(gt_.NumAggs());
+
     ComputeVertexTargets(M_ext_global, D_ext_global);
-    ComputeEdgeTargets(mgl, constant_rep, face_perm_edge);
+    ComputeEdgeTargets(mgl, constant_rep, face_perm_edge_);
 
     BuildFaceCoarseDof();
     BuildAggBubbleDof();
@@ -95,10 +141,24 @@ GraphCoarsen::GraphCoarsen(GraphTopology gt, const GraphSpace& graph_space,
     DebugChecks(mgl);
 }
 
+std::vector<int> GraphCoarsen::DofLayout(const GraphSpace& graph_space) const
+{
+    std::vector<int> layout = graph_space.vertex_vdof.GetDiag().GetIndptr();
+
+    const auto& edge_indptr = graph_space.edge_edof.GetDiag().GetIndptr();
+    const auto& bubble_indptr = graph_space.vertex_bdof.GetDiag().GetIndptr();
+
+    layout.insert(std::end(layout), std::begin(edge_indptr), std::end(edge_indptr));
+    layout.insert(std::end(layout), std::begin(bubble_indptr), std::end(bubble_indptr));
+
+    return layout;
+}
+
 GraphCoarsen::GraphCoarsen(const GraphCoarsen& other) noexcept
     : gt_(other.gt_),
       max_evects_(other.max_evects_),
       spect_tol_(other.spect_tol_),
+      warm_start_(other.warm_start_),
       Q_edge_(other.Q_edge_),
       P_edge_(other.P_edge_),
       P_vertex_(other.P_vertex_),
@@ -114,8 +174,15 @@ GraphCoarsen::GraphCoarsen(const GraphCoarsen& other) noexcept
       agg_ext_vdof_(other.agg_ext_vdof_),
       agg_ext_edof_(other.agg_ext_edof_),
       // End tmp stuff
+      permute_v_(other.permute_v_),
+      permute_e_(other.permute_e_),
+      face_perm_edge_(other.face_perm_edge_),
+      dof_layout_(other.dof_layout_),
+      agg_ext_evects_(other.agg_ext_evects_),
       col_marker_(other.col_marker_),
-      D_trace_sum_(other.D_trace_sum_)
+      D_trace_sum_(other.D_trace_sum_),
+      num_not_converged_(other.num_not_converged_),
+      num_warm_started_(other.num_warm_started_)
 {
 
 }
@@ -138,6 +205,7 @@ void swap(GraphCoarsen& lhs, GraphCoarsen& rhs) noexcept
 
     std::swap(lhs.max_evects_, rhs.max_evects_);
     std::swap(lhs.spect_tol_, rhs.spect_tol_);
+    std::swap(lhs.warm_start_, rhs.warm_start_);
 
     swap(lhs.Q_edge_, rhs.Q_edge_);
     swap(lhs.P_edge_, rhs.P_edge_);
@@ -153,6 +221,9 @@ void swap(GraphCoarsen& lhs, GraphCoarsen& rhs) noexcept
 
     swap(lhs.D_trace_sum_, rhs.D_trace_sum_);
 
+    std::swap(lhs.num_not_converged_, rhs.num_not_converged_);
+    std::swap(lhs.num_warm_started_, rhs.num_warm_started_);
+
     // Temp Stuff
     swap(lhs.agg_vertexdof_, rhs.agg_vertexdof_);
     swap(lhs.agg_edgedof_, rhs.agg_edgedof_);
@@ -161,6 +232,82 @@ void swap(GraphCoarsen& lhs, GraphCoarsen& rhs) noexcept
     swap(lhs.agg_ext_vdof_, rhs.agg_ext_vdof_);
     swap(lhs.agg_ext_edof_, rhs.agg_ext_edof_);
     // End Temp Stuff
+
+    swap(lhs.permute_v_, rhs.permute_v_);
+    swap(lhs.permute_e_, rhs.permute_e_);
+    swap(lhs.face_perm_edge_, rhs.face_perm_edge_);
+    swap(lhs.dof_layout_, rhs.dof_layout_);
+    swap(lhs.agg_ext_evects_, rhs.agg_ext_evects_);
+}
+
+void WriteBinary(std::ostream& out, const GraphCoarsen& coarsener)
+{
+    WriteBinary(out, coarsener.gt_);
+
+    WriteBinary(out, coarsener.max_evects_);
+    WriteBinary(out, coarsener.spect_tol_);
+    WriteBinary(out, coarsener.warm_start_);
+
+    WriteBinary(out, coarsener.Q_edge_);
+    WriteBinary(out, coarsener.P_edge_);
+    WriteBinary(out, coarsener.P_vertex_);
+    WriteBinary(out, coarsener.face_cdof_);
+    WriteBinary(out, coarsener.agg_bubble_dof_);
+
+    WriteBinary(out, coarsener.vertex_targets_);
+    WriteBinary(out, coarsener.edge_targets_);
+
+    WriteBinary(out, coarsener.agg_vertexdof_);
+    WriteBinary(out, coarsener.agg_edgedof_);
+    WriteBinary(out, coarsener.face_edgedof_);
+    WriteBinary(out, coarsener.agg_ext_vdof_);
+    WriteBinary(out, coarsener.agg_ext_edof_);
+
+    WriteBinary(out, coarsener.permute_v_);
+    WriteBinary(out, coarsener.permute_e_);
+    WriteBinary(out, coarsener.face_perm_edge_);
+    WriteBinary(out, coarsener.dof_layout_);
+    WriteBinary(out, coarsener.agg_ext_evects_);
+
+    WriteBinary(out, coarsener.D_trace_sum_);
+}
+
+void ReadBinary(std::istream& in, MPI_Comm comm, GraphCoarsen& coarsener)
+{
+    ReadBinary(in, comm, coarsener.gt_);
+
+    ReadBinary(in, coarsener.max_evects_);
+    ReadBinary(in, coarsener.spect_tol_);
+    ReadBinary(in, coarsener.warm_start_);
+
+    ReadBinary(in, coarsener.Q_edge_);
+    ReadBinary(in, coarsener.P_edge_);
+    ReadBinary(in, coarsener.P_vertex_);
+    ReadBinary(in, coarsener.face_cdof_);
+    ReadBinary(in, coarsener.agg_bubble_dof_);
+
+    ReadBinary(in, coarsener.vertex_targets_);
+    ReadBinary(in, coarsener.edge_targets_);
+
+    ReadBinary(in, coarsener.agg_vertexdof_);
+    ReadBinary(in, coarsener.agg_edgedof_);
+    ReadBinary(in, coarsener.face_edgedof_);
+    ReadBinary(in, comm, coarsener.agg_ext_vdof_);
+    ReadBinary(in, comm, coarsener.agg_ext_edof_);
+
+    ReadBinary(in, comm, coarsener.permute_v_);
+    ReadBinary(in, comm, coarsener.permute_e_);
+    ReadBinary(in, comm, coarsener.face_perm_edge_);
+    ReadBinary(in, coarsener.dof_layout_);
+    ReadBinary(in, coarsener.agg_ext_evects_);
+
+    ReadBinary(in, coarsener.D_trace_sum_);
+
+    coarsener.agg_ext_sigma_.clear();
+    coarsener.agg_ext_sigma_.resize(coarsener.gt_.NumAggs());
+
+    int marker_size = std::max(coarsener.permute_v_.Rows(), coarsener.permute_e_.Rows());
+    coarsener.col_marker_.assign(marker_size, -1);
 }
 
 void GraphCoarsen::ComputeVertexTargets(const ParMatrix& M_ext_global,
@@ -170,50 +317,115 @@ void GraphCoarsen::ComputeVertexTargets(const ParMatrix& M_ext_global,
     const SparseMatrix& D_ext = D_ext_global.GetDiag();
 
     int num_aggs = gt_.NumAggs();
+    int marker_size = col_marker_.size();
+
+    // Aggregates are solved in fixed chunks, so the batched eigensolver can
+    // group aggregates of the same size. The chunks do not depend on the
+    // number of threads, so neither do the batches nor the results.
+    const int chunk_size = 256;
+    const int num_chunks = (num_aggs + chunk_size - 1) / chunk_size;
+
+    int num_not_converged = 0;
+    int num_warm_started = 0;
+
+    // Chunks are independent, each thread keeps its own
+    // eigensolver workspace and column marker
+#if GAUSS_USE_OPENMP
+    #pragma omp parallel reduction(+:num_not_converged, num_warm_started)
+#endif
+    {
+        LocalEigenSolver eigs(max_evects_, spect_tol_);
+        std::vector<int> col_marker(marker_size, -1);
 
-    LocalEigenSolver eigs(max_evects_, spect_tol_);
+        std::vector<int> aggs;
+        std::vector<SparseMatrix> M_sub;
+        std::vector<SparseMatrix> D_sub;
+        std::vector<DenseMatrix> initial_evects;
+        std::vector<DenseMatrix> evects;
 
-    DenseMatrix evects;
-    DenseMatrix DT_evect;
+        DenseMatrix DT_evect;
 
-    for (int agg = 0; agg < num_aggs; ++agg)
-    {
-        std::vector<int> edge_dofs_ext = GetExtDofs(agg_ext_edof_, agg);
-        std::vector<int> vertex_dofs_ext = GetExtDofs(agg_ext_vdof_, agg);
+#if GAUSS_USE_OPENMP
+        #pragma omp for schedule(dynamic)
+#endif
+        for (int chunk = 0; chunk < num_chunks; ++chunk)
+        {
+            int agg_begin = chunk * chunk_size;
+            int agg_end = std::min(agg_begin + chunk_size, num_aggs);
 
-        std::vector<int> vertex_dofs_local = agg_vertexdof_.GetIndices(agg);
+            aggs.clear();
+            M_sub.clear();
+            D_sub.clear();
+            initial_evects.clear();
 
-        if (edge_dofs_ext.size() == 0)
-        {
-            vertex_targets_[agg] = DenseMatrix(1, 1, {1.0});
-            continue;
-        }
+            for (int agg = agg_begin; agg < agg_end; ++agg)
+            {
+                std::vector<int> edge_dofs_ext = GetExtDofs(agg_ext_edof_, agg);
 
-        SparseMatrix M_sub = M_ext.GetSubMatrix(edge_dofs_ext, edge_dofs_ext, col_marker_);
-        SparseMatrix D_sub = D_ext.GetSubMatrix(vertex_dofs_ext, edge_dofs_ext, col_marker_);
+                if (edge_dofs_ext.size() == 0)
+                {
+                    vertex_targets_[agg] = DenseMatrix(1, 1, {1.0});
+                    continue;
+                }
 
-        eigs.BlockCompute(M_sub, D_sub, evects);
+                std::vector<int> vertex_dofs_ext = GetExtDofs(agg_ext_vdof_, agg);
 
-        if (evects.Cols() > 1)
-        {
-            SparseSolver M_inv(std::move(M_sub));
+                aggs.push_back(agg);
+                M_sub.push_back(M_ext.GetSubMatrix(edge_dofs_ext, edge_dofs_ext, col_marker));
+                D_sub.push_back(D_ext.GetSubMatrix(vertex_dofs_ext, edge_dofs_ext, col_marker));
 
-            OffsetMultAT(D_sub, evects, DT_evect, 1);
-            OffsetMult(M_inv, DT_evect, agg_ext_sigma_[agg], 0);
-        }
+                if (warm_start_)
+                {
+                    initial_evects.push_back(std::move(agg_ext_evects_[agg]));
+                }
+            }
 
-        DenseMatrix evects_restricted = RestrictLocal(evects, col_marker_,
-                                                      vertex_dofs_ext, vertex_dofs_local);
+            eigs.BlockCompute(M_sub, D_sub, evects, initial_evects);
 
-        VectorView first_vect = evects_restricted.GetColView(0);
-        vertex_targets_[agg] = Orthogonalize(evects_restricted, first_vect, 1, max_evects_);
+            int num_chunk_aggs = aggs.size();
+
+            for (int i = 0; i < num_chunk_aggs; ++i)
+            {
+                int agg = aggs[i];
+
+                if (warm_start_)
+                {
+                    agg_ext_evects_[agg] = evects[i];
+                }
+
+                if (evects[i].Cols() > 1)
+                {
+                    SparseSolver M_inv(std::move(M_sub[i]));
+
+                    OffsetMultAT(D_sub[i], evects[i], DT_evect, 1);
+                    OffsetMult(M_inv, DT_evect, agg_ext_sigma_[agg], 0);
+                }
+
+                std::vector<int> vertex_dofs_ext = GetExtDofs(agg_ext_vdof_, agg);
+                std::vector<int> vertex_dofs_local = agg_vertexdof_.GetIndices(agg);
+
+                DenseMatrix evects_restricted = RestrictLocal(evects[i], col_marker,
+                                                              vertex_dofs_ext, vertex_dofs_local);
+
+                VectorView first_vect = evects_restricted.GetColView(0);
+                vertex_targets_[agg] = Orthogonalize(evects_restricted, first_vect, 1, max_evects_);
+            }
+        }
+
+        num_not_converged += eigs.NumNotConverged();
+        num_warm_started += eigs.NumWarmStarted();
     }
+
+    int counts[2] = {num_not_converged, num_warm_started};
+    MPI_Allreduce(MPI_IN_PLACE, counts, 2, MPI_INT, MPI_SUM, M_ext_global.GetComm());
+
+    num_not_converged_ = counts[0];
+    num_warm_started_ = counts[1];
 }
 
-std::vector<std::vector<DenseMatrix>> GraphCoarsen::CollectSigma(const SparseMatrix& face_edgedof)
+std::vector<std::vector<DenseMatrix>>& GraphCoarsen::CollectSigma(
+    const SparseMatrix& face_edgedof, SharedEntityComm<DenseMatrix>& sec_sigma)
 {
-    SharedEntityComm<DenseMatrix> sec_sigma(gt_.face_true_face_);
-
     int num_faces = gt_.NumFaces();
 
     for (int face = 0; face < num_faces; ++face)
@@ -250,13 +462,12 @@ std::vector<std::vector<DenseMatrix>> GraphCoarsen::CollectSigma(const SparseMat
         sec_sigma.ReduceSend(face, std::move(face_sigma));
     }
 
-    return sec_sigma.Collect();
+    return sec_sigma.CollectBegin();
 }
 
-std::vector<std::vector<Vector>> GraphCoarsen::CollectConstant(const VectorView& constant_vect)
+std::vector<std::vector<Vector>>& GraphCoarsen::CollectConstant(
+    const VectorView& constant_vect, SharedEntityComm<Vector>& sec_constant)
 {
-    SharedEntityComm<Vector> sec_constant(gt_.face_true_face_);
-
     int num_faces = gt_.NumFaces();
 
     for (int face = 0; face < num_faces; ++face)
@@ -276,15 +487,14 @@ std::vector<std::vector<Vector>> GraphCoarsen::CollectConstant(const VectorView&
         sec_constant.ReduceSend(face, Vector(std::move(constant_data)));
     }
 
-    return sec_constant.Collect();
+    return sec_constant.CollectBegin();
 }
 
-std::vector<std::vector<SparseMatrix>> GraphCoarsen::CollectD(const MixedMatrix& mgl)
+std::vector<std::vector<SparseMatrix>>& GraphCoarsen::CollectD(
+    const MixedMatrix& mgl, SharedEntityComm<SparseMatrix>& sec_D)
 {
     const auto& D_local = mgl.LocalD();
 
-    SharedEntityComm<SparseMatrix> sec_D(gt_.face_true_face_);
-
     int num_faces = gt_.NumFaces();
 
     for (int face = 0; face < num_faces; ++face)
@@ -309,13 +519,12 @@ std::vector<std::vector<SparseMatrix>> GraphCoarsen::CollectD(const MixedMatrix&
         sec_D.ReduceSend(face, std::move(D_face));
     }
 
-    return sec_D.Collect();
+    return sec_D.CollectBegin();
 }
 
-std::vector<std::vector<SparseMatrix>> GraphCoarsen::CollectM(const SparseMatrix& M_local)
+std::vector<std::vector<SparseMatrix>>& GraphCoarsen::CollectM(
+    const SparseMatrix& M_local, SharedEntityComm<SparseMatrix>& sec_M)
 {
-    SharedEntityComm<SparseMatrix> sec_M(gt_.face_true_face_);
-
     int num_faces = gt_.NumFaces();
 
     for (int face = 0; face < num_faces; ++face)
@@ -335,7 +544,7 @@ std::vector<std::vector<SparseMatrix>> GraphCoarsen::CollectM(const SparseMatrix
         sec_M.ReduceSend(face, std::move(M_face));
     }
 
-    return sec_M.Collect();
+    return sec_M.CollectBegin();
 }
 
 void GraphCoarsen::ComputeEdgeTargets(const MixedMatrix& mgl, const VectorView& constant_vect,
@@ -343,65 +552,102 @@ void GraphCoarsen::ComputeEdgeTargets(const MixedMatrix& mgl, const VectorView&
 {
     const SparseMatrix& face_edge = face_perm_edge.GetDiag();
 
-    auto shared_sigma = CollectSigma(face_edge);
-    auto shared_constant = CollectConstant(constant_vect);
-    auto shared_M = CollectM(mgl.LocalM());
-    auto shared_D = CollectD(mgl);
+    SharedEntityPlan& face_plan = gt_.FacePlan();
 
-    const SparseMatrix& face_shared = gt_.face_face_.GetOffd();
+    SharedEntityComm<DenseMatrix> sec_sigma(face_plan);
+    SharedEntityComm<Vector> sec_constant(face_plan);
+    SharedEntityComm<SparseMatrix> sec_M(face_plan);
+    SharedEntityComm<SparseMatrix> sec_D(face_plan);
+
+    auto& shared_sigma = CollectSigma(face_edge, sec_sigma);
+    auto& shared_constant = CollectConstant(constant_vect, sec_constant);
+    auto& shared_M = CollectM(mgl.LocalM(), sec_M);
+    auto& shared_D = CollectD(mgl, sec_D);
+
+    // Interior faces need no remote data, so they are computed
+    // while the shared face data is in flight
+    ComputeFaceTargets(face_edge, false, shared_sigma, shared_constant, shared_M, shared_D);
 
-    SharedEntityComm<DenseMatrix> sec_face(gt_.face_true_face_);
-    DenseMatrix collected_sigma;
+    sec_sigma.CollectEnd();
+    sec_constant.CollectEnd();
+    sec_M.CollectEnd();
+    sec_D.CollectEnd();
+
+    ComputeFaceTargets(face_edge, true, shared_sigma, shared_constant, shared_M, shared_D);
+
+    SharedEntityComm<DenseMatrix> sec_face(face_plan);
+
+    sec_face.Broadcast(edge_targets_);
+
+    ScaleEdgeTargets(mgl, constant_vect);
+}
+
+void GraphCoarsen::ComputeFaceTargets(const SparseMatrix& face_edge, bool shared_faces,
+                                      Vect2D<DenseMatrix>& shared_sigma,
+                                      Vect2D<Vector>& shared_constant,
+                                      Vect2D<SparseMatrix>& shared_M,
+                                      Vect2D<SparseMatrix>& shared_D)
+{
+    const SparseMatrix& face_shared = gt_.face_face_.GetOffd();
+    const SharedEntityPlan& face_plan = gt_.FacePlan();
 
     int num_faces = gt_.NumFaces();
+    int myid = MyId();
 
-    for (int face = 0; face < num_faces; ++face)
+    // Faces are independent once their data is collected,
+    // communication stays on the main thread
+#if GAUSS_USE_OPENMP
+    #pragma omp parallel
+#endif
     {
-        int num_face_edges = face_edge.RowSize(face);
+        DenseMatrix collected_sigma;
 
-        if (!sec_face.IsOwnedByMe(face))
+#if GAUSS_USE_OPENMP
+        #pragma omp for schedule(dynamic)
+#endif
+        for (int face = 0; face < num_faces; ++face)
         {
-            continue;
-        }
+            int num_face_edges = face_edge.RowSize(face);
+            bool shared = face_shared.RowSize(face) > 0;
 
-        if (num_face_edges == 1)
-        {
-            edge_targets_[face] = DenseMatrix(1, 1, {1.0});
-            continue;
-        }
+            if (!face_plan.IsOwnedByMe(face) || shared != shared_faces)
+            {
+                continue;
+            }
 
-        auto& face_M = shared_M[face];
-        auto& face_D = shared_D[face];
-        auto& face_sigma = shared_sigma[face];
-        auto& face_constant = shared_constant[face];
+            if (num_face_edges == 1)
+            {
+                edge_targets_[face] = DenseMatrix(1, 1, {1.0});
+                continue;
+            }
 
-        linalgcpp::HStack(face_sigma, collected_sigma);
+            auto& face_M = shared_M[face];
+            auto& face_D = shared_D[face];
+            auto& face_sigma = shared_sigma[face];
+            auto& face_constant = shared_constant[face];
 
-        bool shared = face_shared.RowSize(face) > 0;
+            linalgcpp::HStack(face_sigma, collected_sigma);
 
-        int split = shared ? face_D[0].Rows() : GetSplit(face);
-        SparseMatrix M_local = shared ? CombineM(face_M, num_face_edges) : std::move(face_M[0]);
-        SparseMatrix D_local = shared ? CombineD(face_D, num_face_edges) : std::move(face_D[0]);
-        Vector constant_local = shared ? CombineConstant(face_constant) : std::move(face_constant[0]);
+            int split = shared ? face_D[0].Rows() : GetSplit(face);
+            SparseMatrix M_local = shared ? CombineM(face_M, num_face_edges) : std::move(face_M[0]);
+            SparseMatrix D_local = shared ? CombineD(face_D, num_face_edges) : std::move(face_D[0]);
+            Vector constant_local = shared ? CombineConstant(face_constant) : std::move(face_constant[0]);
 
 
-        GraphEdgeSolver solver(std::move(M_local), std::move(D_local));
-        Vector one_neg_one = MakeOneNegOne(constant_local, split);
+            GraphEdgeSolver solver(std::move(M_local), std::move(D_local));
+            Vector one_neg_one = MakeOneNegOne(constant_local, split);
 
-        if (std::fabs(constant_local.Mult(one_neg_one)) > 1e-12)
-        {
-            printf("%d constnat * one neg one : %.8e\n", MyId(), constant_local.Mult(one_neg_one) );
-        }
+            if (std::fabs(constant_local.Mult(one_neg_one)) > 1e-12)
+            {
+                printf("%d constnat * one neg one : %.8e\n", myid, constant_local.Mult(one_neg_one) );
+            }
 
-        Vector pv_sol = solver.Mult(one_neg_one);
-        VectorView pv_sigma(pv_sol.begin(), num_face_edges);
+            Vector pv_sol = solver.Mult(one_neg_one);
+            VectorView pv_sigma(pv_sol.begin(), num_face_edges);
 
-        edge_targets_[face] = Orthogonalize(collected_sigma, pv_sigma, 0, max_evects_);
+            edge_targets_[face] = Orthogonalize(collected_sigma, pv_sigma, 0, max_evects_);
+        }
     }
-
-    sec_face.Broadcast(edge_targets_);
-
-    ScaleEdgeTargets(mgl, constant_vect);
 }
 
 void GraphCoarsen::ScaleEdgeTargets(const MixedMatrix& mgl, const VectorView& constant_vect)
@@ -1118,6 +1364,7 @@ std::vector<DenseMatrix> GraphCoarsen::BuildElemM(const MixedMatrix& mgl,
     std::vector<DenseMatrix> M_elem(num_aggs);
 
     DenseMatrix M_loc;
+    DenseMatrix M_fine;
     DenseMatrix M_sub;
     DenseMatrix P_sub;
     DenseMatrix M_tmp;
@@ -1142,7 +1389,6 @@ std::vector<DenseMatrix> GraphCoarsen::BuildElemM(const MixedMatrix& mgl,
 
         for (int j = 0; j < num_elem; ++j)
         {
-            const auto& M_fine_elem = mgl.GetElemM();
             auto elem = elems[j];
             auto fine_dofs = mgl.GetElemDof().GetIndices(elem);
 
@@ -1162,7 +1408,8 @@ std::vector<DenseMatrix> GraphCoarsen::BuildElemM(const MixedMatrix& mgl,
                 }
             }
 
-            M_fine_elem[elem].GetSubMatrix(M_sub_dofs, M_sub_dofs, M_sub);
+            mgl.GetElemM(elem, M_fine);
+            M_fine.GetSubMatrix(M_sub_dofs, M_sub_dofs, M_sub);
             M_loc.AddSubMatrix(loc_dofs, loc_dofs, M_sub);
 
             ClearMarker(col_marker_, fine_dofs);
@@ -1437,6 +1684,24 @@ void GraphCoarsen::Restrict(const BlockVector& fine_vect, BlockVector& coarse_ve
     P_vertex_.MultAT(fine_vect.GetBlock(1), coarse_vect.GetBlock(1));
 }
 
+void GraphCoarsen::Interpolate(const std::vector<BlockVector>& coarse_vects,
+                               std::vector<BlockVector>& fine_vects) const
+{
+    assert(coarse_vects.size() == fine_vects.size());
+
+    MultiMult(P_edge_, BlockData(coarse_vects, 0), BlockData(fine_vects, 0));
+    MultiMult(P_vertex_, BlockData(coarse_vects, 1), BlockData(fine_vects, 1));
+}
+
+void GraphCoarsen::Restrict(const std::vector<BlockVector>& fine_vects,
+                            std::vector<BlockVector>& coarse_vects) const
+{
+    assert(coarse_vects.size() == fine_vects.size());
+
+    MultiMultAT(P_edge_, BlockData(fine_vects, 0), BlockData(coarse_vects, 0));
+    MultiMultAT(P_vertex_, BlockData(fine_vects, 1), BlockData(coarse_vects, 1));
+}
+
 BlockVector GraphCoarsen::Project(const BlockVector& fine_vect) const
 {
     std::vector<int> coarse_offsets = {0, Q_edge_.Cols(), Q_edge_.Cols() + P_vertex_.Cols()};
@@ -0,0 +1,376 @@
+/*BHEADER**********************************************************************
+ *
+ * Copyright (c) 2018, Lawrence Livermore National Security, LLC.
+ * Produced at the Lawrence Livermore National Laboratory.
+ * LLNL-CODE-759464. All Rights reserved. See file COPYRIGHT for details.
+ *
+ * This file is part of GAUSS. For more information and source code
+ * availability, see https://www.github.com/gelever/GAUSS.
+ *
+ * GAUSS is free software; you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License (as published by the Free
+ * Software Foundation) version 2.1 dated February 1999.
+ *
+ ***********************************************************************EHEADER*/
+
+/** @file
+
+    @brief Implements the binary graph file format
+*/
+
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "GraphFile.hpp"
+
+namespace gauss
+{
+
+namespace
+{
+const char magic[8] = {'G', 'A', 'U', 'S', 'S', 'G', 'R', 'F'};
+const int32_t version = 1;
+const long long header_size = 40;
+
+bool IsLittleEndian()
+{
+    const uint16_t one = 1;
+    char first;
+
+    std::memcpy(&first, &one, 1);
+
+    return first == 1;
+}
+
+void SwapBytes(char* bytes, size_t size)
+{
+    for (size_t i = 0; i < size / 2; ++i)
+    {
+        std::swap(bytes[i], bytes[size - 1 - i]);
+    }
+}
+
+// Copy count little endian values of type File into dest
+template <typename File, typename T>
+void CopyValues(const char* src, long long count, T* dest)
+{
+    const bool swap = !IsLittleEndian();
+
+    for (long long i = 0; i < count; ++i)
+    {
+        File val;
+        std::memcpy(&val, src + i * sizeof(File), sizeof(File));
+
+        if (swap)
+        {
+            SwapBytes(reinterpret_cast<char*>(&val), sizeof(File));
+        }
+
+        dest[i] = val;
+    }
+}
+
+// Write count values as little endian values of type File
+template <typename File, typename T>
+void WriteValues(std::ostream& out, const T* src, long long count)
+{
+    const bool swap = !IsLittleEndian();
+
+    for (long long i = 0; i < count; ++i)
+    {
+        File val = src[i];
+
+        if (swap)
+        {
+            SwapBytes(reinterpret_cast<char*>(&val), sizeof(File));
+        }
+
+        out.write(reinterpret_cast<const char*>(&val), sizeof(File));
+    }
+}
+
+void WriteHeader(std::ostream& out, GraphFileKind kind,
+                 long long rows, long long cols, long long nnz)
+{
+    const int32_t header_ints[2] = {version, static_cast<int32_t>(kind)};
+    const long long header_sizes[3] = {rows, cols, nnz};
+
+    out.write(magic, sizeof(magic));
+    WriteValues<int32_t>(out, header_ints, 2);
+    WriteValues<int64_t>(out, header_sizes, 3);
+}
+
+void OpenOutput(const std::string& filename, std::ofstream& out)
+{
+    out.open(filename, std::ios::binary);
+
+    if (!out)
+    {
+        throw std::runtime_error("Unable to open file: " + filename);
+    }
+}
+
+void CloseOutput(const std::string& filename, std::ofstream& out)
+{
+    out.close();
+
+    if (!out)
+    {
+        throw std::runtime_error("Error writing file: " + filename);
+    }
+}
+
+// Indices are padded so the data that follows is 8 byte aligned
+long long PaddedIndices(long long nnz)
+{
+    return nnz + (nnz % 2);
+}
+
+template <typename T>
+GraphFileKind ArrayKind();
+
+template <>
+GraphFileKind ArrayKind<int>()
+{
+    return GraphFileKind::IntArray;
+}
+
+template <>
+GraphFileKind ArrayKind<double>()
+{
+    return GraphFileKind::DoubleArray;
+}
+} // namespace
+
+GraphFileReader::GraphFileReader(const std::string& filename)
+    : filename_(filename), data_(nullptr), size_(0)
+{
+    int fd = open(filename.c_str(), O_RDONLY);
+
+    if (fd < 0)
+    {
+        throw std::runtime_error("Unable to open file: " + filename);
+    }
+
+    struct stat file_stat;
+
+    if (fstat(fd, &file_stat) != 0 || file_stat.st_size < header_size)
+    {
+        close(fd);
+        throw std::runtime_error("Not a GAUSS graph file: " + filename);
+    }
+
+    size_ = file_stat.st_size;
+
+    void* map = mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+
+    if (map == MAP_FAILED)
+    {
+        throw std::runtime_error("Unable to map file: " + filename);
+    }
+
+    data_ = static_cast<char*>(map);
+
+    int32_t header_ints[2];
+    long long header_sizes[3];
+
+    CopyValues<int32_t>(data_ + sizeof(magic), 2, header_ints);
+    CopyValues<int64_t>(data_ + sizeof(magic) + sizeof(header_ints), 3, header_sizes);
+
+    kind_ = static_cast<GraphFileKind>(header_ints[1]);
+    rows_ = header_sizes[0];
+    cols_ = header_sizes[1];
+    nnz_ = header_sizes[2];
+
+    long long expected_size = header_size;
+
+    switch (kind_)
+    {
+        case GraphFileKind::CSR:
+            expected_size += 8 * (rows_ + 1) + 4 * PaddedIndices(nnz_) + 8 * nnz_;
+            break;
+        case GraphFileKind::IntArray:
+            expected_size += 4 * rows_;
+            break;
+        case GraphFileKind::DoubleArray:
+            expected_size += 8 * rows_;
+            break;
+        default:
+            expected_size = -1;
+    }
+
+    if (std::memcmp(data_, magic, sizeof(magic)) != 0 || header_ints[0] != version ||
+            expected_size != static_cast<long long>(size_))
+    {
+        munmap(data_, size_);
+        throw std::runtime_error("Not a GAUSS graph file, or unsupported version: " + filename);
+    }
+}
+
+GraphFileReader::~GraphFileReader() noexcept
+{
+    munmap(data_, size_);
+}
+
+const char* GraphFileReader::Section(long long offset) const
+{
+    assert(offset >= 0 && offset <= static_cast<long long>(size_));
+
+    return data_ + offset;
+}
+
+SparseMatrix GraphFileReader::ReadCSR() const
+{
+    return ReadCSRRows(0, rows_);
+}
+
+SparseMatrix GraphFileReader::ReadCSRRows(long long row_begin, long long row_end) const
+{
+    if (kind_ != GraphFileKind::CSR)
+    {
+        throw std::runtime_error("Not a CSR matrix: " + filename_);
+    }
+
+    assert(0 <= row_begin && row_begin <= row_end && row_end <= rows_);
+
+    const long long num_rows = row_end - row_begin;
+
+    std::vector<long long> offsets(num_rows + 1);
+    CopyValues<int64_t>(Section(header_size + 8 * row_begin), num_rows + 1, offsets.data());
+
+    const long long nnz_begin = offsets[0];
+    const long long num_nnz = offsets.back() - nnz_begin;
+
+    std::vector<int> indptr(num_rows + 1);
+
+    for (long long i = 0; i <= num_rows; ++i)
+    {
+        indptr[i] = offsets[i] - nnz_begin;
+    }
+
+    const long long indices_begin = header_size + 8 * (rows_ + 1);
+    const long long data_begin = indices_begin + 4 * PaddedIndices(nnz_);
+
+    std::vector<int> indices(num_nnz);
+    std::vector<double> data(num_nnz);
+
+    CopyValues<int32_t>(Section(indices_begin + 4 * nnz_begin), num_nnz, indices.data());
+    CopyValues<double>(Section(data_begin + 8 * nnz_begin), num_nnz, data.data());
+
+    return SparseMatrix(std::move(indptr), std::move(indices), std::move(data),
+                        num_rows, cols_);
+}
+
+template <typename T>
+std::vector<T> GraphFileReader::ReadArray(long long begin, long long end) const
+{
+    if (kind_ != ArrayKind<T>())
+    {
+        throw std::runtime_error("Unexpected array type in: " + filename_);
+    }
+
+    assert(0 <= begin && begin <= end && end <= rows_);
+
+    std::vector<T> vect(end - begin);
+
+    CopyValues<T>(Section(header_size + sizeof(T) * begin), end - begin, vect.data());
+
+    return vect;
+}
+
+template std::vector<int> GraphFileReader::ReadArray<int>(long long, long long) const;
+template std::vector<double> GraphFileReader::ReadArray<double>(long long, long long) const;
+
+Vector GraphFileReader::ReadVector(const std::vector<int>& local_to_global) const
+{
+    if (kind_ != GraphFileKind::DoubleArray)
+    {
+        throw std::runtime_error("Not an array of doubles: " + filename_);
+    }
+
+    const char* values = Section(header_size);
+    const int local_size = local_to_global.size();
+
+    Vector local_vect(local_size);
+
+    for (int i = 0; i < local_size; ++i)
+    {
+        assert(local_to_global[i] >= 0 && local_to_global[i] < rows_);
+
+        CopyValues<double>(values + 8LL * local_to_global[i], 1, &local_vect[i]);
+    }
+
+    return local_vect;
+}
+
+bool IsGraphFile(const std::string& filename)
+{
+    std::ifstream in(filename, std::ios::binary);
+
+    char file_magic[sizeof(magic)];
+    in.read(file_magic, sizeof(magic));
+
+    return in && std::memcmp(file_magic, magic, sizeof(magic)) == 0;
+}
+
+void WriteGraphFile(const std::string& filename, const SparseMatrix& mat)
+{
+    const long long nnz = mat.nnz();
+
+    std::ofstream out;
+    OpenOutput(filename, out);
+
+    WriteHeader(out, GraphFileKind::CSR, mat.Rows(), mat.Cols(), nnz);
+
+    WriteValues<int64_t>(out, mat.GetIndptr().data(), mat.Rows() + 1);
+    WriteValues<int32_t>(out, mat.GetIndices().data(), nnz);
+
+    const int32_t padding = 0;
+    WriteValues<int32_t>(out, &padding, PaddedIndices(nnz) - nnz);
+
+    WriteValues<double>(out, mat.GetData().data(), nnz);
+
+    CloseOutput(filename, out);
+}
+
+void WriteGraphFile(const std::string& filename, const std::vector<int>& vect)
+{
+    std::ofstream out;
+    OpenOutput(filename, out);
+
+    WriteHeader(out, GraphFileKind::IntArray, vect.size(), 0, 0);
+    WriteValues<int32_t>(out, vect.data(), vect.size());
+
+    CloseOutput(filename, out);
+}
+
+void WriteGraphFile(const std::string& filename, const std::vector<double>& vect)
+{
+    std::ofstream out;
+    OpenOutput(filename, out);
+
+    WriteHeader(out, GraphFileKind::DoubleArray, vect.size(), 0, 0);
+    WriteValues<double>(out, vect.data(), vect.size());
+
+    CloseOutput(filename, out);
+}
+
+SparseMatrix ReadGraphCSR(const std::string& filename)
+{
+    if (IsGraphFile(filename))
+    {
+        return GraphFileReader(filename).ReadCSR();
+    }
+
+    return linalgcpp::ReadCSR(filename);
+}
+
+} // namespace gauss
@@ -125,7 +125,8 @@ GraphTopology::GraphTopology(const GraphTopology& other) noexcept
       face_edge_(other.face_edge_),
       agg_ext_vertex_(other.agg_ext_vertex_),
       agg_ext_edge_(other.agg_ext_edge_),
-      edge_true_edge_(other.edge_true_edge_)
+      edge_true_edge_(other.edge_true_edge_),
+      face_plan_(other.face_plan_)
 {
 
 }
@@ -156,6 +157,18 @@ void swap(GraphTopology& lhs, GraphTopology& rhs) noexcept
     swap(lhs.agg_ext_vertex_, rhs.agg_ext_vertex_);
     swap(lhs.agg_ext_edge_, rhs.agg_ext_edge_);
     swap(lhs.edge_true_edge_, rhs.edge_true_edge_);
+
+    swap(lhs.face_plan_, rhs.face_plan_);
+}
+
+SharedEntityPlan& GraphTopology::FacePlan() const
+{
+    if (!face_plan_)
+    {
+        face_plan_ = std::make_shared<SharedEntityPlan>(face_true_face_);
+    }
+
+    return *face_plan_;
 }
 
 SparseMatrix GraphTopology::MakeFaceIntAgg(const ParMatrix& agg_agg)
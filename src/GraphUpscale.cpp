@@ -18,17 +18,97 @@
     @brief Contains GraphUpscale class
 */
 
+#include <fstream>
+#include <stdexcept>
+
 #include "GraphUpscale.hpp"
 
 namespace gauss
 {
 
+namespace
+{
+// Increment when the checkpoint layout changes
+const int checkpoint_version = 3;
+
+void OpenCheckpoint(MPI_Comm comm, const std::string& prefix, std::ifstream& in)
+{
+    std::string filename = ProcFilename(comm, prefix);
+
+    in.open(filename, std::ios::binary);
+
+    if (!in)
+    {
+        throw std::runtime_error("Unable to open checkpoint file: " + filename);
+    }
+
+    int version = ReadBinaryHeader(in, comm);
+
+    if (version != checkpoint_version)
+    {
+        throw std::runtime_error("Unsupported checkpoint version " + std::to_string(version)
+                                 + " in " + filename);
+    }
+}
+
+int ReadCheckpointRows(MPI_Comm comm, const std::string& prefix)
+{
+    std::ifstream in;
+    OpenCheckpoint(comm, prefix, in);
+
+    int rows;
+    ReadBinary(in, rows);
+
+    return rows;
+}
+
+void WriteBinary(std::ostream& out, const MultigridParams& params)
+{
+    gauss::WriteBinary(out, static_cast<int>(params.smoother));
+    gauss::WriteBinary(out, params.smooth_steps);
+    gauss::WriteBinary(out, params.chebyshev_degree);
+    gauss::WriteBinary(out, params.chebyshev_ratio);
+    gauss::WriteBinary(out, params.coarse_rel_tol);
+    gauss::WriteBinary(out, params.restart);
+}
+
+void ReadBinary(std::istream& in, MultigridParams& params)
+{
+    int smoother;
+
+    gauss::ReadBinary(in, smoother);
+    gauss::ReadBinary(in, params.smooth_steps);
+    gauss::ReadBinary(in, params.chebyshev_degree);
+    gauss::ReadBinary(in, params.chebyshev_ratio);
+    gauss::ReadBinary(in, params.coarse_rel_tol);
+    gauss::ReadBinary(in, params.restart);
+
+    params.smoother = static_cast<SmootherType>(smoother);
+}
+
+void WarnNotConverged(const GraphCoarsen& coarsener, int level_i, int myid)
+{
+    int num_not_converged = coarsener.NumNotConverged();
+
+    if (myid == 0 && num_not_converged > 0)
+    {
+        std::cout << "Warning: local eigenvectors of " << num_not_converged
+                  << " aggregates did not converge in coarsening level " << level_i << "\n";
+    }
+}
+} // namespace
+
 GraphUpscale::GraphUpscale(const Graph& graph, const UpscaleParams& params)
     : Operator(graph.vertex_edge_local_.Rows()),
       comm_(graph.edge_true_edge_.GetComm()),
       myid_(graph.edge_true_edge_.GetMyId()),
       setup_time_(0),
-      hybridization_(params.hybridization)
+      hybridization_(params.hybridization),
+      hybrid_single_precision_(params.hybrid_single_precision),
+      multigrid_(params.multigrid),
+      multigrid_params_(params.multigrid_params),
+      pipelined_cg_(params.pipelined_cg),
+      verbose_(params.verbose)
 {
     Timer timer(Timer::Start::True);
 
@@ -53,8 +133,13 @@ GraphUpscale::GraphUpscale(const Graph& graph, const UpscaleParams& params)
         const auto& prev_level = GetLevel(level_i);
         const auto& spect_pair_i = params.spectral_pair[level_i];
 
-        coarsener_.emplace_back(std::move(gt_i), prev_level, spect_pair_i);
+        coarsener_.emplace_back(std::move(gt_i), prev_level, spect_pair_i, params.warm_start);
         levels_.push_back(coarsener_.back().Coarsen(prev_level));
+
+        if (verbose_)
+        {
+            WarnNotConverged(coarsener_.back(), level_i, myid_);
+        }
     }
 
     // Generate Solvers (potentially optional)
@@ -69,6 +154,134 @@ GraphUpscale::GraphUpscale(const Graph& graph, const UpscaleParams& params)
     setup_time_ += timer.TotalTime();
 }
 
+GraphUpscale::GraphUpscale(MPI_Comm comm, const std::string& prefix)
+    : Operator(ReadCheckpointRows(comm, prefix)),
+      comm_(comm),
+      setup_time_(0)
+{
+    Timer timer(Timer::Start::True);
+
+    MPI_Comm_rank(comm_, &myid_);
+
+    std::ifstream in;
+    OpenCheckpoint(comm_, prefix, in);
+
+    int rows;
+    int num_levels;
+    std::vector<int> pipelined_cg;
+
+    ReadBinary(in, rows);
+    ReadBinary(in, hybridization_);
+    ReadBinary(in, hybrid_single_precision_);
+    ReadBinary(in, multigrid_);
+    ReadBinary(in, multigrid_params_);
+    ReadBinary(in, pipelined_cg);
+    ReadBinary(in, do_ortho_);
+    ReadBinary(in, num_levels);
+
+    levels_.resize(num_levels);
+    coarsener_.resize(num_levels - 1);
+
+    for (auto& level : levels_)
+    {
+        ReadBinary(in, comm_, level);
+    }
+
+    for (auto& coarsener : coarsener_)
+    {
+        ReadBinary(in, comm_, coarsener);
+    }
+
+    if (!in)
+    {
+        throw std::runtime_error("Checkpoint file is truncated: " + ProcFilename(comm_, prefix));
+    }
+
+    pipelined_cg_.assign(pipelined_cg.begin(), pipelined_cg.end());
+
+    for (int level_i = 0; level_i < NumLevels(); ++level_i)
+    {
+        MakeSolver(level_i);
+    }
+
+    SetOrthogonalize(do_ortho_);
+
+    timer.Click();
+    setup_time_ += timer.TotalTime();
+}
+
+void GraphUpscale::Save(const std::string& prefix) const
+{
+    std::string filename = ProcFilename(comm_, prefix);
+    std::ofstream out(filename, std::ios::binary);
+
+    if (!out)
+    {
+        throw std::runtime_error("Unable to open checkpoint file: " + filename);
+    }
+
+    WriteBinaryHeader(out, comm_, checkpoint_version);
+
+    WriteBinary(out, GetMatrix(0).LocalD().Rows());
+    WriteBinary(out, hybridization_);
+    WriteBinary(out, hybrid_single_precision_);
+    WriteBinary(out, multigrid_);
+    WriteBinary(out, multigrid_params_);
+    WriteBinary(out, std::vector<int>(pipelined_cg_.begin(), pipelined_cg_.end()));
+    WriteBinary(out, do_ortho_);
+    WriteBinary(out, NumLevels());
+
+    for (const auto& level : levels_)
+    {
+        WriteBinary(out, level);
+    }
+
+    for (const auto& coarsener : coarsener_)
+    {
+        WriteBinary(out, coarsener);
+    }
+}
+
+void GraphUpscale::UpdateWeights(const Graph& graph)
+{
+    Timer timer(Timer::Start::True);
+
+    Level& fine_level = GetLevel(0);
+
+    assert(graph.vertex_edge_local_.Rows() == fine_level.mixed_matrix.LocalD().Rows());
+    assert(graph.vertex_edge_local_.Cols() == fine_level.mixed_matrix.LocalD().Cols());
+
+    fine_level.mixed_matrix = MixedMatrix(graph);
+    fine_level.mixed_matrix.AssembleM();
+
+    size_to_level_.clear();
+
+    int num_coarse = NumLevels() - 1;
+
+    for (int level_i = 0; level_i < num_coarse; ++level_i)
+    {
+        const auto& prev_level = GetLevel(level_i);
+
+        coarsener_[level_i].Update(prev_level);
+        levels_[level_i + 1] = coarsener_[level_i].Coarsen(prev_level);
+
+        if (verbose_)
+        {
+            WarnNotConverged(coarsener_[level_i], level_i, myid_);
+        }
+    }
+
+    for (int level_i = 0; level_i < NumLevels(); ++level_i)
+    {
+        MakeSolver(level_i);
+    }
+
+    SetOrthogonalize(!GetMatrix(0).CheckW());
+
+    timer.Click();
+    setup_time_ += timer.TotalTime();
+}
+
 void GraphUpscale::MakeSolver(int level_i)
 {
     MakeSolver(level_i, GetMatrix(level_i));
@@ -78,14 +291,21 @@ void GraphUpscale::MakeSolver(int level_i, MixedMatrix& mm)
 {
     auto& level = GetLevel(level_i);
 
-    if (level_i == 0)
+    if (level_i == 0 && multigrid_ && NumLevels() > 1)
+    {
+        mm.AssembleM();
+        level.solver = make_unique<MultigridSolver>(mm, levels_, coarsener_,
+                                                    multigrid_params_);
+    }
+    else if (level_i == 0)
     {
         mm.AssembleM();
         level.solver = make_unique<SPDSolver>(mm, level.edge_elim_dofs);
     }
     else if (hybridization_)
     {
-        level.solver = make_unique<HybridSolver>(mm, GetGraphSpace(level_i));
+        level.solver = make_unique<HybridSolver>(mm, GetGraphSpace(level_i),
+                                                 hybrid_single_precision_);
     }
     else
     {
@@ -93,6 +313,19 @@ void GraphUpscale::MakeSolver(int level_i, MixedMatrix& mm)
         level.solver = make_unique<MinresBlockSolver>(mm, level.edge_elim_dofs);
     }
 
+    level.solver->SetConstantRep(level.constant_rep);
+    level.solver->SetPipelinedCG(level_i < static_cast<int>(pipelined_cg_.size()) &&
+                                 pipelined_cg_[level_i]);
+
+    if (static_cast<int>(prec_reuse_.size()) != NumLevels())
+    {
+        prec_reuse_.resize(NumLevels());
+    }
+
+    prec_reuse_[level_i].num_reuse = 0;
+    prec_reuse_[level_i].base_iters = -1;
+    prec_reuse_[level_i].num_builds++;
+
     size_to_level_[mm.LocalD().Rows()] = level_i;
 }
 
@@ -106,31 +339,89 @@ void GraphUpscale::RescaleSolver(int level_i, const std::vector<double>& agg_wei
 {
     auto& level = GetLevel(level_i);
 
-    if (level_i == 0)
+    // A solver made here has just built its preconditioner
+    bool rebuild = false;
+
+    if (!level.solver)
+    {
+        MakeSolver(level_i, mm);
+    }
+    else
+    {
+        rebuild = RebuildPrec(level_i);
+    }
+
+    if (level_i == 0 && dynamic_cast<MultigridSolver*>(level.solver.get()))
     {
         mm.AssembleM(agg_weights);
 
-        level.solver = make_unique<SPDSolver>(mm, level.edge_elim_dofs);
+        auto& multigrid = static_cast<MultigridSolver&>(*level.solver);
+        multigrid.UpdateOperator(mm, rebuild);
     }
-    else if (hybridization_)
+    else if (level_i == 0)
     {
-        if (!level.solver)
-        {
-            level.solver = make_unique<HybridSolver>(mm, GetGraphSpace(level_i));
-        }
+        mm.AssembleM(agg_weights);
 
+        auto& spd = dynamic_cast<SPDSolver&>(*level.solver);
+        spd.UpdateOperator(mm, rebuild);
+    }
+    else if (hybridization_)
+    {
         auto& hb = dynamic_cast<HybridSolver&>(*level.solver);
-        hb.UpdateAggScaling(agg_weights);
+        hb.UpdateAggScaling(agg_weights, rebuild);
     }
     else
     {
         mm.AssembleM(agg_weights);
-        level.solver = make_unique<MinresBlockSolver>(mm, level.edge_elim_dofs);
+
+        auto& minres = dynamic_cast<MinresBlockSolver&>(*level.solver);
+        minres.UpdateOperator(mm, rebuild);
     }
 
     size_to_level_[mm.LocalD().Rows()] = level_i;
 }
 
+bool GraphUpscale::RebuildPrec(int level)
+{
+    const auto& policy = prec_reuse_policy_;
+    auto& state = prec_reuse_.at(level);
+
+    // The first solve after a build sets the reference iteration count
+    int last_iters = Solver(level).GetNumIterations();
+
+    if (state.base_iters < 0 && last_iters > 0)
+    {
+        state.base_iters = last_iters;
+    }
+
+    bool rebuild = policy.max_reuse == 0 ||
+                   (policy.max_reuse > 0 && state.num_reuse >= policy.max_reuse);
+
+    if (policy.max_iter_growth > 0.0 && state.base_iters > 0 &&
+            last_iters > policy.max_iter_growth * state.base_iters)
+    {
+        rebuild = true;
+    }
+
+    if (rebuild)
+    {
+        state.num_reuse = 0;
+        state.base_iters = -1;
+        state.num_builds++;
+    }
+    else
+    {
+        state.num_reuse++;
+    }
+
+    return rebuild;
+}
+
+int GraphUpscale::NumPrecBuilds(int level) const
+{
+    return prec_reuse_.at(level).num_builds;
+}
+
 std::vector<BlockVector> GraphUpscale::MultMultiLevel(const BlockVector& x) const
 {
     std::vector<BlockVector> sols;
@@ -162,40 +453,108 @@ BlockVector GraphUpscale::MultMultiGrid(const BlockVector& x) const
     return sol;
 }
 
+UpscaleWorkspace GraphUpscale::MakeWorkspace() const
+{
+    UpscaleWorkspace work;
+    InitWorkspace(work);
+
+    return work;
+}
+
+void GraphUpscale::InitWorkspace(UpscaleWorkspace& work) const
+{
+    int num_levels = NumLevels();
+
+    if (static_cast<int>(work.rhs.size()) == num_levels)
+    {
+        return;
+    }
+
+    work.rhs.clear();
+    work.sol.clear();
+
+    for (int i = 0; i < num_levels; ++i)
+    {
+        work.rhs.push_back(GetBlockVector(i));
+        work.sol.push_back(GetBlockVector(i));
+    }
+}
+
+SolverWorkspace& GraphUpscale::GetSolverWorkspace(int level, UpscaleWorkspace& work) const
+{
+    if (static_cast<int>(work.solver.size()) != NumLevels())
+    {
+        work.solver.resize(NumLevels());
+    }
+
+    if (!work.solver[level])
+    {
+        work.solver[level] = Solver(level).MakeWorkspace();
+    }
+
+    return *work.solver[level];
+}
+
+std::vector<BlockVector>& GraphUpscale::GetMultiVectors(
+    int level, int num_rhs, std::vector<std::vector<BlockVector>>& vects) const
+{
+    if (static_cast<int>(vects.size()) != NumLevels())
+    {
+        vects.resize(NumLevels());
+    }
+
+    if (static_cast<int>(vects[level].size()) != num_rhs)
+    {
+        vects[level].assign(num_rhs, GetBlockVector(level));
+    }
+
+    return vects[level];
+}
+
 void GraphUpscale::MultMultiGrid(const BlockVector& x, BlockVector& sol) const
 {
-    GetLevel(0).rhs = x;
-    GetLevel(0).sol = sol;
+    UpscaleWorkspace work;
+
+    MultMultiGrid(x, sol, work);
+}
+
+void GraphUpscale::MultMultiGrid(const BlockVector& x, BlockVector& sol,
+                                 UpscaleWorkspace& work) const
+{
+    InitWorkspace(work);
+
+    work.rhs[0] = x;
+    work.sol[0] = sol;
 
     int num_coarse = NumLevels() - 1;
 
     for (int i = 0; i < num_coarse; ++i)
     {
-        Coarsener(i).Restrict(GetLevel(i).rhs, GetLevel(i + 1).rhs);
-        Coarsener(i).Restrict(GetLevel(i).sol, GetLevel(i + 1).sol);
+        Coarsener(i).Restrict(work.rhs[i], work.rhs[i + 1]);
+        Coarsener(i).Restrict(work.sol[i], work.sol[i + 1]);
     }
 
     int num_levels = NumLevels();
 
     for (int i = num_levels - 1; i >= 0; --i)
     {
-        GetLevel(i).rhs.GetBlock(1) *= -1.0;
-        GetLevel(i).sol.GetBlock(1) *= -1.0;
+        work.rhs[i].GetBlock(1) *= -1.0;
+        work.sol[i].GetBlock(1) *= -1.0;
 
-        Solver(i).Solve(GetLevel(i).rhs, GetLevel(i).sol);
+        Solver(i).Solve(work.rhs[i], work.sol[i], GetSolverWorkspace(i, work));
 
         if (do_ortho_)
         {
-            OrthoConstant(comm_, GetLevel(i).sol.GetBlock(1), ConstantRep(i));
+            OrthoConstant(comm_, work.sol[i].GetBlock(1), ConstantRep(i));
         }
 
         if (i != 0)
         {
-            Coarsener(i - 1).Interpolate(GetLevel(i).sol, GetLevel(i - 1).sol);
+            Coarsener(i - 1).Interpolate(work.sol[i], work.sol[i - 1]);
         }
     }
 
-    sol = GetLevel(0).sol;
+    sol = work.sol[0];
 
     if (do_ortho_)
     {
@@ -230,30 +589,40 @@ BlockVector GraphUpscale::Solve(const BlockVector& x) const
 
 void GraphUpscale::Solve(int level, const VectorView& x, VectorView y) const
 {
-    GetLevel(0).rhs.GetBlock(0) = 0.0;
-    GetLevel(0).rhs.GetBlock(1) = x;
+    UpscaleWorkspace work;
+
+    Solve(level, x, y, work);
+}
+
+void GraphUpscale::Solve(int level, const VectorView& x, VectorView y,
+                         UpscaleWorkspace& work) const
+{
+    InitWorkspace(work);
+
+    work.rhs[0].GetBlock(0) = 0.0;
+    work.rhs[0].GetBlock(1) = x;
 
     for (int i = 0; i < level; ++i)
     {
-        Coarsener(i).Restrict(GetLevel(i).rhs, GetLevel(i + 1).rhs);
+        Coarsener(i).Restrict(work.rhs[i], work.rhs[i + 1]);
     }
 
-    GetLevel(level).rhs.GetBlock(1) *= -1.0;
-    GetLevel(level).sol = 0.0;
+    work.rhs[level].GetBlock(1) *= -1.0;
+    work.sol[level] = 0.0;
 
-    Solver(level).Solve(GetLevel(level).rhs, GetLevel(level).sol);
+    Solver(level).Solve(work.rhs[level], work.sol[level], GetSolverWorkspace(level, work));
 
     if (do_ortho_)
     {
-        Orthogonalize(level, GetLevel(level).sol.GetBlock(1));
+        Orthogonalize(level, work.sol[level].GetBlock(1));
     }
 
     for (int i = level - 1; i >= 0; --i)
     {
-        Coarsener(i).Interpolate(GetLevel(i + 1).sol, GetLevel(i).sol);
+        Coarsener(i).Interpolate(work.sol[i + 1], work.sol[i]);
     }
 
-    y = GetLevel(0).sol.GetBlock(1);
+    y = work.sol[0].GetBlock(1);
 }
 
 Vector GraphUpscale::Solve(int level, const VectorView& x) const
@@ -267,29 +636,39 @@ Vector GraphUpscale::Solve(int level, const VectorView& x) const
 
 void GraphUpscale::Solve(int level, const BlockVector& x, BlockVector& y) const
 {
-    GetLevel(0).rhs = x;
+    UpscaleWorkspace work;
+
+    Solve(level, x, y, work);
+}
+
+void GraphUpscale::Solve(int level, const BlockVector& x, BlockVector& y,
+                         UpscaleWorkspace& work) const
+{
+    InitWorkspace(work);
+
+    work.rhs[0] = x;
 
     for (int i = 0; i < level; ++i)
     {
-        Coarsener(i).Restrict(GetLevel(i).rhs, GetLevel(i + 1).rhs);
+        Coarsener(i).Restrict(work.rhs[i], work.rhs[i + 1]);
     }
 
-    GetLevel(level).rhs.GetBlock(1) *= -1.0;
-    GetLevel(level).sol = 0.0;
+    work.rhs[level].GetBlock(1) *= -1.0;
+    work.sol[level] = 0.0;
 
-    Solver(level).Solve(GetLevel(level).rhs, GetLevel(level).sol);
+    Solver(level).Solve(work.rhs[level], work.sol[level], GetSolverWorkspace(level, work));
 
     if (do_ortho_)
     {
-        Orthogonalize(level, GetLevel(level).sol);
+        Orthogonalize(level, work.sol[level]);
     }
 
     for (int i = level - 1; i >= 0; --i)
     {
-        Coarsener(i).Interpolate(GetLevel(i + 1).sol, GetLevel(i).sol);
+        Coarsener(i).Interpolate(work.sol[i + 1], work.sol[i]);
     }
 
-    y = GetLevel(0).sol;
+    y = work.sol[0];
 }
 
 BlockVector GraphUpscale::Solve(int level, const BlockVector& x) const
@@ -301,9 +680,113 @@ BlockVector GraphUpscale::Solve(int level, const BlockVector& x) const
     return y;
 }
 
+void GraphUpscale::Solve(int level, const BlockVector& x, BlockVector& y,
+                         const BlockVector& initial_guess) const
+{
+    UpscaleWorkspace work;
+
+    Solve(level, x, y, initial_guess, work);
+}
+
+void GraphUpscale::Solve(int level, const BlockVector& x, BlockVector& y,
+                         const BlockVector& initial_guess, UpscaleWorkspace& work) const
+{
+    InitWorkspace(work);
+
+    work.rhs[0] = x;
+    work.sol[0] = initial_guess;
+
+    for (int i = 0; i < level; ++i)
+    {
+        Coarsener(i).Restrict(work.rhs[i], work.rhs[i + 1]);
+        Coarsener(i).Project(work.sol[i], work.sol[i + 1]);
+    }
+
+    work.rhs[level].GetBlock(1) *= -1.0;
+
+    Solver(level).Solve(work.rhs[level], work.sol[level], work.sol[level],
+                        GetSolverWorkspace(level, work));
+
+    if (do_ortho_)
+    {
+        Orthogonalize(level, work.sol[level]);
+    }
+
+    for (int i = level - 1; i >= 0; --i)
+    {
+        Coarsener(i).Interpolate(work.sol[i + 1], work.sol[i]);
+    }
+
+    y = work.sol[0];
+}
+
+void GraphUpscale::Solve(int level, const std::vector<BlockVector>& x,
+                         std::vector<BlockVector>& y) const
+{
+    UpscaleWorkspace work;
+
+    Solve(level, x, y, work);
+}
+
+void GraphUpscale::Solve(int level, const std::vector<BlockVector>& x,
+                         std::vector<BlockVector>& y, UpscaleWorkspace& work) const
+{
+    int num_rhs = x.size();
+
+    for (int i = 0; i <= level; ++i)
+    {
+        GetMultiVectors(i, num_rhs, work.multi_rhs);
+        GetMultiVectors(i, num_rhs, work.multi_sol);
+    }
+
+    auto& rhs = work.multi_rhs;
+    auto& sol = work.multi_sol;
+
+    for (int k = 0; k < num_rhs; ++k)
+    {
+        rhs[0][k] = x[k];
+    }
+
+    for (int i = 0; i < level; ++i)
+    {
+        Coarsener(i).Restrict(rhs[i], rhs[i + 1]);
+    }
+
+    for (int k = 0; k < num_rhs; ++k)
+    {
+        rhs[level][k].GetBlock(1) *= -1.0;
+        sol[level][k] = 0.0;
+    }
+
+    Solver(level).Solve(rhs[level], sol[level]);
+
+    if (do_ortho_)
+    {
+        for (auto& sol_k : sol[level])
+        {
+            Orthogonalize(level, sol_k);
+        }
+    }
+
+    for (int i = level - 1; i >= 0; --i)
+    {
+        Coarsener(i).Interpolate(sol[i + 1], sol[i]);
+    }
+
+    y = sol[0];
+}
+
 void GraphUpscale::SolveLevel(int level, const VectorView& x, VectorView y) const
 {
-    Solver(level).Solve(x, y);
+    UpscaleWorkspace work;
+
+    SolveLevel(level, x, y, work);
+}
+
+void GraphUpscale::SolveLevel(int level, const VectorView& x, VectorView y,
+                              UpscaleWorkspace& work) const
+{
+    Solver(level).Solve(x, y, GetSolverWorkspace(level, work));
     y *= -1.0;
 
     if (do_ortho_)
@@ -322,7 +805,15 @@ Vector GraphUpscale::SolveLevel(int level, const VectorView& x) const
 
 void GraphUpscale::SolveLevel(int level, const BlockVector& x, BlockVector& y) const
 {
-    Solver(level).Solve(x, y);
+    UpscaleWorkspace work;
+
+    SolveLevel(level, x, y, work);
+}
+
+void GraphUpscale::SolveLevel(int level, const BlockVector& x, BlockVector& y,
+                              UpscaleWorkspace& work) const
+{
+    Solver(level).Solve(x, y, GetSolverWorkspace(level, work));
     y.GetBlock(1) *= -1.0;
 
     if (do_ortho_)
@@ -339,7 +830,41 @@ BlockVector GraphUpscale::SolveLevel(int level, const BlockVector& x) const
     return y;
 }
 
+void GraphUpscale::SolveLevel(int level, const BlockVector& x, BlockVector& y,
+                              const BlockVector& initial_guess) const
+{
+    UpscaleWorkspace work;
+
+    SolveLevel(level, x, y, initial_guess, work);
+}
+
+void GraphUpscale::SolveLevel(int level, const BlockVector& x, BlockVector& y,
+                              const BlockVector& initial_guess, UpscaleWorkspace& work) const
+{
+    InitWorkspace(work);
+
+    // The solver sees the vertex block with the opposite sign
+    work.sol[level] = initial_guess;
+    work.sol[level].GetBlock(1) *= -1.0;
+
+    Solver(level).Solve(x, y, work.sol[level], GetSolverWorkspace(level, work));
+    y.GetBlock(1) *= -1.0;
+
+    if (do_ortho_)
+    {
+        Orthogonalize(level, y);
+    }
+}
+
 void GraphUpscale::Interpolate(const VectorView& x, VectorView y) const
+{
+    UpscaleWorkspace work;
+
+    Interpolate(x, y, work);
+}
+
+void GraphUpscale::Interpolate(const VectorView& x, VectorView y,
+                               UpscaleWorkspace& work) const
 {
     int x_level = size_to_level_.at(x.size());
     int y_level = size_to_level_.at(y.size());
@@ -352,14 +877,16 @@ void GraphUpscale::Interpolate(const VectorView& x, VectorView y) const
         return;
     }
 
-    GetLevel(x_level).sol.GetBlock(1) = x;
+    InitWorkspace(work);
+
+    work.sol[x_level].GetBlock(1) = x;
 
     for (int i = x_level - 1; i >= y_level; --i)
     {
-        Coarsener(i).Interpolate(GetLevel(i + 1).sol.GetBlock(1), GetLevel(i).sol.GetBlock(1));
+        Coarsener(i).Interpolate(work.sol[i + 1].GetBlock(1), work.sol[i].GetBlock(1));
     }
 
-    y = GetLevel(y_level).sol.GetBlock(1);
+    y = work.sol[y_level].GetBlock(1);
 }
 
 Vector GraphUpscale::Interpolate(const VectorView& x, int level) const
@@ -372,6 +899,14 @@ Vector GraphUpscale::Interpolate(const VectorView& x, int level) const
 }
 
 void GraphUpscale::Interpolate(const BlockVector& x, BlockVector& y) const
+{
+    UpscaleWorkspace work;
+
+    Interpolate(x, y, work);
+}
+
+void GraphUpscale::Interpolate(const BlockVector& x, BlockVector& y,
+                               UpscaleWorkspace& work) const
 {
     int x_level = size_to_level_.at(x.GetBlock(1).size());
     int y_level = size_to_level_.at(y.GetBlock(1).size());
@@ -384,14 +919,16 @@ void GraphUpscale::Interpolate(const BlockVector& x, BlockVector& y) const
         return;
     }
 
-    GetLevel(x_level).sol = x;
+    InitWorkspace(work);
+
+    work.sol[x_level] = x;
 
     for (int i = x_level - 1; i >= y_level; --i)
     {
-        Coarsener(i).Interpolate(GetLevel(i + 1).sol, GetLevel(i).sol);
+        Coarsener(i).Interpolate(work.sol[i + 1], work.sol[i]);
     }
 
-    y = GetLevel(y_level).sol;
+    y = work.sol[y_level];
 }
 
 BlockVector GraphUpscale::Interpolate(const BlockVector& x, int level) const
@@ -404,6 +941,14 @@ BlockVector GraphUpscale::Interpolate(const BlockVector& x, int level) const
 }
 
 void GraphUpscale::Restrict(const VectorView& x, VectorView y) const
+{
+    UpscaleWorkspace work;
+
+    Restrict(x, y, work);
+}
+
+void GraphUpscale::Restrict(const VectorView& x, VectorView y,
+                            UpscaleWorkspace& work) const
 {
     int x_level = size_to_level_.at(x.size());
     int y_level = size_to_level_.at(y.size());
@@ -416,14 +961,16 @@ void GraphUpscale::Restrict(const VectorView& x, VectorView y) const
         return;
     }
 
-    GetLevel(x_level).sol.GetBlock(1) = x;
+    InitWorkspace(work);
+
+    work.sol[x_level].GetBlock(1) = x;
 
     for (int i = x_level; i < y_level; ++i)
     {
-        Coarsener(i).Restrict(GetLevel(i).sol.GetBlock(1), GetLevel(i + 1).sol.GetBlock(1));
+        Coarsener(i).Restrict(work.sol[i].GetBlock(1), work.sol[i + 1].GetBlock(1));
     }
 
-    y = GetLevel(y_level).sol.GetBlock(1);
+    y = work.sol[y_level].GetBlock(1);
 }
 
 Vector GraphUpscale::Restrict(const VectorView& x, int level) const
@@ -436,6 +983,14 @@ Vector GraphUpscale::Restrict(const VectorView& x, int level) const
 }
 
 void GraphUpscale::Restrict(const BlockVector& x, BlockVector& y) const
+{
+    UpscaleWorkspace work;
+
+    Restrict(x, y, work);
+}
+
+void GraphUpscale::Restrict(const BlockVector& x, BlockVector& y,
+                            UpscaleWorkspace& work) const
 {
     int x_level = size_to_level_.at(x.GetBlock(1).size());
     int y_level = size_to_level_.at(y.GetBlock(1).size());
@@ -448,14 +1003,16 @@ void GraphUpscale::Restrict(const BlockVector& x, BlockVector& y) const
         return;
     }
 
-    GetLevel(x_level).sol = x;
+    InitWorkspace(work);
+
+    work.sol[x_level] = x;
 
     for (int i = x_level; i < y_level; ++i)
     {
-        Coarsener(i).Restrict(GetLevel(i).sol, GetLevel(i + 1).sol);
+        Coarsener(i).Restrict(work.sol[i], work.sol[i + 1]);
     }
 
-    y = GetLevel(y_level).sol;
+    y = work.sol[y_level];
 }
 
 BlockVector GraphUpscale::Restrict(const BlockVector& x, int level) const
@@ -565,6 +1122,24 @@ void GraphUpscale::PrintInfo(std::ostream& out) const
     int num_procs;
     MPI_Comm_size(comm_, &num_procs);
 
+    // Memory used by the element matrices of M, and memory
+    // saved over dense element matrices, summed over processors
+    std::vector<long long> elem_bytes(NumLevels());
+    std::vector<long long> saved_bytes(NumLevels());
+
+    for (int i = 0; i < NumLevels(); ++i)
+    {
+        long long local_bytes[2] = {GetMatrix(i).ElemMBytes(),
+                                    GetMatrix(i).DenseElemMBytes() - GetMatrix(i).ElemMBytes()
+                                   };
+        long long global_bytes[2];
+
+        MPI_Reduce(local_bytes, global_bytes, 2, MPI_LONG_LONG, MPI_SUM, 0, comm_);
+
+        elem_bytes[i] = global_bytes[0];
+        saved_bytes[i] = global_bytes[1];
+    }
+
     if (myid_ == 0)
     {
         int old_precision = out.precision();
@@ -588,6 +1163,8 @@ void GraphUpscale::PrintInfo(std::ostream& out) const
             out << "D Size\t\t" << GetMatrix(i).GlobalD().GlobalRows() << "\n";
             out << "+ Size\t\t" << GetMatrix(i).GlobalRows() << "\n";
             out << "NonZeros:\t" << GetMatrix(i).GlobalNNZ() << "\n";
+            out << "Elem M (MB)\t" << elem_bytes[i] / (1024.0 * 1024.0) << "\n";
+            out << "Saved (MB)\t" << saved_bytes[i] / (1024.0 * 1024.0) << "\n";
             out << "\n";
 
             if (i != 0)
@@ -670,6 +1247,23 @@ void GraphUpscale::SetAbsTol(double atol)
     }
 }
 
+void GraphUpscale::SetPipelinedCG(int level, bool pipelined_cg)
+{
+    assert(level >= 0 && level < NumLevels());
+
+    if (static_cast<int>(pipelined_cg_.size()) <= level)
+    {
+        pipelined_cg_.resize(level + 1, false);
+    }
+
+    pipelined_cg_[level] = pipelined_cg;
+
+    if (GetLevel(level).solver)
+    {
+        GetLevel(level).solver->SetPipelinedCG(pipelined_cg);
+    }
+}
+
 void GraphUpscale::ShowCoarseSolveInfo(std::ostream& out) const
 {
     if (myid_ == 0)
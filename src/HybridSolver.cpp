@@ -19,12 +19,76 @@
    @brief Implements HybridSolver object
 */
 
+#include <algorithm>
+#include <limits>
+
 #include "HybridSolver.hpp"
 
 namespace gauss
 {
 
-HybridSolver::HybridSolver(const MixedMatrix& mgl, const GraphSpace& graph_space)
+namespace
+{
+// Iterative refinement stops after this many corrections
+const int max_refine_iter = 10;
+
+// y += alpha * A * x, A is column major rows x cols,
+// in double or single precision, always summed in double precision
+template <typename T>
+void PackedMultAdd(int rows, int cols, double alpha, const T* A,
+                   const double* x, double* y)
+{
+    for (int j = 0; j < cols; ++j)
+    {
+        const double alpha_x = alpha * x[j];
+        const T* A_j = A + j * rows;
+
+        for (int i = 0; i < rows; ++i)
+        {
+            y[i] += alpha_x * A_j[i];
+        }
+    }
+}
+
+// y += alpha * A^T * x, A is column major rows x cols
+template <typename T>
+void PackedMultAddAT(int rows, int cols, double alpha, const T* A,
+                     const double* x, double* y)
+{
+    for (int j = 0; j < cols; ++j)
+    {
+        const T* A_j = A + j * rows;
+        double sum = 0.0;
+
+        for (int i = 0; i < rows; ++i)
+        {
+            sum += A_j[i] * x[i];
+        }
+
+        y[j] += alpha * sum;
+    }
+}
+
+// Copy a dense matrix into packed column major storage
+template <typename T>
+T* Pack(const DenseMatrix& mat, int rows, int cols, T* dest)
+{
+    assert(rows * cols == 0 || (mat.Rows() == rows && mat.Cols() == cols));
+
+    for (int j = 0; j < cols; ++j)
+    {
+        for (int i = 0; i < rows; ++i)
+        {
+            *dest++ = mat(i, j);
+        }
+    }
+
+    return dest;
+}
+} // namespace
+
+HybridSolver::HybridSolver(const MixedMatrix& mgl, const GraphSpace& graph_space,
+                           bool single_precision)
     :
     MGLSolver(mgl),
     agg_vertexdof_(graph_space.agg_vertexdof.GetDiag()),
@@ -32,10 +96,9 @@ HybridSolver::HybridSolver(const MixedMatrix& mgl, const GraphSpace& graph_space
     num_aggs_(agg_edgedof_.Rows()),
     num_edge_dofs_(agg_edgedof_.Cols()),
     num_multiplier_dofs_(graph_space.face_facedof.Cols()),
-    Minv_(num_aggs_), MinvDT_(num_aggs_), MinvCT_(num_aggs_),
-    AinvDMinvCT_(num_aggs_), Ainv_(num_aggs_),
-    hybrid_elem_(num_aggs_), Ainv_f_(num_aggs_),
-    Minv_g_(num_aggs_), AinvDMinv_g_(num_aggs_),
+    single_precision_(single_precision),
+    hybrid_elem_(num_aggs_),
+    diagonal_M_(false),
     edgedof_count_(agg_edgedof_.Cols(), 0.0),
     agg_weights_(num_aggs_, 1.0),
     rescale_iter_(0)
@@ -48,6 +111,9 @@ HybridSolver::HybridSolver(const MixedMatrix& mgl, const GraphSpace& graph_space
 
     agg_multiplier_ = agg_edgedof_.Mult(edgedof_multiplier);
 
+    SparseMatrix multiplier_agg = agg_multiplier_.Transpose();
+    hybrid_pattern_ = multiplier_agg.Mult(agg_multiplier_);
+
     ParMatrix edge_td_d = mgl.EdgeTrueEdge().Transpose();
     ParMatrix edge_edge = mgl.EdgeTrueEdge().Mult(edge_td_d);
     ParMatrix edgedof_multiplier_d(comm_, std::move(edgedof_multiplier));
@@ -55,6 +121,14 @@ HybridSolver::HybridSolver(const MixedMatrix& mgl, const GraphSpace& graph_space
 
     multiplier_d_td_ = MakeEntityTrueEntity(multiplier_d_td_d);
 
+    PackOffsets();
+    ColorAggregates();
+
+    if (single_precision_)
+    {
+        PackM(mgl);
+    }
+
     SparseMatrix local_hybrid = AssembleHybridSystem(mgl, j_multiplier_edgedof);
 
     InitSolver(std::move(local_hybrid));
@@ -82,7 +156,7 @@ ParMatrix HybridSolver::ComputeScaledSystem(const ParMatrix& hybrid_d)
     return linalgcpp::RAP(tmpH, scale_mat_d);
 }
 
-void HybridSolver::InitSolver(SparseMatrix local_hybrid)
+void HybridSolver::InitSolver(SparseMatrix local_hybrid, bool rebuild_prec)
 {
     if (myid_ == 0 && !use_w_)
     {
@@ -103,25 +177,13 @@ void HybridSolver::InitSolver(SparseMatrix local_hybrid)
 
     nnz_ = pHybridSystem_.nnz();
 
-    cg_ = linalgcpp::PCGSolver(pHybridSystem_, max_num_iter_, rtol_,
-                               atol_, 0, linalgcpp::ParMult);
-    if (myid_ == 0)
-    {
-        SetPrintLevel(print_level_);
-    }
-
     // HypreBoomerAMG is broken if local size is zero
     int local_size = pHybridSystem_.Rows();
     int min_size;
     MPI_Allreduce(&local_size, &min_size, 1, MPI_INT, MPI_MIN, comm_);
 
-    const bool use_prec = min_size > 0;
-    if (use_prec)
-    {
-        prec_ = linalgcpp::BoomerAMG(pHybridSystem_);
-        cg_.SetPreconditioner(prec_);
-    }
-    else
+    use_prec_ = min_size > 0;
+    if (!use_prec_)
     {
         if (myid_ == 0)
         {
@@ -130,11 +192,10 @@ void HybridSolver::InitSolver(SparseMatrix local_hybrid)
             printf("Warning: Not using preconditioner for Hybrid Solver!\n");
         }
     }
-
-    trueHrhs_.SetSize(multiplier_d_td_.Cols());
-    trueMu_.SetSize(trueHrhs_.size());
-    Hrhs_.SetSize(num_multiplier_dofs_);
-    Mu_.SetSize(num_multiplier_dofs_);
+    else if (rebuild_prec)
+    {
+        prec_ = linalgcpp::BoomerAMG(pHybridSystem_);
+    }
 }
 
 SparseMatrix HybridSolver::MakeEdgeDofMultiplier() const
@@ -166,10 +227,126 @@ void HybridSolver::CountEdgeDofs()
     }
 }
 
+void HybridSolver::PackOffsets()
+{
+    const auto& vertex_indptr = agg_vertexdof_.GetIndptr();
+    const auto& edge_indptr = agg_edgedof_.GetIndptr();
+    const auto& multiplier_indptr = agg_multiplier_.GetIndptr();
+
+    elem_offsets_.resize(num_aggs_ + 1);
+    elem_offsets_[0] = 0;
+
+    max_vertexdof_ = 0;
+    max_edgedof_ = 0;
+    max_multiplier_ = 0;
+
+    for (int agg = 0; agg < num_aggs_; ++agg)
+    {
+        const int nv = vertex_indptr[agg + 1] - vertex_indptr[agg];
+        const int ne = edge_indptr[agg + 1] - edge_indptr[agg];
+        const int nm = multiplier_indptr[agg + 1] - multiplier_indptr[agg];
+
+        // Minv, MinvDT, MinvCT, AinvDMinvCT, Ainv
+        const int elem_size = ne * ne + ne * nv + ne * nm + nv * nm + nv * nv;
+
+        elem_offsets_[agg + 1] = elem_offsets_[agg] + elem_size;
+
+        max_vertexdof_ = std::max(max_vertexdof_, nv);
+        max_edgedof_ = std::max(max_edgedof_, ne);
+        max_multiplier_ = std::max(max_multiplier_, nm);
+    }
+
+    if (single_precision_)
+    {
+        elem_data_single_.resize(elem_offsets_.back());
+
+        hybrid_offsets_.resize(num_aggs_ + 1);
+        hybrid_offsets_[0] = 0;
+
+        for (int agg = 0; agg < num_aggs_; ++agg)
+        {
+            const int nm = multiplier_indptr[agg + 1] - multiplier_indptr[agg];
+
+            hybrid_offsets_[agg + 1] = hybrid_offsets_[agg] + nm * nm;
+        }
+
+        hybrid_data_single_.resize(hybrid_offsets_.back());
+    }
+    else
+    {
+        elem_data_.resize(elem_offsets_.back());
+    }
+
+    work_stride_ = max_edgedof_ + 2 * max_vertexdof_ + max_multiplier_;
+}
+
+void HybridSolver::PackM(const MixedMatrix& mgl)
+{
+    const auto& edge_indptr = agg_edgedof_.GetIndptr();
+
+    diagonal_M_ = mgl.IsDiagonalM();
+
+    if (diagonal_M_)
+    {
+        // Diagonals are stored by edge dof, pack them by aggregate
+        const auto& edge_indices = agg_edgedof_.GetIndices();
+        const auto& M_diag = mgl.GetElemMDiag();
+
+        M_offsets_ = edge_indptr;
+        M_data_.resize(M_offsets_.back());
+
+        for (int i = 0; i < M_offsets_.back(); ++i)
+        {
+            M_data_[i] = M_diag[edge_indices[i]];
+        }
+    }
+    else
+    {
+        M_offsets_.resize(num_aggs_ + 1);
+        M_offsets_[0] = 0;
+
+        for (int agg = 0; agg < num_aggs_; ++agg)
+        {
+            const int ne = edge_indptr[agg + 1] - edge_indptr[agg];
+
+            M_offsets_[agg + 1] = M_offsets_[agg] + ne * (ne + 1) / 2;
+        }
+
+        M_data_.resize(M_offsets_.back());
+
+        DenseMatrix Mloc;
+
+        // M is symmetric, only the lower triangle is kept, column by column
+        for (int agg = 0; agg < num_aggs_; ++agg)
+        {
+            const int ne = edge_indptr[agg + 1] - edge_indptr[agg];
+
+            mgl.GetElemM(agg, Mloc);
+
+            double* M = M_data_.data() + M_offsets_[agg];
+
+            for (int j = 0; j < ne; ++j)
+            {
+                for (int i = j; i < ne; ++i)
+                {
+                    *M++ = Mloc(i, j);
+                }
+            }
+        }
+    }
+
+    D_local_ = mgl.LocalD();
+
+    if (use_w_)
+    {
+        W_local_ = mgl.LocalW();
+    }
+}
+
 SparseMatrix HybridSolver::MakeLocalC(int agg, const ParMatrix& edge_true_edge,
                                       const std::vector<int>& j_multiplier_edgedof,
-                                      std::vector<int>& edge_map,
-                                      std::vector<bool>& edge_marker) const
+                                      const std::vector<int>& edgedof_first_agg,
+                                      std::vector<int>& edge_map) const
 {
     const auto& edgedof_IsOwned = edge_true_edge.GetDiag();
 
@@ -195,9 +372,8 @@ SparseMatrix HybridSolver::MakeLocalC(int agg, const ParMatrix& edge_true_edge,
         Cloc_j[i] = edgedof_local_id;
 
         if (edgedof_IsOwned.RowSize(edgedof_global_id) &&
-            edge_marker[edgedof_global_id])
+            edgedof_first_agg[edgedof_global_id] == agg)
         {
-            edge_marker[edgedof_global_id] = false;
             Cloc_data[i] = 1.;
         }
         else
@@ -216,315 +392,1155 @@ SparseMatrix HybridSolver::AssembleHybridSystem(
     const MixedMatrix& mgl,
     const std::vector<int>& j_multiplier_edgedof)
 {
-    const auto& M_el = mgl.GetElemM();
-
     const int map_size = std::max(num_edge_dofs_, agg_vertexdof_.Cols());
-    std::vector<int> edge_map(map_size, -1);
-    std::vector<bool> edge_marker(num_edge_dofs_, true);
 
-    DenseMatrix Aloc;
-    DenseMatrix Wloc;
-    DenseMatrix CMDADMC;
-    DenseMatrix DMinvCT;
+    // The first aggregate to contain an owned edge dof gets the positive
+    // constraint, found up front so aggregates can be processed in any order
+    std::vector<int> edgedof_first_agg(num_edge_dofs_, -1);
 
-    CooMatrix hybrid_system(num_multiplier_dofs_);
+    const auto& edge_indptr = agg_edgedof_.GetIndptr();
+    const auto& edge_indices = agg_edgedof_.GetIndices();
 
     for (int agg = 0; agg < num_aggs_; ++agg)
     {
-        // Extracting the size and global numbering of local dof
-        std::vector<int> local_vertexdof = agg_vertexdof_.GetIndices(agg);
-        std::vector<int> local_edgedof = agg_edgedof_.GetIndices(agg);
-        std::vector<int> local_multiplier = agg_multiplier_.GetIndices(agg);
+        for (int j = edge_indptr[agg]; j < edge_indptr[agg + 1]; ++j)
+        {
+            if (edgedof_first_agg[edge_indices[j]] == -1)
+            {
+                edgedof_first_agg[edge_indices[j]] = agg;
+            }
+        }
+    }
 
-        assert(local_vertexdof.size() > 0);
+    // Element matrices are independent, each thread keeps its own workspace
+#if GAUSS_USE_OPENMP
+    #pragma omp parallel
+#endif
+    {
+        std::vector<int> edge_map(map_size, -1);
+
+        DenseMatrix Aloc;
+        DenseMatrix Wloc;
+        DenseMatrix CMDADMC;
+        DenseMatrix DMinvCT;
+
+        DenseMatrix Mloc;
+        DenseMatrix Minv;
+        DenseMatrix MinvDT_i;
+        DenseMatrix MinvCT_i;
+        DenseMatrix AinvDMinvCT_i;
+        DenseMatrix Ainv_i;
+
+#if GAUSS_USE_OPENMP
+        #pragma omp for schedule(dynamic)
+#endif
+        for (int agg = 0; agg < num_aggs_; ++agg)
+        {
+            // Extracting the size and global numbering of local dof
+            std::vector<int> local_vertexdof = agg_vertexdof_.GetIndices(agg);
+            std::vector<int> local_edgedof = agg_edgedof_.GetIndices(agg);
+            std::vector<int> local_multiplier = agg_multiplier_.GetIndices(agg);
+
+            assert(local_vertexdof.size() > 0);
+
+            SparseMatrix Dloc = mgl.LocalD().GetSubMatrix(local_vertexdof, local_edgedof,
+                                                          edge_map);
+
+            SparseMatrix Cloc = MakeLocalC(agg, mgl.EdgeTrueEdge(), j_multiplier_edgedof,
+                                           edgedof_first_agg, edge_map);
+
+            // Compute:
+            //      CMinvCT = Cloc * MinvCT
+            //      Aloc = DMinvDT = Dloc * MinvDT
+            //      DMinvCT = Dloc * MinvCT
+            //      CMinvDTAinvDMinvCT = CMinvDT * AinvDMinvCT_
+            //      hybrid_elem = CMinvCT - CMinvDTAinvDMinvCT
+
+
+            DenseMatrix& hybrid_elem(hybrid_elem_[agg]);
+
+            mgl.GetElemM(agg, Mloc);
+            Mloc.Invert(Minv);
+
+            Dloc.MultCT(Minv, MinvDT_i);
+            Cloc.MultCT(Minv, MinvCT_i);
+
+            Cloc.Mult(MinvCT_i, hybrid_elem);
+            Dloc.Mult(MinvCT_i, DMinvCT);
+            Dloc.Mult(MinvDT_i, Aloc);
+
+            if (use_w_)
+            {
+                auto Wloc_tmp = mgl.LocalW().GetSubMatrix(local_vertexdof, local_vertexdof, edge_map);
+                Wloc_tmp.ToDense(Wloc);
+
+                Aloc -= Wloc;
+            }
+
+            Aloc.Invert(Ainv_i);
+
+            Ainv_i.Mult(DMinvCT, AinvDMinvCT_i);
+
+            if (DMinvCT.Cols() > 0)
+            {
+                AinvDMinvCT_i.MultAT(DMinvCT, CMDADMC);
+                hybrid_elem -= CMDADMC;
+            }
+
+            // Store the element matrices needed by the solve
+            const int nv = local_vertexdof.size();
+            const int ne = local_edgedof.size();
+            const int nm = local_multiplier.size();
+
+            if (single_precision_)
+            {
+                float* elem = elem_data_single_.data() + elem_offsets_[agg];
+                elem = Pack(Minv, ne, ne, elem);
+                elem = Pack(MinvDT_i, ne, nv, elem);
+                elem = Pack(MinvCT_i, ne, nm, elem);
+                elem = Pack(AinvDMinvCT_i, nv, nm, elem);
+                elem = Pack(Ainv_i, nv, nv, elem);
+
+                assert(elem == elem_data_single_.data() + elem_offsets_[agg + 1]);
+
+                Pack(hybrid_elem, nm, nm, hybrid_data_single_.data() + hybrid_offsets_[agg]);
+                hybrid_elem = DenseMatrix();
+            }
+            else
+            {
+                double* elem = elem_data_.data() + elem_offsets_[agg];
+                elem = Pack(Minv, ne, ne, elem);
+                elem = Pack(MinvDT_i, ne, nv, elem);
+                elem = Pack(MinvCT_i, ne, nm, elem);
+                elem = Pack(AinvDMinvCT_i, nv, nm, elem);
+                elem = Pack(Ainv_i, nv, nv, elem);
+
+                assert(elem == elem_data_.data() + elem_offsets_[agg + 1]);
+            }
+        }
+    }
 
-        SparseMatrix Dloc = mgl.LocalD().GetSubMatrix(local_vertexdof, local_edgedof,
-                                                      edge_map);
+    return AssembleElements(agg_weights_);
+}
 
-        SparseMatrix Cloc = MakeLocalC(agg, mgl.EdgeTrueEdge(), j_multiplier_edgedof,
-                                       edge_map, edge_marker);
+SparseMatrix HybridSolver::AssembleElements(const std::vector<double>& agg_weight) const
+{
+    // The sparsity pattern of the hybridized system is known from the
+    // aggregate to multiplier relation, so elements are added in place
+    std::vector<int> indptr = hybrid_pattern_.GetIndptr();
+    std::vector<int> indices = hybrid_pattern_.GetIndices();
+    std::vector<double> data(indices.size(), 0.0);
+
+    const int num_colors = color_agg_.Rows();
+    const auto& color_indptr = color_agg_.GetIndptr();
+    const auto& color_indices = color_agg_.GetIndices();
+
+    const auto& multiplier_indptr = agg_multiplier_.GetIndptr();
+    const auto& multiplier_indices = agg_multiplier_.GetIndices();
+
+    // Aggregates of the same color share no multipliers, so their rows are
+    // disjoint and the sum order is independent of the number of threads
+#if GAUSS_USE_OPENMP
+    #pragma omp parallel
+#endif
+    {
+        std::vector<int> col_map(num_multiplier_dofs_, -1);
 
-        // Compute:
-        //      CMinvCT = Cloc * MinvCT
-        //      Aloc = DMinvDT = Dloc * MinvDT
-        //      DMinvCT = Dloc * MinvCT
-        //      CMinvDTAinvDMinvCT = CMinvDT * AinvDMinvCT_
-        //      hybrid_elem = CMinvCT - CMinvDTAinvDMinvCT
+        for (int color = 0; color < num_colors; ++color)
+        {
+#if GAUSS_USE_OPENMP
+            #pragma omp for schedule(static)
+#endif
+            for (int c = color_indptr[color]; c < color_indptr[color + 1]; ++c)
+            {
+                const int agg = color_indices[c];
+                const int* local_multiplier = multiplier_indices.data() + multiplier_indptr[agg];
+                const int nlocal_multiplier = multiplier_indptr[agg + 1] - multiplier_indptr[agg];
+
+                const DenseMatrix& hybrid_elem = hybrid_elem_[agg];
+                const float* hybrid_single = single_precision_ ?
+                                             hybrid_data_single_.data() + hybrid_offsets_[agg] :
+                                             nullptr;
+
+                for (int i = 0; i < nlocal_multiplier; ++i)
+                {
+                    const int row = local_multiplier[i];
+
+                    for (int k = indptr[row]; k < indptr[row + 1]; ++k)
+                    {
+                        col_map[indices[k]] = k;
+                    }
+
+                    for (int j = 0; j < nlocal_multiplier; ++j)
+                    {
+                        const double value = hybrid_single ?
+                                             hybrid_single[j * nlocal_multiplier + i] :
+                                             hybrid_elem(i, j);
+
+                        data[col_map[local_multiplier[j]]] += agg_weight[agg] * value;
+                    }
+                }
+            }
+        }
+    }
 
+    return SparseMatrix(std::move(indptr), std::move(indices), std::move(data),
+                        num_multiplier_dofs_, num_multiplier_dofs_);
+}
 
-        DenseMatrix& Minv(Minv_[agg]);
-        DenseMatrix& MinvCT_i(MinvCT_[agg]);
-        DenseMatrix& MinvDT_i(MinvDT_[agg]);
-        DenseMatrix& AinvDMinvCT_i(AinvDMinvCT_[agg]);
-        DenseMatrix& Ainv_i(Ainv_[agg]);
-        DenseMatrix& hybrid_elem(hybrid_elem_[agg]);
+struct HybridSolver::Workspace : public SolverWorkspace
+{
+    Workspace(const HybridSolver& solver)
+        : SolverWorkspace(solver.offsets_),
+          elem_sol(solver.MakeElemSolution()),
+          work(NumThreads() * solver.work_stride_),
+          Hrhs(solver.num_multiplier_dofs_),
+          Mu(solver.num_multiplier_dofs_),
+          true_rhs(1, Vector(solver.multiplier_d_td_.Cols())),
+          true_mu(1, Vector(solver.multiplier_d_td_.Cols()))
+    {
+        if (solver.single_precision_)
+        {
+            resid = BlockVector(solver.offsets_);
+            correction = BlockVector(solver.offsets_);
+        }
+    }
 
-        M_el[agg].Invert(Minv);
+    ElemSolution elem_sol;
+    std::vector<double> work;
 
-        Dloc.MultCT(Minv, MinvDT_i);
-        Cloc.MultCT(Minv, MinvCT_i);
+    Vector Hrhs;
+    Vector Mu;
 
-        Cloc.Mult(MinvCT_i, hybrid_elem);
-        Dloc.Mult(MinvCT_i, DMinvCT);
-        Dloc.Mult(MinvDT_i, Aloc);
+    std::vector<Vector> true_rhs;
+    std::vector<Vector> true_mu;
 
-        if (use_w_)
-        {
-            auto Wloc_tmp = mgl.LocalW().GetSubMatrix(local_vertexdof, local_vertexdof, edge_map);
-            Wloc_tmp.ToDense(Wloc);
+    // Residual and correction of iterative refinement
+    BlockVector resid;
+    BlockVector correction;
+};
 
-            Aloc -= Wloc;
-        }
+std::unique_ptr<SolverWorkspace> HybridSolver::MakeWorkspace() const
+{
+    return make_unique<Workspace>(*this);
+}
 
-        Aloc.Invert(Ainv_i);
+HybridSolver::ElemSolution HybridSolver::MakeElemSolution() const
+{
+    const auto& vertex_indptr = agg_vertexdof_.GetIndptr();
+    const auto& edge_indptr = agg_edgedof_.GetIndptr();
 
-        Ainv_i.Mult(DMinvCT, AinvDMinvCT_i);
+    ElemSolution elem_sol;
+    elem_sol.Ainv_f.resize(vertex_indptr[num_aggs_]);
+    elem_sol.AinvDMinv_g.resize(vertex_indptr[num_aggs_]);
+    elem_sol.Minv_g.resize(edge_indptr[num_aggs_]);
 
-        if (DMinvCT.Cols() > 0)
-        {
-            AinvDMinvCT_i.MultAT(DMinvCT, CMDADMC);
-            hybrid_elem -= CMDADMC;
-        }
+    return elem_sol;
+}
 
-        // Add contribution of the element matrix to the global system
-        hybrid_system.Add(local_multiplier, hybrid_elem);
+void HybridSolver::Rescale(VectorView vect) const
+{
+    if (rescale_iter_ > 0)
+    {
+        vect *= VectorView(diag_scaling_);
     }
+}
+
+void HybridSolver::Solve(const BlockVector& Rhs, BlockVector& Sol,
+                         SolverWorkspace& work) const
+{
+    assert(dynamic_cast<Workspace*>(&work));
+
+    auto& hb_work = static_cast<Workspace&>(work);
+
+    TrueRHS(Rhs, hb_work);
+
+    hb_work.true_mu[0] = 0.0;
 
-    return hybrid_system.ToSparse();
+    SolveMultiplier(Sol, hb_work);
+    Refine(Rhs, Sol, hb_work);
 }
 
+void HybridSolver::Solve(const BlockVector& Rhs, BlockVector& Sol,
+                         const BlockVector& initial_guess, SolverWorkspace& work) const
+{
+    assert(dynamic_cast<Workspace*>(&work));
+
+    auto& hb_work = static_cast<Workspace&>(work);
+
+    TrueRHS(Rhs, hb_work);
+    InitialMultiplier(initial_guess, hb_work);
 
+    SolveMultiplier(Sol, hb_work);
+    Refine(Rhs, Sol, hb_work);
+}
 
-void HybridSolver::Solve(const BlockVector& Rhs, BlockVector& Sol) const
+void HybridSolver::TrueRHS(const BlockVector& Rhs, Workspace& work) const
 {
-    RHSTransform(Rhs, Hrhs_);
+    RHSTransform(Rhs, work.Hrhs, work.elem_sol, work.work);
 
     if (!use_w_ && myid_ == 0)
     {
-        Hrhs_[0] = 0.0;
+        work.Hrhs[0] = 0.0;
     }
 
     // assemble true right hand side
-    multiplier_d_td_.MultAT(Hrhs_, trueHrhs_);
-
-    if (rescale_iter_ > 0)
-    {
-        trueHrhs_ *= VectorView(diag_scaling_);
-    }
+    multiplier_d_td_.MultAT(work.Hrhs, work.true_rhs[0]);
+    Rescale(work.true_rhs[0]);
+}
 
+void HybridSolver::SolveMultiplier(BlockVector& Sol, Workspace& work) const
+{
     // solve the parallel global hybridized system
     Timer timer(Timer::Start::True);
 
-    trueMu_ = 0.0;
-    cg_.Mult(trueHrhs_, trueMu_);
+    LockedOperator prec(prec_, prec_mutex_);
+
+    work.num_iterations = PCG(pHybridSystem_, use_prec_ ? &prec : nullptr,
+                              work.true_rhs, work.true_mu);
 
     timer.Click();
-    timing_ = timer.TotalTime();
+    work.timing = timer.TotalTime();
 
     if (myid_ == 0 && print_level_ > 0)
     {
-        std::cout << "  Timing: PCG done in " << timing_ << "s. \n";
+        std::cout << "  Timing: PCG done in " << work.timing << "s, "
+                  << work.num_iterations << " iterations.\n";
     }
 
-    num_iterations_ = cg_.GetNumIterations();
+    num_iterations_ = work.num_iterations;
+    timing_ = work.timing;
 
-    if (myid_ == 0 && print_level_ > 0)
+    Rescale(work.true_mu[0]);
+
+    // distribute true dofs to dofs and recover solution of the original system
+    multiplier_d_td_.Mult(work.true_mu[0], work.Mu);
+    RecoverOriginalSolution(work.Mu, Sol, work.elem_sol, work.work);
+}
+
+void HybridSolver::Refine(const BlockVector& Rhs, BlockVector& Sol, Workspace& work) const
+{
+    if (!single_precision_)
     {
-        /*
-        if (cg_.GetConverged())
-            std::cout << "  CG converged in "
-                      << num_iterations_
-                      << " with a final residual norm "
-                      << cg_->GetFinalNorm() << "\n";
-        else
-            std::cout << "  CG did not converge in "
-                      << num_iterations_
-                      << ". Final residual norm is "
-                      << cg_->GetFinalNorm() << "\n";
-        */
+        return;
     }
 
-    if (rescale_iter_ > 0)
+    int num_iterations = work.num_iterations;
+    double timing = work.timing;
+
+    const double rhs_norm = ParNorm(comm_, Rhs);
+    double prev_norm = std::numeric_limits<double>::max();
+
+    // Stop once converged, or when the residual no longer decreases
+    // much, at the accuracy of the solves on the hybridized system
+    for (int iter = 0; iter < max_refine_iter; ++iter)
     {
-        trueMu_ *= VectorView(diag_scaling_);
+        double resid_norm = Residual(Rhs, Sol, work.resid, work.work);
+
+        if (resid_norm <= rtol_ * rhs_norm || resid_norm > 0.5 * prev_norm)
+        {
+            break;
+        }
+
+        prev_norm = resid_norm;
+
+        TrueRHS(work.resid, work);
+        work.true_mu[0] = 0.0;
+
+        SolveMultiplier(work.correction, work);
+
+        Sol.GetBlock(0) += work.correction.GetBlock(0);
+        Sol.GetBlock(1) += work.correction.GetBlock(1);
+
+        num_iterations += work.num_iterations;
+        timing += work.timing;
     }
 
-    // distribute true dofs to dofs and recover solution of the original system
-    multiplier_d_td_.Mult(trueMu_, Mu_);
-    RecoverOriginalSolution(Mu_, Sol);
+    work.num_iterations = num_iterations;
+    work.timing = timing;
+
+    num_iterations_ = num_iterations;
+    timing_ = timing;
 }
 
-void HybridSolver::RHSTransform(const BlockVector& OriginalRHS,
-                                VectorView HybridRHS) const
+double HybridSolver::Residual(const BlockVector& Rhs, const BlockVector& Sol,
+                              BlockVector& resid, std::vector<double>& work_space) const
 {
-    HybridRHS = 0.;
+    // [g; f] - [M D^T; D W][sigma; u], where the edge rows are summed over
+    // processors as in the right hand side, so shared edge dofs only get the
+    // contributions of local elements
+    const VectorView& sigma = Sol.GetBlock(0);
+    const VectorView& u = Sol.GetBlock(1);
+
+    resid = Rhs;
+
+    VectorView resid_sigma = resid.GetBlock(0);
+    VectorView resid_u = resid.GetBlock(1);
+
+    Vector DT_u(D_local_.Cols());
+    D_local_.MultAT(u, DT_u);
+    resid_sigma -= DT_u;
+
+    Vector D_sigma(D_local_.Rows());
+    D_local_.Mult(sigma, D_sigma);
+    resid_u -= D_sigma;
+
+    if (use_w_)
+    {
+        Vector W_u(W_local_.Rows());
+        W_local_.Mult(u, W_u);
+        resid_u -= W_u;
+    }
+
+    ResizeWork(work_space);
+
+    const int num_colors = color_agg_.Rows();
+    const auto& color_indptr = color_agg_.GetIndptr();
+    const auto& color_indices = color_agg_.GetIndices();
+
+    const auto& edge_indptr = agg_edgedof_.GetIndptr();
+
+    // Aggregates of the same color share no edge dofs
+#if GAUSS_USE_OPENMP
+    #pragma omp parallel
+#endif
+    {
+        double* sigma_loc = work_space.data() + ThreadId() * work_stride_;
+
+        for (int color = 0; color < num_colors; ++color)
+        {
+#if GAUSS_USE_OPENMP
+            #pragma omp for schedule(static)
+#endif
+            for (int c = color_indptr[color]; c < color_indptr[color + 1]; ++c)
+            {
+                const int agg = color_indices[c];
+                const int* local_edgedof = agg_edgedof_.GetIndices().data() + edge_indptr[agg];
+                const int nlocal_edgedof = edge_indptr[agg + 1] - edge_indptr[agg];
+
+                const double* M = M_data_.data() + M_offsets_[agg];
+                const double scale = 1.0 / agg_weights_[agg];
+
+                if (diagonal_M_)
+                {
+                    for (int i = 0; i < nlocal_edgedof; ++i)
+                    {
+                        resid_sigma[local_edgedof[i]] -= scale * M[i] * sigma[local_edgedof[i]];
+                    }
+
+                    continue;
+                }
+
+                for (int i = 0; i < nlocal_edgedof; ++i)
+                {
+                    sigma_loc[i] = sigma[local_edgedof[i]];
+                }
+
+                // Lower triangle of M, column by column
+                for (int j = 0; j < nlocal_edgedof; ++j)
+                {
+                    const double scale_x = scale * sigma_loc[j];
+                    double sum = M[0] * sigma_loc[j];
+
+                    for (int i = j + 1; i < nlocal_edgedof; ++i)
+                    {
+                        resid_sigma[local_edgedof[i]] -= scale_x * M[i - j];
+                        sum += M[i - j] * sigma_loc[i];
+                    }
+
+                    resid_sigma[local_edgedof[j]] -= scale * sum;
+                    M += nlocal_edgedof - j;
+                }
+            }
+        }
+    }
+
+    // Without W, only the part of the vertex residual orthogonal
+    // to the constant representation can be corrected
+    if (!use_w_)
+    {
+        const int num_vertexdofs = resid_u.size();
+        const bool has_rep = constant_rep_.size() > 0;
+
+        double dots[2] = {0.0, 0.0};
+
+        for (int i = 0; i < num_vertexdofs; ++i)
+        {
+            const double rep_i = has_rep ? constant_rep_[i] : 1.0;
+
+            dots[0] += rep_i * resid_u[i];
+            dots[1] += rep_i * rep_i;
+        }
+
+        ParSum(comm_, dots, 2);
+
+        const double shift = dots[1] > 0.0 ? dots[0] / dots[1] : 0.0;
+
+        for (int i = 0; i < num_vertexdofs; ++i)
+        {
+            resid_u[i] -= shift * (has_rep ? constant_rep_[i] : 1.0);
+        }
+    }
+
+    return ParNorm(comm_, resid);
+}
+
+void HybridSolver::InitialMultiplier(const BlockVector& initial_guess, Workspace& work) const
+{
+    // Fit the multipliers that recover the initial guess in each aggregate.
+    // Without W, the multipliers of a constant shift in the vertex guess are
+    // also fit, so the result can be shifted to match the pinned multiplier.
+    const bool pinned = !use_w_;
+
+    Vector null_mu(pinned ? num_multiplier_dofs_ : 0);
+
+    work.Mu = 0.0;
+    null_mu = 0.0;
+
+    const int num_colors = color_agg_.Rows();
+    const auto& color_indptr = color_agg_.GetIndptr();
+    const auto& color_indices = color_agg_.GetIndices();
+
+    // Aggregates of the same color share no multipliers
+#if GAUSS_USE_OPENMP
+    #pragma omp parallel
+#endif
+    {
+        std::vector<double> local_work(2 * max_edgedof_ + max_vertexdof_ + 2 * max_multiplier_);
+        DenseMatrix normal;
+        DenseMatrix normal_inv;
 
-    Vector f_loc;
-    Vector g_loc;
-    Vector CMinvDTAinv_f_loc;
-    Vector CMinvDTAinvDM_g_loc;
-    Vector CMinv_g_loc;
-    Vector DMinv_g_loc;
+        for (int color = 0; color < num_colors; ++color)
+        {
+#if GAUSS_USE_OPENMP
+            #pragma omp for schedule(static)
+#endif
+            for (int i = color_indptr[color]; i < color_indptr[color + 1]; ++i)
+            {
+                const int agg = color_indices[i];
+
+                if (single_precision_)
+                {
+                    InitialMultiplier(agg, elem_data_single_.data() + elem_offsets_[agg],
+                                      initial_guess, work.elem_sol, work.Mu, null_mu,
+                                      normal, normal_inv, local_work.data());
+                }
+                else
+                {
+                    InitialMultiplier(agg, elem_data_.data() + elem_offsets_[agg],
+                                      initial_guess, work.elem_sol, work.Mu, null_mu,
+                                      normal, normal_inv, local_work.data());
+                }
+            }
+        }
+    }
+
+    // Average over the aggregates that share a multiplier
+    std::vector<int> multiplier_count(num_multiplier_dofs_, 0);
 
-    for (int iAgg = 0; iAgg < num_aggs_; ++iAgg)
+    for (auto&& multiplier : agg_multiplier_.GetIndices())
     {
-        // Extracting the size and global numbering of local dof
-        std::vector<int> local_edgedof = agg_edgedof_.GetIndices(iAgg);
-        std::vector<int> local_vertexdof = agg_vertexdof_.GetIndices(iAgg);
-        std::vector<int> local_multiplier = agg_multiplier_.GetIndices(iAgg);
+        multiplier_count[multiplier]++;
+    }
 
-        int nlocal_edgedof = local_edgedof.size();
-        int nlocal_multiplier = local_multiplier.size();
+    for (int i = 0; i < num_multiplier_dofs_; ++i)
+    {
+        work.Mu[i] /= std::max(multiplier_count[i], 1);
+    }
 
-        // Compute local contribution to the RHS of the hybrid system
-        OriginalRHS.GetBlock(0).GetSubVector(local_edgedof, g_loc);
-        OriginalRHS.GetBlock(1).GetSubVector(local_vertexdof, f_loc);
+    if (pinned)
+    {
+        double shift = 0.0;
+
+        if (myid_ == 0 && num_multiplier_dofs_ > 0 && null_mu[0] != 0.0)
+        {
+            // Both fits are sums over the same aggregates
+            shift = work.Mu[0] * multiplier_count[0] / null_mu[0];
+        }
 
-        g_loc *= -1.0;
-        f_loc *= -1.0;
+        if (NumProcs(comm_) > 1)
+        {
+            MPI_Bcast(&shift, 1, MPI_DOUBLE, 0, comm_);
+        }
 
-        for (int i = 0; i < nlocal_edgedof; ++i)
+        for (int i = 0; i < num_multiplier_dofs_; ++i)
         {
-            int count = edgedof_count_[local_edgedof[i]];
-            g_loc[i] /= count;
+            work.Mu[i] -= shift * null_mu[i] / std::max(multiplier_count[i], 1);
+        }
+    }
 
-            assert(count == 1 || count == 2);
+    // Each true multiplier takes the value of its owned copy
+    multiplier_d_td_.GetDiag().MultAT(work.Mu, work.true_mu[0]);
+
+    // Undo the scaling applied to the solution of the scaled system
+    if (rescale_iter_ > 0)
+    {
+        const int num_true = work.true_mu[0].size();
+
+        for (int i = 0; i < num_true; ++i)
+        {
+            work.true_mu[0][i] /= diag_scaling_[i];
         }
+    }
+}
+
+template <typename T>
+void HybridSolver::InitialMultiplier(int agg, const T* elem,
+                                     const BlockVector& initial_guess,
+                                     const ElemSolution& elem_sol,
+                                     VectorView mu, VectorView null_mu,
+                                     DenseMatrix& normal, DenseMatrix& normal_inv,
+                                     double* work) const
+{
+    // Least squares solution of MinvCT mu = -sigma / w - Minv g - MinvDT u,
+    // the recovery of sigma from the multipliers, which is exact if the
+    // initial guess is the recovered solution
+    const VectorView& sigma = initial_guess.GetBlock(0);
+    const VectorView& u = initial_guess.GetBlock(1);
+
+    const auto& vertex_indptr = agg_vertexdof_.GetIndptr();
+    const auto& edge_indptr = agg_edgedof_.GetIndptr();
+    const auto& multiplier_indptr = agg_multiplier_.GetIndptr();
+
+    const int* local_edgedof = agg_edgedof_.GetIndices().data() + edge_indptr[agg];
+    const int* local_vertexdof = agg_vertexdof_.GetIndices().data() + vertex_indptr[agg];
+    const int* local_multiplier = agg_multiplier_.GetIndices().data() + multiplier_indptr[agg];
 
-        AinvDMinvCT_[iAgg].MultAT(f_loc, CMinvDTAinv_f_loc);
-        MinvCT_[iAgg].MultAT(g_loc, CMinv_g_loc);
-        MinvDT_[iAgg].MultAT(g_loc, DMinv_g_loc);
-        AinvDMinvCT_[iAgg].MultAT(DMinv_g_loc, CMinvDTAinvDM_g_loc);
+    const int nlocal_edgedof = edge_indptr[agg + 1] - edge_indptr[agg];
+    const int nlocal_vertexdof = vertex_indptr[agg + 1] - vertex_indptr[agg];
+    const int nlocal_multiplier = multiplier_indptr[agg + 1] - multiplier_indptr[agg];
 
-        CMinv_g_loc *= agg_weights_[iAgg];
-        CMinvDTAinvDM_g_loc *= agg_weights_[iAgg];
+    if (nlocal_multiplier == 0)
+    {
+        return;
+    }
+
+    const T* MinvDT = elem + nlocal_edgedof * nlocal_edgedof;
+    const T* MinvCT = MinvDT + nlocal_edgedof * nlocal_vertexdof;
+
+    const double* Minv_g = elem_sol.Minv_g.data() + edge_indptr[agg];
+
+    double* resid = work;
+    double* null_resid = resid + max_edgedof_;
+    double* vertex_loc = null_resid + max_edgedof_;
+    double* proj = vertex_loc + max_vertexdof_;
+    double* null_proj = proj + max_multiplier_;
+
+    const double weight = agg_weights_[agg];
+
+    for (int i = 0; i < nlocal_edgedof; ++i)
+    {
+        resid[i] = -sigma[local_edgedof[i]] / weight - Minv_g[i];
+    }
+
+    for (int i = 0; i < nlocal_vertexdof; ++i)
+    {
+        vertex_loc[i] = u[local_vertexdof[i]];
+    }
+
+    PackedMultAdd(nlocal_edgedof, nlocal_vertexdof, -1.0, MinvDT, vertex_loc, resid);
 
-        CMinvDTAinv_f_loc -= CMinvDTAinvDM_g_loc;
-        CMinvDTAinv_f_loc += CMinv_g_loc;
+    // Normal equations of the least squares problem
+    normal.SetSize(nlocal_multiplier, nlocal_multiplier);
+
+    for (int j = 0; j < nlocal_multiplier; ++j)
+    {
+        // Column j in double precision, null_resid is not used yet
+        std::copy_n(MinvCT + j * nlocal_edgedof, nlocal_edgedof, null_resid);
+
+        std::fill_n(proj, nlocal_multiplier, 0.0);
+        PackedMultAddAT(nlocal_edgedof, nlocal_multiplier, 1.0, MinvCT, null_resid, proj);
 
         for (int i = 0; i < nlocal_multiplier; ++i)
         {
-            HybridRHS[local_multiplier[i]] -= CMinvDTAinv_f_loc[i];
+            normal(i, j) = proj[i];
         }
+    }
+
+    normal.Invert(normal_inv);
+
+    std::fill_n(proj, nlocal_multiplier, 0.0);
+    PackedMultAddAT(nlocal_edgedof, nlocal_multiplier, 1.0, MinvCT, resid, proj);
+
+    for (int i = 0; i < nlocal_multiplier; ++i)
+    {
+        double mu_i = 0.0;
+
+        for (int j = 0; j < nlocal_multiplier; ++j)
+        {
+            mu_i += normal_inv(i, j) * proj[j];
+        }
+
+        mu[local_multiplier[i]] += mu_i;
+    }
+
+    if (null_mu.size() == 0)
+    {
+        return;
+    }
+
+    // Multipliers of a constant shift in u
+    for (int i = 0; i < nlocal_vertexdof; ++i)
+    {
+        vertex_loc[i] = constant_rep_.size() > 0 ? constant_rep_[local_vertexdof[i]] : 1.0;
+    }
 
-        // Save the element rhs [M B^T;B 0]^-1[f;g] for solution recovery
-        Ainv_[iAgg].Mult(f_loc, Ainv_f_[iAgg]);
-        Ainv_f_[iAgg] /= agg_weights_[iAgg];
+    std::fill_n(null_resid, nlocal_edgedof, 0.0);
+    PackedMultAdd(nlocal_edgedof, nlocal_vertexdof, -1.0, MinvDT, vertex_loc, null_resid);
+
+    std::fill_n(null_proj, nlocal_multiplier, 0.0);
+    PackedMultAddAT(nlocal_edgedof, nlocal_multiplier, 1.0, MinvCT, null_resid, null_proj);
+
+    for (int i = 0; i < nlocal_multiplier; ++i)
+    {
+        double null_mu_i = 0.0;
+
+        for (int j = 0; j < nlocal_multiplier; ++j)
+        {
+            null_mu_i += normal_inv(i, j) * null_proj[j];
+        }
 
-        Ainv_[iAgg].Mult(DMinv_g_loc, AinvDMinv_g_[iAgg]);
-        Minv_[iAgg].Mult(g_loc, Minv_g_[iAgg]);
+        null_mu[local_multiplier[i]] += null_mu_i;
     }
 }
 
-void HybridSolver::RecoverOriginalSolution(const VectorView& HybridSol,
-                                           BlockVector& RecoveredSol) const
+void HybridSolver::Solve(const std::vector<BlockVector>& Rhs,
+                         std::vector<BlockVector>& Sol) const
 {
-    // Recover the solution of the original system from multiplier mu, i.e.,
-    // [u;p] = [f;g] - [M B^T;B 0]^-1[C 0]^T * mu
-    // This procedure is done locally in each element
+    SolveBatched(Rhs, Sol);
 
-    RecoveredSol = 0.;
+    if (!single_precision_)
+    {
+        return;
+    }
+
+    // Refine the right hand sides together, correcting those not yet converged
+    const int num_rhs = Rhs.size();
+
+    int num_iterations = num_iterations_;
+    double timing = timing_;
 
-    Vector mu_loc;
-    Vector sigma_loc;
-    Vector tmp;
+    BlockVector resid(offsets_);
+    std::vector<double> work;
+
+    std::vector<double> rhs_norms(num_rhs);
+    std::vector<double> prev_norms(num_rhs, std::numeric_limits<double>::max());
+    std::vector<bool> active(num_rhs, true);
+
+    for (int i = 0; i < num_rhs; ++i)
+    {
+        rhs_norms[i] = ParNorm(comm_, Rhs[i]);
+    }
 
-    for (int iAgg = 0; iAgg < num_aggs_; ++iAgg)
+    for (int iter = 0; iter < max_refine_iter; ++iter)
     {
-        // Extracting the size and global numbering of local dof
-        std::vector<int> local_vertexdof = agg_vertexdof_.GetIndices(iAgg);
-        std::vector<int> local_edgedof = agg_edgedof_.GetIndices(iAgg);
-        std::vector<int> local_multiplier = agg_multiplier_.GetIndices(iAgg);
+        std::vector<int> index;
+        std::vector<BlockVector> resids;
+
+        for (int i = 0; i < num_rhs; ++i)
+        {
+            if (!active[i])
+            {
+                continue;
+            }
+
+            double resid_norm = Residual(Rhs[i], Sol[i], resid, work);
 
-        int nlocal_vertexdof = local_vertexdof.size();
-        int nlocal_edgedof = local_edgedof.size();
-        int nlocal_multiplier = local_multiplier.size();
+            if (resid_norm <= rtol_ * rhs_norms[i] || resid_norm > 0.5 * prev_norms[i])
+            {
+                active[i] = false;
+                continue;
+            }
+
+            prev_norms[i] = resid_norm;
+
+            index.push_back(i);
+            resids.push_back(resid);
+        }
+
+        if (index.empty())
+        {
+            break;
+        }
+
+        std::vector<BlockVector> corrections(index.size(), BlockVector(offsets_));
+
+        for (auto& correction : corrections)
+        {
+            correction = 0.0;
+        }
 
-        // Initialize a vector which will store the local contribution of Hdiv
-        // and L2 space
-        Vector& u_loc(Ainv_f_[iAgg]);
+        SolveBatched(resids, corrections);
 
-        // This check is just for the case when there is only one element for
-        // the global problem, then there will be no Lagrange multipliers
-        if (nlocal_multiplier > 0)
+        for (int j = 0; j < static_cast<int>(index.size()); ++j)
         {
-            // Extract the local portion of the Lagrange multiplier solution
-            HybridSol.GetSubVector(local_multiplier, mu_loc);
+            Sol[index[j]].GetBlock(0) += corrections[j].GetBlock(0);
+            Sol[index[j]].GetBlock(1) += corrections[j].GetBlock(1);
+        }
+
+        num_iterations += num_iterations_;
+        timing += timing_;
+    }
 
-            // Compute u = (DMinvDT)^-1(f-DMinvC^T mu)
-            AinvDMinvCT_[iAgg].Mult(mu_loc, tmp);
-            u_loc -= tmp;
-            u_loc -= AinvDMinv_g_[iAgg];
+    num_iterations_ = num_iterations;
+    timing_ = timing;
+}
+
+void HybridSolver::SolveBatched(const std::vector<BlockVector>& Rhs,
+                                std::vector<BlockVector>& Sol) const
+{
+    assert(Rhs.size() == Sol.size());
 
-            // Compute -sigma = Minv(DT u + DT mu)
-            MinvDT_[iAgg].Mult(u_loc, sigma_loc);
-            MinvCT_[iAgg].Mult(mu_loc, tmp);
-            sigma_loc += tmp;
-            sigma_loc += Minv_g_[iAgg];
-            sigma_loc *= agg_weights_[iAgg];
+    int num_rhs = Rhs.size();
+
+    Workspace work(*this);
+
+    // Each right hand side keeps its own element solutions for recovery
+    std::vector<ElemSolution> elem_sols(num_rhs, work.elem_sol);
+    std::vector<Vector> true_rhs(num_rhs, Vector(multiplier_d_td_.Cols()));
+    std::vector<Vector> true_mu(num_rhs, Vector(multiplier_d_td_.Cols()));
+
+    for (int i = 0; i < num_rhs; ++i)
+    {
+        RHSTransform(Rhs[i], work.Hrhs, elem_sols[i], work.work);
+
+        if (!use_w_ && myid_ == 0)
+        {
+            work.Hrhs[0] = 0.0;
         }
 
-        // Save local solution to the global solution vector
-        for (int i = 0; i < nlocal_edgedof; ++i)
+        multiplier_d_td_.MultAT(work.Hrhs, true_rhs[i]);
+        Rescale(true_rhs[i]);
+
+        true_mu[i] = 0.0;
+    }
+
+    Timer timer(Timer::Start::True);
+
+    LockedOperator prec(prec_, prec_mutex_);
+
+    int num_iterations = PCG(pHybridSystem_, use_prec_ ? &prec : nullptr,
+                             true_rhs, true_mu);
+
+    timer.Click();
+
+    num_iterations_ = num_iterations;
+    timing_ = timer.TotalTime();
+
+    for (int i = 0; i < num_rhs; ++i)
+    {
+        Rescale(true_mu[i]);
+
+        multiplier_d_td_.Mult(true_mu[i], work.Mu);
+        RecoverOriginalSolution(work.Mu, Sol[i], elem_sols[i], work.work);
+    }
+}
+
+void HybridSolver::RHSTransform(const BlockVector& OriginalRHS, VectorView HybridRHS,
+                                SolverWorkspace& work) const
+{
+    assert(dynamic_cast<Workspace*>(&work));
+
+    auto& hb_work = static_cast<Workspace&>(work);
+
+    RHSTransform(OriginalRHS, HybridRHS, hb_work.elem_sol, hb_work.work);
+}
+
+void HybridSolver::RHSTransform(const BlockVector& OriginalRHS, VectorView HybridRHS,
+                                ElemSolution& elem_sol, std::vector<double>& work_space) const
+{
+    HybridRHS = 0.;
+
+    ResizeWork(work_space);
+
+    const int num_colors = color_agg_.Rows();
+    const auto& color_indptr = color_agg_.GetIndptr();
+    const auto& color_indices = color_agg_.GetIndices();
+
+    // Aggregates of the same color share no edge dofs, so each thread
+    // owns the multipliers of the aggregates it works on
+#if GAUSS_USE_OPENMP
+    #pragma omp parallel
+#endif
+    {
+        double* work = work_space.data() + ThreadId() * work_stride_;
+
+        for (int color = 0; color < num_colors; ++color)
         {
-            RecoveredSol[local_edgedof[i]] = -sigma_loc[i];
+#if GAUSS_USE_OPENMP
+            #pragma omp for schedule(static)
+#endif
+            for (int i = color_indptr[color]; i < color_indptr[color + 1]; ++i)
+            {
+                const int agg = color_indices[i];
+
+                if (single_precision_)
+                {
+                    RHSTransform(agg, elem_data_single_.data() + elem_offsets_[agg],
+                                 OriginalRHS, HybridRHS, elem_sol, work);
+                }
+                else
+                {
+                    RHSTransform(agg, elem_data_.data() + elem_offsets_[agg],
+                                 OriginalRHS, HybridRHS, elem_sol, work);
+                }
+            }
         }
+    }
+}
+
+template <typename T>
+void HybridSolver::RHSTransform(int agg, const T* elem, const BlockVector& OriginalRHS,
+                                VectorView HybridRHS, ElemSolution& elem_sol,
+                                double* work) const
+{
+    const VectorView& g = OriginalRHS.GetBlock(0);
+    const VectorView& f = OriginalRHS.GetBlock(1);
+
+    const auto& vertex_indptr = agg_vertexdof_.GetIndptr();
+    const auto& edge_indptr = agg_edgedof_.GetIndptr();
+    const auto& multiplier_indptr = agg_multiplier_.GetIndptr();
+
+    // Extracting the size and global numbering of local dof
+    const int* local_edgedof = agg_edgedof_.GetIndices().data() + edge_indptr[agg];
+    const int* local_vertexdof = agg_vertexdof_.GetIndices().data() + vertex_indptr[agg];
+    const int* local_multiplier = agg_multiplier_.GetIndices().data() + multiplier_indptr[agg];
+
+    const int nlocal_edgedof = edge_indptr[agg + 1] - edge_indptr[agg];
+    const int nlocal_vertexdof = vertex_indptr[agg + 1] - vertex_indptr[agg];
+    const int nlocal_multiplier = multiplier_indptr[agg + 1] - multiplier_indptr[agg];
+
+    const T* Minv = elem;
+    const T* MinvDT = Minv + nlocal_edgedof * nlocal_edgedof;
+    const T* MinvCT = MinvDT + nlocal_edgedof * nlocal_vertexdof;
+    const T* AinvDMinvCT = MinvCT + nlocal_edgedof * nlocal_multiplier;
+    const T* Ainv = AinvDMinvCT + nlocal_vertexdof * nlocal_multiplier;
+
+    double* g_loc = work;
+    double* f_loc = g_loc + max_edgedof_;
+    double* DMinv_g_loc = f_loc + max_vertexdof_;
+    double* hybrid_loc = DMinv_g_loc + max_vertexdof_;
+
+    const double weight = agg_weights_[agg];
+
+    // Compute local contribution to the RHS of the hybrid system
+    for (int i = 0; i < nlocal_edgedof; ++i)
+    {
+        int count = edgedof_count_[local_edgedof[i]];
+        g_loc[i] = -g[local_edgedof[i]] / count;
+
+        assert(count == 1 || count == 2);
+    }
+
+    for (int i = 0; i < nlocal_vertexdof; ++i)
+    {
+        f_loc[i] = -f[local_vertexdof[i]];
+    }
+
+    std::fill_n(DMinv_g_loc, nlocal_vertexdof, 0.0);
+    std::fill_n(hybrid_loc, nlocal_multiplier, 0.0);
+
+    PackedMultAddAT(nlocal_edgedof, nlocal_vertexdof, 1.0, MinvDT, g_loc, DMinv_g_loc);
+
+    // CMinvDTAinv_f - w * CMinvDTAinvDMinv_g + w * CMinv_g
+    PackedMultAddAT(nlocal_vertexdof, nlocal_multiplier, 1.0, AinvDMinvCT, f_loc, hybrid_loc);
+    PackedMultAddAT(nlocal_vertexdof, nlocal_multiplier, -weight, AinvDMinvCT,
+                    DMinv_g_loc, hybrid_loc);
+    PackedMultAddAT(nlocal_edgedof, nlocal_multiplier, weight, MinvCT, g_loc, hybrid_loc);
+
+    for (int i = 0; i < nlocal_multiplier; ++i)
+    {
+        HybridRHS[local_multiplier[i]] -= hybrid_loc[i];
+    }
 
-        for (int i = 0; i < nlocal_vertexdof; ++i)
+    // Save the element rhs [M B^T;B 0]^-1[f;g] for solution recovery
+    double* Ainv_f = elem_sol.Ainv_f.data() + vertex_indptr[agg];
+    double* AinvDMinv_g = elem_sol.AinvDMinv_g.data() + vertex_indptr[agg];
+    double* Minv_g = elem_sol.Minv_g.data() + edge_indptr[agg];
+
+    std::fill_n(Ainv_f, nlocal_vertexdof, 0.0);
+    std::fill_n(AinvDMinv_g, nlocal_vertexdof, 0.0);
+    std::fill_n(Minv_g, nlocal_edgedof, 0.0);
+
+    PackedMultAdd(nlocal_vertexdof, nlocal_vertexdof, 1.0 / weight, Ainv, f_loc, Ainv_f);
+    PackedMultAdd(nlocal_vertexdof, nlocal_vertexdof, 1.0, Ainv, DMinv_g_loc, AinvDMinv_g);
+    PackedMultAdd(nlocal_edgedof, nlocal_edgedof, 1.0, Minv, g_loc, Minv_g);
+}
+
+void HybridSolver::RecoverOriginalSolution(const VectorView& HybridSol,
+                                           BlockVector& RecoveredSol,
+                                           SolverWorkspace& work) const
+{
+    assert(dynamic_cast<Workspace*>(&work));
+
+    auto& hb_work = static_cast<Workspace&>(work);
+
+    RecoverOriginalSolution(HybridSol, RecoveredSol, hb_work.elem_sol, hb_work.work);
+}
+
+void HybridSolver::RecoverOriginalSolution(const VectorView& HybridSol,
+                                           BlockVector& RecoveredSol,
+                                           const ElemSolution& elem_sol,
+                                           std::vector<double>& work_space) const
+{
+    // Recover the solution of the original system from multiplier mu, i.e.,
+    // [u;p] = [f;g] - [M B^T;B 0]^-1[C 0]^T * mu
+    // This procedure is done locally in each element
+
+    RecoveredSol = 0.;
+
+    ResizeWork(work_space);
+
+    const int num_colors = color_agg_.Rows();
+    const auto& color_indptr = color_agg_.GetIndptr();
+    const auto& color_indices = color_agg_.GetIndices();
+
+    // Shared edge dofs are written by one aggregate per color,
+    // in the same order regardless of the number of threads
+#if GAUSS_USE_OPENMP
+    #pragma omp parallel
+#endif
+    {
+        double* work = work_space.data() + ThreadId() * work_stride_;
+
+        for (int color = 0; color < num_colors; ++color)
         {
-            RecoveredSol.GetBlock(1)[local_vertexdof[i]] += u_loc[i];
+#if GAUSS_USE_OPENMP
+            #pragma omp for schedule(static)
+#endif
+            for (int i = color_indptr[color]; i < color_indptr[color + 1]; ++i)
+            {
+                const int agg = color_indices[i];
+
+                if (single_precision_)
+                {
+                    RecoverOriginalSolution(agg, elem_data_single_.data() + elem_offsets_[agg],
+                                            HybridSol, RecoveredSol, elem_sol, work);
+                }
+                else
+                {
+                    RecoverOriginalSolution(agg, elem_data_.data() + elem_offsets_[agg],
+                                            HybridSol, RecoveredSol, elem_sol, work);
+                }
+            }
         }
     }
 }
 
-void HybridSolver::UpdateAggScaling(const std::vector<double>& agg_weight)
+template <typename T>
+void HybridSolver::RecoverOriginalSolution(int agg, const T* elem, const VectorView& HybridSol,
+                                           BlockVector& RecoveredSol,
+                                           const ElemSolution& elem_sol, double* work) const
 {
-    assert(!use_w_);
-    assert(static_cast<int>(agg_weight.size()) == num_aggs_);
+    VectorView sigma = RecoveredSol.GetBlock(0);
+    VectorView u = RecoveredSol.GetBlock(1);
 
-    std::copy(std::begin(agg_weight), std::end(agg_weight), std::begin(agg_weights_));
+    const auto& vertex_indptr = agg_vertexdof_.GetIndptr();
+    const auto& edge_indptr = agg_edgedof_.GetIndptr();
+    const auto& multiplier_indptr = agg_multiplier_.GetIndptr();
 
-    CooMatrix hybrid_system(num_multiplier_dofs_);
+    // Extracting the size and global numbering of local dof
+    const int* local_edgedof = agg_edgedof_.GetIndices().data() + edge_indptr[agg];
+    const int* local_vertexdof = agg_vertexdof_.GetIndices().data() + vertex_indptr[agg];
+    const int* local_multiplier = agg_multiplier_.GetIndices().data() + multiplier_indptr[agg];
 
-    for (int i = 0; i < num_aggs_; ++i)
+    const int nlocal_edgedof = edge_indptr[agg + 1] - edge_indptr[agg];
+    const int nlocal_vertexdof = vertex_indptr[agg + 1] - vertex_indptr[agg];
+    const int nlocal_multiplier = multiplier_indptr[agg + 1] - multiplier_indptr[agg];
+
+    const T* MinvDT = elem + nlocal_edgedof * nlocal_edgedof;
+    const T* MinvCT = MinvDT + nlocal_edgedof * nlocal_vertexdof;
+    const T* AinvDMinvCT = MinvCT + nlocal_edgedof * nlocal_multiplier;
+
+    const double* Ainv_f = elem_sol.Ainv_f.data() + vertex_indptr[agg];
+    const double* AinvDMinv_g = elem_sol.AinvDMinv_g.data() + vertex_indptr[agg];
+    const double* Minv_g = elem_sol.Minv_g.data() + edge_indptr[agg];
+
+    double* sigma_loc = work;
+    double* u_loc = sigma_loc + max_edgedof_;
+    double* mu_loc = u_loc + 2 * max_vertexdof_;
+
+    // Extract the local portion of the Lagrange multiplier solution
+    for (int i = 0; i < nlocal_multiplier; ++i)
     {
-        std::vector<int> local_multipliers = agg_multiplier_.GetIndices(i);
+        mu_loc[i] = HybridSol[local_multiplier[i]];
+    }
+
+    // Compute u = (DMinvDT)^-1(f-DMinvC^T mu)
+    for (int i = 0; i < nlocal_vertexdof; ++i)
+    {
+        u_loc[i] = Ainv_f[i] - AinvDMinv_g[i];
+    }
+
+    PackedMultAdd(nlocal_vertexdof, nlocal_multiplier, -1.0, AinvDMinvCT, mu_loc, u_loc);
+
+    // Compute -sigma = Minv(DT u + DT mu)
+    std::copy_n(Minv_g, nlocal_edgedof, sigma_loc);
+
+    PackedMultAdd(nlocal_edgedof, nlocal_vertexdof, 1.0, MinvDT, u_loc, sigma_loc);
+    PackedMultAdd(nlocal_edgedof, nlocal_multiplier, 1.0, MinvCT, mu_loc, sigma_loc);
+
+    // Save local solution to the global solution vector
+    const double weight = agg_weights_[agg];
 
-        hybrid_system.Add(local_multipliers, agg_weight[i], hybrid_elem_[i]);
+    for (int i = 0; i < nlocal_edgedof; ++i)
+    {
+        sigma[local_edgedof[i]] = -weight * sigma_loc[i];
     }
 
-    InitSolver(hybrid_system.ToSparse());
+    for (int i = 0; i < nlocal_vertexdof; ++i)
+    {
+        u[local_vertexdof[i]] += u_loc[i];
+    }
 }
 
-void HybridSolver::SetPrintLevel(int print_level)
+long long HybridSolver::ElemBytes() const
 {
-    MGLSolver::SetPrintLevel(print_level);
+    long long bytes = sizeof(double) * static_cast<long long>(elem_data_.size()) +
+                      sizeof(float) * static_cast<long long>(elem_data_single_.size()) +
+                      sizeof(float) * static_cast<long long>(hybrid_data_single_.size()) +
+                      sizeof(double) * static_cast<long long>(M_data_.size());
 
-    if (myid_ == 0)
+    for (const auto& hybrid_elem : hybrid_elem_)
     {
-        cg_.SetVerbose(print_level_);
+        bytes += sizeof(double) * static_cast<long long>(hybrid_elem.Rows()) * hybrid_elem.Cols();
     }
+
+    return bytes;
 }
 
-void HybridSolver::SetMaxIter(int max_num_iter)
+void HybridSolver::ResizeWork(std::vector<double>& work) const
 {
-    MGLSolver::SetMaxIter(max_num_iter);
+    const int work_size = NumThreads() * work_stride_;
 
-    cg_.SetMaxIter(max_num_iter_);
+    if (static_cast<int>(work.size()) < work_size)
+    {
+        work.resize(work_size);
+    }
 }
 
-void HybridSolver::SetRelTol(double rtol)
+void HybridSolver::ColorAggregates()
 {
-    MGLSolver::SetRelTol(rtol);
+    if (num_aggs_ == 0)
+    {
+        return;
+    }
+
+    // Aggregates that share an edge dof also share any multiplier on it
+    SparseMatrix edgedof_agg = agg_edgedof_.Transpose();
+    SparseMatrix agg_agg = agg_edgedof_.Mult(edgedof_agg);
 
-    cg_.SetRelTol(rtol_);
+    color_agg_ = MakeAggVertex(GetElementColoring(agg_agg));
 }
 
-void HybridSolver::SetAbsTol(double atol)
+void HybridSolver::UpdateAggScaling(const std::vector<double>& agg_weight, bool rebuild_prec)
 {
-    MGLSolver::SetAbsTol(atol);
+    assert(!use_w_);
+    assert(static_cast<int>(agg_weight.size()) == num_aggs_);
+
+    std::copy(std::begin(agg_weight), std::end(agg_weight), std::begin(agg_weights_));
 
-    cg_.SetAbsTol(atol_);
+    InitSolver(AssembleElements(agg_weights_), rebuild_prec);
 }
 
 } // namespace gauss
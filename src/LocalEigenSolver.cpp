@@ -19,12 +19,17 @@
    @brief Implements LocalEigensolver object
 */
 
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+#include <random>
+
 #include "LocalEigenSolver.hpp"
+#include "sparsesolve.hpp"
 
 #if GAUSS_USE_ARPACK
 // arpackpp include
 #define ARPACK_SILENT_MODE
-#include "sparsesolve.hpp"
 #include "arssym.h"
 #include "argsym.h"
 #endif
@@ -62,11 +67,14 @@ namespace gauss
 {
 
 LocalEigenSolver::LocalEigenSolver(
-    int max_num_evects, double rel_tol, int size_offset)
+    int max_num_evects, double rel_tol, int size_offset, int iterative_size)
     :
     max_num_evects_(max_num_evects),
     rel_tol_(rel_tol),
     size_offset_(size_offset),
+    iterative_size_(iterative_size),
+    num_not_converged_(0),
+    num_warm_started_(0),
     eig_max_ptr_(&eig_max_),
     uplo_('U'),
     side_('L'),
@@ -77,6 +85,9 @@ LocalEigenSolver::LocalEigenSolver(
     lwork_(-1),
     itype_(1),
     diag_('N'),
+    batch_width_(8),
+    batch_max_size_(14),
+    max_sweeps_(30),
     num_arnoldi_vectors_(-1),
     tolerance_(1e-10),
     max_iterations_(1000),
@@ -245,8 +256,7 @@ void LocalEigenSolver::Compute(
     dtrtrs_(&uplo_, &trans_, &diag_, &n, &m, b, &n, evects.GetData(), &n, &info_);
 }
 
-void LocalEigenSolver::DenseBlockCompute(const SparseMatrix& M, const SparseMatrix& D,
-                                         std::vector<double>& evals, DenseMatrix& evects)
+void LocalEigenSolver::FormDMinvDT(const SparseMatrix& M, const SparseMatrix& D)
 {
     if (IsDiag(M))
     {
@@ -269,10 +279,745 @@ void LocalEigenSolver::DenseBlockCompute(const SparseMatrix& M, const SparseMatr
 
         DMinv_.Mult(DT_, DMinvDT_);
     }
+}
+
+/**
+   Flip the sign of each eigenvector so its largest entry is positive,
+   so all BlockCompute paths return the same eigenvectors.
+*/
+void NormalizeSigns(DenseMatrix& evects)
+{
+    for (int j = 0; j < evects.Cols(); ++j)
+    {
+        double max_entry = 0.0;
+
+        for (int i = 0; i < evects.Rows(); ++i)
+        {
+            if (std::fabs(evects(i, j)) > std::fabs(max_entry))
+            {
+                max_entry = evects(i, j);
+            }
+        }
+
+        if (max_entry < 0.0)
+        {
+            for (int i = 0; i < evects.Rows(); ++i)
+            {
+                evects(i, j) *= -1.0;
+            }
+        }
+    }
+}
+
+void LocalEigenSolver::DenseBlockCompute(const SparseMatrix& M, const SparseMatrix& D,
+                                         std::vector<double>& evals, DenseMatrix& evects)
+{
+    FormDMinvDT(M, D);
 
     Compute(DMinvDT_, evals, evects);
+
+    NormalizeSigns(evects);
+}
+
+/**
+   Cyclic Jacobi on a batch of symmetric n x n matrices.
+
+   Entry (i, j) of batch member l is stored at a[(i * n + j) * lanes + l],
+   so every inner loop runs over the batch and vectorizes. On return the
+   diagonals hold the eigenvalues and v holds the eigenvectors by column.
+
+   @returns number of batch members not converged after max_sweeps
+*/
+int BatchedJacobi(int n, int lanes, int max_sweeps, double* a, double* v,
+                  double* c, double* s)
+{
+    const double tol = 1e-30;
+
+    auto entry = [n, lanes](double * mat, int i, int j)
+    {
+        return mat + (i * n + j) * lanes;
+    };
+
+    auto lane_converged = [&](int l)
+    {
+        double off = 0.0;
+        double total = 0.0;
+
+        for (int i = 0; i < n; ++i)
+        {
+            total += entry(a, i, i)[l] * entry(a, i, i)[l];
+
+            for (int j = i + 1; j < n; ++j)
+            {
+                off += entry(a, i, j)[l] * entry(a, i, j)[l];
+            }
+        }
+
+        return off <= tol * (total + 2.0 * off);
+    };
+
+    for (int sweep = 0; sweep < max_sweeps; ++sweep)
+    {
+        bool converged = true;
+
+        for (int l = 0; l < lanes && converged; ++l)
+        {
+            converged = lane_converged(l);
+        }
+
+        if (converged)
+        {
+            return 0;
+        }
+
+        for (int p = 0; p < n - 1; ++p)
+        {
+            for (int q = p + 1; q < n; ++q)
+            {
+                const double* a_pp = entry(a, p, p);
+                const double* a_qq = entry(a, q, q);
+                const double* a_pq = entry(a, p, q);
+
+                // Rotation that annihilates a_pq, tan = t
+                for (int l = 0; l < lanes; ++l)
+                {
+                    double y = a_qq[l] - a_pp[l];
+                    double denom = std::fabs(y) + std::sqrt(y * y + 4.0 * a_pq[l] * a_pq[l]);
+                    double t = denom > 0.0 ? std::copysign(2.0, y) * a_pq[l] / denom : 0.0;
+
+                    c[l] = 1.0 / std::sqrt(t * t + 1.0);
+                    s[l] = t * c[l];
+                }
+
+                // A = A J
+                for (int k = 0; k < n; ++k)
+                {
+                    double* a_kp = entry(a, k, p);
+                    double* a_kq = entry(a, k, q);
+
+                    for (int l = 0; l < lanes; ++l)
+                    {
+                        double kp = a_kp[l];
+                        double kq = a_kq[l];
+
+                        a_kp[l] = c[l] * kp - s[l] * kq;
+                        a_kq[l] = s[l] * kp + c[l] * kq;
+                    }
+                }
+
+                // A = J^T A
+                for (int k = 0; k < n; ++k)
+                {
+                    double* a_pk = entry(a, p, k);
+                    double* a_qk = entry(a, q, k);
+
+                    for (int l = 0; l < lanes; ++l)
+                    {
+                        double pk = a_pk[l];
+                        double qk = a_qk[l];
+
+                        a_pk[l] = c[l] * pk - s[l] * qk;
+                        a_qk[l] = s[l] * pk + c[l] * qk;
+                    }
+                }
+
+                // V = V J
+                for (int k = 0; k < n; ++k)
+                {
+                    double* v_kp = entry(v, k, p);
+                    double* v_kq = entry(v, k, q);
+
+                    for (int l = 0; l < lanes; ++l)
+                    {
+                        double kp = v_kp[l];
+                        double kq = v_kq[l];
+
+                        v_kp[l] = c[l] * kp - s[l] * kq;
+                        v_kq[l] = s[l] * kp + c[l] * kq;
+                    }
+                }
+
+                std::fill_n(entry(a, p, q), lanes, 0.0);
+                std::fill_n(entry(a, q, p), lanes, 0.0);
+            }
+        }
+    }
+
+    int num_not_converged = 0;
+
+    for (int l = 0; l < lanes; ++l)
+    {
+        num_not_converged += !lane_converged(l);
+    }
+
+    return num_not_converged;
 }
 
+void LocalEigenSolver::BatchedDenseCompute(int n, const std::vector<int>& ids,
+                                           const std::vector<SparseMatrix>& M,
+                                           const std::vector<SparseMatrix>& D,
+                                           std::vector<DenseMatrix>& evects)
+{
+    const int lanes = ids.size();
+    const int max_num_evects = max_num_evects_ == -1 ? n : std::min(n, max_num_evects_);
+
+    A_batch_.resize(n * n * lanes);
+    V_batch_.assign(n * n * lanes, 0.0);
+    rot_c_.resize(lanes);
+    rot_s_.resize(lanes);
+    order_.resize(n);
+    evals_.resize(n);
+
+    for (int l = 0; l < lanes; ++l)
+    {
+        FormDMinvDT(M[ids[l]], D[ids[l]]);
+
+        for (int i = 0; i < n; ++i)
+        {
+            for (int j = 0; j < n; ++j)
+            {
+                A_batch_[(i * n + j) * lanes + l] = DMinvDT_(i, j);
+            }
+
+            V_batch_[(i * n + i) * lanes + l] = 1.0;
+        }
+    }
+
+    num_not_converged_ += BatchedJacobi(n, lanes, max_sweeps_, A_batch_.data(),
+                                        V_batch_.data(), rot_c_.data(), rot_s_.data());
+
+    for (int l = 0; l < lanes; ++l)
+    {
+        std::iota(std::begin(order_), std::end(order_), 0);
+        std::sort(std::begin(order_), std::end(order_), [&](int i, int j)
+        {
+            return A_batch_[(i * n + i) * lanes + l] < A_batch_[(j * n + j) * lanes + l];
+        });
+
+        for (int i = 0; i < n; ++i)
+        {
+            evals_[i] = A_batch_[(order_[i] * n + order_[i]) * lanes + l];
+        }
+
+        int m = FindNumberOfEigenPairs(evals_, max_num_evects, evals_[n - 1]);
+
+        DenseMatrix& evects_l = evects[ids[l]];
+        evects_l.SetSize(n, m);
+
+        for (int k = 0; k < m; ++k)
+        {
+            for (int i = 0; i < n; ++i)
+            {
+                evects_l(i, k) = V_batch_[(i * n + order_[k]) * lanes + l];
+            }
+        }
+
+        NormalizeSigns(evects_l);
+    }
+}
+
+void LocalEigenSolver::BlockCompute(const std::vector<SparseMatrix>& M,
+                                    const std::vector<SparseMatrix>& D,
+                                    std::vector<DenseMatrix>& evects,
+                                    const std::vector<DenseMatrix>& initial_evects)
+{
+    assert(M.size() == D.size());
+    assert(initial_evects.empty() || initial_evects.size() == D.size());
+
+    int num_problems = D.size();
+    evects.resize(num_problems);
+
+#if GAUSS_USE_ARPACK
+    const int batch_max_size = std::min(batch_max_size_, size_offset_);
+#else
+    const int batch_max_size = std::min(batch_max_size_, iterative_size_);
+#endif
+
+    std::map<int, std::vector<int>> size_buckets;
+
+    for (int i = 0; i < num_problems; ++i)
+    {
+        int n = D[i].Rows();
+
+        if (n < 2)
+        {
+            DenseBlockCompute(M[i], D[i], evals_, evects[i]);
+            continue;
+        }
+
+        const bool warm_start = !initial_evects.empty() &&
+                                initial_evects[i].Rows() == n &&
+                                initial_evects[i].Cols() > 0;
+
+        if (n > batch_max_size || warm_start)
+        {
+            if (initial_evects.empty())
+            {
+                BlockCompute(M[i], D[i], evects[i]);
+            }
+            else
+            {
+                BlockCompute(M[i], D[i], evects[i], initial_evects[i]);
+            }
+
+            continue;
+        }
+
+        size_buckets[n].push_back(i);
+    }
+
+    std::vector<int> ids;
+
+    for (const auto& bucket : size_buckets)
+    {
+        int n = bucket.first;
+        const std::vector<int>& bucket_ids = bucket.second;
+        int bucket_size = bucket_ids.size();
+
+        for (int start = 0; start < bucket_size; start += batch_width_)
+        {
+            int end = std::min(start + batch_width_, bucket_size);
+            ids.assign(std::begin(bucket_ids) + start, std::begin(bucket_ids) + end);
+
+            BatchedDenseCompute(n, ids, M, D, evects);
+        }
+    }
+}
+
+
+/// Evaluate y = D M^{-1} D^T x without forming the product
+class DMinvDTOperator
+{
+public:
+    DMinvDTOperator(const SparseMatrix& M, const SparseMatrix& D)
+        :
+        D_(D),
+        DT_x_(D.Cols()),
+        Minv_DT_x_(D.Cols())
+    {
+        if (IsDiag(M))
+        {
+            Minv_diag_.resize(M.Rows());
+
+            for (int i = 0; i < M.Rows(); ++i)
+            {
+                Minv_diag_[i] = 1.0 / M.GetData()[i];
+            }
+        }
+        else
+        {
+            Minv_ = make_unique<SparseSolver>(M);
+        }
+    }
+
+    void Mult(const double* in, double* out)
+    {
+        VectorView v_in(const_cast<double*>(in), D_.Rows());
+        VectorView v_out(out, D_.Rows());
+
+        D_.MultAT(v_in, DT_x_);
+
+        if (Minv_)
+        {
+            Minv_->Mult(DT_x_, Minv_DT_x_);
+        }
+        else
+        {
+            for (int i = 0; i < DT_x_.size(); ++i)
+            {
+                Minv_DT_x_[i] = DT_x_[i] * Minv_diag_[i];
+            }
+        }
+
+        D_.Mult(Minv_DT_x_, v_out);
+    }
+
+    /// Inverse of diag(D diag(M)^{-1} D^T), used as preconditioner
+    std::vector<double> InverseDiagonal(const SparseMatrix& M) const
+    {
+        std::vector<double> M_diag(M.Rows(), 1.0);
+
+        const auto& M_indptr = M.GetIndptr();
+        const auto& M_indices = M.GetIndices();
+        const auto& M_data = M.GetData();
+
+        for (int i = 0; i < M.Rows(); ++i)
+        {
+            for (int j = M_indptr[i]; j < M_indptr[i + 1]; ++j)
+            {
+                if (M_indices[j] == i)
+                {
+                    M_diag[i] = M_data[j];
+                }
+            }
+        }
+
+        const auto& indptr = D_.GetIndptr();
+        const auto& indices = D_.GetIndices();
+        const auto& data = D_.GetData();
+
+        std::vector<double> inv_diag(D_.Rows(), 1.0);
+
+        for (int i = 0; i < D_.Rows(); ++i)
+        {
+            double sum = 0.0;
+
+            for (int j = indptr[i]; j < indptr[i + 1]; ++j)
+            {
+                sum += data[j] * data[j] / M_diag[indices[j]];
+            }
+
+            if (sum > 0.0)
+            {
+                inv_diag[i] = 1.0 / sum;
+            }
+        }
+
+        return inv_diag;
+    }
+
+private:
+    const SparseMatrix& D_;
+
+    std::vector<double> Minv_diag_;
+    std::unique_ptr<SparseSolver> Minv_;
+
+    Vector DT_x_;
+    Vector Minv_DT_x_;
+};
+
+/**
+   Orthonormalize the num_cols columns of the n x num_cols column major S
+   by twice applied modified Gram-Schmidt. Columns that are numerically
+   dependent on earlier ones are dropped and the rest are compacted.
+
+   @returns number of columns kept
+*/
+int Orthonormalize(int n, int num_cols, double* S)
+{
+    int kept = 0;
+
+    for (int j = 0; j < num_cols; ++j)
+    {
+        double* col = S + j * n;
+        double orig_norm = std::sqrt(std::inner_product(col, col + n, col, 0.0));
+
+        for (int pass = 0; pass < 2; ++pass)
+        {
+            for (int i = 0; i < kept; ++i)
+            {
+                const double* q = S + i * n;
+                double alpha = std::inner_product(q, q + n, col, 0.0);
+
+                for (int r = 0; r < n; ++r)
+                {
+                    col[r] -= alpha * q[r];
+                }
+            }
+        }
+
+        double norm = std::sqrt(std::inner_product(col, col + n, col, 0.0));
+
+        if (norm <= 1e-10 * orig_norm || norm == 0.0)
+        {
+            continue;
+        }
+
+        double* dest = S + kept * n;
+
+        for (int r = 0; r < n; ++r)
+        {
+            dest[r] = col[r] / norm;
+        }
+
+        ++kept;
+    }
+
+    return kept;
+}
+
+/**
+   Locally optimal block preconditioned conjugate gradient for the
+   k smallest eigenpairs of the symmetric positive semidefinite A.
+
+   Each iteration orthonormalizes the search space [X W P] and does a
+   Rayleigh-Ritz step with the batched Jacobi kernel. If fewer than k
+   independent columns remain, the missing ones are replaced by random
+   directions and the search space restarts from the block.
+
+   @param A operator providing Mult(const double*, double*)
+   @param inv_diag diagonal preconditioner
+   @param n problem size
+   @param k block size, requires 3k <= n
+   @param tol absolute residual tolerance
+   @param max_iter maximum number of iterations
+   @param max_sweeps maximum number of Jacobi sweeps
+   @param X (in/out) initial guess, up to n x k column major,
+            on return the n x k eigenvectors
+   @param theta (out) k eigenvalues, ascending
+   @returns number of iterations, or -1 if not converged
+*/
+template <typename Operator>
+int LOBPCG(Operator& A, const std::vector<double>& inv_diag, int n, int k,
+           double tol, int max_iter, int max_sweeps,
+           std::vector<double>& X, std::vector<double>& theta)
+{
+    assert(3 * k <= n);
+
+    const int max_cols = 3 * k;
+
+    std::vector<double> S(n * max_cols);
+    std::vector<double> AS(n * max_cols);
+    std::vector<double> S_next(n * max_cols);
+    std::vector<double> G(max_cols * max_cols);
+    std::vector<double> C(max_cols * max_cols);
+    std::vector<double> rot_c(1);
+    std::vector<double> rot_s(1);
+    std::vector<int> order(max_cols);
+
+    int num_guess = std::min<int>(X.size(), n * k);
+
+    std::copy_n(std::begin(X), num_guess, std::begin(S));
+
+    X.resize(n * k);
+    theta.resize(k);
+
+    std::mt19937 gen(n);
+    std::uniform_real_distribution<double> dist(-1.0, 1.0);
+
+    for (int i = num_guess; i < n * k; ++i)
+    {
+        S[i] = dist(gen);
+    }
+
+    int num_cols = k;
+    int num_p = 0;
+
+    for (int iter = 0; iter < max_iter; ++iter)
+    {
+        num_cols = Orthonormalize(n, num_cols, S.data());
+
+        // If the block itself lost columns, restart with random directions
+        for (int restart = 0; num_cols < k && restart < 3; ++restart)
+        {
+            for (int i = num_cols * n; i < k * n; ++i)
+            {
+                S[i] = dist(gen);
+            }
+
+            num_cols = Orthonormalize(n, k, S.data());
+        }
+
+        if (num_cols < k)
+        {
+            return -1;
+        }
+
+        for (int j = 0; j < num_cols; ++j)
+        {
+            A.Mult(S.data() + j * n, AS.data() + j * n);
+        }
+
+        // Rayleigh-Ritz on the search space
+        for (int i = 0; i < num_cols; ++i)
+        {
+            for (int j = i; j < num_cols; ++j)
+            {
+                const double* s_i = S.data() + i * n;
+                const double* as_j = AS.data() + j * n;
+                const double* s_j = S.data() + j * n;
+                const double* as_i = AS.data() + i * n;
+
+                double g_ij = 0.5 * (std::inner_product(s_i, s_i + n, as_j, 0.0) +
+                                     std::inner_product(s_j, s_j + n, as_i, 0.0));
+
+                G[i * num_cols + j] = g_ij;
+                G[j * num_cols + i] = g_ij;
+            }
+        }
+
+        std::fill_n(std::begin(C), num_cols * num_cols, 0.0);
+
+        for (int i = 0; i < num_cols; ++i)
+        {
+            C[i * num_cols + i] = 1.0;
+        }
+
+        BatchedJacobi(num_cols, 1, max_sweeps, G.data(), C.data(),
+                      rot_c.data(), rot_s.data());
+
+        std::iota(std::begin(order), std::begin(order) + num_cols, 0);
+        std::sort(std::begin(order), std::begin(order) + num_cols, [&](int i, int j)
+        {
+            return G[i * num_cols + i] < G[j * num_cols + j];
+        });
+
+        // X = S C_k, P = S[:, k:] C[k:, :k], and the residuals R = A X - X theta
+        std::fill(std::begin(S_next), std::end(S_next), 0.0);
+
+        double max_residual = 0.0;
+
+        for (int c = 0; c < k; ++c)
+        {
+            int ritz = order[c];
+            theta[c] = G[ritz * num_cols + ritz];
+
+            double* x = X.data() + c * n;
+            double* w = S_next.data() + (k + c) * n;
+            double* p = S_next.data() + (2 * k + c) * n;
+
+            std::fill_n(x, n, 0.0);
+
+            for (int j = 0; j < num_cols; ++j)
+            {
+                double coef = C[j * num_cols + ritz];
+                const double* s_j = S.data() + j * n;
+                const double* as_j = AS.data() + j * n;
+
+                for (int r = 0; r < n; ++r)
+                {
+                    x[r] += coef * s_j[r];
+                    w[r] += coef * as_j[r];
+                }
+
+                if (j >= k)
+                {
+                    for (int r = 0; r < n; ++r)
+                    {
+                        p[r] += coef * s_j[r];
+                    }
+                }
+            }
+
+            double residual = 0.0;
+
+            for (int r = 0; r < n; ++r)
+            {
+                w[r] -= theta[c] * x[r];
+                residual += w[r] * w[r];
+                w[r] *= inv_diag[r];
+            }
+
+            max_residual = std::max(max_residual, std::sqrt(residual));
+        }
+
+        if (max_residual <= tol)
+        {
+            return iter;
+        }
+
+        std::copy(std::begin(X), std::end(X), std::begin(S_next));
+
+        num_p = (iter > 0 || num_cols > k) ? k : 0;
+        num_cols = 2 * k + num_p;
+
+        std::swap(S, S_next);
+    }
+
+    return -1;
+}
+
+/// Estimate the largest eigenvalue of A by power iteration
+template <typename Operator>
+double EstimateMaxEigenvalue(Operator& A, int n, int num_iter = 20)
+{
+    std::vector<double> x(n);
+    std::vector<double> Ax(n);
+
+    std::mt19937 gen(n + 1);
+    std::uniform_real_distribution<double> dist(-1.0, 1.0);
+
+    for (auto& x_i : x)
+    {
+        x_i = dist(gen);
+    }
+
+    double eig = 0.0;
+
+    for (int iter = 0; iter < num_iter; ++iter)
+    {
+        double norm = std::sqrt(std::inner_product(std::begin(x), std::end(x),
+                                                   std::begin(x), 0.0));
+
+        if (norm == 0.0)
+        {
+            break;
+        }
+
+        for (auto& x_i : x)
+        {
+            x_i /= norm;
+        }
+
+        A.Mult(x.data(), Ax.data());
+
+        eig = std::inner_product(std::begin(x), std::end(x), std::begin(Ax), 0.0);
+
+        std::swap(x, Ax);
+    }
+
+    return eig;
+}
+
+void LocalEigenSolver::IterativeBlockCompute(const SparseMatrix& M, const SparseMatrix& D,
+                                             std::vector<double>& evals, DenseMatrix& evects,
+                                             const DenseMatrix& initial_evects)
+{
+    int n = D.Rows();
+    int max_num_evects = (max_num_evects_ == -1) ? n : std::min(n, max_num_evects_);
+
+    if (3 * max_num_evects > n)
+    {
+        DenseBlockCompute(M, D, evals, evects);
+        return;
+    }
+
+    DMinvDTOperator A(M, D);
+    std::vector<double> inv_diag = A.InverseDiagonal(M);
+
+    eig_max_ = EstimateMaxEigenvalue(A, n);
+
+    std::vector<double> X;
+
+    if (initial_evects.Rows() == n)
+    {
+        ++num_warm_started_;
+
+        int num_guess = std::min(initial_evects.Cols(), max_num_evects);
+        X.resize(n * num_guess);
+
+        for (int j = 0; j < num_guess; ++j)
+        {
+            for (int i = 0; i < n; ++i)
+            {
+                X[j * n + i] = initial_evects(i, j);
+            }
+        }
+    }
+
+    int num_iter = LOBPCG(A, inv_diag, n, max_num_evects, tolerance_ * eig_max_,
+                          max_iterations_, max_sweeps_, X, evals);
+
+    if (num_iter < 0)
+    {
+        ++num_not_converged_;
+    }
+
+    int num_evects = FindNumberOfEigenPairs(evals, max_num_evects, eig_max_);
+
+    evals.resize(num_evects);
+    evects.SetSize(n, num_evects);
+
+    for (int j = 0; j < num_evects; ++j)
+    {
+        for (int i = 0; i < n; ++i)
+        {
+            evects(i, j) = X[j * n + i];
+        }
+    }
+
+    NormalizeSigns(evects);
+}
 
 #if GAUSS_USE_ARPACK
 /// Adapter for applying the action of a certain operator in ARPACK
@@ -500,16 +1245,6 @@ int ComputeNCV(int size, int num_evects, int num_arnoldi_vectors)
     return std::min(size, ncv);
 }
 
-void CheckNotConverged(int num_evects, int num_converged)
-{
-    int num_not_converged = num_evects - num_converged;
-    if (num_not_converged)
-    {
-        std::cout << "Sparse eigen solver warning: " << num_not_converged
-                  << " eigenvectors did not converge!\n";
-    }
-}
-
 template<>
 void LocalEigenSolver::Compute(
     SparseMatrix& A, std::vector<double>& evals, DenseMatrix& evects)
@@ -527,7 +1262,10 @@ void LocalEigenSolver::Compute(
             shift_, "LM", ncv, tolerance_, max_iterations_);
     auto data_ptr = EigenPairsSetSizeAndData(n, max_num_evects, evals, evects);
     int num_converged = eigprob.EigenValVectors(data_ptr[0], data_ptr[1]);
-    CheckNotConverged(max_num_evects, num_converged);
+    if (num_converged < max_num_evects)
+    {
+        ++num_not_converged_;
+    }
 
     if (rel_tol_ < 1.0)
     {
@@ -569,16 +1307,14 @@ void LocalEigenSolver::SparseBlockCompute(SparseMatrix M, SparseMatrix D,
     auto data_ptr = EigenPairsSetSizeAndData(n, max_num_evects, evals, evects);
     int num_converged = eigprob.EigenValVectors(data_ptr[0], data_ptr[1]);
 
-    CheckNotConverged(max_num_evects, num_converged);
+    if (num_converged < max_num_evects)
+    {
+        ++num_not_converged_;
+    }
 
     //evects.Print("EVECTS:");
 
     assert(evects.Rows() > 0 && evects.Cols() > 0);
-    if (evects(0, 0) < 0 && std::fabs(evects(0, 0)) > 1e-8 )
-    {
-        auto vect = evects.GetColView(0);
-        vect *= -1.0;
-    }
 
     if (rel_tol_ < 1.0 && max_num_evects > 1)
     {
@@ -616,7 +1352,10 @@ void LocalEigenSolver::Compute(
 
     auto data_ptr = EigenPairsSetSizeAndData(n, max_num_evects, evals, evects);
     int num_converged = eigprob.EigenValVectors(data_ptr[0], data_ptr[1]);
-    CheckNotConverged(max_num_evects, num_converged);
+    if (num_converged < max_num_evects)
+    {
+        ++num_not_converged_;
+    }
 
     if (rel_tol_ < 1.0)
     {
@@ -652,18 +1391,35 @@ double LocalEigenSolver::Compute(SparseMatrix& A, DenseMatrix& evects)
     return evals_[0];
 }
 
-double LocalEigenSolver::BlockCompute(SparseMatrix M, SparseMatrix D, DenseMatrix& evects)
+double LocalEigenSolver::BlockCompute(SparseMatrix M, SparseMatrix D, DenseMatrix& evects,
+                                      const DenseMatrix& initial_evects)
 {
+    // Eigenvectors of a similar problem make the iterative solver cheap
+    if (initial_evects.Rows() == D.Rows() && initial_evects.Cols() > 0)
+    {
+        IterativeBlockCompute(M, D, evals_, evects, initial_evects);
+
+        return evals_[0];
+    }
+
 #if GAUSS_USE_ARPACK
     if (D.Rows() > size_offset_)
     {
         SparseBlockCompute(std::move(M), std::move(D), evals_, evects);
+        NormalizeSigns(evects);
+
+        return evals_[0];
     }
-    else
-#endif
+#else
+    if (D.Rows() > iterative_size_)
     {
-        DenseBlockCompute(M, D, evals_, evects);
+        IterativeBlockCompute(M, D, evals_, evects, initial_evects);
+
+        return evals_[0];
     }
+#endif
+
+    DenseBlockCompute(M, D, evals_, evects);
 
     return evals_[0];
 }
@@ -27,8 +27,8 @@ MGLSolver::MGLSolver(const MixedMatrix& mgl)
     : comm_(mgl.GlobalD().GetComm()),
       myid_(mgl.GlobalD().GetMyId()),
       use_w_(mgl.CheckW()),
-      rhs_(mgl.Offsets()), sol_(mgl.Offsets()),
-      nnz_(0), num_iterations_(0), timing_(0)
+      offsets_(mgl.Offsets()),
+      nnz_(0), num_iterations_(0), timing_(0.0)
 {
 
 }
@@ -36,12 +36,14 @@ MGLSolver::MGLSolver(const MixedMatrix& mgl)
 MGLSolver::MGLSolver(const MGLSolver& other) noexcept
     : Operator(other),  comm_(other.comm_),
       myid_(other.myid_), use_w_(other.use_w_),
-      rhs_(other.rhs_), sol_(other.sol_),
+      offsets_(other.offsets_),
+      constant_rep_(other.constant_rep_),
       print_level_(other.print_level_),
       max_num_iter_(other.max_num_iter_),
       rtol_(other.rtol_), atol_(other.atol_),
-      nnz_(other.nnz_), num_iterations_(other.num_iterations_),
-      timing_(other.timing_)
+      pipelined_cg_(other.pipelined_cg_),
+      nnz_(other.nnz_), num_iterations_(other.num_iterations_.load()),
+      timing_(other.timing_.load())
 {
 }
 
@@ -54,15 +56,100 @@ void swap(MGLSolver& lhs, MGLSolver& rhs) noexcept
     std::swap(lhs.myid_, rhs.myid_);
     std::swap(lhs.use_w_, rhs.use_w_);
 
-    std::swap(lhs.rhs_, rhs.rhs_);
-    std::swap(lhs.sol_, rhs.sol_);
+    std::swap(lhs.offsets_, rhs.offsets_);
+    std::swap(lhs.constant_rep_, rhs.constant_rep_);
     std::swap(lhs.print_level_, rhs.print_level_);
     std::swap(lhs.max_num_iter_, rhs.max_num_iter_);
     std::swap(lhs.rtol_, rhs.rtol_);
     std::swap(lhs.atol_, rhs.atol_);
+    std::swap(lhs.pipelined_cg_, rhs.pipelined_cg_);
     std::swap(lhs.nnz_, rhs.nnz_);
-    std::swap(lhs.num_iterations_, rhs.num_iterations_);
-    std::swap(lhs.timing_, rhs.timing_);
+
+    lhs.num_iterations_ = rhs.num_iterations_.exchange(lhs.num_iterations_);
+    lhs.timing_ = rhs.timing_.exchange(lhs.timing_);
+}
+
+int MGLSolver::PCG(const linalgcpp::Operator& A, const linalgcpp::Operator* M,
+                   const std::vector<Vector>& b, std::vector<Vector>& x) const
+{
+    if (pipelined_cg_)
+    {
+        return BatchedPipelinedPCG(comm_, A, M, b, x, max_num_iter_, rtol_, atol_);
+    }
+
+    return BatchedPCG(comm_, A, M, b, x, max_num_iter_, rtol_, atol_);
+}
+
+std::unique_ptr<SolverWorkspace> MGLSolver::MakeWorkspace() const
+{
+    return make_unique<SolverWorkspace>(offsets_);
+}
+
+void MGLSolver::Solve(const BlockVector& rhs, BlockVector& sol) const
+{
+    auto work = MakeWorkspace();
+
+    Solve(rhs, sol, *work);
+}
+
+void MGLSolver::Solve(const BlockVector& rhs, BlockVector& sol,
+                      const BlockVector& initial_guess, SolverWorkspace& work) const
+{
+    // Solvers that start from the given solution only need the guess copied in
+    if (&sol != &initial_guess)
+    {
+        sol = initial_guess;
+    }
+
+    PinInitialGuess(sol.GetBlock(1));
+
+    Solve(rhs, sol, work);
+}
+
+void MGLSolver::Solve(const BlockVector& rhs, BlockVector& sol,
+                      const BlockVector& initial_guess) const
+{
+    auto work = MakeWorkspace();
+
+    Solve(rhs, sol, initial_guess, *work);
+}
+
+void MGLSolver::SetConstantRep(const VectorView& constant_rep)
+{
+    assert(constant_rep.size() == offsets_[2] - offsets_[1]);
+
+    constant_rep_ = Vector(constant_rep);
+}
+
+void MGLSolver::PinInitialGuess(VectorView vertex_guess) const
+{
+    if (use_w_)
+    {
+        return;
+    }
+
+    const bool has_rep = constant_rep_.size() > 0;
+
+    double shift = 0.0;
+
+    if (myid_ == 0 && vertex_guess.size() > 0)
+    {
+        const double rep_0 = has_rep ? constant_rep_[0] : 1.0;
+
+        shift = rep_0 != 0.0 ? vertex_guess[0] / rep_0 : 0.0;
+    }
+
+    if (NumProcs(comm_) > 1)
+    {
+        MPI_Bcast(&shift, 1, MPI_DOUBLE, 0, comm_);
+    }
+
+    const int size = vertex_guess.size();
+
+    for (int i = 0; i < size; ++i)
+    {
+        vertex_guess[i] -= shift * (has_rep ? constant_rep_[i] : 1.0);
+    }
 }
 
 void MGLSolver::Mult(const BlockVector& rhs, BlockVector& sol) const
@@ -72,20 +159,52 @@ void MGLSolver::Mult(const BlockVector& rhs, BlockVector& sol) const
 
 BlockVector MGLSolver::Mult(const BlockVector& rhs) const
 {
-    sol_ = 0.0;
-    Solve(rhs, sol_);
+    BlockVector sol(offsets_);
+    sol = 0.0;
+
+    Solve(rhs, sol);
 
-    return sol_;
+    return sol;
+}
+
+void MGLSolver::Solve(const std::vector<BlockVector>& rhs,
+                      std::vector<BlockVector>& sol) const
+{
+    assert(rhs.size() == sol.size());
+
+    int num_rhs = rhs.size();
+    int max_iterations = 0;
+    double total_timing = 0.0;
+
+    auto work = MakeWorkspace();
+
+    for (int i = 0; i < num_rhs; ++i)
+    {
+        Solve(rhs[i], sol[i], *work);
+
+        max_iterations = std::max(max_iterations, work->num_iterations);
+        total_timing += work->timing;
+    }
+
+    num_iterations_ = max_iterations;
+    timing_ = total_timing;
 }
 
 void MGLSolver::Solve(const VectorView& rhs, VectorView sol) const
 {
-    rhs_.GetBlock(0) = 0.0;
-    rhs_.GetBlock(1) = rhs;
+    auto work = MakeWorkspace();
 
-    Solve(rhs_, sol_);
+    Solve(rhs, sol, *work);
+}
+
+void MGLSolver::Solve(const VectorView& rhs, VectorView sol, SolverWorkspace& work) const
+{
+    work.rhs.GetBlock(0) = 0.0;
+    work.rhs.GetBlock(1) = rhs;
 
-    sol = sol_.GetBlock(1);
+    Solve(work.rhs, work.sol, work);
+
+    sol = work.sol.GetBlock(1);
 }
 
 void MGLSolver::Mult(const VectorView& rhs, VectorView sol) const
@@ -95,10 +214,12 @@ void MGLSolver::Mult(const VectorView& rhs, VectorView sol) const
 
 Vector MGLSolver::Mult(const VectorView& rhs) const
 {
-    sol_.GetBlock(1) = 0.0;
-    Solve(rhs, sol_.GetBlock(1));
+    Vector sol(offsets_[2] - offsets_[1]);
+    sol = 0.0;
+
+    Solve(rhs, sol);
 
-    return Vector(sol_.GetBlock(1));
+    return sol;
 }
 
 } // namespace gauss
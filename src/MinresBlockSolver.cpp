@@ -33,7 +33,31 @@ MinresBlockSolver::MinresBlockSolver(const MixedMatrix& mgl, const std::vector<i
     : MGLSolver(mgl), M_(mgl.GlobalM()), /*D_(mgl.GlobalD()), DT_(D_.Transpose()),*/ W_(mgl.GlobalW()),
       edge_true_edge_(mgl.EdgeTrueEdge()),
       op_(mgl.TrueOffsets()), prec_(mgl.TrueOffsets()),
-      true_rhs_(mgl.TrueOffsets()), true_sol_(mgl.TrueOffsets())
+      true_offsets_(mgl.TrueOffsets()), elim_dofs_(elim_dofs)
+{
+    schur_prec_ = linalgcpp::BoomerAMG(AssembleOperator(mgl));
+
+    op_.SetBlock(0, 0, M_);
+    op_.SetBlock(0, 1, DT_);
+    op_.SetBlock(1, 0, D_);
+    op_.SetBlock(1, 1, W_);
+
+    prec_.SetBlock(0, 0, M_prec_);
+    prec_.SetBlock(1, 1, schur_prec_);
+}
+
+void MinresBlockSolver::UpdateOperator(const MixedMatrix& mgl, bool rebuild_prec)
+{
+    // The block operators refer to the members, which are replaced in place
+    ParMatrix schur_block = AssembleOperator(mgl);
+
+    if (rebuild_prec)
+    {
+        schur_prec_ = linalgcpp::BoomerAMG(std::move(schur_block));
+    }
+}
+
+ParMatrix MinresBlockSolver::AssembleOperator(const MixedMatrix& mgl)
 {
     SparseMatrix M_elim = mgl.LocalM();
     SparseMatrix D_elim = mgl.LocalD();
@@ -45,7 +69,7 @@ MinresBlockSolver::MinresBlockSolver(const MixedMatrix& mgl, const std::vector<i
 
     std::vector<int> marker(D_elim.Cols(), 0);
 
-    for (auto&& dof : elim_dofs)
+    for (auto&& dof : elim_dofs_)
     {
         marker[dof] = 1;
     }
@@ -78,37 +102,22 @@ MinresBlockSolver::MinresBlockSolver(const MixedMatrix& mgl, const std::vector<i
     }
     else
     {
+        W_ = mgl.GlobalW();
         schur_block = linalgcpp::ParSub(schur_block, W_);
     }
 
     M_prec_ = linalgcpp::ParDiagScale(M_);
-    schur_prec_ = linalgcpp::BoomerAMG(std::move(schur_block));
-
-    op_.SetBlock(0, 0, M_);
-    op_.SetBlock(0, 1, DT_);
-    op_.SetBlock(1, 0, D_);
-    op_.SetBlock(1, 1, W_);
-
-    prec_.SetBlock(0, 0, M_prec_);
-    prec_.SetBlock(1, 1, schur_prec_);
-
-    pminres_ = linalgcpp::PMINRESSolver(op_, prec_, max_num_iter_, rtol_,
-                                        atol_, 0, linalgcpp::ParMult);
-
-    if (myid_ == 0)
-    {
-        SetPrintLevel(print_level_);
-    }
 
     nnz_ = M_.nnz() + DT_.nnz() + D_.nnz() + W_.nnz();
+
+    return schur_block;
 }
 
 
 MinresBlockSolver::MinresBlockSolver(const MinresBlockSolver& other) noexcept
     : MGLSolver(other), op_(other.op_), prec_(other.prec_),
       M_prec_(other.M_prec_), schur_prec_(other.schur_prec_),
-      pminres_(other.pminres_),
-      true_rhs_(other.true_rhs_), true_sol_(other.true_sol_)
+      true_offsets_(other.true_offsets_), elim_dofs_(other.elim_dofs_)
 {
 
 }
@@ -134,65 +143,133 @@ void swap(MinresBlockSolver& lhs, MinresBlockSolver& rhs) noexcept
     swap(lhs.prec_, rhs.prec_);
     swap(lhs.M_prec_, rhs.M_prec_);
     swap(lhs.schur_prec_, rhs.schur_prec_);
-    swap(lhs.pminres_, rhs.pminres_);
-    swap(lhs.true_rhs_, rhs.true_rhs_);
-    swap(lhs.true_sol_, rhs.true_sol_);
+    std::swap(lhs.true_offsets_, rhs.true_offsets_);
+    std::swap(lhs.elim_dofs_, rhs.elim_dofs_);
 }
 
-void MinresBlockSolver::Solve(const BlockVector& rhs, BlockVector& sol) const
+struct MinresBlockSolver::Workspace : public SolverWorkspace
 {
-    Timer timer(Timer::Start::True);
-
-    edge_true_edge_.MultAT(rhs.GetBlock(0), true_rhs_.GetBlock(0));
-    true_rhs_.GetBlock(1) = rhs.GetBlock(1);
-
-    edge_true_edge_.MultAT(sol.GetBlock(0), true_sol_.GetBlock(0));
-    true_sol_.GetBlock(1) = sol.GetBlock(1);
-
-    if (!use_w_ && myid_ == 0)
+    Workspace(const MinresBlockSolver& solver)
+        : SolverWorkspace(solver.offsets_),
+          op(solver.op_), prec(solver.prec_),
+          schur_prec(solver.schur_prec_, solver.prec_mutex_),
+          true_rhs(1, Vector(solver.true_offsets_.back())),
+          true_sol(1, Vector(solver.true_offsets_.back()))
     {
-        true_rhs_.GetBlock(1)[0] = 0.0;
+        prec.SetBlock(1, 1, schur_prec);
     }
 
-    pminres_.Mult(true_rhs_, true_sol_);
-    num_iterations_ = pminres_.GetNumIterations();
+    // The block operators keep their own work vectors, so each workspace has a copy
+    linalgcpp::BlockOperator op;
+    linalgcpp::BlockOperator prec;
+    LockedOperator schur_prec;
 
-    edge_true_edge_.Mult(true_sol_.GetBlock(0), sol.GetBlock(0));
-    sol.GetBlock(1) = true_sol_.GetBlock(1);
+    std::vector<Vector> true_rhs;
+    std::vector<Vector> true_sol;
+};
 
-    timer.Click();
-    timing_ = timer.TotalTime();
+std::unique_ptr<SolverWorkspace> MinresBlockSolver::MakeWorkspace() const
+{
+    return make_unique<Workspace>(*this);
 }
 
-void MinresBlockSolver::SetPrintLevel(int print_level)
+void MinresBlockSolver::ToTrue(const BlockVector& rhs, const BlockVector& sol,
+                               Vector& true_rhs, Vector& true_sol) const
 {
-    MGLSolver::SetPrintLevel(print_level);
+    int num_true_edges = true_offsets_[1];
+    int num_vertices = true_offsets_[2] - true_offsets_[1];
+
+    VectorView rhs_edge(true_rhs.begin(), num_true_edges);
+    VectorView rhs_vertex(true_rhs.begin() + num_true_edges, num_vertices);
+
+    VectorView sol_edge(true_sol.begin(), num_true_edges);
+    VectorView sol_vertex(true_sol.begin() + num_true_edges, num_vertices);
 
-    if (myid_ == 0)
+    edge_true_edge_.MultAT(rhs.GetBlock(0), rhs_edge);
+    rhs_vertex = rhs.GetBlock(1);
+
+    edge_true_edge_.MultAT(sol.GetBlock(0), sol_edge);
+    sol_vertex = sol.GetBlock(1);
+
+    if (!use_w_ && myid_ == 0)
     {
-        pminres_.SetVerbose(print_level_);
+        rhs_vertex[0] = 0.0;
     }
 }
 
-void MinresBlockSolver::SetMaxIter(int max_num_iter)
+void MinresBlockSolver::FromTrue(Vector& true_sol, BlockVector& sol) const
 {
-    MGLSolver::SetMaxIter(max_num_iter);
+    int num_true_edges = true_offsets_[1];
+    int num_vertices = true_offsets_[2] - true_offsets_[1];
+
+    VectorView sol_edge(true_sol.begin(), num_true_edges);
+    VectorView sol_vertex(true_sol.begin() + num_true_edges, num_vertices);
 
-    pminres_.SetMaxIter(max_num_iter);
+    edge_true_edge_.Mult(sol_edge, sol.GetBlock(0));
+    sol.GetBlock(1) = sol_vertex;
 }
 
-void MinresBlockSolver::SetRelTol(double rtol)
+void MinresBlockSolver::Solve(const BlockVector& rhs, BlockVector& sol,
+                              SolverWorkspace& work) const
 {
-    MGLSolver::SetRelTol(rtol);
+    assert(dynamic_cast<Workspace*>(&work));
 
-    pminres_.SetRelTol(rtol);
+    auto& minres_work = static_cast<Workspace&>(work);
+
+    Timer timer(Timer::Start::True);
+
+    ToTrue(rhs, sol, minres_work.true_rhs[0], minres_work.true_sol[0]);
+
+    work.num_iterations = BatchedPMINRES(comm_, minres_work.op, &minres_work.prec,
+                                         minres_work.true_rhs, minres_work.true_sol,
+                                         max_num_iter_, rtol_, atol_);
+
+    FromTrue(minres_work.true_sol[0], sol);
+
+    timer.Click();
+    work.timing = timer.TotalTime();
+
+    if (myid_ == 0 && print_level_ > 0)
+    {
+        std::cout << "  MINRES done in " << work.num_iterations << " iterations, "
+                  << work.timing << "s.\n";
+    }
+
+    num_iterations_ = work.num_iterations;
+    timing_ = work.timing;
 }
 
-void MinresBlockSolver::SetAbsTol(double atol)
+void MinresBlockSolver::Solve(const std::vector<BlockVector>& rhs,
+                              std::vector<BlockVector>& sol) const
 {
-    MGLSolver::SetAbsTol(atol);
+    assert(rhs.size() == sol.size());
+
+    Timer timer(Timer::Start::True);
+
+    int num_rhs = rhs.size();
 
-    pminres_.SetAbsTol(atol);
+    Workspace work(*this);
+
+    std::vector<Vector> true_rhs(num_rhs, Vector(true_offsets_.back()));
+    std::vector<Vector> true_sol(num_rhs, Vector(true_offsets_.back()));
+
+    for (int i = 0; i < num_rhs; ++i)
+    {
+        ToTrue(rhs[i], sol[i], true_rhs[i], true_sol[i]);
+    }
+
+    int num_iterations = BatchedPMINRES(comm_, work.op, &work.prec, true_rhs, true_sol,
+                                        max_num_iter_, rtol_, atol_);
+
+    for (int i = 0; i < num_rhs; ++i)
+    {
+        FromTrue(true_sol[i], sol[i]);
+    }
+
+    timer.Click();
+
+    num_iterations_ = num_iterations;
+    timing_ = timer.TotalTime();
 }
 
 } // namespace gauss
@@ -29,7 +29,6 @@ MixedMatrix::MixedMatrix(const Graph& graph)
       W_local_(graph.W_local_),
       elem_dof_(graph.vertex_edge_local_)
 {
-    int num_vertices = D_local_.Rows();
     int num_edges = D_local_.Cols();
 
     std::vector<double> weight_inv = graph.weight_local_;
@@ -49,22 +48,9 @@ MixedMatrix::MixedMatrix(const Graph& graph)
         }
     }
 
-    M_elem_.resize(num_vertices);
-
-    for (int i = 0; i < num_vertices; ++i)
-    {
-        std::vector<int> edge_dofs = elem_dof_.GetIndices(i);
-
-        int num_dofs = edge_dofs.size();
-
-        M_elem_[i].SetSize(num_dofs);
-        M_elem_[i] = 0.0;
-
-        for (int j = 0; j < num_dofs; ++j)
-        {
-            M_elem_[i](j, j) = weight_inv[edge_dofs[j]];
-        }
-    }
+    // The element matrices are diagonal, so only
+    // the entry on each edge is kept
+    M_elem_diag_ = std::move(weight_inv);
 
     Init();
 }
@@ -81,6 +67,20 @@ MixedMatrix::MixedMatrix(std::vector<DenseMatrix> M_elem, SparseMatrix elem_dof,
     Init();
 }
 
+MixedMatrix::MixedMatrix(std::vector<double> M_elem_diag, SparseMatrix elem_dof,
+                         SparseMatrix D_local, SparseMatrix W_local,
+                         ParMatrix edge_true_edge)
+    : edge_true_edge_(std::move(edge_true_edge)),
+      D_local_(std::move(D_local)),
+      W_local_(std::move(W_local)),
+      elem_dof_(std::move(elem_dof)),
+      M_elem_diag_(std::move(M_elem_diag))
+{
+    assert(static_cast<int>(M_elem_diag_.size()) == D_local_.Cols());
+
+    Init();
+}
+
 void MixedMatrix::Init()
 {
     MPI_Comm comm = edge_true_edge_.GetComm();
@@ -118,7 +118,9 @@ MixedMatrix::MixedMatrix(const MixedMatrix& other) noexcept
       offsets_(other.offsets_),
       true_offsets_(other.true_offsets_),
       M_elem_(other.M_elem_),
-      elem_dof_(other.elem_dof_)
+      elem_dof_(other.elem_dof_),
+      M_elem_diag_(other.M_elem_diag_),
+      M_elem_pos_(other.M_elem_pos_)
 {
 }
 
@@ -151,6 +153,8 @@ void swap(MixedMatrix& lhs, MixedMatrix& rhs) noexcept
 
     swap(lhs.M_elem_, rhs.M_elem_);
     swap(lhs.elem_dof_, rhs.elem_dof_);
+    std::swap(lhs.M_elem_diag_, rhs.M_elem_diag_);
+    std::swap(lhs.M_elem_pos_, rhs.M_elem_pos_);
 }
 
 int MixedMatrix::Rows() const
@@ -218,14 +222,90 @@ ParMatrix MixedMatrix::ToPrimal() const
 
 void MixedMatrix::AssembleM()
 {
-    std::vector<double> agg_weight(M_elem_.size(), 1.0);
+    std::vector<double> agg_weight(elem_dof_.Rows(), 1.0);
 
     AssembleM(agg_weight);
 }
 
 void MixedMatrix::AssembleM(const std::vector<double>& agg_weight)
 {
-    assert(agg_weight.size() == M_elem_.size());
+    assert(static_cast<int>(agg_weight.size()) == elem_dof_.Rows());
+
+    if (IsDiagonalM())
+    {
+        AssembleDiagonalM(agg_weight);
+    }
+    else
+    {
+        AssembleDenseM(agg_weight);
+    }
+
+    ParMatrix M_d(edge_true_edge_.GetComm(), edge_true_edge_.GetRowStarts(), M_local_);
+    M_global_ = linalgcpp::RAP(M_d, edge_true_edge_);
+}
+
+void MixedMatrix::AssembleDiagonalM(const std::vector<double>& agg_weight)
+{
+    std::vector<double> M_diag(D_local_.Cols(), 0.0);
+
+    const int num_elem = elem_dof_.Rows();
+    const auto& indptr = elem_dof_.GetIndptr();
+    const auto& indices = elem_dof_.GetIndices();
+
+    for (int i = 0; i < num_elem; ++i)
+    {
+        const double scale = 1.0 / agg_weight[i];
+
+        for (int k = indptr[i]; k < indptr[i + 1]; ++k)
+        {
+            M_diag[indices[k]] += scale * M_elem_diag_[indices[k]];
+        }
+    }
+
+    M_local_ = SparseMatrix(std::move(M_diag));
+}
+
+void MixedMatrix::AssembleDenseM(const std::vector<double>& agg_weight)
+{
+    if (M_elem_pos_.empty())
+    {
+        AssembleMPattern();
+    }
+
+    // The pattern only depends on the element matrices and
+    // element to dof relationship, so only the values are rewritten
+    std::vector<int> indptr = M_local_.GetIndptr();
+    std::vector<int> indices = M_local_.GetIndices();
+    std::vector<double> data(indices.size(), 0.0);
+
+    const int num_aggs = M_elem_.size();
+    const int* pos = M_elem_pos_.data();
+
+    for (int i = 0; i < num_aggs; ++i)
+    {
+        const double scale = 1.0 / agg_weight[i];
+        const DenseMatrix& elem = M_elem_[i];
+
+        for (int col = 0; col < elem.Cols(); ++col)
+        {
+            for (int row = 0; row < elem.Rows(); ++row, ++pos)
+            {
+                if (*pos >= 0)
+                {
+                    data[*pos] += scale * elem(row, col);
+                }
+            }
+        }
+    }
+
+    int M_size = D_local_.Cols();
+    M_local_ = SparseMatrix(std::move(indptr), std::move(indices), std::move(data),
+                            M_size, M_size);
+}
+
+void MixedMatrix::AssembleMPattern()
+{
+    const double zero_tol = 1e-15;
 
     int M_size = D_local_.Cols();
     CooMatrix M_coo(M_size, M_size);
@@ -240,18 +320,111 @@ void MixedMatrix::AssembleM(const std::vector<double>& agg_weight)
 
     M_coo.Reserve(nnz);
 
+    // Structurally zero element entries are left out of the pattern
     for (int i = 0; i < num_aggs; ++i)
     {
-        double scale = 1.0 / agg_weight[i];
         std::vector<int> dofs = elem_dof_.GetIndices(i);
+        const DenseMatrix& elem = M_elem_[i];
 
-        M_coo.Add(dofs, dofs, scale, M_elem_[i]);
+        for (int col = 0; col < elem.Cols(); ++col)
+        {
+            for (int row = 0; row < elem.Rows(); ++row)
+            {
+                if (std::fabs(elem(row, col)) > zero_tol)
+                {
+                    M_coo.Add(dofs[row], dofs[col], 1.0);
+                }
+            }
+        }
     }
 
-    M_coo.EliminateZeros(1e-15);
     M_local_ = M_coo.ToSparse();
-    ParMatrix M_d(edge_true_edge_.GetComm(), edge_true_edge_.GetRowStarts(), M_local_);
-    M_global_ = linalgcpp::RAP(M_d, edge_true_edge_);
+
+    const auto& indptr = M_local_.GetIndptr();
+    const auto& indices = M_local_.GetIndices();
+
+    // Position of each element entry in the data of M_local_, -1 if left out
+    M_elem_pos_.resize(nnz);
+    int* pos = M_elem_pos_.data();
+
+    for (int i = 0; i < num_aggs; ++i)
+    {
+        std::vector<int> dofs = elem_dof_.GetIndices(i);
+        const DenseMatrix& elem = M_elem_[i];
+
+        for (int col = 0; col < elem.Cols(); ++col)
+        {
+            for (int row = 0; row < elem.Rows(); ++row, ++pos)
+            {
+                *pos = -1;
+
+                if (std::fabs(elem(row, col)) <= zero_tol)
+                {
+                    continue;
+                }
+
+                const int dof = dofs[row];
+
+                for (int k = indptr[dof]; k < indptr[dof + 1]; ++k)
+                {
+                    if (indices[k] == dofs[col])
+                    {
+                        *pos = k;
+                        break;
+                    }
+                }
+
+                assert(*pos >= 0);
+            }
+        }
+    }
+}
+
+void MixedMatrix::GetElemM(int elem, DenseMatrix& M_elem) const
+{
+    if (!IsDiagonalM())
+    {
+        M_elem = M_elem_[elem];
+        return;
+    }
+
+    const auto& indptr = elem_dof_.GetIndptr();
+    const auto& indices = elem_dof_.GetIndices();
+
+    const int num_dofs = indptr[elem + 1] - indptr[elem];
+
+    M_elem.SetSize(num_dofs);
+    M_elem = 0.0;
+
+    for (int j = 0; j < num_dofs; ++j)
+    {
+        M_elem(j, j) = M_elem_diag_[indices[indptr[elem] + j]];
+    }
+}
+
+long long MixedMatrix::ElemMBytes() const
+{
+    long long num_entries = M_elem_diag_.size();
+
+    for (const auto& elem : M_elem_)
+    {
+        num_entries += elem.Rows() * elem.Cols();
+    }
+
+    return num_entries * sizeof(double);
+}
+
+long long MixedMatrix::DenseElemMBytes() const
+{
+    long long num_entries = 0;
+
+    for (int i = 0; i < elem_dof_.Rows(); ++i)
+    {
+        long long num_dofs = elem_dof_.RowSize(i);
+        num_entries += num_dofs * num_dofs;
+    }
+
+    return num_entries * sizeof(double);
 }
 
 SparseMatrix MixedMatrix::MakeLocalD(const ParMatrix& edge_true_edge,
@@ -0,0 +1,785 @@
+/*BHEADER**********************************************************************
+ *
+ * Copyright (c) 2018, Lawrence Livermore National Security, LLC.
+ * Produced at the Lawrence Livermore National Laboratory.
+ * LLNL-CODE-759464. All Rights reserved. See file COPYRIGHT for details.
+ *
+ * This file is part of GAUSS. For more information and source code
+ * availability, see https://www.github.com/gelever/GAUSS.
+ *
+ * GAUSS is free software; you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License (as published by the Free
+ * Software Foundation) version 2.1 dated February 1999.
+ *
+ ***********************************************************************EHEADER*/
+
+/**
+   @file
+
+   @brief Implements MultigridSolver object.
+*/
+
+#include "MultigridSolver.hpp"
+
+namespace gauss
+{
+
+namespace
+{
+// Number of processors sharing each true edge
+std::vector<double> TrueEdgeCounts(const ParMatrix& edge_true_edge)
+{
+    Vector ones(edge_true_edge.Rows(), 1.0);
+    Vector counts = edge_true_edge.MultAT(ones);
+
+    return std::vector<double>(std::begin(counts), std::end(counts));
+}
+
+// Add the sums of the absolute values in each row
+void AddAbsRowSums(const SparseMatrix& A, std::vector<double>& sums)
+{
+    const auto& indptr = A.GetIndptr();
+    const auto& data = A.GetData();
+
+    const int rows = A.Rows();
+
+    for (int i = 0; i < rows; ++i)
+    {
+        for (int j = indptr[i]; j < indptr[i + 1]; ++j)
+        {
+            sums[i] += std::fabs(data[j]);
+        }
+    }
+}
+
+// l1 row sums of the local rows, over both local and off processor columns
+std::vector<double> L1RowSums(const ParMatrix& A)
+{
+    std::vector<double> sums(A.GetDiag().Rows(), 0.0);
+
+    AddAbsRowSums(A.GetDiag(), sums);
+    AddAbsRowSums(A.GetOffd(), sums);
+
+    return sums;
+}
+
+// Entrywise inverse, with zero for zero entries
+std::vector<double> Reciprocal(const std::vector<double>& vect)
+{
+    std::vector<double> inverse(vect.size(), 0.0);
+
+    const int size = vect.size();
+
+    for (int i = 0; i < size; ++i)
+    {
+        if (vect[i] != 0.0)
+        {
+            inverse[i] = 1.0 / vect[i];
+        }
+    }
+
+    return inverse;
+}
+
+// Inverses of the blocks of A on the dofs of each aggregate, with the
+// l1 sum of the entries outside the block added to the block diagonal
+std::vector<DenseMatrix> L1BlockInverses(const ParMatrix& A, const std::vector<double>& l1_sums,
+                                         const SparseMatrix& agg_dof)
+{
+    const SparseMatrix& diag = A.GetDiag();
+
+    const auto& indptr = diag.GetIndptr();
+    const auto& indices = diag.GetIndices();
+    const auto& data = diag.GetData();
+
+    const int num_aggs = agg_dof.Rows();
+
+    std::vector<int> marker(diag.Rows(), -1);
+    std::vector<DenseMatrix> block_inverses(num_aggs);
+
+    for (int agg = 0; agg < num_aggs; ++agg)
+    {
+        std::vector<int> dofs = agg_dof.GetIndices(agg);
+
+        const int num_dofs = dofs.size();
+
+        for (int i = 0; i < num_dofs; ++i)
+        {
+            marker[dofs[i]] = i;
+        }
+
+        DenseMatrix block(num_dofs, num_dofs);
+        block = 0.0;
+
+        for (int i = 0; i < num_dofs; ++i)
+        {
+            const int row = dofs[i];
+
+            double off_block = l1_sums[row];
+
+            for (int j = indptr[row]; j < indptr[row + 1]; ++j)
+            {
+                const int col = marker[indices[j]];
+
+                if (col >= 0)
+                {
+                    block(i, col) += data[j];
+                    off_block -= std::fabs(data[j]);
+                }
+            }
+
+            block(i, i) += off_block;
+        }
+
+        block.Invert(block_inverses[agg]);
+
+        for (auto dof : dofs)
+        {
+            marker[dof] = -1;
+        }
+    }
+
+    return block_inverses;
+}
+
+// Remove the component along the constant representation,
+// all ones if it is empty
+void OrthoConstant(MPI_Comm comm, const Vector& constant_rep, VectorView vect)
+{
+    const bool has_rep = constant_rep.size() > 0;
+    const int size = vect.size();
+
+    double dots[2] = {0.0, 0.0};
+
+    for (int i = 0; i < size; ++i)
+    {
+        const double rep_i = has_rep ? constant_rep[i] : 1.0;
+
+        dots[0] += rep_i * vect[i];
+        dots[1] += rep_i * rep_i;
+    }
+
+    ParSum(comm, dots, 2);
+
+    if (dots[1] == 0.0)
+    {
+        return;
+    }
+
+    const double shift = dots[0] / dots[1];
+
+    for (int i = 0; i < size; ++i)
+    {
+        vect[i] -= shift * (has_rep ? constant_rep[i] : 1.0);
+    }
+}
+} // namespace
+
+MultigridSolver::MultigridSolver(const MixedMatrix& mgl, const std::vector<Level>& levels,
+                                 const std::vector<GraphCoarsen>& coarseners,
+                                 const MultigridParams& params)
+    : MGLSolver(mgl), params_(params), levels_(levels.size() - 1),
+      edge_true_edge_(mgl.EdgeTrueEdge()),
+      edge_count_(TrueEdgeCounts(edge_true_edge_)),
+      elim_dofs_(levels[0].edge_elim_dofs)
+{
+    assert(levels.size() > 1);
+    assert(coarseners.size() + 1 >= levels.size());
+    assert(params_.smooth_steps > 0);
+    assert(params_.chebyshev_degree > 0);
+    assert(params_.chebyshev_ratio > 1.0);
+
+    const int num_smooth = levels_.size();
+
+    for (int level_i = 0; level_i < num_smooth; ++level_i)
+    {
+        const MixedMatrix& mgl_i = level_i == 0 ? mgl : levels[level_i].mixed_matrix;
+        const GraphCoarsen& coarsener = coarseners[level_i];
+
+        auto& level = levels_[level_i];
+
+        // Aggregates of the vertices on this level, as coarsened to the next
+        const SparseMatrix& vertex_vdof = levels[level_i].graph_space.vertex_vdof.GetDiag();
+        level.agg_vertexdof = coarsener.Topology().agg_vertex_local_.Mult(vertex_vdof);
+
+        BuildLevel(mgl_i, levels[level_i].edge_elim_dofs, level);
+        BuildInterpolation(mgl_i, levels[level_i + 1].mixed_matrix, coarsener, level);
+
+        nnz_ += level.M.nnz() + level.DT.nnz() + level.D.nnz() +
+                (level.use_w ? level.W.nnz() : 0);
+    }
+
+    const Level& coarse = levels[num_smooth];
+
+    coarse_solver_ = make_unique<HybridSolver>(coarse.mixed_matrix, coarse.graph_space);
+    coarse_solver_->SetConstantRep(coarse.constant_rep);
+    coarse_solver_->SetRelTol(params_.coarse_rel_tol);
+
+    coarse_edge_true_edge_ = coarse.mixed_matrix.EdgeTrueEdge();
+    coarse_edge_count_ = TrueEdgeCounts(coarse_edge_true_edge_);
+    coarse_offsets_ = coarse.mixed_matrix.Offsets();
+    coarse_true_offsets_ = coarse.mixed_matrix.TrueOffsets();
+
+    nnz_ += coarse_solver_->GetNNZ();
+}
+
+void MultigridSolver::UpdateOperator(const MixedMatrix& mgl, bool rebuild_prec)
+{
+    assert(mgl.LocalD().Rows() == offsets_[2] - offsets_[1]);
+
+    BuildLevel(mgl, elim_dofs_, levels_[0], rebuild_prec);
+}
+
+void MultigridSolver::BuildLevel(const MixedMatrix& mgl, const std::vector<int>& elim_dofs,
+                                 SmoothLevel& level, bool build_smoother) const
+{
+    SparseMatrix M_elim = mgl.LocalM();
+    SparseMatrix D_elim = mgl.LocalD();
+
+    std::vector<int> marker(D_elim.Cols(), 0);
+
+    for (auto&& dof : elim_dofs)
+    {
+        marker[dof] = 1;
+    }
+
+    M_elim.EliminateRowCol(marker);
+    D_elim.EliminateCol(marker);
+
+    ParMatrix M_elim_g(comm_, std::move(M_elim));
+    ParMatrix D_elim_g(comm_, std::move(D_elim));
+
+    level.true_offsets = mgl.TrueOffsets();
+    level.use_w = mgl.CheckW();
+
+    level.M = linalgcpp::RAP(M_elim_g, mgl.EdgeTrueEdge());
+    level.D = D_elim_g.Mult(mgl.EdgeTrueEdge());
+    level.DT = level.D.Transpose();
+
+    if (level.use_w)
+    {
+        level.W = mgl.GlobalW();
+    }
+
+    if (build_smoother)
+    {
+        BuildSmoother(level);
+    }
+}
+
+void MultigridSolver::BuildSmoother(SmoothLevel& level) const
+{
+    level.M_scale = Reciprocal(L1RowSums(level.M));
+
+    ParMatrix MinvDT = level.DT;
+    MinvDT.ScaleRows(level.M_scale);
+    level.schur = level.D.Mult(MinvDT);
+
+    if (level.use_w)
+    {
+        level.schur = linalgcpp::ParSub(level.schur, level.W);
+    }
+
+    std::vector<double> schur_l1 = L1RowSums(level.schur);
+
+    level.schur_scale = Reciprocal(schur_l1);
+
+    if (params_.smoother == SmootherType::Schwarz)
+    {
+        level.schur_blocks = L1BlockInverses(level.schur, schur_l1, level.agg_vertexdof);
+    }
+}
+
+void MultigridSolver::BuildInterpolation(const MixedMatrix& mgl, const MixedMatrix& coarse_mgl,
+                                         const GraphCoarsen& coarsener, SmoothLevel& level) const
+{
+    const ParMatrix& edge_true_edge = mgl.EdgeTrueEdge();
+    const ParMatrix& coarse_edge_true_edge = coarse_mgl.EdgeTrueEdge();
+
+    ParMatrix P_edge_local(comm_, edge_true_edge.GetRowStarts(),
+                           coarse_edge_true_edge.GetRowStarts(), coarsener.Pedge());
+
+    // Shared edges are interpolated on each processor, keep the average
+    ParMatrix true_P = edge_true_edge.Transpose().Mult(P_edge_local);
+    level.P_edge = true_P.Mult(coarse_edge_true_edge);
+    level.P_edge.InverseScaleRows(TrueEdgeCounts(edge_true_edge));
+
+    level.P_vertex = coarsener.Pvertex();
+}
+
+struct MultigridSolver::Workspace : public SolverWorkspace
+{
+    // Work vectors of a level, in true dofs
+    struct LevelWork
+    {
+        LevelWork(const std::vector<int>& true_offsets)
+            : rhs(true_offsets), sol(true_offsets), resid(true_offsets),
+              correction(true_offsets), A_correction(true_offsets),
+              edge(true_offsets[1]), vertex(true_offsets[2] - true_offsets[1]),
+              schur_rhs(vertex.size()), schur_sol(vertex.size()),
+              schur_dir(vertex.size()), schur_S_dir(vertex.size())
+        {
+        }
+
+        BlockVector rhs;
+        BlockVector sol;
+        BlockVector resid;
+        BlockVector correction;
+        BlockVector A_correction;
+
+        Vector edge;
+        Vector vertex;
+
+        // Schur complement solve, also used by the Chebyshev iteration
+        // and as block vectors of the Schwarz smoother
+        Vector schur_rhs;
+        Vector schur_sol;
+        Vector schur_dir;
+        Vector schur_S_dir;
+    };
+
+    Workspace(const MultigridSolver& solver)
+        : SolverWorkspace(solver.offsets_),
+          op_input(solver.levels_[0].true_offsets),
+          op_output(solver.levels_[0].true_offsets),
+          coarse_work(solver.coarse_solver_->MakeWorkspace()),
+          coarse_rhs(solver.coarse_offsets_),
+          coarse_sol(solver.coarse_offsets_),
+          true_rhs(1, Vector(solver.levels_[0].true_offsets.back())),
+          true_sol(1, Vector(solver.levels_[0].true_offsets.back()))
+    {
+        for (const auto& level : solver.levels_)
+        {
+            levels.emplace_back(level.true_offsets);
+        }
+
+        levels.emplace_back(solver.coarse_true_offsets_);
+    }
+
+    // All levels, the coarsest only uses rhs, sol and edge
+    std::vector<LevelWork> levels;
+
+    // Fine level operator
+    BlockVector op_input;
+    BlockVector op_output;
+
+    // Coarsest level solve, in local dofs
+    std::unique_ptr<SolverWorkspace> coarse_work;
+    BlockVector coarse_rhs;
+    BlockVector coarse_sol;
+
+    std::vector<Vector> true_rhs;
+    std::vector<Vector> true_sol;
+};
+
+std::unique_ptr<SolverWorkspace> MultigridSolver::MakeWorkspace() const
+{
+    return make_unique<Workspace>(*this);
+}
+
+/// Fine level operator in true dofs
+class MultigridSolver::LevelOperator : public linalgcpp::Operator
+{
+public:
+    LevelOperator(const MultigridSolver& solver, Workspace& work)
+        : linalgcpp::Operator(solver.levels_[0].true_offsets.back()),
+          solver_(solver), work_(work) { }
+
+    void Mult(const VectorView& input, VectorView output) const override
+    {
+        std::copy(std::begin(input), std::end(input), std::begin(work_.op_input));
+
+        solver_.Mult(0, work_.op_input, work_.op_output, work_);
+
+        std::copy(std::begin(work_.op_output), std::end(work_.op_output), std::begin(output));
+    }
+
+    using linalgcpp::Operator::Mult;
+
+private:
+    const MultigridSolver& solver_;
+    Workspace& work_;
+};
+
+/// V-cycle from the fine level, in true dofs
+class MultigridSolver::VCycle : public linalgcpp::Operator
+{
+public:
+    VCycle(const MultigridSolver& solver, Workspace& work)
+        : linalgcpp::Operator(solver.levels_[0].true_offsets.back()),
+          solver_(solver), work_(work) { }
+
+    void Mult(const VectorView& input, VectorView output) const override
+    {
+        auto& fine = work_.levels[0];
+
+        std::copy(std::begin(input), std::end(input), std::begin(fine.rhs));
+
+        solver_.Cycle(0, work_);
+
+        std::copy(std::begin(fine.sol), std::end(fine.sol), std::begin(output));
+    }
+
+    using linalgcpp::Operator::Mult;
+
+private:
+    const MultigridSolver& solver_;
+    Workspace& work_;
+};
+
+void MultigridSolver::Mult(int level_i, const BlockVector& x, BlockVector& y,
+                           Workspace& work) const
+{
+    const auto& level = levels_[level_i];
+    auto& level_work = work.levels[level_i];
+
+    level.M.Mult(x.GetBlock(0), y.GetBlock(0));
+    level.DT.Mult(x.GetBlock(1), level_work.edge);
+    y.GetBlock(0) += level_work.edge;
+
+    level.D.Mult(x.GetBlock(0), y.GetBlock(1));
+
+    if (level.use_w)
+    {
+        level.W.Mult(x.GetBlock(1), level_work.vertex);
+        y.GetBlock(1) += level_work.vertex;
+    }
+}
+
+void MultigridSolver::Correct(int level_i, Workspace& work, bool update_resid) const
+{
+    auto& level_work = work.levels[level_i];
+
+    level_work.sol += level_work.correction;
+
+    if (update_resid)
+    {
+        Mult(level_i, level_work.correction, level_work.A_correction, work);
+        level_work.resid -= level_work.A_correction;
+    }
+}
+
+void MultigridSolver::Smooth(int level_i, Workspace& work) const
+{
+    const auto& level = levels_[level_i];
+    auto& level_work = work.levels[level_i];
+
+    VectorView resid_edge = level_work.resid.GetBlock(0);
+    VectorView resid_vertex = level_work.resid.GetBlock(1);
+    VectorView corr_edge = level_work.correction.GetBlock(0);
+    VectorView corr_vertex = level_work.correction.GetBlock(1);
+
+    const int num_edges = corr_edge.size();
+
+    // y = M_l1^{-1} r_edge
+    for (int i = 0; i < num_edges; ++i)
+    {
+        corr_edge[i] = level.M_scale[i] * resid_edge[i];
+    }
+
+    // Schur complement residual D y - r_vertex
+    level.D.Mult(corr_edge, level_work.schur_rhs);
+    level_work.schur_rhs -= resid_vertex;
+
+    SchurSolve(level_i, work);
+
+    corr_vertex = level_work.schur_sol;
+
+    // Edge correction y - M_l1^{-1} D^T c_vertex
+    level.DT.Mult(corr_vertex, level_work.edge);
+
+    for (int i = 0; i < num_edges; ++i)
+    {
+        corr_edge[i] -= level.M_scale[i] * level_work.edge[i];
+    }
+}
+
+void MultigridSolver::SchurSolve(int level_i, Workspace& work) const
+{
+    const auto& level = levels_[level_i];
+    auto& level_work = work.levels[level_i];
+
+    const Vector& rhs = level_work.schur_rhs;
+    Vector& sol = level_work.schur_sol;
+
+    const std::vector<double>& scale = level.schur_scale;
+    const int size = rhs.size();
+
+    if (params_.smoother == SmootherType::Jacobi)
+    {
+        for (int i = 0; i < size; ++i)
+        {
+            sol[i] = scale[i] * rhs[i];
+        }
+    }
+    else if (params_.smoother == SmootherType::Schwarz)
+    {
+        const auto& indptr = level.agg_vertexdof.GetIndptr();
+        const auto& indices = level.agg_vertexdof.GetIndices();
+
+        const int num_aggs = level.agg_vertexdof.Rows();
+
+        for (int agg = 0; agg < num_aggs; ++agg)
+        {
+            const int begin = indptr[agg];
+            const int num_dofs = indptr[agg + 1] - begin;
+
+            VectorView block_rhs(level_work.schur_dir.begin(), num_dofs);
+            VectorView block_sol(level_work.schur_S_dir.begin(), num_dofs);
+
+            for (int i = 0; i < num_dofs; ++i)
+            {
+                block_rhs[i] = rhs[indices[begin + i]];
+            }
+
+            level.schur_blocks[agg].Mult(block_rhs, block_sol);
+
+            for (int i = 0; i < num_dofs; ++i)
+            {
+                sol[indices[begin + i]] = block_sol[i];
+            }
+        }
+    }
+    else
+    {
+        // Chebyshev iteration, as in Saad, on the l1 scaled Schur complement,
+        // whose spectrum is in (0, 1], targeting [1 / ratio, 1]
+        const int degree = params_.chebyshev_degree;
+        const double lower = 1.0 / params_.chebyshev_ratio;
+        const double theta = (1.0 + lower) / 2.0;
+        const double delta = (1.0 - lower) / 2.0;
+        const double sigma = theta / delta;
+
+        Vector& resid = level_work.vertex;
+        Vector& dir = level_work.schur_dir;
+        Vector& S_dir = level_work.schur_S_dir;
+
+        for (int i = 0; i < size; ++i)
+        {
+            resid[i] = scale[i] * rhs[i];
+            dir[i] = resid[i] / theta;
+            sol[i] = 0.0;
+        }
+
+        double rho = 1.0 / sigma;
+
+        for (int step = 0; step < degree; ++step)
+        {
+            sol += dir;
+
+            if (step == degree - 1)
+            {
+                break;
+            }
+
+            level.schur.Mult(dir, S_dir);
+
+            const double rho_next = 1.0 / (2.0 * sigma - rho);
+
+            for (int i = 0; i < size; ++i)
+            {
+                resid[i] -= scale[i] * S_dir[i];
+                dir[i] = rho_next * rho * dir[i] + (2.0 * rho_next / delta) * resid[i];
+            }
+
+            rho = rho_next;
+        }
+
+        // The error polynomial is bounded by 1 / T_k(sigma) on the target
+        // interval, scale so the result stays below the inverse of S
+        sol /= 1.0 + 1.0 / std::cosh(degree * std::acosh(sigma));
+    }
+}
+
+void MultigridSolver::CoarseSolve(Workspace& work) const
+{
+    auto& coarse = work.levels.back();
+
+    VectorView rhs_edge = coarse.rhs.GetBlock(0);
+    VectorView sol_edge = coarse.sol.GetBlock(0);
+
+    const int num_true_edges = rhs_edge.size();
+
+    // Split the rhs of shared edges, the local rhs sums to the true rhs
+    for (int i = 0; i < num_true_edges; ++i)
+    {
+        coarse.edge[i] = rhs_edge[i] / coarse_edge_count_[i];
+    }
+
+    coarse_edge_true_edge_.Mult(coarse.edge, work.coarse_rhs.GetBlock(0));
+    work.coarse_rhs.GetBlock(1) = coarse.rhs.GetBlock(1);
+
+    work.coarse_sol = 0.0;
+
+    coarse_solver_->Solve(work.coarse_rhs, work.coarse_sol, *work.coarse_work);
+
+    coarse_edge_true_edge_.MultAT(work.coarse_sol.GetBlock(0), sol_edge);
+
+    for (int i = 0; i < num_true_edges; ++i)
+    {
+        sol_edge[i] /= coarse_edge_count_[i];
+    }
+
+    coarse.sol.GetBlock(1) = work.coarse_sol.GetBlock(1);
+}
+
+void MultigridSolver::Cycle(int level_i, Workspace& work) const
+{
+    if (level_i == static_cast<int>(levels_.size()))
+    {
+        CoarseSolve(work);
+        return;
+    }
+
+    const auto& level = levels_[level_i];
+    auto& level_work = work.levels[level_i];
+    auto& coarse_work = work.levels[level_i + 1];
+
+    level_work.sol = 0.0;
+    std::copy(std::begin(level_work.rhs), std::end(level_work.rhs),
+              std::begin(level_work.resid));
+
+    for (int i = 0; i < params_.smooth_steps; ++i)
+    {
+        Smooth(level_i, work);
+        Correct(level_i, work, true);
+    }
+
+    level.P_edge.MultAT(level_work.resid.GetBlock(0), coarse_work.rhs.GetBlock(0));
+    level.P_vertex.MultAT(level_work.resid.GetBlock(1), coarse_work.rhs.GetBlock(1));
+
+    Cycle(level_i + 1, work);
+
+    level.P_edge.Mult(coarse_work.sol.GetBlock(0), level_work.correction.GetBlock(0));
+    level.P_vertex.Mult(coarse_work.sol.GetBlock(1), level_work.correction.GetBlock(1));
+
+    Correct(level_i, work, true);
+
+    for (int i = 0; i < params_.smooth_steps; ++i)
+    {
+        Smooth(level_i, work);
+        Correct(level_i, work, i < params_.smooth_steps - 1);
+    }
+}
+
+void MultigridSolver::ToTrue(const BlockVector& rhs, const BlockVector& sol,
+                             Vector& true_rhs, Vector& true_sol) const
+{
+    const auto& true_offsets = levels_[0].true_offsets;
+
+    int num_true_edges = true_offsets[1];
+    int num_vertices = true_offsets[2] - true_offsets[1];
+
+    VectorView rhs_edge(true_rhs.begin(), num_true_edges);
+    VectorView rhs_vertex(true_rhs.begin() + num_true_edges, num_vertices);
+
+    VectorView sol_edge(true_sol.begin(), num_true_edges);
+    VectorView sol_vertex(true_sol.begin() + num_true_edges, num_vertices);
+
+    edge_true_edge_.MultAT(rhs.GetBlock(0), rhs_edge);
+    rhs_vertex = rhs.GetBlock(1);
+
+    // The edge solution is repeated on shared edges, not summed as the rhs
+    edge_true_edge_.MultAT(sol.GetBlock(0), sol_edge);
+
+    for (int i = 0; i < num_true_edges; ++i)
+    {
+        sol_edge[i] /= edge_count_[i];
+    }
+
+    sol_vertex = sol.GetBlock(1);
+
+    // Without W the operator is singular, keep the system consistent
+    if (!use_w_)
+    {
+        OrthoConstant(comm_, constant_rep_, rhs_vertex);
+    }
+}
+
+void MultigridSolver::FromTrue(Vector& true_sol, BlockVector& sol) const
+{
+    const auto& true_offsets = levels_[0].true_offsets;
+
+    int num_true_edges = true_offsets[1];
+    int num_vertices = true_offsets[2] - true_offsets[1];
+
+    VectorView sol_edge(true_sol.begin(), num_true_edges);
+    VectorView sol_vertex(true_sol.begin() + num_true_edges, num_vertices);
+
+    edge_true_edge_.Mult(sol_edge, sol.GetBlock(0));
+    sol.GetBlock(1) = sol_vertex;
+
+    // Fix the constant as the other solvers do, with the first dof zero
+    PinInitialGuess(sol.GetBlock(1));
+}
+
+void MultigridSolver::Solve(const BlockVector& rhs, BlockVector& sol,
+                            SolverWorkspace& work) const
+{
+    assert(dynamic_cast<Workspace*>(&work));
+
+    auto& mg_work = static_cast<Workspace&>(work);
+
+    Timer timer(Timer::Start::True);
+
+    ToTrue(rhs, sol, mg_work.true_rhs[0], mg_work.true_sol[0]);
+
+    LevelOperator op(*this, mg_work);
+    VCycle vcycle(*this, mg_work);
+
+    work.num_iterations = BatchedFGMRES(comm_, op, &vcycle, mg_work.true_rhs, mg_work.true_sol,
+                                        max_num_iter_, rtol_, atol_, params_.restart);
+
+    FromTrue(mg_work.true_sol[0], sol);
+
+    timer.Click();
+    work.timing = timer.TotalTime();
+
+    if (myid_ == 0 && print_level_ > 0)
+    {
+        std::cout << "  FGMRES done in " << work.num_iterations << " iterations, "
+                  << work.timing << "s.\n";
+    }
+
+    num_iterations_ = work.num_iterations;
+    timing_ = work.timing;
+}
+
+void MultigridSolver::Solve(const std::vector<BlockVector>& rhs,
+                            std::vector<BlockVector>& sol) const
+{
+    assert(rhs.size() == sol.size());
+
+    Timer timer(Timer::Start::True);
+
+    int num_rhs = rhs.size();
+    int true_size = levels_[0].true_offsets.back();
+
+    Workspace work(*this);
+
+    std::vector<Vector> true_rhs(num_rhs, Vector(true_size));
+    std::vector<Vector> true_sol(num_rhs, Vector(true_size));
+
+    for (int i = 0; i < num_rhs; ++i)
+    {
+        ToTrue(rhs[i], sol[i], true_rhs[i], true_sol[i]);
+    }
+
+    LevelOperator op(*this, work);
+    VCycle vcycle(*this, work);
+
+    int num_iterations = BatchedFGMRES(comm_, op, &vcycle, true_rhs, true_sol,
+                                       max_num_iter_, rtol_, atol_, params_.restart);
+
+    for (int i = 0; i < num_rhs; ++i)
+    {
+        FromTrue(true_sol[i], sol[i]);
+    }
+
+    timer.Click();
+
+    num_iterations_ = num_iterations;
+    timing_ = timer.TotalTime();
+}
+
+} // namespace gauss
@@ -30,34 +30,40 @@ SPDSolver::SPDSolver(const MixedMatrix& mgl)
 }
 
 SPDSolver::SPDSolver(const MixedMatrix& mgl, const std::vector<int>& elim_dofs)
-    : MGLSolver(mgl)
+    : MGLSolver(mgl), elim_dofs_(elim_dofs)
 {
-    const auto& ete = mgl.EdgeTrueEdge();
-    const auto& ete_T = ete.Transpose();
+    AssemblePattern(mgl);
+    AssembleOperator(mgl);
 
-    std::vector<double> M_diag_inv(mgl.GlobalM().GetDiag().GetDiag());
-    std::vector<double> diag(mgl.LocalD().Rows(), 0.0);
+    prec_ = linalgcpp::BoomerAMG(A_);
+}
 
-    SparseMatrix D_elim = mgl.LocalD();
+void SPDSolver::UpdateOperator(const MixedMatrix& mgl, bool rebuild_prec)
+{
+    AssembleOperator(mgl);
 
-    for (auto&& M_i : M_diag_inv)
+    if (rebuild_prec)
     {
-        M_i = 1.0 / M_i;
+        prec_ = linalgcpp::BoomerAMG(A_);
     }
+}
+
+void SPDSolver::AssemblePattern(const MixedMatrix& mgl)
+{
+    const auto& ete = mgl.EdgeTrueEdge();
 
-    SparseMatrix M_inv(std::move(M_diag_inv));
+    SparseMatrix D_elim = mgl.LocalD();
 
     if (myid_ == 0 && !use_w_)
     {
-        diag[0] = 1.0;
         D_elim.EliminateRow(0);
     }
 
-    if (!elim_dofs.empty())
+    if (!elim_dofs_.empty())
     {
         std::vector<int> marker(D_elim.Cols(), 0);
 
-        for (auto&& dof : elim_dofs)
+        for (auto&& dof : elim_dofs_)
         {
             marker[dof] = 1;
         }
@@ -65,41 +71,56 @@ SPDSolver::SPDSolver(const MixedMatrix& mgl, const std::vector<int>& elim_dofs)
         D_elim.EliminateCol(marker);
     }
 
-    ParMatrix Minv_true(comm_, mgl.EdgeTrueEdge().GetColStarts(), std::move(M_inv));
-    Minv_ = gauss::Mult(ete, Minv_true, ete_T);
+    D_elim_ = ParMatrix(comm_, mgl.GlobalD().GetRowStarts(),
+                        ete.GetRowStarts(), std::move(D_elim));
+
+    // Local edges that are copies of the same true edge
+    edge_edge_ = ete.Mult(ete.Transpose());
+    edge_DT_ = edge_edge_.Mult(D_elim_.Transpose());
+}
+
+void SPDSolver::AssembleOperator(const MixedMatrix& mgl)
+{
+    // M is diagonal, so every entry in a row of ete M^{-1} ete^T is the
+    // inverse of the same true edge weight and both Minv and MinvDT are
+    // row scalings of the cached patterns
+    Vector M_true(mgl.GlobalM().GetDiag().GetDiag());
+    Vector M_edge = mgl.EdgeTrueEdge().Mult(M_true);
+
+    std::vector<double> M_diag(std::begin(M_edge), std::end(M_edge));
 
-    ParMatrix D_elim_global(comm_, mgl.GlobalD().GetRowStarts(),
-                            mgl.EdgeTrueEdge().GetRowStarts(), std::move(D_elim));
+    Minv_ = edge_edge_;
+    Minv_.InverseScaleRows(M_diag);
 
-    ParMatrix D = D_elim_global;
-    ParMatrix MinvDT = Minv_.Mult(D_elim_global.Transpose());
+    MinvDT_ = edge_DT_;
+    MinvDT_.InverseScaleRows(M_diag);
 
-    for (auto&& dof : elim_dofs)
+    // Columns of eliminated dofs are already zero in D,
+    // so A is the same with or without these rows
+    for (auto&& dof : elim_dofs_)
     {
         Minv_.EliminateRow(dof);
+        MinvDT_.EliminateRow(dof);
     }
 
     if (use_w_)
     {
-        A_ = linalgcpp::ParSub(D.Mult(MinvDT), mgl.GlobalW());
+        A_ = linalgcpp::ParSub(D_elim_.Mult(MinvDT_), mgl.GlobalW());
     }
     else
     {
-        A_ = D.Mult(MinvDT);
+        A_ = D_elim_.Mult(MinvDT_);
     }
 
-    A_.AddDiag(diag);
-    MinvDT_ = Minv_.Mult(D_elim_global.Transpose());
-
-    prec_ = linalgcpp::BoomerAMG(A_);
-    pcg_ = linalgcpp::PCGSolver(A_, prec_, max_num_iter_, rtol_,
-                                atol_, 0, linalgcpp::ParMult);
+    std::vector<double> diag(mgl.LocalD().Rows(), 0.0);
 
-    if (myid_ == 0)
+    if (myid_ == 0 && !use_w_)
     {
-        SetPrintLevel(print_level_);
+        diag[0] = 1.0;
     }
 
+    A_.AddDiag(diag);
+
     nnz_ = A_.nnz();
 }
 
@@ -109,7 +130,11 @@ SPDSolver::SPDSolver(const SPDSolver& other) noexcept
       A_(other.A_),
       Minv_(other.Minv_),
       MinvDT_(other.MinvDT_),
-      prec_(other.prec_), pcg_(other.pcg_)
+      D_elim_(other.D_elim_),
+      edge_edge_(other.edge_edge_),
+      edge_DT_(other.edge_DT_),
+      elim_dofs_(other.elim_dofs_),
+      prec_(other.prec_)
 {
 
 }
@@ -134,68 +159,127 @@ void swap(SPDSolver& lhs, SPDSolver& rhs) noexcept
     swap(lhs.A_, rhs.A_);
     swap(lhs.Minv_, rhs.Minv_);
     swap(lhs.MinvDT_, rhs.MinvDT_);
+    swap(lhs.D_elim_, rhs.D_elim_);
+    swap(lhs.edge_edge_, rhs.edge_edge_);
+    swap(lhs.edge_DT_, rhs.edge_DT_);
+    std::swap(lhs.elim_dofs_, rhs.elim_dofs_);
 
     swap(lhs.prec_, rhs.prec_);
-    swap(lhs.pcg_, rhs.pcg_);
 }
 
-void SPDSolver::Solve(const BlockVector& rhs, BlockVector& sol) const
+struct SPDSolver::Workspace : public SolverWorkspace
 {
-    Timer timer(Timer::Start::True);
+    Workspace(const std::vector<int>& offsets)
+        : SolverWorkspace(offsets),
+          primal_rhs(1, Vector(offsets[2] - offsets[1])),
+          primal_sol(1, Vector(offsets[2] - offsets[1])),
+          edge_work(offsets[1] - offsets[0]) { }
+
+    std::vector<Vector> primal_rhs;
+    std::vector<Vector> primal_sol;
+    Vector edge_work;
+};
+
+std::unique_ptr<SolverWorkspace> SPDSolver::MakeWorkspace() const
+{
+    return make_unique<Workspace>(offsets_);
+}
 
-    rhs_.GetBlock(1) = rhs.GetBlock(1);
-    rhs_.GetBlock(1) *= -1.0;
+void SPDSolver::PrimalRHS(const BlockVector& rhs, VectorView primal_rhs,
+                          VectorView vertex_work) const
+{
+    primal_rhs = rhs.GetBlock(1);
+    primal_rhs *= -1.0;
 
     if (!use_w_ && myid_ == 0)
     {
-        rhs_.GetBlock(1)[0] = 0.0;
+        primal_rhs[0] = 0.0;
     }
 
-    MinvDT_.MultAT(rhs.GetBlock(0), sol_.GetBlock(1));
-    rhs_.GetBlock(1) += sol_.GetBlock(1);
-
-    pcg_.Mult(rhs_.GetBlock(1), sol.GetBlock(1));
+    MinvDT_.MultAT(rhs.GetBlock(0), vertex_work);
+    primal_rhs += vertex_work;
+}
 
+void SPDSolver::RecoverEdges(const BlockVector& rhs, BlockVector& sol,
+                             VectorView edge_work) const
+{
     Minv_.Mult(rhs.GetBlock(0), sol.GetBlock(0));
-    MinvDT_.Mult(sol.GetBlock(1), sol_.GetBlock(0));
+    MinvDT_.Mult(sol.GetBlock(1), edge_work);
 
-    sol.GetBlock(0) -= sol_.GetBlock(0);
-
-    timer.Click();
-    timing_ = timer.TotalTime();
-
-    num_iterations_ = pcg_.GetNumIterations();
+    sol.GetBlock(0) -= edge_work;
 }
 
-void SPDSolver::SetPrintLevel(int print_level)
+void SPDSolver::Solve(const BlockVector& rhs, BlockVector& sol,
+                      SolverWorkspace& work) const
 {
-    MGLSolver::SetPrintLevel(print_level);
+    assert(dynamic_cast<Workspace*>(&work));
+
+    auto& spd_work = static_cast<Workspace&>(work);
+
+    Timer timer(Timer::Start::True);
+
+    VectorView primal_rhs = spd_work.primal_rhs[0];
+    VectorView primal_sol = spd_work.primal_sol[0];
 
-    if (myid_ == 0)
+    PrimalRHS(rhs, primal_rhs, primal_sol);
+    primal_sol = sol.GetBlock(1);
+
+    LockedOperator prec(prec_, prec_mutex_);
+
+    work.num_iterations = PCG(A_, &prec, spd_work.primal_rhs, spd_work.primal_sol);
+
+    sol.GetBlock(1) = primal_sol;
+    RecoverEdges(rhs, sol, spd_work.edge_work);
+
+    timer.Click();
+    work.timing = timer.TotalTime();
+
+    if (myid_ == 0 && print_level_ > 0)
     {
-        pcg_.SetVerbose(print_level_);
+        std::cout << "  PCG done in " << work.num_iterations << " iterations, "
+                  << work.timing << "s.\n";
     }
+
+    num_iterations_ = work.num_iterations;
+    timing_ = work.timing;
 }
 
-void SPDSolver::SetMaxIter(int max_num_iter)
+void SPDSolver::Solve(const std::vector<BlockVector>& rhs,
+                      std::vector<BlockVector>& sol) const
 {
-    MGLSolver::SetMaxIter(max_num_iter);
+    assert(rhs.size() == sol.size());
 
-    pcg_.SetMaxIter(max_num_iter);
-}
+    Timer timer(Timer::Start::True);
 
-void SPDSolver::SetRelTol(double rtol)
-{
-    MGLSolver::SetRelTol(rtol);
+    int num_rhs = rhs.size();
+    int num_vertices = offsets_[2] - offsets_[1];
 
-    pcg_.SetRelTol(rtol);
-}
+    std::vector<Vector> primal_rhs(num_rhs, Vector(num_vertices));
+    std::vector<Vector> primal_sol(num_rhs, Vector(num_vertices));
+    Vector edge_work(offsets_[1] - offsets_[0]);
 
-void SPDSolver::SetAbsTol(double atol)
-{
-    MGLSolver::SetAbsTol(atol);
+    for (int i = 0; i < num_rhs; ++i)
+    {
+        VectorView primal_sol_i = primal_sol[i];
+
+        PrimalRHS(rhs[i], primal_rhs[i], primal_sol_i);
+        primal_sol_i = sol[i].GetBlock(1);
+    }
+
+    LockedOperator prec(prec_, prec_mutex_);
 
-    pcg_.SetAbsTol(atol);
+    int num_iterations = PCG(A_, &prec, primal_rhs, primal_sol);
+
+    for (int i = 0; i < num_rhs; ++i)
+    {
+        sol[i].GetBlock(1) = primal_sol[i];
+        RecoverEdges(rhs[i], sol[i], edge_work);
+    }
+
+    timer.Click();
+
+    num_iterations_ = num_iterations;
+    timing_ = timer.TotalTime();
 }
 
 } // namespace gauss
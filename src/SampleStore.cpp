@@ -0,0 +1,338 @@
+/*BHEADER**********************************************************************
+ *
+ * Copyright (c) 2018, Lawrence Livermore National Security, LLC.
+ * Produced at the Lawrence Livermore National Laboratory.
+ * LLNL-CODE-759464. All Rights reserved. See file COPYRIGHT for details.
+ *
+ * This file is part of GAUSS. For more information and source code
+ * availability, see https://www.github.com/gelever/GAUSS.
+ *
+ * GAUSS is free software; you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License (as published by the Free
+ * Software Foundation) version 2.1 dated February 1999.
+ *
+ ***********************************************************************EHEADER*/
+
+/** @file
+
+    @brief Implements the binary sample store
+*/
+
+#include <cstdint>
+#include <cstring>
+
+#include "SampleStore.hpp"
+
+namespace gauss
+{
+
+namespace
+{
+const char magic[8] = {'G', 'A', 'U', 'S', 'S', 'S', 'M', 'P'};
+const int32_t version = 1;
+const int name_size = 32;
+
+long long HeaderSize(int num_fields)
+{
+    return 24 + name_size * num_fields;
+}
+
+long long RecordOffset(int num_fields, int global_size, int sample, int field)
+{
+    long long record = static_cast<long long>(sample) * num_fields + field;
+
+    return HeaderSize(num_fields) + record * global_size * sizeof(double);
+}
+
+std::vector<char> MakeHeader(int global_size, const std::vector<std::string>& fields)
+{
+    const int num_fields = fields.size();
+    const int32_t header_ints[2] = {version, num_fields};
+    const int64_t file_global_size = global_size;
+
+    std::vector<char> header(HeaderSize(num_fields), 0);
+
+    std::memcpy(&header[0], magic, sizeof(magic));
+    std::memcpy(&header[8], header_ints, sizeof(header_ints));
+    std::memcpy(&header[16], &file_global_size, sizeof(file_global_size));
+
+    for (int i = 0; i < num_fields; ++i)
+    {
+        if (fields[i].empty() || static_cast<int>(fields[i].size()) >= name_size)
+        {
+            throw std::runtime_error("Invalid sample field name: " + fields[i]);
+        }
+
+        std::memcpy(&header[HeaderSize(i)], fields[i].data(), fields[i].size());
+    }
+
+    return header;
+}
+} // namespace
+
+SampleWriter::SampleWriter(MPI_Comm comm, const std::string& filename, int global_size,
+                           std::vector<int> local_to_global, std::vector<std::string> fields,
+                           bool truncate)
+    : comm_(comm), filename_(filename), global_size_(global_size),
+      fields_(std::move(fields))
+{
+    assert(global_size_ > 0);
+    assert(fields_.size() > 0);
+
+    int myid;
+    int num_procs;
+    MPI_Comm_size(comm_, &num_procs);
+    MPI_Comm_rank(comm_, &myid);
+
+    std::vector<char> header = MakeHeader(global_size_, fields_);
+
+    if (MPI_File_open(comm_, filename_.c_str(), MPI_MODE_CREATE | MPI_MODE_RDWR,
+                      MPI_INFO_NULL, &file_) != MPI_SUCCESS)
+    {
+        throw std::runtime_error("Unable to open file: " + filename_);
+    }
+
+    if (truncate)
+    {
+        MPI_File_set_size(file_, 0);
+    }
+
+    int valid = 1;
+
+    if (myid == 0)
+    {
+        MPI_Offset file_size;
+        MPI_File_get_size(file_, &file_size);
+
+        if (file_size == 0)
+        {
+            MPI_File_write_at(file_, 0, header.data(), header.size(), MPI_CHAR,
+                              MPI_STATUS_IGNORE);
+        }
+        else
+        {
+            std::vector<char> file_header(header.size(), 0);
+
+            if (file_size >= static_cast<MPI_Offset>(header.size()))
+            {
+                MPI_File_read_at(file_, 0, file_header.data(), file_header.size(), MPI_CHAR,
+                                 MPI_STATUS_IGNORE);
+            }
+
+            valid = file_header == header;
+        }
+    }
+
+    MPI_Bcast(&valid, 1, MPI_INT, 0, comm_);
+
+    if (!valid)
+    {
+        MPI_File_close(&file_);
+        throw std::runtime_error("Sample store has different fields or size: " + filename_);
+    }
+
+    // Plan the exchange of local entries to the owners of their blocks
+    int local_size = local_to_global.size();
+
+    std::vector<int> owner(local_size);
+    send_counts_.resize(num_procs, 0);
+
+    for (int i = 0; i < local_size; ++i)
+    {
+        owner[i] = BlockOwner(global_size_, num_procs, local_to_global[i]);
+        send_counts_[owner[i]]++;
+    }
+
+    send_offsets_.resize(num_procs + 1, 0);
+    std::partial_sum(std::begin(send_counts_), std::end(send_counts_),
+                     std::begin(send_offsets_) + 1);
+
+    std::vector<int> position(std::begin(send_offsets_), std::end(send_offsets_) - 1);
+    std::vector<std::vector<int>> send_indices(num_procs);
+
+    send_order_.resize(local_size);
+
+    for (int i = 0; i < local_size; ++i)
+    {
+        send_order_[position[owner[i]]++] = i;
+        send_indices[owner[i]].push_back(local_to_global[i]);
+    }
+
+    auto recv_indices = Exchange(comm_, send_indices, MPI_INT);
+
+    block_begin_ = BlockStart(global_size_, num_procs, myid);
+    block_size_ = BlockStart(global_size_, num_procs, myid + 1) - block_begin_;
+
+    recv_counts_.resize(num_procs);
+    recv_offsets_.resize(num_procs + 1, 0);
+
+    for (int proc = 0; proc < num_procs; ++proc)
+    {
+        recv_counts_[proc] = recv_indices[proc].size();
+        recv_offsets_[proc + 1] = recv_offsets_[proc] + recv_counts_[proc];
+
+        for (auto index : recv_indices[proc])
+        {
+            recv_indices_.push_back(index - block_begin_);
+        }
+    }
+}
+
+SampleWriter::~SampleWriter() noexcept
+{
+    MPI_File_close(&file_);
+}
+
+void SampleWriter::WriteRecord(int sample, int field, const std::vector<double>& vect)
+{
+    assert(sample >= 0);
+
+    std::vector<double> recv_values(recv_indices_.size());
+
+    MPI_Alltoallv(vect.data(), send_counts_.data(), send_offsets_.data(), MPI_DOUBLE,
+                  recv_values.data(), recv_counts_.data(), recv_offsets_.data(), MPI_DOUBLE,
+                  comm_);
+
+    std::vector<double> block(block_size_, 0.0);
+
+    int num_recv = recv_indices_.size();
+
+    for (int i = 0; i < num_recv; ++i)
+    {
+        block[recv_indices_[i]] += recv_values[i];
+    }
+
+    MPI_Offset offset = RecordOffset(fields_.size(), global_size_, sample, field) +
+                        sizeof(double) * static_cast<MPI_Offset>(block_begin_);
+
+    if (MPI_File_write_at_all(file_, offset, block.data(), block_size_, MPI_DOUBLE,
+                              MPI_STATUS_IGNORE) != MPI_SUCCESS)
+    {
+        throw std::runtime_error("Error writing file: " + filename_);
+    }
+}
+
+SampleReader::SampleReader(const std::string& filename)
+    : filename_(filename), in_(filename, std::ios::binary)
+{
+    if (!in_)
+    {
+        throw std::runtime_error("Unable to open file: " + filename_);
+    }
+
+    char file_magic[sizeof(magic)];
+    int32_t header_ints[2];
+    int64_t file_global_size;
+
+    in_.read(file_magic, sizeof(file_magic));
+    in_.read(reinterpret_cast<char*>(header_ints), sizeof(header_ints));
+    in_.read(reinterpret_cast<char*>(&file_global_size), sizeof(file_global_size));
+
+    if (!in_ || std::memcmp(file_magic, magic, sizeof(magic)) != 0 ||
+            header_ints[0] != version || header_ints[1] <= 0)
+    {
+        throw std::runtime_error("Not a GAUSS sample store, or unsupported version: " + filename_);
+    }
+
+    global_size_ = file_global_size;
+    fields_.resize(header_ints[1]);
+
+    for (auto& field : fields_)
+    {
+        char name[name_size];
+        in_.read(name, name_size);
+
+        field.assign(name, strnlen(name, name_size));
+    }
+
+    if (!in_)
+    {
+        throw std::runtime_error("Error reading file: " + filename_);
+    }
+}
+
+int SampleReader::NumSamples()
+{
+    in_.clear();
+    in_.seekg(0, std::ios::end);
+
+    long long file_size = in_.tellg();
+    long long sample_size = RecordOffset(fields_.size(), global_size_, 1, 0) -
+                            HeaderSize(fields_.size());
+
+    return (file_size - HeaderSize(fields_.size())) / sample_size;
+}
+
+Vector SampleReader::Read(int sample, const std::string& field)
+{
+    std::vector<double> values = ReadValues(sample, field, 0, global_size_);
+
+    Vector vect(global_size_);
+
+    for (int i = 0; i < global_size_; ++i)
+    {
+        vect[i] = values[i];
+    }
+
+    return vect;
+}
+
+Vector SampleReader::Read(int sample, const std::string& field,
+                          const std::vector<int>& local_to_global)
+{
+    int local_size = local_to_global.size();
+
+    Vector local_vect(local_size);
+
+    if (local_size == 0)
+    {
+        return local_vect;
+    }
+
+    // Read the range covering the local entries
+    auto range = std::minmax_element(std::begin(local_to_global), std::end(local_to_global));
+    int begin = *range.first;
+    int end = *range.second + 1;
+
+    std::vector<double> values = ReadValues(sample, field, begin, end);
+
+    for (int i = 0; i < local_size; ++i)
+    {
+        local_vect[i] = values[local_to_global[i] - begin];
+    }
+
+    return local_vect;
+}
+
+std::vector<double> SampleReader::ReadValues(int sample, const std::string& field,
+                                             int begin, int end)
+{
+    auto iter = std::find(std::begin(fields_), std::end(fields_), field);
+
+    if (iter == std::end(fields_))
+    {
+        throw std::runtime_error("Unknown field " + field + " in: " + filename_);
+    }
+
+    assert(sample >= 0);
+    assert(0 <= begin && begin <= end && end <= global_size_);
+
+    std::vector<double> values(end - begin);
+
+    long long offset = RecordOffset(fields_.size(), global_size_, sample,
+                                    iter - std::begin(fields_)) + sizeof(double) * begin;
+
+    in_.clear();
+    in_.seekg(offset);
+    in_.read(reinterpret_cast<char*>(values.data()), sizeof(double) * values.size());
+
+    if (!in_)
+    {
+        throw std::runtime_error("Sample " + std::to_string(sample) + " of " + field +
+                                 " not found in: " + filename_);
+    }
+
+    return values;
+}
+
+} // namespace gauss
@@ -27,10 +27,13 @@
    operation onto the master, where the user is responsible to do what is
    necessary.
 
+   All entities going to the same neighbor are packed into one buffer of
+   ints and one of doubles, so each pair of neighbors exchanges a fixed
+   number of messages per collective regardless of how many entities they share.
+
    This is "fairly" generic but not completely, if you want to use for a
-   datatype other than DenseMatrix or Vector you need to implement:
-   SetSizeSpecifer(), PackSizes(), SendData(), ReceiveData(), and CopyData()
-   routines yourself.
+   datatype other than DenseMatrix, SparseMatrix or Vector you need to
+   implement the PackData() and UnpackData() routines yourself.
 
    Significant improvements to handling the "tags" argument to honor the
    MPI_TAG_UB constraint are due to Alex Druinsky from Lawrence Berkeley
@@ -42,159 +45,449 @@
 namespace gauss
 {
 
-template<>
-void SharedEntityComm<Vector>::SetSizeSpecifier()
+SharedEntityPlan::SharedEntityPlan(const ParMatrix& entity_true_entity)
+    : comm_(entity_true_entity.GetComm()),
+      myid_(entity_true_entity.GetMyId()),
+      num_entities_(entity_true_entity.Rows()),
+      true_entity_begin_(entity_true_entity.GetColStarts()[0]),
+      entity_master_(num_entities_),
+      true_entity_(num_entities_),
+      owned_entity_(entity_true_entity.Cols(), -1),
+      num_master_comms_(0),
+      num_slave_comms_(0)
 {
-    size_specifier_ = 1;
+    MakeEntityProc(entity_true_entity);
+
+    const auto& ete_diag = entity_true_entity.GetDiag();
+    const auto& ete_diag_indptr = ete_diag.GetIndptr();
+    const auto& ete_diag_indices = ete_diag.GetIndices();
+
+    const auto& ete_offd = entity_true_entity.GetOffd();
+    const auto& ete_offd_indptr = ete_offd.GetIndptr();
+    const auto& ete_offd_indices = ete_offd.GetIndices();
+    const auto& ete_colmap = entity_true_entity.GetColMap();
+
+    for (int i = 0; i < num_entities_; ++i)
+    {
+        if (entity_master_[i] == myid_)
+        {
+            int true_entity = ete_diag_indices[ete_diag_indptr[i]];
+
+            true_entity_[i] = true_entity_begin_ + true_entity;
+            owned_entity_[true_entity] = i;
+
+            num_master_comms_ += entity_proc_.RowSize(i) - 1; // -1 for myself
+
+            for (auto proc : entity_proc_.GetIndices(i))
+            {
+                if (proc != myid_)
+                {
+                    slave_procs_.push_back(proc);
+                }
+            }
+        }
+        else
+        {
+            true_entity_[i] = ete_colmap[ete_offd_indices[ete_offd_indptr[i]]];
+            shared_entity_[true_entity_[i]] = i;
+
+            num_slave_comms_++;
+            master_procs_.push_back(entity_master_[i]);
+        }
+    }
+
+    for (auto procs : {&master_procs_, &slave_procs_})
+    {
+        std::sort(std::begin(*procs), std::end(*procs));
+        procs->erase(std::unique(std::begin(*procs), std::end(*procs)), std::end(*procs));
+    }
+
+    size_slots_.resize(num_slots_);
+
+    for (int slot = 0; slot < num_slots_; ++slot)
+    {
+        InitSizeRequests(slot, Direction::Reduce);
+        InitSizeRequests(slot, Direction::Broadcast);
+    }
 }
 
-template<>
-void SharedEntityComm<std::vector<double>>::SetSizeSpecifier()
+SharedEntityPlan::~SharedEntityPlan() noexcept
 {
-    size_specifier_ = 1;
+    int finalized;
+    MPI_Finalized(&finalized);
+
+    if (finalized)
+    {
+        return;
+    }
+
+    for (auto& slot : size_slots_)
+    {
+        for (auto& requests : slot.requests)
+        {
+            for (auto& request : requests)
+            {
+                MPI_Request_free(&request);
+            }
+        }
+    }
 }
 
-template<>
-void SharedEntityComm<DenseMatrix>::SetSizeSpecifier()
+void SharedEntityPlan::InitSizeRequests(int slot, Direction direction)
 {
-    size_specifier_ = 2;
+    const auto& send_procs = SendProcs(direction);
+    const auto& recv_procs = RecvProcs(direction);
+
+    const int num_sends = send_procs.size();
+    const int num_recvs = recv_procs.size();
+
+    const int dir = static_cast<int>(direction);
+    const int tag = NUM_ENTITY_TAGS * slot + ENTITY_HEADER_TAG;
+
+    SizeSlot& sizes = size_slots_[slot];
+
+    sizes.send_sizes[dir].resize(2 * num_sends);
+    sizes.recv_sizes[dir].resize(2 * num_recvs);
+    sizes.requests[dir].resize(num_recvs + num_sends);
+
+    for (int i = 0; i < num_recvs; ++i)
+    {
+        MPI_Recv_init(&sizes.recv_sizes[dir][2 * i], 2, MPI_INT, recv_procs[i],
+                      tag, comm_, &sizes.requests[dir][i]);
+    }
+
+    for (int i = 0; i < num_sends; ++i)
+    {
+        MPI_Send_init(&sizes.send_sizes[dir][2 * i], 2, MPI_INT, send_procs[i],
+                      tag, comm_, &sizes.requests[dir][num_recvs + i]);
+    }
 }
 
-template<>
-void SharedEntityComm<SparseMatrix>::SetSizeSpecifier()
+void SharedEntityPlan::MakeEntityProc(const ParMatrix& entity_true_entity)
 {
-    size_specifier_ = 3;
+    linalgcpp::ParCommPkg comm_pkg = entity_true_entity.MakeCommPkg();
+
+    const auto& send_starts = comm_pkg.send_map_starts_;
+    const auto& recv_starts = comm_pkg.recv_vec_starts_;
+
+    // Processors each owned true entity is sent to
+    std::vector<std::vector<int>> true_entity_procs(entity_true_entity.Cols());
+
+    for (int send = 0; send < comm_pkg.num_sends_; ++send)
+    {
+        int proc = comm_pkg.send_procs_[send];
+
+        for (int j = send_starts[send]; j < send_starts[send + 1]; ++j)
+        {
+            true_entity_procs[comm_pkg.send_map_elmts_[j]].push_back(proc);
+        }
+    }
+
+    // Processor each shared true entity is received from
+    std::vector<int> shared_entity_proc(entity_true_entity.GetOffd().Cols(), -1);
+
+    for (int recv = 0; recv < comm_pkg.num_recvs_; ++recv)
+    {
+        for (int k = recv_starts[recv]; k < recv_starts[recv + 1]; ++k)
+        {
+            shared_entity_proc[k] = comm_pkg.recv_procs_[recv];
+        }
+    }
+
+    const auto& ete_diag = entity_true_entity.GetDiag();
+    const auto& ete_diag_indptr = ete_diag.GetIndptr();
+    const auto& ete_diag_indices = ete_diag.GetIndices();
+
+    const auto& ete_offd = entity_true_entity.GetOffd();
+    const auto& ete_offd_indptr = ete_offd.GetIndptr();
+    const auto& ete_offd_indices = ete_offd.GetIndices();
+
+    linalgcpp::CooMatrix<int> entity_proc;
+
+    for (int entity = 0; entity < num_entities_; ++entity)
+    {
+        int offd_size = ete_offd.RowSize(entity);
+
+        entity_master_[entity] = myid_;
+        entity_proc.Add(entity, myid_, 1);
+
+        if (offd_size == 0)
+        {
+            assert(ete_diag.RowSize(entity) == 1);
+
+            int true_entity = ete_diag_indices[ete_diag_indptr[entity]];
+
+            for (auto proc : true_entity_procs[true_entity])
+            {
+                entity_proc.Add(entity, proc, 1);
+            }
+        }
+        else
+        {
+            assert(ete_diag.RowSize(entity) == 0 && offd_size == 1);
+
+            int shared_entity = ete_offd_indices[ete_offd_indptr[entity]];
+            int proc = shared_entity_proc[shared_entity];
+
+            assert(proc >= 0);
+
+            entity_proc.Add(entity, proc, 1);
+
+            if (proc < entity_master_[entity])
+            {
+                entity_master_[entity] = proc;
+            }
+        }
+    }
+
+    entity_proc_ = entity_proc.ToSparse();
 }
 
-template<>
-std::vector<int>
-SharedEntityComm<Vector>::PackSendSize(const Vector& vect) const
+bool SharedEntityPlan::IsOwnedByMe(int entity) const
 {
-    return std::vector<int> {static_cast<int>(vect.size())};
+    assert(entity >= 0);
+    assert(entity < num_entities_);
+
+    return (entity_master_[entity] == myid_);
 }
 
-template<>
-std::vector<int>
-SharedEntityComm<std::vector<double>>::PackSendSize(const std::vector<double>& vect) const
+int SharedEntityPlan::GetEntity(int true_entity) const
+{
+    int owned = true_entity - true_entity_begin_;
+
+    if (owned >= 0 && owned < static_cast<int>(owned_entity_.size()))
+    {
+        return owned_entity_[owned];
+    }
+
+    return shared_entity_.at(true_entity);
+}
+
+const std::vector<int>& SharedEntityPlan::SendProcs(Direction direction) const
 {
-    return std::vector<int> {static_cast<int>(vect.size())};
+    return direction == Direction::Reduce ? master_procs_ : slave_procs_;
 }
 
-template<>
-std::vector<int>
-SharedEntityComm<DenseMatrix>::PackSendSize(const DenseMatrix& mat) const
+const std::vector<int>& SharedEntityPlan::RecvProcs(Direction direction) const
 {
-    return std::vector<int> {mat.Rows(), mat.Cols()};
+    return direction == Direction::Reduce ? slave_procs_ : master_procs_;
 }
 
-template<>
-std::vector<int>
-SharedEntityComm<SparseMatrix>::PackSendSize(const SparseMatrix& mat) const
+int SharedEntityPlan::SendIndex(Direction direction, int proc) const
 {
-    return std::vector<int> {mat.Rows(), mat.Cols(), mat.nnz()};
+    const auto& procs = SendProcs(direction);
+
+    auto iter = std::lower_bound(std::begin(procs), std::end(procs), proc);
+
+    assert(iter != std::end(procs) && *iter == proc);
+
+    return iter - std::begin(procs);
 }
 
-template<>
-void
-SharedEntityComm<Vector>::SendData(const Vector& vect,
-                                   int recipient, int tag, MPI_Request& request) const
+void SharedEntityPlan::Exchange(Direction direction,
+                                const std::vector<std::vector<int>>& send_ints,
+                                const std::vector<std::vector<double>>& send_doubles,
+                                std::vector<std::vector<int>>& recv_ints,
+                                std::vector<std::vector<double>>& recv_doubles)
+{
+    PendingExchange pending;
+
+    ExchangeBegin(direction, send_ints, send_doubles, pending);
+    ExchangeEnd(pending, recv_ints, recv_doubles);
+}
+
+void SharedEntityPlan::ExchangeBegin(Direction direction,
+                                     const std::vector<std::vector<int>>& send_ints,
+                                     const std::vector<std::vector<double>>& send_doubles,
+                                     PendingExchange& pending)
+{
+    const auto& send_procs = SendProcs(direction);
+    const auto& recv_procs = RecvProcs(direction);
+
+    const int num_sends = send_procs.size();
+    const int num_recvs = recv_procs.size();
+
+    assert(static_cast<int>(send_ints.size()) == num_sends);
+    assert(static_cast<int>(send_doubles.size()) == num_sends);
+
+    const int slot = num_exchanges_++ % num_slots_;
+    const int dir = static_cast<int>(direction);
+    const int tag = NUM_ENTITY_TAGS * slot;
+
+    SizeSlot& sizes = size_slots_[slot];
+
+    if (sizes.in_flight)
+    {
+        throw std::runtime_error("Too many shared entity exchanges in flight!");
+    }
+
+    sizes.in_flight = true;
+
+    pending.direction = direction;
+    pending.slot = slot;
+    pending.requests.assign(2 * (num_recvs + num_sends), MPI_REQUEST_NULL);
+
+    for (int i = 0; i < num_sends; ++i)
+    {
+        sizes.send_sizes[dir][2 * i] = send_ints[i].size();
+        sizes.send_sizes[dir][2 * i + 1] = send_doubles[i].size();
+    }
+
+    MPI_Startall(sizes.requests[dir].size(), sizes.requests[dir].data());
+
+    // Buffer sends do not wait for the sizes, the buffer receives do
+    for (int i = 0; i < num_sends; ++i)
+    {
+        MPI_Isend(send_ints[i].data(), send_ints[i].size(), MPI_INT, send_procs[i],
+                  tag + ENTITY_INT_TAG, comm_,
+                  &pending.requests[2 * (num_recvs + i)]);
+        MPI_Isend(send_doubles[i].data(), send_doubles[i].size(), MPI_DOUBLE, send_procs[i],
+                  tag + ENTITY_DOUBLE_TAG, comm_,
+                  &pending.requests[2 * (num_recvs + i) + 1]);
+    }
+}
+
+void SharedEntityPlan::ExchangeEnd(PendingExchange& pending,
+                                   std::vector<std::vector<int>>& recv_ints,
+                                   std::vector<std::vector<double>>& recv_doubles)
 {
-    MPI_Isend(std::begin(vect), vect.size(), MPI_DOUBLE,
-              recipient, tag, comm_, &request);
+    const auto& recv_procs = RecvProcs(pending.direction);
+    const int num_recvs = recv_procs.size();
+
+    const int dir = static_cast<int>(pending.direction);
+    const int tag = NUM_ENTITY_TAGS * pending.slot;
+
+    SizeSlot& sizes = size_slots_[pending.slot];
+    auto& size_requests = sizes.requests[dir];
+    const auto& recv_sizes = sizes.recv_sizes[dir];
+
+    assert(sizes.in_flight);
+
+    recv_ints.resize(num_recvs);
+    recv_doubles.resize(num_recvs);
+
+    // Post each buffer receive as soon as its size arrives
+    for (int received = 0; received < num_recvs; ++received)
+    {
+        int i;
+        MPI_Waitany(num_recvs, size_requests.data(), &i, MPI_STATUS_IGNORE);
+
+        assert(i >= 0 && i < num_recvs);
+
+        recv_ints[i].resize(recv_sizes[2 * i]);
+        recv_doubles[i].resize(recv_sizes[2 * i + 1]);
+
+        MPI_Irecv(recv_ints[i].data(), recv_ints[i].size(), MPI_INT, recv_procs[i],
+                  tag + ENTITY_INT_TAG, comm_, &pending.requests[2 * i]);
+        MPI_Irecv(recv_doubles[i].data(), recv_doubles[i].size(), MPI_DOUBLE, recv_procs[i],
+                  tag + ENTITY_DOUBLE_TAG, comm_, &pending.requests[2 * i + 1]);
+    }
+
+    MPI_Waitall(size_requests.size(), size_requests.data(), MPI_STATUSES_IGNORE);
+    MPI_Waitall(pending.requests.size(), pending.requests.data(), MPI_STATUSES_IGNORE);
+
+    sizes.in_flight = false;
 }
 
 template<>
-void
-SharedEntityComm<std::vector<double>>::SendData(const std::vector<double>& vect,
-                                                int recipient, int tag, MPI_Request& request) const
+void SharedEntityComm<Vector>::PackData(const Vector& vect, std::vector<int>& ints,
+                                        std::vector<double>& doubles) const
 {
-    MPI_Isend(vect.data(), vect.size(), MPI_DOUBLE,
-              recipient, tag, comm_, &request);
+    ints.push_back(vect.size());
+    doubles.insert(std::end(doubles), std::begin(vect), std::end(vect));
 }
 
 template<>
-void
-SharedEntityComm<DenseMatrix>::SendData(const DenseMatrix& mat,
-                                        int recipient, int tag, MPI_Request& request) const
+void SharedEntityComm<std::vector<double>>::PackData(const std::vector<double>& vect,
+                                                     std::vector<int>& ints,
+                                                     std::vector<double>& doubles) const
 {
-    MPI_Isend(mat.GetData(), mat.Rows() * mat.Cols(), MPI_DOUBLE,
-              recipient, tag, comm_, &request);
+    ints.push_back(vect.size());
+    doubles.insert(std::end(doubles), std::begin(vect), std::end(vect));
 }
 
 template<>
-void
-SharedEntityComm<SparseMatrix>::SendData(const SparseMatrix& mat,
-                                         int recipient, int tag, MPI_Request& request) const
+void SharedEntityComm<DenseMatrix>::PackData(const DenseMatrix& mat, std::vector<int>& ints,
+                                             std::vector<double>& doubles) const
 {
-    MPI_Isend(mat.GetIndptr().data(), mat.Rows() + 1, MPI_INT,
-              recipient, tag, comm_, &request);
-    MPI_Isend(mat.GetIndices().data(), mat.nnz(), MPI_INT,
-              recipient, tag + 1, comm_, &request);
-    MPI_Isend(mat.GetData().data(), mat.nnz(), MPI_DOUBLE,
-              recipient, tag + 2, comm_, &request);
+    const int size = mat.Rows() * mat.Cols();
+
+    ints.push_back(mat.Rows());
+    ints.push_back(mat.Cols());
+    doubles.insert(std::end(doubles), mat.GetData(), mat.GetData() + size);
 }
 
 template<>
-Vector SharedEntityComm<Vector>::ReceiveData(const std::vector<int>& sizes, int sender, int tag,
-                                             MPI_Request& request) const
+void SharedEntityComm<SparseMatrix>::PackData(const SparseMatrix& mat, std::vector<int>& ints,
+                                              std::vector<double>& doubles) const
 {
-    const int size = sizes[0];
+    const auto& indptr = mat.GetIndptr();
+    const auto& indices = mat.GetIndices();
+    const auto& data = mat.GetData();
+
+    ints.push_back(mat.Rows());
+    ints.push_back(mat.Cols());
+    ints.push_back(mat.nnz());
+    ints.insert(std::end(ints), std::begin(indptr), std::end(indptr));
+    ints.insert(std::end(ints), std::begin(indices), std::end(indices));
+    doubles.insert(std::end(doubles), std::begin(data), std::end(data));
+}
 
-    Vector vect(size);
+template<>
+Vector SharedEntityComm<Vector>::UnpackData(const int*& ints, const double*& doubles) const
+{
+    const int size = *ints++;
 
-    MPI_Irecv(std::begin(vect), size, MPI_DOUBLE,
-              sender, tag, comm_, &request);
+    Vector vect(std::vector<double>(doubles, doubles + size));
+    doubles += size;
 
     return vect;
 }
 
 template<>
 std::vector<double>
-SharedEntityComm<std::vector<double>>::ReceiveData(const std::vector<int>& sizes, int sender,
-                                                   int tag, MPI_Request& request) const
+SharedEntityComm<std::vector<double>>::UnpackData(const int*& ints,
+                                                  const double*& doubles) const
 {
-    const int size = sizes[0];
-
-    std::vector<double> vect(size);
+    const int size = *ints++;
 
-    MPI_Irecv(vect.data(), size, MPI_DOUBLE,
-              sender, tag, comm_, &request);
+    std::vector<double> vect(doubles, doubles + size);
+    doubles += size;
 
     return vect;
 }
 
 template<>
-DenseMatrix SharedEntityComm<DenseMatrix>::ReceiveData(const std::vector<int>& sizes, int sender,
-                                                       int tag, MPI_Request& request) const
+DenseMatrix SharedEntityComm<DenseMatrix>::UnpackData(const int*& ints,
+                                                      const double*& doubles) const
 {
-    const int rows = sizes[0];
-    const int cols = sizes[1];
+    const int rows = *ints++;
+    const int cols = *ints++;
 
     const int size = rows * cols;
 
-    std::vector<double> data(size);
-
-    MPI_Irecv(data.data(), size, MPI_DOUBLE,
-              sender, tag, comm_, &request);
+    std::vector<double> data(doubles, doubles + size);
+    doubles += size;
 
     return DenseMatrix(rows, cols, std::move(data));
 }
 
 template<>
-SparseMatrix SharedEntityComm<SparseMatrix>::ReceiveData(const std::vector<int>& sizes, int sender,
-                                                         int tag, MPI_Request& request) const
+SparseMatrix SharedEntityComm<SparseMatrix>::UnpackData(const int*& ints,
+                                                        const double*& doubles) const
 {
-    const int rows = sizes[0];
-    const int cols = sizes[1];
-    const int nnz = sizes[2];
+    const int rows = *ints++;
+    const int cols = *ints++;
+    const int nnz = *ints++;
+
+    std::vector<int> indptr(ints, ints + rows + 1);
+    ints += rows + 1;
 
-    std::vector<int> indptr(rows + 1);
-    std::vector<int> indices(nnz);
-    std::vector<double> data(nnz);
+    std::vector<int> indices(ints, ints + nnz);
+    ints += nnz;
 
-    MPI_Irecv(indptr.data(), rows + 1, MPI_INT, sender, tag, comm_, &request);
-    MPI_Irecv(indices.data(), nnz, MPI_INT, sender, tag + 1, comm_, &request);
-    MPI_Irecv(data.data(), nnz, MPI_DOUBLE, sender, tag + 2, comm_, &request);
+    std::vector<double> data(doubles, doubles + nnz);
+    doubles += nnz;
 
     return SparseMatrix(std::move(indptr), std::move(indices), std::move(data), rows, cols);
 }
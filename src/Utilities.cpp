@@ -20,7 +20,14 @@
     These are implemented with and operate on linalgcpp data structures.
 */
 
+#include <sstream>
+
 #include "Utilities.hpp"
+#include "GraphFile.hpp"
+
+#if GAUSS_USE_OPENMP
+#include <omp.h>
+#endif
 
 namespace gauss
 {
@@ -33,6 +40,56 @@ int MyId(MPI_Comm comm)
     return myid;
 }
 
+int NumProcs(MPI_Comm comm)
+{
+    int num_procs;
+    MPI_Comm_size(comm, &num_procs);
+
+    return num_procs;
+}
+
+void ParSum(MPI_Comm comm, double* vals, int count)
+{
+    if (NumProcs(comm) > 1)
+    {
+        MPI_Allreduce(MPI_IN_PLACE, vals, count, MPI_DOUBLE, MPI_SUM, comm);
+    }
+}
+
+double ParNorm(MPI_Comm comm, const VectorView& vect)
+{
+    const int size = vect.size();
+
+    double norm_sq = 0.0;
+
+    for (int i = 0; i < size; ++i)
+    {
+        norm_sq += vect[i] * vect[i];
+    }
+
+    ParSum(comm, &norm_sq, 1);
+
+    return std::sqrt(norm_sq);
+}
+
+int NumThreads()
+{
+#if GAUSS_USE_OPENMP
+    return omp_get_max_threads();
+#else
+    return 1;
+#endif
+}
+
+int ThreadId()
+{
+#if GAUSS_USE_OPENMP
+    return omp_get_thread_num();
+#else
+    return 0;
+#endif
+}
+
 ParMatrix MakeEdgeTrueEdge(MPI_Comm comm, const SparseMatrix& proc_edge,
                            const std::vector<int>& edge_map)
 {
@@ -55,7 +112,6 @@ ParMatrix MakeEdgeTrueEdge(MPI_Comm comm, const SparseMatrix& proc_edge,
     }
 
     int num_tedges_local = tedge_counter[myid + 1];
-    int num_edge_diff = num_edges_local - num_tedges_local;
     std::partial_sum(std::begin(tedge_counter), std::end(tedge_counter),
                      std::begin(tedge_counter));
 
@@ -68,11 +124,23 @@ ParMatrix MakeEdgeTrueEdge(MPI_Comm comm, const SparseMatrix& proc_edge,
         edge_perm[i] = tedge_counter[edge_proc.GetIndices(i)[0]]++;
     }
 
-    for (int i = num_procs - 1; i > 0; i--)
+    std::vector<HYPRE_Int> edge_tedge(num_edges_local);
+
+    for (int i = 0; i < num_edges_local; ++i)
     {
-        tedge_counter[i] = tedge_counter[i - 1];
+        edge_tedge[i] = edge_perm[edge_map[i]];
     }
-    tedge_counter[0] = 0;
+
+    return MakeEdgeTrueEdge(comm, edge_tedge, num_tedges_local);
+}
+
+ParMatrix MakeEdgeTrueEdge(MPI_Comm comm, const std::vector<HYPRE_Int>& edge_tedge,
+                           int num_tedges_local)
+{
+    int num_edges_local = edge_tedge.size();
+    int num_edge_diff = num_edges_local - num_tedges_local;
+
+    auto starts = linalgcpp::GenerateOffsets(comm, {num_edges_local, num_tedges_local});
 
     std::vector<int> diag_indptr(num_edges_local + 1);
     std::vector<int> diag_indices(num_tedges_local);
@@ -87,15 +155,15 @@ ParMatrix MakeEdgeTrueEdge(MPI_Comm comm, const SparseMatrix& proc_edge,
     diag_indptr[0] = 0;
     offd_indptr[0] = 0;
 
-    int tedge_begin = tedge_counter[myid];
-    int tedge_end = tedge_counter[myid + 1];
+    HYPRE_Int tedge_begin = starts[1][0];
+    HYPRE_Int tedge_end = starts[1][1];
 
     int diag_counter = 0;
     int offd_counter = 0;
 
     for (int i = 0; i < num_edges_local; ++i)
     {
-        int tedge = edge_perm[edge_map[i]];
+        HYPRE_Int tedge = edge_tedge[i];
 
         if ((tedge >= tedge_begin) && (tedge < tedge_end))
         {
@@ -112,6 +180,7 @@ ParMatrix MakeEdgeTrueEdge(MPI_Comm comm, const SparseMatrix& proc_edge,
         offd_indptr[i + 1] = offd_counter;
     }
 
+    assert(diag_counter == num_tedges_local);
     assert(offd_counter == static_cast<int>(num_edge_diff));
 
     auto compare = [] (const std::pair<HYPRE_Int, int>& lhs,
@@ -128,8 +197,6 @@ ParMatrix MakeEdgeTrueEdge(MPI_Comm comm, const SparseMatrix& proc_edge,
         col_map[i] = offd_map[i].first;
     }
 
-    auto starts = linalgcpp::GenerateOffsets(comm, {num_edges_local, num_tedges_local});
-
     SparseMatrix diag(std::move(diag_indptr), std::move(diag_indices), std::move(diag_data),
                       num_edges_local, num_tedges_local);
 
@@ -730,6 +797,28 @@ void BroadCast(MPI_Comm comm, SparseMatrix& mat)
     }
 }
 
+int BlockStart(int size, int num_procs, int proc)
+{
+    return (static_cast<long long>(size) * proc) / num_procs;
+}
+
+int BlockOwner(int size, int num_procs, int index)
+{
+    int proc = (static_cast<long long>(index) * num_procs) / size;
+
+    while (BlockStart(size, num_procs, proc + 1) <= index)
+    {
+        proc++;
+    }
+
+    while (BlockStart(size, num_procs, proc) > index)
+    {
+        proc--;
+    }
+
+    return proc;
+}
+
 //TODO(gelever1): Define this inplace in linalgcpp
 SparseMatrix Add(double alpha, const SparseMatrix& A, double beta, const SparseMatrix& B)
 {
@@ -878,6 +967,11 @@ std::vector<int> PartitionPostIsolate(const SparseMatrix& A, std::vector<int> pa
 Vector ReadVector(const std::string& filename,
                   const std::vector<int>& local_to_global)
 {
+    if (IsGraphFile(filename))
+    {
+        return GraphFileReader(filename).ReadVector(local_to_global);
+    }
+
     std::vector<double> global_vect = linalgcpp::ReadText(filename);
 
     int local_size = local_to_global.size();
@@ -892,6 +986,90 @@ Vector ReadVector(const std::string& filename,
     return local_vect;
 }
 
+void WriteDistributedVector(MPI_Comm comm, const std::vector<double>& vect,
+                            const std::string& filename, int global_size,
+                            const std::vector<int>& local_to_global)
+{
+    assert(vect.size() == local_to_global.size());
+
+    int myid;
+    int num_procs;
+    MPI_Comm_size(comm, &num_procs);
+    MPI_Comm_rank(comm, &myid);
+
+    std::vector<std::vector<int>> send_indices(num_procs);
+    std::vector<std::vector<double>> send_values(num_procs);
+
+    int local_size = local_to_global.size();
+
+    for (int i = 0; i < local_size; ++i)
+    {
+        int owner = BlockOwner(global_size, num_procs, local_to_global[i]);
+
+        send_indices[owner].push_back(local_to_global[i]);
+        send_values[owner].push_back(vect[i]);
+    }
+
+    auto recv_indices = Exchange(comm, send_indices, MPI_INT);
+    auto recv_values = Exchange(comm, send_values, MPI_DOUBLE);
+
+    int block_begin = BlockStart(global_size, num_procs, myid);
+    int block_end = BlockStart(global_size, num_procs, myid + 1);
+
+    std::vector<double> block(block_end - block_begin, 0.0);
+
+    for (int proc = 0; proc < num_procs; ++proc)
+    {
+        int num_recv = recv_indices[proc].size();
+
+        for (int i = 0; i < num_recv; ++i)
+        {
+            block[recv_indices[proc][i] - block_begin] += recv_values[proc][i];
+        }
+    }
+
+    std::ostringstream block_stream;
+    block_stream.precision(16);
+    block_stream << std::scientific;
+
+    for (auto val : block)
+    {
+        block_stream << val << "\n";
+    }
+
+    std::string block_text = block_stream.str();
+
+    long long block_bytes = block_text.size();
+    long long offset = 0;
+
+    MPI_Exscan(&block_bytes, &offset, 1, MPI_LONG_LONG, MPI_SUM, comm);
+
+    if (myid == 0)
+    {
+        offset = 0;
+    }
+
+    MPI_File file;
+
+    if (MPI_File_open(comm, filename.c_str(), MPI_MODE_CREATE | MPI_MODE_WRONLY,
+                      MPI_INFO_NULL, &file) != MPI_SUCCESS)
+    {
+        throw std::runtime_error("Unable to open file: " + filename);
+    }
+
+    MPI_File_set_size(file, 0);
+
+    int error = MPI_File_write_at_all(file, offset, &block_text[0], block_bytes,
+                                      MPI_CHAR, MPI_STATUS_IGNORE);
+
+    MPI_File_close(&file);
+
+    if (error != MPI_SUCCESS)
+    {
+        throw std::runtime_error("Error writing file: " + filename);
+    }
+}
+
 std::vector<int> GetElementColoring(const SparseMatrix& el_el)
 {
     int num_el = el_el.Rows();
@@ -1106,6 +1284,97 @@ void ShiftPartition(std::vector<int>& partition)
     linalgcpp::RemoveEmpty(partition);
 }
 
+void MultiMult(const SparseMatrix& A, const std::vector<const double*>& x,
+               const std::vector<double*>& y)
+{
+    assert(x.size() == y.size());
+
+    const int num_vects = x.size();
+    const int rows = A.Rows();
+
+    const auto& indptr = A.GetIndptr();
+    const auto& indices = A.GetIndices();
+    const auto& data = A.GetData();
+
+    for (int i = 0; i < rows; ++i)
+    {
+        for (int k = 0; k < num_vects; ++k)
+        {
+            y[k][i] = 0.0;
+        }
+
+        for (int j = indptr[i]; j < indptr[i + 1]; ++j)
+        {
+            const int col = indices[j];
+            const double val = data[j];
+
+            for (int k = 0; k < num_vects; ++k)
+            {
+                y[k][i] += val * x[k][col];
+            }
+        }
+    }
+}
+
+void MultiMultAT(const SparseMatrix& A, const std::vector<const double*>& x,
+                 const std::vector<double*>& y)
+{
+    assert(x.size() == y.size());
+
+    const int num_vects = x.size();
+    const int rows = A.Rows();
+    const int cols = A.Cols();
+
+    const auto& indptr = A.GetIndptr();
+    const auto& indices = A.GetIndices();
+    const auto& data = A.GetData();
+
+    for (int k = 0; k < num_vects; ++k)
+    {
+        std::fill(y[k], y[k] + cols, 0.0);
+    }
+
+    for (int i = 0; i < rows; ++i)
+    {
+        for (int j = indptr[i]; j < indptr[i + 1]; ++j)
+        {
+            const int col = indices[j];
+            const double val = data[j];
+
+            for (int k = 0; k < num_vects; ++k)
+            {
+                y[k][col] += val * x[k][i];
+            }
+        }
+    }
+}
+
+std::vector<const double*> BlockData(const std::vector<BlockVector>& vects, int block)
+{
+    std::vector<const double*> data;
+    data.reserve(vects.size());
+
+    for (const auto& vect : vects)
+    {
+        data.push_back(vect.GetBlock(block).begin());
+    }
+
+    return data;
+}
+
+std::vector<double*> BlockData(std::vector<BlockVector>& vects, int block)
+{
+    std::vector<double*> data;
+    data.reserve(vects.size());
+
+    for (auto& vect : vects)
+    {
+        data.push_back(vect.GetBlock(block).begin());
+    }
+
+    return data;
+}
+
 
 
 } // namespace gauss
@@ -242,6 +242,119 @@ int test_fe_dense()
     return failed;
 }
 
+// vertex edge relation of a path, edge weights given by M
+void build_path_problem(int num_vertices, double weight_scale,
+                        SparseMatrix& M, SparseMatrix& D)
+{
+    int num_edges = num_vertices - 1;
+
+    CooMatrix D_coo(num_vertices, num_edges);
+    std::vector<double> M_diag(num_edges);
+
+    for (int i = 0; i < num_edges; ++i)
+    {
+        D_coo.Add(i, i, 1.0);
+        D_coo.Add(i + 1, i, -1.0);
+
+        M_diag[i] = 1.0 + weight_scale * ((i * 7) % 5);
+    }
+
+    D = D_coo.ToSparse();
+    M = SparseMatrix(std::move(M_diag));
+}
+
+int test_batched_dense()
+{
+    const int num_ev = 4;
+    const int num_per_size = 11;
+
+    std::cout << "Building batched path problems...\n";
+
+    std::vector<SparseMatrix> M;
+    std::vector<SparseMatrix> D;
+
+    // Sizes on both sides of the batched Jacobi limit
+    for (int size = 5; size <= 60; ++size)
+    {
+        for (int i = 0; i < num_per_size; ++i)
+        {
+            M.emplace_back();
+            D.emplace_back();
+
+            build_path_problem(size, 0.1 * (i + 1), M.back(), D.back());
+        }
+    }
+
+    LocalEigenSolver eigensolver(num_ev, 1.0);
+
+    std::vector<DenseMatrix> batched_evects;
+    eigensolver.BlockCompute(M, D, batched_evects);
+
+    double max_error = 0.0;
+    int num_problems = D.size();
+
+    for (int i = 0; i < num_problems; ++i)
+    {
+        DenseMatrix evects;
+        eigensolver.BlockCompute(M[i], D[i], evects);
+
+        assert(evects.Cols() == batched_evects[i].Cols());
+
+        for (int k = 0; k < evects.Cols(); ++k)
+        {
+            // Both paths use the same sign convention
+            double dot = evects.GetColView(k).Mult(batched_evects[i].GetColView(k));
+            max_error = std::max(max_error, std::fabs(1.0 - dot));
+        }
+    }
+
+    std::cout << "Batched eigenvector error: " << max_error << "\n";
+
+    bool failed = (max_error > 1e-8);
+
+    std::cout << "Batched dense Eigensolver " << (failed ? "FAILS!" : "passes.") << "\n";
+
+    return failed;
+}
+
+int test_large_block()
+{
+    const int num_dof = 60;
+    const int num_ev = 4;
+
+    std::cout << "Building large path problem...\n";
+
+    SparseMatrix M;
+    SparseMatrix D;
+    build_path_problem(num_dof, 0.25, M, D);
+
+    // Sizes 20 select the sparse solvers, num_dof the dense one
+    LocalEigenSolver sparse_solver(num_ev, 1.0, 20, 20);
+    LocalEigenSolver dense_solver(num_ev, 1.0, num_dof, num_dof);
+
+    DenseMatrix sparse_evects;
+    DenseMatrix dense_evects;
+
+    sparse_solver.BlockCompute(M, D, sparse_evects);
+    dense_solver.BlockCompute(M, D, dense_evects);
+
+    double max_error = 0.0;
+
+    for (int k = 0; k < num_ev; ++k)
+    {
+        double dot = sparse_evects.GetColView(k).Mult(dense_evects.GetColView(k));
+        max_error = std::max(max_error, 1.0 - std::fabs(dot));
+    }
+
+    std::cout << "Large block eigenvector error: " << max_error << "\n";
+
+    bool failed = (max_error > 1e-6);
+
+    std::cout << "Large block Eigensolver " << (failed ? "FAILS!" : "passes.") << "\n";
+
+    return failed;
+}
+
 int main(int argc, char* argv[])
 {
     int out = 0;
@@ -251,5 +364,7 @@ int main(int argc, char* argv[])
 #endif // GAUSS_USE_ARPACK
     out += test_fd_dense();
     out += test_fe_dense();
+    out += test_batched_dense();
+    out += test_large_block();
     return out;
 }
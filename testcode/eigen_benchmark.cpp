@@ -0,0 +1,139 @@
+/*BHEADER**********************************************************************
+ *
+ * Copyright (c) 2018, Lawrence Livermore National Security, LLC.
+ * Produced at the Lawrence Livermore National Laboratory.
+ * LLNL-CODE-759464. All Rights reserved. See file COPYRIGHT for details.
+ *
+ * This file is part of GAUSS. For more information and source code
+ * availability, see https://www.github.com/gelever/GAUSS.
+ *
+ * GAUSS is free software; you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License (as published by the Free
+ * Software Foundation) version 2.1 dated February 1999.
+ *
+ ***********************************************************************EHEADER*/
+
+/**
+   Compares the per aggregate and batched local eigensolvers
+   on many small weighted path problems.
+*/
+
+#include <random>
+
+#include "GAUSS.hpp"
+
+using namespace gauss;
+
+// vertex edge relation of a path with random edge weights
+void build_path_problem(int num_vertices, std::mt19937& gen,
+                        SparseMatrix& M, SparseMatrix& D)
+{
+    std::uniform_real_distribution<double> dist(0.5, 1.5);
+
+    int num_edges = num_vertices - 1;
+
+    CooMatrix D_coo(num_vertices, num_edges);
+    std::vector<double> M_diag(num_edges);
+
+    for (int i = 0; i < num_edges; ++i)
+    {
+        D_coo.Add(i, i, 1.0);
+        D_coo.Add(i + 1, i, -1.0);
+
+        M_diag[i] = dist(gen);
+    }
+
+    D = D_coo.ToSparse();
+    M = SparseMatrix(std::move(M_diag));
+}
+
+int main(int argc, char* argv[])
+{
+    MpiSession mpi_info(argc, argv);
+    int myid = mpi_info.myid_;
+
+    int num_problems = 4096;
+    int min_size = 4;
+    int max_size = 14;
+    int max_evects = 4;
+    double spect_tol = 1.0;
+
+    linalgcpp::ArgParser arg_parser(argc, argv);
+
+    arg_parser.Parse(num_problems, "--np", "Number of local problems.");
+    arg_parser.Parse(min_size, "--min", "Minimum problem size.");
+    arg_parser.Parse(max_size, "--max", "Maximum problem size.");
+    arg_parser.Parse(max_evects, "--m", "Maximum eigenvectors per problem.");
+    arg_parser.Parse(spect_tol, "--t", "Spectral tolerance for eigenvalue problem.");
+
+    if (!arg_parser.IsGood())
+    {
+        ParPrint(myid, arg_parser.ShowHelp());
+        ParPrint(myid, arg_parser.ShowErrors());
+
+        return EXIT_FAILURE;
+    }
+
+    ParPrint(myid, arg_parser.ShowOptions());
+
+    std::mt19937 gen(myid);
+    std::uniform_int_distribution<int> size_dist(min_size, max_size);
+
+    std::vector<SparseMatrix> M(num_problems);
+    std::vector<SparseMatrix> D(num_problems);
+
+    for (int i = 0; i < num_problems; ++i)
+    {
+        build_path_problem(size_dist(gen), gen, M[i], D[i]);
+    }
+
+    // Compare against the LAPACK path for all sizes
+    LocalEigenSolver eigs(max_evects, spect_tol, max_size);
+
+    std::vector<DenseMatrix> evects(num_problems);
+
+    Timer single_timer(Timer::Start::True);
+
+    for (int i = 0; i < num_problems; ++i)
+    {
+        eigs.BlockCompute(M[i], D[i], evects[i]);
+    }
+
+    single_timer.Click();
+
+    std::vector<DenseMatrix> batched_evects;
+
+    Timer batched_timer(Timer::Start::True);
+
+    eigs.BlockCompute(M, D, batched_evects);
+
+    batched_timer.Click();
+
+    double max_error = 0.0;
+
+    for (int i = 0; i < num_problems; ++i)
+    {
+        if (evects[i].Cols() != batched_evects[i].Cols())
+        {
+            max_error = 1.0;
+            continue;
+        }
+
+        for (int k = 0; k < evects[i].Cols(); ++k)
+        {
+            double dot = evects[i].GetColView(k).Mult(batched_evects[i].GetColView(k));
+            max_error = std::max(max_error, 1.0 - std::fabs(dot));
+        }
+    }
+
+    if (myid == 0)
+    {
+        std::cout << "Per aggregate time: " << single_timer.TotalTime() << "s\n";
+        std::cout << "Batched time:       " << batched_timer.TotalTime() << "s\n";
+        std::cout << "Speedup:            "
+                  << single_timer.TotalTime() / batched_timer.TotalTime() << "\n";
+        std::cout << "Eigenvector error:  " << max_error << "\n";
+    }
+
+    return (max_error > 1e-8);
+}
@@ -0,0 +1,125 @@
+/*BHEADER**********************************************************************
+ *
+ * Copyright (c) 2018, Lawrence Livermore National Security, LLC.
+ * Produced at the Lawrence Livermore National Laboratory.
+ * LLNL-CODE-759464. All Rights reserved. See file COPYRIGHT for details.
+ *
+ * This file is part of GAUSS. For more information and source code
+ * availability, see https://www.github.com/gelever/GAUSS.
+ *
+ * GAUSS is free software; you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License (as published by the Free
+ * Software Foundation) version 2.1 dated February 1999.
+ *
+ ***********************************************************************EHEADER*/
+
+/**
+   Measures the per solve overhead of the hybridization solver outside of PCG,
+   that is the element level right hand side transform and solution recovery.
+*/
+
+#include "GAUSS.hpp"
+
+using namespace gauss;
+
+int main(int argc, char* argv[])
+{
+    MpiSession mpi_info(argc, argv);
+    MPI_Comm comm = mpi_info.comm_;
+    int myid = mpi_info.myid_;
+
+    int gen_vertices = 10000;
+    int mean_degree = 10;
+    double beta = 0.15;
+    int seed = 1;
+    int coarsen_factor = 10;
+    int num_solves = 20;
+
+    linalgcpp::ArgParser arg_parser(argc, argv);
+
+    arg_parser.Parse(gen_vertices, "--nv", "Number of vertices of generated graph.");
+    arg_parser.Parse(mean_degree, "--md", "Average vertex degree of generated graph.");
+    arg_parser.Parse(beta, "--b", "Probability of rewiring in the Watts-Strogatz model.");
+    arg_parser.Parse(seed, "--s", "Seed for random number generator.");
+    arg_parser.Parse(coarsen_factor, "--cf", "Coarsening factor for partitioning.");
+    arg_parser.Parse(num_solves, "--ns", "Number of solves to time.");
+
+    if (!arg_parser.IsGood())
+    {
+        ParPrint(myid, arg_parser.ShowHelp());
+        ParPrint(myid, arg_parser.ShowErrors());
+
+        return EXIT_FAILURE;
+    }
+
+    ParPrint(myid, arg_parser.ShowOptions());
+
+    SparseMatrix vertex_edge = GenerateGraph(comm, gen_vertices, mean_degree, beta, seed);
+    std::vector<int> partition = PartitionAAT(vertex_edge, coarsen_factor);
+
+    Graph graph(comm, vertex_edge, partition);
+    MixedMatrix mgl(graph);
+    mgl.AssembleM();
+
+    HybridSolver hb(mgl, FineGraphSpace(graph));
+    SPDSolver spd(mgl);
+
+    BlockVector rhs(mgl.Offsets());
+    BlockVector sol(mgl.Offsets());
+    BlockVector spd_sol(mgl.Offsets());
+
+    Vector random_vect(mgl.LocalD().Cols());
+    random_vect.Randomize(-1.0, 1.0);
+
+    rhs.GetBlock(0) = 0.0;
+    mgl.LocalD().Mult(random_vect, rhs.GetBlock(1));
+
+    Vector hybrid_rhs(hb.NumMultiplierDofs());
+    auto work = hb.MakeWorkspace();
+
+    // Transform and recovery only
+    Timer transform_timer(Timer::Start::True);
+
+    for (int i = 0; i < num_solves; ++i)
+    {
+        hb.RHSTransform(rhs, hybrid_rhs, *work);
+        hb.RecoverOriginalSolution(hybrid_rhs, sol, *work);
+    }
+
+    transform_timer.Click();
+
+    // Full solves
+    double pcg_time = 0.0;
+
+    Timer solve_timer(Timer::Start::True);
+
+    for (int i = 0; i < num_solves; ++i)
+    {
+        hb.Solve(rhs, sol);
+        pcg_time += hb.GetTiming();
+    }
+
+    solve_timer.Click();
+
+    spd.Solve(rhs, spd_sol);
+
+    OrthoConstant(comm, sol.GetBlock(1), vertex_edge.Rows());
+    OrthoConstant(comm, spd_sol.GetBlock(1), vertex_edge.Rows());
+
+    double error = CompareError(comm, sol.GetBlock(1), spd_sol.GetBlock(1));
+
+    if (myid == 0)
+    {
+        double solve_time = solve_timer.TotalTime() / num_solves;
+        double transform_time = transform_timer.TotalTime() / num_solves;
+        double pcg_avg = pcg_time / num_solves;
+
+        std::cout << "Hybrid solve time:       " << solve_time << "s\n";
+        std::cout << "  PCG time:              " << pcg_avg << "s\n";
+        std::cout << "  Overhead outside PCG:  " << solve_time - pcg_avg << "s\n";
+        std::cout << "Transform + recovery:    " << transform_time << "s\n";
+        std::cout << "Error vs SPD solver:     " << error << "\n";
+    }
+
+    return (error > 1e-6);
+}
@@ -0,0 +1,132 @@
+/*BHEADER**********************************************************************
+ *
+ * Copyright (c) 2018, Lawrence Livermore National Security, LLC.
+ * Produced at the Lawrence Livermore National Laboratory.
+ * LLNL-CODE-759464. All Rights reserved. See file COPYRIGHT for details.
+ *
+ * This file is part of GAUSS. For more information and source code
+ * availability, see https://www.github.com/gelever/GAUSS.
+ *
+ * GAUSS is free software; you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License (as published by the Free
+ * Software Foundation) version 2.1 dated February 1999.
+ *
+ ***********************************************************************EHEADER*/
+
+/**
+   Compares standard and pipelined CG in the fine level SPD solver and the
+   coarse level hybridization solver. For a scaling comparison, run on an
+   increasing number of processors, with --nv scaled along for weak scaling.
+*/
+
+#include "GAUSS.hpp"
+
+using namespace gauss;
+
+struct PCGResult
+{
+    double time;
+    int iterations;
+    BlockVector sol;
+};
+
+PCGResult TimeSolves(MPI_Comm comm, GraphUpscale& upscale, int level,
+                     const BlockVector& rhs, bool pipelined_cg, int num_solves)
+{
+    upscale.SetPipelinedCG(level, pipelined_cg);
+
+    BlockVector sol = upscale.GetBlockVector(level);
+    double time = 0.0;
+
+    for (int i = 0; i < num_solves; ++i)
+    {
+        sol = 0.0;
+        upscale.Solve(level, rhs, sol);
+        time += upscale.SolveTime(level);
+    }
+
+    // The slowest processor sets the time
+    double max_time;
+    MPI_Allreduce(&time, &max_time, 1, MPI_DOUBLE, MPI_MAX, comm);
+
+    return {max_time / num_solves, upscale.SolveIters(level), std::move(sol)};
+}
+
+bool Compare(MPI_Comm comm, int myid, const std::string& name, GraphUpscale& upscale,
+             int level, const BlockVector& rhs, int num_solves)
+{
+    PCGResult standard = TimeSolves(comm, upscale, level, rhs, false, num_solves);
+    PCGResult pipelined = TimeSolves(comm, upscale, level, rhs, true, num_solves);
+
+    double error = CompareError(comm, pipelined.sol.GetBlock(1), standard.sol.GetBlock(1));
+
+    if (myid == 0)
+    {
+        std::cout << name << ":\n";
+        std::cout << "  Standard CG:   " << standard.time << "s, "
+                  << standard.iterations << " iterations\n";
+        std::cout << "  Pipelined CG:  " << pipelined.time << "s, "
+                  << pipelined.iterations << " iterations\n";
+        std::cout << "  Speedup:       " << standard.time / pipelined.time << "\n";
+        std::cout << "  Difference:    " << error << "\n";
+    }
+
+    return error > 1e-6;
+}
+
+int main(int argc, char* argv[])
+{
+    MpiSession mpi_info(argc, argv);
+    MPI_Comm comm = mpi_info.comm_;
+    int myid = mpi_info.myid_;
+    int num_procs = mpi_info.num_procs_;
+
+    int gen_vertices = 10000;
+    int mean_degree = 10;
+    double beta = 0.15;
+    int seed = 1;
+    int coarsen_factor = 10;
+    int num_solves = 5;
+
+    linalgcpp::ArgParser arg_parser(argc, argv);
+
+    arg_parser.Parse(gen_vertices, "--nv", "Number of vertices of generated graph.");
+    arg_parser.Parse(mean_degree, "--md", "Average vertex degree of generated graph.");
+    arg_parser.Parse(beta, "--b", "Probability of rewiring in the Watts-Strogatz model.");
+    arg_parser.Parse(seed, "--s", "Seed for random number generator.");
+    arg_parser.Parse(coarsen_factor, "--cf", "Coarsening factor for partitioning.");
+    arg_parser.Parse(num_solves, "--ns", "Number of solves to time.");
+
+    if (!arg_parser.IsGood())
+    {
+        ParPrint(myid, arg_parser.ShowHelp());
+        ParPrint(myid, arg_parser.ShowErrors());
+
+        return EXIT_FAILURE;
+    }
+
+    ParPrint(myid, arg_parser.ShowOptions());
+    ParPrint(myid, std::cout << "Processors: " << num_procs << "\n");
+
+    SparseMatrix vertex_edge = GenerateGraph(comm, gen_vertices, mean_degree, beta, seed);
+    std::vector<int> partition = PartitionAAT(vertex_edge, coarsen_factor);
+
+    Graph graph(comm, vertex_edge, partition);
+
+    UpscaleParams params(0.001, 4, true);
+    GraphUpscale upscale(graph, params);
+
+    BlockVector fine_rhs = upscale.GetBlockVector(0);
+    fine_rhs.GetBlock(0) = 0.0;
+    fine_rhs.GetBlock(1).Randomize(-1.0, 1.0);
+    upscale.Orthogonalize(0, fine_rhs);
+
+    BlockVector coarse_rhs = upscale.Restrict(fine_rhs);
+
+    bool failed = false;
+
+    failed |= Compare(comm, myid, "Fine SPD solver", upscale, 0, fine_rhs, num_solves);
+    failed |= Compare(comm, myid, "Coarse hybrid solver", upscale, 1, coarse_rhs, num_solves);
+
+    return failed;
+}
@@ -0,0 +1,101 @@
+/*BHEADER**********************************************************************
+ *
+ * Copyright (c) 2018, Lawrence Livermore National Security, LLC.
+ * Produced at the Lawrence Livermore National Laboratory.
+ * LLNL-CODE-759464. All Rights reserved. See file COPYRIGHT for details.
+ *
+ * This file is part of GAUSS. For more information and source code
+ * availability, see https://www.github.com/gelever/GAUSS.
+ *
+ * GAUSS is free software; you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License (as published by the Free
+ * Software Foundation) version 2.1 dated February 1999.
+ *
+ ***********************************************************************EHEADER*/
+
+/**
+   @file test_checkpoint.cpp
+   @brief tests saving and loading a hierarchy from a binary checkpoint
+
+   The upscaled solution from a loaded hierarchy should match
+   the solution from the hierarchy that was saved.
+*/
+
+#include <cstdio>
+#include <mpi.h>
+
+#include "GAUSS.hpp"
+
+using namespace gauss;
+
+int main(int argc, char* argv[])
+{
+    // Initialize MPI
+    MpiSession mpi_info(argc, argv);
+    MPI_Comm comm = mpi_info.comm_;
+    int myid = mpi_info.myid_;
+
+    // Graph Params
+    int gen_vertices = 400;
+    int mean_degree = 10;
+    double beta = 0.15;
+    int seed = -1;
+    int coarsen_factor = 40;
+
+    // Upscale Params
+    int max_evects = 4;
+    double spect_tol = 1.0;
+    int max_levels = 3;
+
+    // Test Params
+    double test_tol = 1e-8;
+    std::string prefix = "test_checkpoint.bin";
+
+    /// [Load Input]
+    SparseMatrix vertex_edge_global = GenerateGraph(comm, gen_vertices, mean_degree, beta, seed);
+    std::vector<int> global_partitioning = PartitionAAT(vertex_edge_global, coarsen_factor);
+    /// [Load Input]
+
+    UpscaleParams params(spect_tol, max_evects, false, max_levels);
+
+    Graph graph(comm, vertex_edge_global, global_partitioning);
+
+    /// [Checkpoint]
+    GraphUpscale upscale(graph, params);
+    upscale.ShowSetupTime();
+
+    Timer save_timer(Timer::Start::True);
+    upscale.Save(prefix);
+    save_timer.Click();
+
+    ParPrint(myid, std::cout << "Save time: " << save_timer.TotalTime() << "s\n");
+
+    GraphUpscale loaded_upscale(comm, prefix);
+    loaded_upscale.ShowSetupTime();
+    /// [Checkpoint]
+
+    /// [Compare]
+    BlockVector test_vect = upscale.GetBlockVector(0);
+    test_vect.GetBlock(0).Randomize(-1.0, 1.0);
+
+    Vector rhs = upscale.GetMatrix(0).LocalD().Mult(test_vect.GetBlock(0));
+
+    bool failed = loaded_upscale.NumLevels() != upscale.NumLevels();
+
+    for (int level = 0; level < upscale.NumLevels() && !failed; ++level)
+    {
+        Vector sol = upscale.Solve(level, rhs);
+        Vector loaded_sol = loaded_upscale.Solve(level, rhs);
+
+        double error = CompareError(comm, sol, loaded_sol);
+
+        ParPrint(myid, std::cout << "Level " << level << " Checkpoint Error: " << error << "\n");
+
+        failed |= error > test_tol;
+    }
+    /// [Compare]
+
+    std::remove(ProcFilename(comm, prefix).c_str());
+
+    return failed;
+}
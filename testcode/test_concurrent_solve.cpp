@@ -0,0 +1,126 @@
+/*BHEADER**********************************************************************
+ *
+ * Copyright (c) 2018, Lawrence Livermore National Security, LLC.
+ * Produced at the Lawrence Livermore National Laboratory.
+ * LLNL-CODE-759464. All Rights reserved. See file COPYRIGHT for details.
+ *
+ * This file is part of GAUSS. For more information and source code
+ * availability, see https://www.github.com/gelever/GAUSS.
+ *
+ * GAUSS is free software; you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License (as published by the Free
+ * Software Foundation) version 2.1 dated February 1999.
+ *
+ ***********************************************************************EHEADER*/
+
+/**
+   @file test_concurrent_solve.cpp
+   @brief tests solving with one hierarchy from several threads at once
+
+   Each thread solves its own right hand sides with its own workspace.
+   The solutions should match solving the same right hand sides one at a time.
+*/
+
+#include <thread>
+#include <mpi.h>
+
+#include "GAUSS.hpp"
+
+using namespace gauss;
+
+int main(int argc, char* argv[])
+{
+    // Initialize MPI
+    MpiSession mpi_info(argc, argv, MPI_COMM_WORLD, true);
+    MPI_Comm comm = mpi_info.comm_;
+    int myid = mpi_info.myid_;
+
+    // Graph Params
+    int gen_vertices = 400;
+    int mean_degree = 10;
+    double beta = 0.15;
+    int seed = -1;
+    int coarsen_factor = 40;
+
+    // Upscale Params
+    int max_evects = 4;
+    double spect_tol = 1.0;
+    int max_levels = 3;
+
+    // Test Params
+    int num_threads = 4;
+    int solves_per_thread = 4;
+    double test_tol = 1e-6;
+
+    /// [Load Input]
+    SparseMatrix vertex_edge_global = GenerateGraph(comm, gen_vertices, mean_degree, beta, seed);
+    std::vector<int> global_partitioning = PartitionAAT(vertex_edge_global, coarsen_factor);
+
+    Graph graph(comm, vertex_edge_global, global_partitioning);
+    /// [Load Input]
+
+    bool failed = false;
+
+    for (bool hybridization : {false, true})
+    {
+        UpscaleParams params(spect_tol, max_evects, hybridization, max_levels);
+
+        GraphUpscale upscale(graph, params);
+
+        /// [Right Hand Sides]
+        int num_rhs = num_threads * solves_per_thread;
+
+        std::vector<Vector> rhs(num_rhs, upscale.GetVector(0));
+
+        for (auto& rhs_k : rhs)
+        {
+            rhs_k.Randomize(-1.0, 1.0);
+            OrthoConstant(comm, rhs_k, upscale.ConstantRep(0));
+        }
+        /// [Right Hand Sides]
+
+        for (int level = 0; level < max_levels; ++level)
+        {
+            /// [Concurrent Solve]
+            std::vector<Vector> sols(num_rhs, upscale.GetVector(0));
+            std::vector<std::thread> threads;
+
+            for (int t = 0; t < num_threads; ++t)
+            {
+                threads.emplace_back([&, t]()
+                {
+                    UpscaleWorkspace work = upscale.MakeWorkspace();
+
+                    for (int k = t; k < num_rhs; k += num_threads)
+                    {
+                        upscale.Solve(level, rhs[k], sols[k], work);
+                    }
+                });
+            }
+
+            for (auto& thread : threads)
+            {
+                thread.join();
+            }
+            /// [Concurrent Solve]
+
+            /// [Compare]
+            double max_error = 0.0;
+
+            for (int k = 0; k < num_rhs; ++k)
+            {
+                Vector sol = upscale.Solve(level, rhs[k]);
+
+                max_error = std::max(max_error, CompareError(comm, sols[k], sol));
+            }
+
+            ParPrint(myid, std::cout << "Hybridization " << hybridization << " Level "
+                     << level << " Concurrent Solve Error: " << max_error << "\n");
+
+            failed |= max_error > test_tol;
+            /// [Compare]
+        }
+    }
+
+    return failed;
+}
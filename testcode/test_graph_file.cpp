@@ -0,0 +1,127 @@
+/*BHEADER**********************************************************************
+ *
+ * Copyright (c) 2018, Lawrence Livermore National Security, LLC.
+ * Produced at the Lawrence Livermore National Laboratory.
+ * LLNL-CODE-759464. All Rights reserved. See file COPYRIGHT for details.
+ *
+ * This file is part of GAUSS. For more information and source code
+ * availability, see https://www.github.com/gelever/GAUSS.
+ *
+ * GAUSS is free software; you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License (as published by the Free
+ * Software Foundation) version 2.1 dated February 1999.
+ *
+ ***********************************************************************EHEADER*/
+
+/**
+   @file test_graph_file.cpp
+   @brief tests the binary graph file format
+
+   Data read back from binary graph files should match what was written,
+   and a graph read in parallel from binary files should match the
+   same graph read in parallel from text files.
+*/
+
+#include <cstdio>
+#include <mpi.h>
+
+#include "GAUSS.hpp"
+
+using namespace gauss;
+using linalgcpp::ReadCSR;
+using linalgcpp::WriteText;
+
+bool SameGraph(const Graph& lhs, const Graph& rhs)
+{
+    return lhs.vertex_map_ == rhs.vertex_map_ &&
+           lhs.part_local_ == rhs.part_local_ &&
+           lhs.vertex_edge_local_.GetIndptr() == rhs.vertex_edge_local_.GetIndptr() &&
+           lhs.vertex_edge_local_.GetIndices() == rhs.vertex_edge_local_.GetIndices() &&
+           lhs.weight_local_ == rhs.weight_local_ &&
+           lhs.edge_true_edge_.GetColMap() == rhs.edge_true_edge_.GetColMap() &&
+           lhs.edge_true_edge_.GetDiag().GetIndices() == rhs.edge_true_edge_.GetDiag().GetIndices();
+}
+
+int main(int argc, char* argv[])
+{
+    // Initialize MPI
+    MpiSession mpi_info(argc, argv);
+    MPI_Comm comm = mpi_info.comm_;
+    int myid = mpi_info.myid_;
+    int num_procs = mpi_info.num_procs_;
+
+    assert(num_procs == 1 || num_procs == 2);
+
+    std::string graph_filename = "../../graphdata/vertex_edge_tiny.txt";
+    std::string prefix = "test_graph_file";
+
+    /// [Write Files]
+    SparseMatrix vertex_edge = ReadCSR(graph_filename);
+    std::vector<int> partition {0, 0, 0, 1, 1, 1};
+    std::vector<double> weight(vertex_edge.Cols());
+
+    for (int i = 0; i < vertex_edge.Cols(); ++i)
+    {
+        weight[i] = 1.0 + i;
+    }
+
+    if (myid == 0)
+    {
+        WriteGraphFile(prefix + ".graph", vertex_edge);
+        WriteGraphFile(prefix + ".part", partition);
+        WriteGraphFile(prefix + ".weight", weight);
+
+        WriteText(partition, prefix + ".part.txt");
+        WriteText(weight, prefix + ".weight.txt");
+    }
+
+    MPI_Barrier(comm);
+    /// [Write Files]
+
+    /// [Read Back]
+    SparseMatrix read_vertex_edge = ReadGraphCSR(prefix + ".graph");
+
+    bool failed = read_vertex_edge.Cols() != vertex_edge.Cols() ||
+                  read_vertex_edge.GetIndptr() != vertex_edge.GetIndptr() ||
+                  read_vertex_edge.GetIndices() != vertex_edge.GetIndices() ||
+                  read_vertex_edge.GetData() != vertex_edge.GetData();
+
+    failed |= ReadGraphArray<int>(prefix + ".part") != partition;
+    failed |= ReadGraphArray(prefix + ".weight") != weight;
+
+    GraphFileReader reader(prefix + ".graph");
+    SparseMatrix rows = reader.ReadCSRRows(2, 5);
+
+    for (int i = 0; i < rows.Rows(); ++i)
+    {
+        failed |= rows.GetIndices(i) != vertex_edge.GetIndices(2 + i);
+    }
+
+    std::vector<int> local_to_global {4, 1};
+    Vector slice = ReadVector(prefix + ".weight", local_to_global);
+
+    failed |= slice[0] != weight[4] || slice[1] != weight[1];
+    /// [Read Back]
+
+    /// [Distributed Read]
+    Graph text_graph(comm, graph_filename, prefix + ".part.txt", prefix + ".weight.txt");
+    Graph binary_graph(comm, prefix + ".graph", prefix + ".part", prefix + ".weight");
+
+    failed |= !SameGraph(text_graph, binary_graph);
+    failed |= binary_graph.edge_true_edge_.GlobalCols() != vertex_edge.Cols();
+    /// [Distributed Read]
+
+    ParPrint(myid, std::cout << "Graph file test " << (failed ? "failed" : "passed") << "\n");
+
+    MPI_Barrier(comm);
+
+    if (myid == 0)
+    {
+        for (auto&& ext : {".graph", ".part", ".weight", ".part.txt", ".weight.txt"})
+        {
+            std::remove((prefix + ext).c_str());
+        }
+    }
+
+    return failed;
+}
@@ -0,0 +1,156 @@
+/*BHEADER**********************************************************************
+ *
+ * Copyright (c) 2018, Lawrence Livermore National Security, LLC.
+ * Produced at the Lawrence Livermore National Laboratory.
+ * LLNL-CODE-759464. All Rights reserved. See file COPYRIGHT for details.
+ *
+ * This file is part of GAUSS. For more information and source code
+ * availability, see https://www.github.com/gelever/GAUSS.
+ *
+ * GAUSS is free software; you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License (as published by the Free
+ * Software Foundation) version 2.1 dated February 1999.
+ *
+ ***********************************************************************EHEADER*/
+
+/**
+   @file test_mixed_precision.cpp
+   @brief tests the hybridization solver with single precision element matrices
+
+   After iterative refinement, solutions from single precision element
+   matrices should match those from double precision element matrices,
+   for single and batched solves, while using less memory. The fine level
+   is checked with its diagonal element matrices of M.
+*/
+
+#include <mpi.h>
+
+#include "GAUSS.hpp"
+
+using namespace gauss;
+
+int main(int argc, char* argv[])
+{
+    // Initialize MPI
+    MpiSession mpi_info(argc, argv);
+    MPI_Comm comm = mpi_info.comm_;
+    int myid = mpi_info.myid_;
+
+    // Graph Params
+    int gen_vertices = 400;
+    int mean_degree = 10;
+    double beta = 0.15;
+    int seed = -1;
+    int coarsen_factor = 40;
+
+    // Upscale Params
+    int max_evects = 4;
+    double spect_tol = 1.0;
+    int max_levels = 3;
+
+    // Test Params
+    double solve_tol = 1e-12;
+    double test_tol = 1e-8;
+    int num_rhs = 3;
+
+    /// [Load Input]
+    SparseMatrix vertex_edge_global = GenerateGraph(comm, gen_vertices, mean_degree, beta, seed);
+    std::vector<int> global_partitioning = PartitionAAT(vertex_edge_global, coarsen_factor);
+
+    Graph graph(comm, vertex_edge_global, global_partitioning);
+    /// [Load Input]
+
+    /// [Upscale]
+    UpscaleParams params(spect_tol, max_evects, true, max_levels);
+    GraphUpscale upscale(graph, params);
+
+    params.hybrid_single_precision = true;
+    GraphUpscale upscale_single(graph, params);
+
+    upscale.SetRelTol(solve_tol);
+    upscale_single.SetRelTol(solve_tol);
+    /// [Upscale]
+
+    /// [Right Hand Sides]
+    std::vector<BlockVector> rhs(num_rhs, upscale.GetBlockVector(0));
+
+    for (auto& rhs_i : rhs)
+    {
+        BlockVector test_vect = upscale.GetBlockVector(0);
+        test_vect.GetBlock(0).Randomize(-1.0, 1.0);
+
+        rhs_i = 0.0;
+        upscale.GetMatrix(0).LocalD().Mult(test_vect.GetBlock(0), rhs_i.GetBlock(1));
+    }
+    /// [Right Hand Sides]
+
+    bool failed = false;
+
+    /// [Compare]
+    // Fine level, whose element matrices of M are diagonal
+    {
+        const MixedMatrix& mgl = upscale.GetMatrix(0);
+
+        HybridSolver solver(mgl, FineGraphSpace(graph));
+        HybridSolver solver_single(mgl, FineGraphSpace(graph), true);
+
+        solver.SetRelTol(solve_tol);
+        solver_single.SetRelTol(solve_tol);
+
+        BlockVector sol = upscale.GetBlockVector(0);
+        BlockVector sol_single = upscale.GetBlockVector(0);
+
+        sol = 0.0;
+        sol_single = 0.0;
+
+        solver.Solve(rhs[0], sol);
+        solver_single.Solve(rhs[0], sol_single);
+
+        double error = CompareError(comm, sol_single, sol);
+
+        ParPrint(myid, std::cout << "Level 0 Single Precision Error: " << error << "\n");
+
+        failed |= error > test_tol;
+    }
+
+    for (int level = 1; level < max_levels; ++level)
+    {
+        BlockVector sol = upscale.Solve(level, rhs[0]);
+        BlockVector sol_single = upscale_single.Solve(level, rhs[0]);
+
+        double error = CompareError(comm, sol_single, sol);
+
+        std::vector<BlockVector> sols(num_rhs, upscale.GetBlockVector(0));
+        std::vector<BlockVector> sols_single(num_rhs, upscale.GetBlockVector(0));
+
+        upscale.Solve(level, rhs, sols);
+        upscale_single.Solve(level, rhs, sols_single);
+
+        double batched_error = 0.0;
+
+        for (int i = 0; i < num_rhs; ++i)
+        {
+            batched_error = std::max(batched_error, CompareError(comm, sols_single[i], sols[i]));
+        }
+
+        const auto& solver = dynamic_cast<const HybridSolver&>(upscale.Solver(level));
+        const auto& solver_single = dynamic_cast<const HybridSolver&>(upscale_single.Solver(level));
+
+        long long bytes = solver.ElemBytes();
+        long long bytes_single = solver_single.ElemBytes();
+
+        MPI_Allreduce(MPI_IN_PLACE, &bytes, 1, MPI_LONG_LONG, MPI_SUM, comm);
+        MPI_Allreduce(MPI_IN_PLACE, &bytes_single, 1, MPI_LONG_LONG, MPI_SUM, comm);
+
+        ParPrint(myid, std::cout << "Level " << level << " Single Precision Error: "
+                 << error << ", Batched: " << batched_error << " Element Bytes: "
+                 << bytes << " -> " << bytes_single << "\n");
+
+        failed |= error > test_tol;
+        failed |= batched_error > test_tol;
+        failed |= bytes_single >= bytes;
+    }
+    /// [Compare]
+
+    return failed;
+}
@@ -0,0 +1,108 @@
+/*BHEADER**********************************************************************
+ *
+ * Copyright (c) 2018, Lawrence Livermore National Security, LLC.
+ * Produced at the Lawrence Livermore National Laboratory.
+ * LLNL-CODE-759464. All Rights reserved. See file COPYRIGHT for details.
+ *
+ * This file is part of GAUSS. For more information and source code
+ * availability, see https://www.github.com/gelever/GAUSS.
+ *
+ * GAUSS is free software; you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License (as published by the Free
+ * Software Foundation) version 2.1 dated February 1999.
+ *
+ ***********************************************************************EHEADER*/
+
+/**
+   @file test_multi_rhs.cpp
+   @brief tests solving several right hand sides at once
+
+   The solutions from the batched GraphUpscale::Solve should match
+   solving each right hand side on its own, for every level and solver type.
+*/
+
+#include <fstream>
+#include <sstream>
+#include <mpi.h>
+
+#include "GAUSS.hpp"
+
+using namespace gauss;
+
+int main(int argc, char* argv[])
+{
+    // Initialize MPI
+    MpiSession mpi_info(argc, argv);
+    MPI_Comm comm = mpi_info.comm_;
+    int myid = mpi_info.myid_;
+
+    // Graph Params
+    int gen_vertices = 400;
+    int mean_degree = 10;
+    double beta = 0.15;
+    int seed = -1;
+    int coarsen_factor = 40;
+
+    // Upscale Params
+    int max_evects = 4;
+    double spect_tol = 1.0;
+    int max_levels = 3;
+
+    // Test Params
+    int num_rhs = 4;
+    double test_tol = 1e-6;
+
+    /// [Load Input]
+    SparseMatrix vertex_edge_global = GenerateGraph(comm, gen_vertices, mean_degree, beta, seed);
+    std::vector<int> global_partitioning = PartitionAAT(vertex_edge_global, coarsen_factor);
+
+    Graph graph(comm, vertex_edge_global, global_partitioning);
+    /// [Load Input]
+
+    bool failed = false;
+
+    for (bool hybridization : {false, true})
+    {
+        UpscaleParams params(spect_tol, max_evects, hybridization, max_levels);
+
+        GraphUpscale upscale(graph, params);
+        upscale.ShowSetupTime();
+
+        /// [Right Hand Sides]
+        std::vector<BlockVector> rhs(num_rhs, upscale.GetBlockVector(0));
+
+        for (auto& rhs_k : rhs)
+        {
+            BlockVector test_vect = upscale.GetBlockVector(0);
+            test_vect.GetBlock(0).Randomize(-1.0, 1.0);
+
+            rhs_k = 0.0;
+            upscale.GetMatrix(0).LocalD().Mult(test_vect.GetBlock(0), rhs_k.GetBlock(1));
+        }
+        /// [Right Hand Sides]
+
+        /// [Compare]
+        for (int level = 0; level < max_levels; ++level)
+        {
+            std::vector<BlockVector> sols;
+            upscale.Solve(level, rhs, sols);
+
+            double max_error = 0.0;
+
+            for (int k = 0; k < num_rhs; ++k)
+            {
+                BlockVector sol = upscale.Solve(level, rhs[k]);
+
+                max_error = std::max(max_error, CompareError(comm, sols[k], sol));
+            }
+
+            ParPrint(myid, std::cout << "Hybridization " << hybridization << " Level "
+                     << level << " Multiple RHS Error: " << max_error << "\n");
+
+            failed |= max_error > test_tol;
+        }
+        /// [Compare]
+    }
+
+    return failed;
+}
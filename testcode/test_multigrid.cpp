@@ -0,0 +1,123 @@
+/*BHEADER**********************************************************************
+ *
+ * Copyright (c) 2018, Lawrence Livermore National Security, LLC.
+ * Produced at the Lawrence Livermore National Laboratory.
+ * LLNL-CODE-759464. All Rights reserved. See file COPYRIGHT for details.
+ *
+ * This file is part of GAUSS. For more information and source code
+ * availability, see https://www.github.com/gelever/GAUSS.
+ *
+ * GAUSS is free software; you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License (as published by the Free
+ * Software Foundation) version 2.1 dated February 1999.
+ *
+ ***********************************************************************EHEADER*/
+
+/**
+   @file test_multigrid.cpp
+   @brief tests the multilevel V-cycle preconditioned fine level solver
+
+   For each smoother, and for edge weights of low and high contrast, the
+   fine level solution from the multigrid solver should match the one
+   from the default fine level solver. The iteration counts are shown
+   to compare across contrasts.
+*/
+
+#include <random>
+#include <mpi.h>
+
+#include "GAUSS.hpp"
+
+using namespace gauss;
+
+int main(int argc, char* argv[])
+{
+    // Initialize MPI
+    MpiSession mpi_info(argc, argv);
+    MPI_Comm comm = mpi_info.comm_;
+    int myid = mpi_info.myid_;
+
+    // Graph Params
+    int gen_vertices = 400;
+    int mean_degree = 10;
+    double beta = 0.15;
+    int seed = 1;
+    int coarsen_factor = 20;
+
+    // Upscale Params
+    int max_evects = 4;
+    double spect_tol = 1.0;
+    int max_levels = 3;
+
+    // Test Params
+    double solve_tol = 1e-10;
+    double test_tol = 1e-6;
+    int max_iter = 500;
+    std::vector<double> contrasts = {1.0, 1e4};
+
+    /// [Load Input]
+    SparseMatrix vertex_edge_global = GenerateGraph(comm, gen_vertices, mean_degree, beta, seed);
+    std::vector<int> global_partitioning = PartitionAAT(vertex_edge_global, coarsen_factor);
+
+    int num_edges = vertex_edge_global.Cols();
+    /// [Load Input]
+
+    std::vector<std::pair<SmootherType, std::string>> smoothers =
+    {
+        {SmootherType::Jacobi, "Jacobi"},
+        {SmootherType::Chebyshev, "Chebyshev"},
+        {SmootherType::Schwarz, "Schwarz"}
+    };
+
+    bool failed = false;
+
+    for (double contrast : contrasts)
+    {
+        // Same weights on all processors
+        std::mt19937 gen(seed);
+        std::uniform_real_distribution<double> dist(0.0, 1.0);
+
+        std::vector<double> weight(num_edges);
+
+        for (auto& weight_i : weight)
+        {
+            weight_i = std::pow(contrast, dist(gen));
+        }
+
+        Graph graph(comm, vertex_edge_global, global_partitioning, weight);
+
+        UpscaleParams params(spect_tol, max_evects, true, max_levels);
+
+        GraphUpscale upscale(graph, params);
+        upscale.SetRelTol(solve_tol);
+
+        BlockVector test_vect = upscale.GetBlockVector(0);
+        test_vect.GetBlock(0).Randomize(-1.0, 1.0);
+
+        Vector rhs = upscale.GetMatrix(0).LocalD().Mult(test_vect.GetBlock(0));
+        Vector sol = upscale.Solve(0, rhs);
+
+        for (const auto& smoother : smoothers)
+        {
+            params.multigrid = true;
+            params.multigrid_params.smoother = smoother.first;
+
+            GraphUpscale upscale_mg(graph, params);
+            upscale_mg.SetRelTol(solve_tol);
+            upscale_mg.SetMaxIter(max_iter);
+
+            Vector sol_mg = upscale_mg.Solve(0, rhs);
+
+            double error = CompareError(comm, sol_mg, sol);
+            int iters = upscale_mg.SolveIters(0);
+
+            ParPrint(myid, std::cout << "Contrast " << contrast << " " << smoother.second
+                     << " Multigrid Error: " << error << ", Iterations: " << iters << "\n");
+
+            failed |= error > test_tol;
+            failed |= iters >= max_iter;
+        }
+    }
+
+    return failed;
+}
@@ -0,0 +1,127 @@
+/*BHEADER**********************************************************************
+ *
+ * Copyright (c) 2018, Lawrence Livermore National Security, LLC.
+ * Produced at the Lawrence Livermore National Laboratory.
+ * LLNL-CODE-759464. All Rights reserved. See file COPYRIGHT for details.
+ *
+ * This file is part of GAUSS. For more information and source code
+ * availability, see https://www.github.com/gelever/GAUSS.
+ *
+ * GAUSS is free software; you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License (as published by the Free
+ * Software Foundation) version 2.1 dated February 1999.
+ *
+ ***********************************************************************EHEADER*/
+
+/**
+   @file test_prec_reuse.cpp
+   @brief tests keeping the preconditioner in RescaleSolver
+
+   Solutions with a kept preconditioner should match those with
+   a rebuilt one, while building the preconditioner only once.
+*/
+
+#include <random>
+#include <mpi.h>
+
+#include "GAUSS.hpp"
+
+using namespace gauss;
+
+int main(int argc, char* argv[])
+{
+    // Initialize MPI
+    MpiSession mpi_info(argc, argv);
+    MPI_Comm comm = mpi_info.comm_;
+    int myid = mpi_info.myid_;
+
+    // Graph Params
+    int gen_vertices = 400;
+    int mean_degree = 10;
+    double beta = 0.15;
+    int seed = -1;
+    int coarsen_factor = 40;
+
+    // Upscale Params
+    int max_evects = 4;
+    double spect_tol = 1.0;
+    int max_levels = 2;
+
+    // Test Params
+    int num_samples = 4;
+    double test_tol = 1e-6;
+
+    /// [Load Input]
+    SparseMatrix vertex_edge_global = GenerateGraph(comm, gen_vertices, mean_degree, beta, seed);
+    std::vector<int> global_partitioning = PartitionAAT(vertex_edge_global, coarsen_factor);
+
+    Graph graph(comm, vertex_edge_global, global_partitioning);
+    /// [Load Input]
+
+    bool failed = false;
+
+    for (bool hybridization : {false, true})
+    {
+        UpscaleParams params(spect_tol, max_evects, hybridization, max_levels);
+
+        GraphUpscale upscale(graph, params);
+        GraphUpscale upscale_reuse(graph, params);
+
+        PrecReusePolicy policy;
+        policy.max_reuse = -1;
+
+        upscale_reuse.SetPrecReuse(policy);
+
+        BlockVector test_vect = upscale.GetBlockVector(0);
+        test_vect.GetBlock(0).Randomize(-1.0, 1.0);
+
+        BlockVector rhs = upscale.GetBlockVector(0);
+        rhs = 0.0;
+        upscale.GetMatrix(0).LocalD().Mult(test_vect.GetBlock(0), rhs.GetBlock(1));
+
+        std::mt19937 generator(myid);
+        std::uniform_real_distribution<double> distribution(0.5, 2.0);
+
+        /// [Samples]
+        for (int sample = 0; sample < num_samples; ++sample)
+        {
+            for (int level = 0; level < max_levels; ++level)
+            {
+                int num_aggs = upscale.GetMatrix(level).GetElemDof().Rows();
+
+                std::vector<double> agg_weights(num_aggs);
+
+                for (auto& weight : agg_weights)
+                {
+                    weight = distribution(generator);
+                }
+
+                upscale.RescaleSolver(level, agg_weights);
+                upscale_reuse.RescaleSolver(level, agg_weights);
+
+                BlockVector sol = upscale.Solve(level, rhs);
+                int iters = upscale.SolveIters(level);
+
+                BlockVector sol_reuse = upscale_reuse.Solve(level, rhs);
+                int iters_reuse = upscale_reuse.SolveIters(level);
+
+                double error = CompareError(comm, sol_reuse, sol);
+
+                ParPrint(myid, std::cout << "Hybridization " << hybridization << " Level "
+                         << level << " Sample " << sample << " Reuse Error: " << error
+                         << " Iterations: " << iters << " -> " << iters_reuse << "\n");
+
+                failed |= error > test_tol;
+            }
+        }
+        /// [Samples]
+
+        for (int level = 0; level < max_levels; ++level)
+        {
+            failed |= upscale_reuse.NumPrecBuilds(level) != 1;
+            failed |= upscale.NumPrecBuilds(level) != num_samples + 1;
+        }
+    }
+
+    return failed;
+}
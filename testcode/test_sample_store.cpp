@@ -0,0 +1,156 @@
+/*BHEADER**********************************************************************
+ *
+ * Copyright (c) 2018, Lawrence Livermore National Security, LLC.
+ * Produced at the Lawrence Livermore National Laboratory.
+ * LLNL-CODE-759464. All Rights reserved. See file COPYRIGHT for details.
+ *
+ * This file is part of GAUSS. For more information and source code
+ * availability, see https://www.github.com/gelever/GAUSS.
+ *
+ * GAUSS is free software; you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License (as published by the Free
+ * Software Foundation) version 2.1 dated February 1999.
+ *
+ ***********************************************************************EHEADER*/
+
+/**
+   @file test_sample_store.cpp
+   @brief tests writing and reading back a sample store
+
+   Samples are written in two runs, the second appending to the first,
+   then read back both in full and as local vectors.
+*/
+
+#include <cstdio>
+#include <mpi.h>
+
+#include "GAUSS.hpp"
+
+using namespace gauss;
+using linalgcpp::ReadCSR;
+
+double Value(int sample, int field, int index)
+{
+    return (field == 0 ? 1.0 : -1.0) * (100.0 * sample + index);
+}
+
+void WriteSamples(const Graph& graph, const std::string& filename,
+                  const std::vector<std::string>& fields, int begin, int end,
+                  bool truncate = false)
+{
+    MPI_Comm comm = graph.edge_true_edge_.GetComm();
+
+    SampleWriter writer(comm, filename, graph.global_vertices_, graph.vertex_map_, fields,
+                        truncate);
+
+    int num_vertices = graph.vertex_map_.size();
+
+    Vector vect(num_vertices);
+
+    for (int sample = begin; sample < end; ++sample)
+    {
+        for (int field = 0; field < static_cast<int>(fields.size()); ++field)
+        {
+            for (int i = 0; i < num_vertices; ++i)
+            {
+                vect[i] = Value(sample, field, graph.vertex_map_[i]);
+            }
+
+            writer.Write(sample, fields[field], vect);
+        }
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    // Initialize MPI
+    MpiSession mpi_info(argc, argv);
+    MPI_Comm comm = mpi_info.comm_;
+    int myid = mpi_info.myid_;
+
+    std::string graph_filename = "../../graphdata/vertex_edge_sample.txt";
+    std::string filename = "test_sample_store.bin";
+    std::vector<std::string> fields {"fine_sol", "coarse_sol"};
+    int coarsen_factor = 100;
+    int num_samples = 3;
+
+    SparseMatrix vertex_edge = ReadCSR(graph_filename);
+    std::vector<int> partition = PartitionAAT(vertex_edge, coarsen_factor);
+
+    Graph graph(comm, vertex_edge, partition);
+
+    if (myid == 0)
+    {
+        std::remove(filename.c_str());
+    }
+
+    MPI_Barrier(comm);
+
+    /// [Write]
+    WriteSamples(graph, filename, fields, 0, num_samples - 1);
+    WriteSamples(graph, filename, fields, num_samples - 1, num_samples);
+
+    MPI_Barrier(comm);
+    /// [Write]
+
+    /// [Read]
+    SampleReader reader(filename);
+
+    bool failed = reader.NumSamples() != num_samples ||
+                  reader.GlobalSize() != graph.global_vertices_ ||
+                  reader.Fields() != fields;
+
+    int num_vertices = graph.vertex_map_.size();
+
+    for (int sample = 0; sample < num_samples; ++sample)
+    {
+        Vector global_vect = reader.Read(sample, fields[0]);
+
+        for (int i = 0; i < graph.global_vertices_; ++i)
+        {
+            failed |= global_vect[i] != Value(sample, 0, i);
+        }
+
+        Vector local_vect = reader.Read(sample, fields[1], graph.vertex_map_);
+
+        for (int i = 0; i < num_vertices; ++i)
+        {
+            failed |= local_vect[i] != Value(sample, 1, graph.vertex_map_[i]);
+        }
+    }
+    /// [Read]
+
+    /// [Mismatch]
+    try
+    {
+        SampleWriter writer(comm, filename, graph.global_vertices_, graph.vertex_map_, {"other"});
+        failed = true;
+    }
+    catch (const std::runtime_error&)
+    {
+    }
+    /// [Mismatch]
+
+    /// [Truncate]
+    std::vector<std::string> new_fields {"other"};
+
+    WriteSamples(graph, filename, new_fields, 0, 1, true);
+
+    MPI_Barrier(comm);
+
+    SampleReader new_reader(filename);
+
+    failed |= new_reader.NumSamples() != 1 || new_reader.Fields() != new_fields;
+    /// [Truncate]
+
+    ParPrint(myid, std::cout << "Sample store test " << (failed ? "failed" : "passed") << "\n");
+
+    MPI_Barrier(comm);
+
+    if (myid == 0)
+    {
+        std::remove(filename.c_str());
+    }
+
+    return failed;
+}
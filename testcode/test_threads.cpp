@@ -0,0 +1,168 @@
+/*BHEADER**********************************************************************
+ *
+ * Copyright (c) 2018, Lawrence Livermore National Security, LLC.
+ * Produced at the Lawrence Livermore National Laboratory.
+ * LLNL-CODE-759464. All Rights reserved. See file COPYRIGHT for details.
+ *
+ * This file is part of GAUSS. For more information and source code
+ * availability, see https://www.github.com/gelever/GAUSS.
+ *
+ * GAUSS is free software; you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License (as published by the Free
+ * Software Foundation) version 2.1 dated February 1999.
+ *
+ ***********************************************************************EHEADER*/
+
+/**
+   @file test_threads.cpp
+   @brief tests that coarsening does not depend on the number of threads
+
+   The vertex and edge interpolations of every level, coarsened with
+   several threads, should match those coarsened with a single thread.
+   Without OpenMP there is nothing to compare and the test passes.
+
+   The setup time for each thread count is shown, e.g. run with
+   --nv 100000 --max-threads 32 for the thread scaling of the setup.
+*/
+
+#include <algorithm>
+#include <cmath>
+#include <mpi.h>
+
+#include "GAUSS.hpp"
+
+#if GAUSS_USE_OPENMP
+#include <omp.h>
+#endif
+
+using namespace gauss;
+
+namespace
+{
+
+// Largest entry difference, or infinity if the sparsity patterns differ
+double MaxDiff(const SparseMatrix& lhs, const SparseMatrix& rhs)
+{
+    if (lhs.Rows() != rhs.Rows() || lhs.Cols() != rhs.Cols() ||
+            lhs.GetIndptr() != rhs.GetIndptr() ||
+            lhs.GetIndices() != rhs.GetIndices())
+    {
+        return INFINITY;
+    }
+
+    const auto& lhs_data = lhs.GetData();
+    const auto& rhs_data = rhs.GetData();
+
+    double max_diff = 0.0;
+
+    for (int i = 0; i < lhs.nnz(); ++i)
+    {
+        max_diff = std::max(max_diff, std::fabs(lhs_data[i] - rhs_data[i]));
+    }
+
+    return max_diff;
+}
+
+} // namespace
+
+int main(int argc, char* argv[])
+{
+    // Initialize MPI
+    MpiSession mpi_info(argc, argv);
+    MPI_Comm comm = mpi_info.comm_;
+    int myid = mpi_info.myid_;
+
+    // Graph Params
+    int gen_vertices = 1000;
+    int mean_degree = 10;
+    double beta = 0.15;
+    int seed = 1;
+    int coarsen_factor = 20;
+
+    // Upscale Params
+    int max_evects = 4;
+    double spect_tol = 1.0;
+    int max_levels = 3;
+
+    // Test Params
+    double test_tol = 1e-12;
+    int max_threads = 8;
+
+    linalgcpp::ArgParser arg_parser(argc, argv);
+
+    arg_parser.Parse(gen_vertices, "--nv", "Number of generated vertices.");
+    arg_parser.Parse(max_threads, "--max-threads", "Largest number of threads to compare.");
+
+    if (!arg_parser.IsGood())
+    {
+        ParPrint(myid, arg_parser.ShowHelp());
+        ParPrint(myid, arg_parser.ShowErrors());
+
+        return EXIT_FAILURE;
+    }
+
+    // Thread counts double up to max_threads
+    std::vector<int> num_threads;
+
+#if GAUSS_USE_OPENMP
+    for (int threads = 2; threads < 2 * max_threads; threads *= 2)
+    {
+        num_threads.push_back(std::min(threads, max_threads));
+    }
+#endif
+
+    /// [Load Input]
+    SparseMatrix vertex_edge_global = GenerateGraph(comm, gen_vertices, mean_degree, beta, seed);
+    std::vector<int> global_partitioning = PartitionAAT(vertex_edge_global, coarsen_factor);
+
+    Graph graph(comm, vertex_edge_global, global_partitioning);
+    /// [Load Input]
+
+    UpscaleParams params(spect_tol, max_evects, true, max_levels);
+
+#if GAUSS_USE_OPENMP
+    omp_set_num_threads(1);
+#endif
+
+    GraphUpscale upscale_serial(graph, params);
+
+    const double serial_time = upscale_serial.GetSetupTime();
+
+    ParPrint(myid, std::cout << "Threads 1 Setup Time: " << serial_time << "s\n");
+
+    const int num_coarseners = upscale_serial.NumLevels() - 1;
+
+    bool failed = false;
+
+    for (int threads : num_threads)
+    {
+#if GAUSS_USE_OPENMP
+        omp_set_num_threads(threads);
+#endif
+
+        GraphUpscale upscale(graph, params);
+
+        const double setup_time = upscale.GetSetupTime();
+
+        ParPrint(myid, std::cout << "Threads " << threads << " Setup Time: " << setup_time
+                 << "s Speedup: " << serial_time / setup_time << "\n");
+
+        for (int level = 0; level < num_coarseners; ++level)
+        {
+            const auto& serial = upscale_serial.Coarsener(level);
+            const auto& threaded = upscale.Coarsener(level);
+
+            double local_diff = std::max(MaxDiff(serial.Pvertex(), threaded.Pvertex()),
+                                         MaxDiff(serial.Pedge(), threaded.Pedge()));
+            double diff;
+            MPI_Allreduce(&local_diff, &diff, 1, MPI_DOUBLE, MPI_MAX, comm);
+
+            ParPrint(myid, std::cout << "Threads " << threads << " Level " << level
+                     << " Max Interpolation Difference: " << diff << "\n");
+
+            failed |= !(diff <= test_tol);
+        }
+    }
+
+    return failed;
+}
@@ -0,0 +1,124 @@
+/*BHEADER**********************************************************************
+ *
+ * Copyright (c) 2018, Lawrence Livermore National Security, LLC.
+ * Produced at the Lawrence Livermore National Laboratory.
+ * LLNL-CODE-759464. All Rights reserved. See file COPYRIGHT for details.
+ *
+ * This file is part of GAUSS. For more information and source code
+ * availability, see https://www.github.com/gelever/GAUSS.
+ *
+ * GAUSS is free software; you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License (as published by the Free
+ * Software Foundation) version 2.1 dated February 1999.
+ *
+ ***********************************************************************EHEADER*/
+
+/**
+   @file test_update.cpp
+   @brief tests updating edge weights of an existing hierarchy
+
+   The upscaled solution after GraphUpscale::UpdateWeights should match
+   the solution from a hierarchy built from scratch with the new weights.
+   The update warm starts the local eigensolvers from the previous
+   eigenvectors, and its time is shown next to an update without warm
+   starts and a setup from scratch.
+*/
+
+#include <fstream>
+#include <sstream>
+#include <mpi.h>
+
+#include "GAUSS.hpp"
+
+using namespace gauss;
+
+int main(int argc, char* argv[])
+{
+    // Initialize MPI
+    MpiSession mpi_info(argc, argv);
+    MPI_Comm comm = mpi_info.comm_;
+    int myid = mpi_info.myid_;
+
+    // Graph Params
+    int gen_vertices = 400;
+    int mean_degree = 10;
+    double beta = 0.15;
+    int seed = -1;
+    int coarsen_factor = 40;
+
+    // Upscale Params
+    int max_evects = 4;
+    double spect_tol = 1.0;
+    int max_levels = 3;
+
+    // Test Params
+    double test_tol = 1e-6;
+
+    /// [Load Input]
+    SparseMatrix vertex_edge_global = GenerateGraph(comm, gen_vertices, mean_degree, beta, seed);
+    std::vector<int> global_partitioning = PartitionAAT(vertex_edge_global, coarsen_factor);
+
+    int num_edges = vertex_edge_global.Cols();
+    std::vector<double> new_weight(num_edges);
+
+    for (int i = 0; i < num_edges; ++i)
+    {
+        new_weight[i] = 1.0 + (i % 7);
+    }
+    /// [Load Input]
+
+    UpscaleParams params(spect_tol, max_evects, false, max_levels);
+
+    Graph graph(comm, vertex_edge_global, global_partitioning);
+    Graph new_graph(comm, vertex_edge_global, global_partitioning, new_weight);
+
+    /// [Update]
+    GraphUpscale cold_upscale(graph, params);
+
+    Timer cold_timer(Timer::Start::True);
+    cold_upscale.UpdateWeights(new_graph);
+    cold_timer.Click();
+
+    params.warm_start = true;
+
+    GraphUpscale upscale(graph, params);
+
+    Timer timer(Timer::Start::True);
+    upscale.UpdateWeights(new_graph);
+    timer.Click();
+
+    Timer fresh_timer(Timer::Start::True);
+    GraphUpscale fresh_upscale(new_graph, params);
+    fresh_timer.Click();
+
+    int num_warm_started = upscale.Coarsener(0).NumWarmStarted();
+
+    ParPrint(myid, std::cout << "Setup time:               " << fresh_timer.TotalTime() << "s\n"
+             << "Update time:              " << cold_timer.TotalTime() << "s\n"
+             << "Warm started update time: " << timer.TotalTime() << "s\n"
+             << "Warm started aggregates:  " << num_warm_started << "\n");
+    /// [Update]
+
+    /// [Compare]
+    BlockVector test_vect = upscale.GetBlockVector(0);
+    test_vect.GetBlock(0).Randomize(-1.0, 1.0);
+
+    Vector rhs = upscale.GetMatrix(0).LocalD().Mult(test_vect.GetBlock(0));
+
+    bool failed = num_warm_started == 0;
+
+    for (int level = 1; level < max_levels; ++level)
+    {
+        Vector sol = upscale.Solve(level, rhs);
+        Vector fresh_sol = fresh_upscale.Solve(level, rhs);
+
+        double error = CompareError(comm, sol, fresh_sol);
+
+        ParPrint(myid, std::cout << "Level " << level << " Update Error: " << error << "\n");
+
+        failed |= error > test_tol;
+    }
+    /// [Compare]
+
+    return failed;
+}
@@ -0,0 +1,121 @@
+/*BHEADER**********************************************************************
+ *
+ * Copyright (c) 2018, Lawrence Livermore National Security, LLC.
+ * Produced at the Lawrence Livermore National Laboratory.
+ * LLNL-CODE-759464. All Rights reserved. See file COPYRIGHT for details.
+ *
+ * This file is part of GAUSS. For more information and source code
+ * availability, see https://www.github.com/gelever/GAUSS.
+ *
+ * GAUSS is free software; you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License (as published by the Free
+ * Software Foundation) version 2.1 dated February 1999.
+ *
+ ***********************************************************************EHEADER*/
+
+/**
+   @file test_warm_start.cpp
+   @brief tests solving from an initial guess
+
+   Starting from the solution should take fewer iterations than starting
+   from zero, and starting from a nearby solution should give the same
+   answer, for every level and solver type.
+*/
+
+#include <fstream>
+#include <sstream>
+#include <mpi.h>
+
+#include "GAUSS.hpp"
+
+using namespace gauss;
+
+int main(int argc, char* argv[])
+{
+    // Initialize MPI
+    MpiSession mpi_info(argc, argv);
+    MPI_Comm comm = mpi_info.comm_;
+    int myid = mpi_info.myid_;
+
+    // Graph Params
+    int gen_vertices = 400;
+    int mean_degree = 10;
+    double beta = 0.15;
+    int seed = -1;
+    int coarsen_factor = 40;
+
+    // Upscale Params
+    int max_evects = 4;
+    double spect_tol = 1.0;
+    int max_levels = 3;
+
+    // Test Params
+    double perturbation = 1e-2;
+    double test_tol = 1e-6;
+
+    /// [Load Input]
+    SparseMatrix vertex_edge_global = GenerateGraph(comm, gen_vertices, mean_degree, beta, seed);
+    std::vector<int> global_partitioning = PartitionAAT(vertex_edge_global, coarsen_factor);
+
+    Graph graph(comm, vertex_edge_global, global_partitioning);
+    /// [Load Input]
+
+    bool failed = false;
+
+    for (bool hybridization : {false, true})
+    {
+        UpscaleParams params(spect_tol, max_evects, hybridization, max_levels);
+
+        GraphUpscale upscale(graph, params);
+        upscale.ShowSetupTime();
+
+        /// [Right Hand Sides]
+        BlockVector test_vect = upscale.GetBlockVector(0);
+        test_vect.GetBlock(0).Randomize(-1.0, 1.0);
+
+        BlockVector rhs = upscale.GetBlockVector(0);
+        rhs = 0.0;
+        upscale.GetMatrix(0).LocalD().Mult(test_vect.GetBlock(0), rhs.GetBlock(1));
+
+        // A nearby problem, as in the next step of a time dependent simulation
+        BlockVector next_rhs(rhs);
+        test_vect.GetBlock(0).Randomize(-perturbation, perturbation);
+        upscale.GetMatrix(0).LocalD().Mult(test_vect.GetBlock(0), test_vect.GetBlock(1));
+        next_rhs.GetBlock(1) += test_vect.GetBlock(1);
+        /// [Right Hand Sides]
+
+        /// [Compare]
+        for (int level = 0; level < max_levels; ++level)
+        {
+            BlockVector sol = upscale.Solve(level, rhs);
+            int cold_iters = upscale.SolveIters(level);
+
+            BlockVector warm_sol = upscale.GetBlockVector(0);
+            upscale.Solve(level, rhs, warm_sol, sol);
+            int warm_iters = upscale.SolveIters(level);
+
+            double error = CompareError(comm, warm_sol, sol);
+
+            BlockVector next_sol = upscale.Solve(level, next_rhs);
+            int next_cold_iters = upscale.SolveIters(level);
+
+            BlockVector next_warm_sol = upscale.GetBlockVector(0);
+            upscale.Solve(level, next_rhs, next_warm_sol, sol);
+            int next_warm_iters = upscale.SolveIters(level);
+
+            double next_error = CompareError(comm, next_warm_sol, next_sol);
+
+            ParPrint(myid, std::cout << "Hybridization " << hybridization << " Level "
+                     << level << " Warm Start Error: " << error << ", " << next_error
+                     << " Iterations: " << cold_iters << " -> " << warm_iters << ", "
+                     << next_cold_iters << " -> " << next_warm_iters << "\n");
+
+            failed |= error > test_tol;
+            failed |= next_error > test_tol;
+            failed |= warm_iters >= cold_iters;
+        }
+        /// [Compare]
+    }
+
+    return failed;
+}
@@ -0,0 +1,92 @@
+/*BHEADER**********************************************************************
+ *
+ * Copyright (c) 2018, Lawrence Livermore National Security, LLC.
+ * Produced at the Lawrence Livermore National Laboratory.
+ * LLNL-CODE-759464. All Rights reserved. See file COPYRIGHT for details.
+ *
+ * This file is part of GAUSS. For more information and source code
+ * availability, see https://www.github.com/gelever/GAUSS.
+ *
+ * GAUSS is free software; you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License (as published by the Free
+ * Software Foundation) version 2.1 dated February 1999.
+ *
+ ***********************************************************************EHEADER*/
+
+/**
+   @file test_write_vector.cpp
+   @brief tests writing a distributed vector to a serial file
+
+   Each vertex writes a value computed from its global index, which is
+   then read back in serial and compared.
+*/
+
+#include <cstdio>
+#include <mpi.h>
+
+#include "GAUSS.hpp"
+
+using namespace gauss;
+using linalgcpp::ReadCSR;
+using linalgcpp::ReadText;
+
+int main(int argc, char* argv[])
+{
+    // Initialize MPI
+    MpiSession mpi_info(argc, argv);
+    MPI_Comm comm = mpi_info.comm_;
+    int myid = mpi_info.myid_;
+
+    std::string graph_filename = "../../graphdata/vertex_edge_sample.txt";
+    std::string filename = "test_write_vector.txt";
+    int coarsen_factor = 100;
+
+    SparseMatrix vertex_edge = ReadCSR(graph_filename);
+    std::vector<int> partition = PartitionAAT(vertex_edge, coarsen_factor);
+
+    Graph graph(comm, vertex_edge, partition);
+
+    /// [Write]
+    int num_vertices = graph.vertex_map_.size();
+
+    Vector vect(num_vertices);
+
+    for (int i = 0; i < num_vertices; ++i)
+    {
+        vect[i] = 0.5 + graph.vertex_map_[i];
+    }
+
+    WriteVertexVector(graph, vect, filename);
+    /// [Write]
+
+    /// [Compare]
+    MPI_Barrier(comm);
+
+    std::vector<double> global_vect = ReadText(filename);
+
+    bool failed = static_cast<int>(global_vect.size()) != graph.global_vertices_;
+
+    for (int i = 0; !failed && i < graph.global_vertices_; ++i)
+    {
+        failed |= global_vect[i] != 0.5 + i;
+    }
+
+    Vector local_vect = ReadVertexVector(graph, filename);
+
+    for (int i = 0; i < num_vertices; ++i)
+    {
+        failed |= local_vect[i] != vect[i];
+    }
+    /// [Compare]
+
+    ParPrint(myid, std::cout << "Write vector test " << (failed ? "failed" : "passed") << "\n");
+
+    MPI_Barrier(comm);
+
+    if (myid == 0)
+    {
+        std::remove(filename.c_str());
+    }
+
+    return failed;
+}